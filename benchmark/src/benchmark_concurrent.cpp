@@ -6,6 +6,7 @@
 #include "../../include/benchmark.h"
 #include "../../include/server.h"
 #include "../../include/Logger.h"
+#include "../../include/server_process.h"
 
 #include <atomic>
 #include <chrono>
@@ -66,28 +67,45 @@ public:
             return result;
         }
 
-        // 启动服务器
+        // 启动服务器：独立进程模式下 fork/exec server，只对服务器进程采样资源
+        std::unique_ptr<ServerProcess> process;
         std::unique_ptr<Server> server;
         std::thread server_thread;
 
-        try {
-            server = std::make_unique<Server>(config.server_host, config.server_port, PluginManager::GetInstance());
-            server_thread = std::thread([&server]() {
-                server->Run();
-            });
+        if (UseServerProcess(config)) {
+            system("mkdir -p public");
+            process = std::make_unique<ServerProcess>(ServerProcessOptions::FromConfig(config));
+            if (!process->Start(result.error_message)) {
+                result.success = false;
+                result.end_time = std::chrono::system_clock::now();
+                return result;
+            }
+        } else {
+            try {
+                server = std::make_unique<Server>(config.server_host, config.server_port, PluginManager::GetInstance());
+                server_thread = std::thread([&server]() {
+                    server->Run();
+                });
 
-            std::this_thread::sleep_for(std::chrono::milliseconds(2000));
-            LOG_INFO("并发基准测试: 服务器已启动");
-        } catch (const std::exception& e) {
-            result.success = false;
-            result.error_message = std::string("启动服务器失败: ") + e.what();
-            result.end_time = std::chrono::system_clock::now();
-            return result;
+                std::this_thread::sleep_for(std::chrono::milliseconds(2000));
+                LOG_INFO("并发基准测试: 服务器已启动");
+            } catch (const std::exception& e) {
+                result.success = false;
+                result.error_message = std::string("启动服务器失败: ") + e.what();
+                result.end_time = std::chrono::system_clock::now();
+                return result;
+            }
         }
 
         // 预热
         WarmUp(config);
 
+        std::unique_ptr<SystemResourceMonitor> monitor;
+        if (process) {
+            monitor = std::make_unique<SystemResourceMonitor>(process->Pid());
+            monitor->Start();
+        }
+
         // 阶段1：测量最大并发连接数
         LOG_INFO("并发基准测试: 阶段1 - 测量最大并发连接数");
         auto max_connections_result = TestMaxConnections(config);
@@ -101,6 +119,12 @@ public:
         auto stability_result = TestConnectionStability(config);
 
         // 停止服务器
+        if (monitor) {
+            monitor->Stop();
+        }
+        if (process) {
+            process->Stop();
+        }
         if (server) {
             server->Stop();
         }
@@ -145,6 +169,9 @@ public:
             result.metrics.push_back({"overall_score", overall_score, "points",
                                      "并发能力综合评分（0-100）"});
         }
+        if (monitor) {
+            ServerProcess::AppendMetrics(*monitor, result);
+        }
 
         LOG_INFO("并发基准测试完成: 最大连接数=%d, 综合评分=%.1f",
                 static_cast<int>(FindMetric(result.metrics, "max_successful_connections").value),
@@ -0,0 +1,704 @@
+/**
+ * @file benchmark_connection_memory.cpp
+ * @brief 连接规模内存基准：每个空闲 keep-alive 连接占用多少字节
+ *
+ * 打开 concurrent_connections 条连接并保持空闲，分阶段测量服务器内存：
+ * 1. idle：连接已建立、尚未发送请求
+ * 2. keepalive：每条连接完成一次请求/响应后空闲 duration_seconds（长轮询的常态）
+ * 3. closed：客户端全部关闭后的残留（泄漏检查）
+ *
+ * 每个阶段报告相对基线的服务器 RSS / 连接、内核 TCP 内存 / 连接（/proc/net/sockstat，
+ * 回环上含两端），进程内模式下还按子系统报告存活堆字节 / 连接：本文件替换全局
+ * operator new，按 alloc_tag.h 中服务器标记的 AllocTag 累计每次分配。
+ *
+ * 单个源地址最多只有 ip_local_port_range 个临时端口，连接数超过时轮流绑定
+ * 127.0.0.1、127.0.0.2 …（custom_params.source_ips，0 表示按端口范围自动计算）。
+ *
+ * 替换的分配器在每块内存前多占 16 字节，对 benchmark_runner 的所有类型生效；
+ * 需要不受影响的 RSS 读数时使用 server_mode = process（此时不报告子系统拆分）。
+ *
+ * custom_params:
+ * - source_ips：源地址个数，0 表示自动
+ * - send_request：是否进入 keepalive 阶段（默认 true）
+ * - settle_seconds：每个阶段采样前的等待时间（默认 2）
+ * - server_threads / server_mode 等见 server_process.h
+ */
+
+#include "../../include/benchmark.h"
+#include "../../include/server.h"
+#include "../../include/Logger.h"
+#include "../../include/alloc_tag.h"
+#include "../../include/buffer_chain.h"
+#include "../../include/connection.h"
+#include "../../include/http_request.h"
+#include "../../include/http_response.h"
+#include "../../include/server_metrics.h"
+#include "../../include/server_process.h"
+#include "../../include/config/server_config.h"
+#include "json.hpp"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <netinet/in.h>
+#include <new>
+#include <sstream>
+#include <string>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// ==================== 分配归属钩子 ====================
+
+namespace {
+
+using tinywebserver::AllocTag;
+
+constexpr size_t kTagCount = static_cast<size_t>(AllocTag::kCount);
+
+/// 每块内存前的头部：请求大小、分配时的标记、是否在统计期间分配
+struct alignas(16) AllocHeader {
+    size_t size;
+    uint8_t tag;
+    bool tracked;
+};
+static_assert(sizeof(AllocHeader) == 16, "AllocHeader must keep 16-byte alignment");
+
+std::atomic<bool> g_tracking{false};
+std::atomic<int64_t> g_live_bytes[kTagCount];
+std::atomic<int64_t> g_live_blocks[kTagCount];
+
+void* TaggedAlloc(size_t size) noexcept {
+    auto* header = static_cast<AllocHeader*>(std::malloc(sizeof(AllocHeader) + size));
+    if (!header) {
+        return nullptr;
+    }
+    header->size = size;
+    header->tracked = g_tracking.load(std::memory_order_relaxed);
+    header->tag = static_cast<uint8_t>(header->tracked ? tinywebserver::CurrentAllocTag() : AllocTag::kOther);
+    if (header->tracked) {
+        g_live_bytes[header->tag].fetch_add(static_cast<int64_t>(size), std::memory_order_relaxed);
+        g_live_blocks[header->tag].fetch_add(1, std::memory_order_relaxed);
+    }
+    return header + 1;
+}
+
+void TaggedFree(void* p) noexcept {
+    if (!p) {
+        return;
+    }
+    auto* header = static_cast<AllocHeader*>(p) - 1;
+    // 按分配时的标记扣减，与释放发生在哪个线程、哪个作用域无关
+    if (header->tracked) {
+        g_live_bytes[header->tag].fetch_sub(static_cast<int64_t>(header->size), std::memory_order_relaxed);
+        g_live_blocks[header->tag].fetch_sub(1, std::memory_order_relaxed);
+    }
+    std::free(header);
+}
+
+void* TaggedAllocOrThrow(size_t size) {
+    void* p = TaggedAlloc(size);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+} // namespace
+
+void* operator new(size_t size) { return TaggedAllocOrThrow(size); }
+void* operator new[](size_t size) { return TaggedAllocOrThrow(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return TaggedAlloc(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return TaggedAlloc(size); }
+void operator delete(void* p) noexcept { TaggedFree(p); }
+void operator delete[](void* p) noexcept { TaggedFree(p); }
+void operator delete(void* p, size_t) noexcept { TaggedFree(p); }
+void operator delete[](void* p, size_t) noexcept { TaggedFree(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { TaggedFree(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { TaggedFree(p); }
+
+namespace tinywebserver {
+namespace benchmark {
+
+namespace {
+
+const char kDocRoot[] = "./public";
+constexpr size_t kConnectBatch = 512;
+// 源地址端口只用到 90%，给 TIME_WAIT 和系统其它连接留余量
+constexpr double kPortUsage = 0.9;
+constexpr int kMaxSourceIps = 254;
+
+std::string GetParam(const BenchmarkConfig& config, const std::string& name, const std::string& default_value) {
+    for (const auto& param : config.custom_params) {
+        if (param.first == name) {
+            return param.second;
+        }
+    }
+    return default_value;
+}
+
+double GetDoubleParam(const BenchmarkConfig& config, const std::string& name, double default_value) {
+    try {
+        return std::stod(GetParam(config, name, std::to_string(default_value)));
+    } catch (...) {
+        LOG_WARN("无效的参数 %s，使用默认值 %.2f", name.c_str(), default_value);
+        return default_value;
+    }
+}
+
+/**
+ * @brief 各子系统的存活堆字节与块数（只含统计开启后的分配）
+ */
+struct HeapSnapshot {
+    int64_t bytes[kTagCount] = {};
+    int64_t blocks[kTagCount] = {};
+
+    static HeapSnapshot Take() {
+        HeapSnapshot snapshot;
+        for (size_t i = 0; i < kTagCount; ++i) {
+            snapshot.bytes[i] = g_live_bytes[i].load(std::memory_order_relaxed);
+            snapshot.blocks[i] = g_live_blocks[i].load(std::memory_order_relaxed);
+        }
+        return snapshot;
+    }
+
+    int64_t TotalBytes() const {
+        int64_t total = 0;
+        for (int64_t value : bytes) {
+            total += value;
+        }
+        return total;
+    }
+
+    int64_t TotalBlocks() const {
+        int64_t total = 0;
+        for (int64_t value : blocks) {
+            total += value;
+        }
+        return total;
+    }
+};
+
+/**
+ * @brief 一个阶段的采样
+ */
+struct StageSample {
+    int64_t rss_kb = 0;
+    int64_t tcp_mem_pages = 0;
+    int64_t server_connections = 0;
+    HeapSnapshot heap;
+};
+
+/// /proc/net/sockstat 中 "TCP: ... mem N" 的页数（全系统 TCP 缓冲区）
+int64_t ReadTcpMemPages() {
+    std::ifstream file("/proc/net/sockstat");
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.compare(0, 4, "TCP:") != 0) {
+            continue;
+        }
+        std::istringstream iss(line.substr(4));
+        std::string key;
+        int64_t value = 0;
+        while (iss >> key >> value) {
+            if (key == "mem") {
+                return value;
+            }
+        }
+    }
+    return 0;
+}
+
+/// 临时端口范围大小
+int LocalPortCount() {
+    std::ifstream file("/proc/sys/net/ipv4/ip_local_port_range");
+    int low = 32768, high = 60999;
+    file >> low >> high;
+    return std::max(1, high - low + 1);
+}
+
+/**
+ * @brief 把 RLIMIT_NOFILE 软限制抬到 wanted，返回实际可用值
+ */
+rlim_t RaiseFdLimit(rlim_t wanted) {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0) {
+        return 0;
+    }
+    if (limit.rlim_cur < wanted) {
+        limit.rlim_cur = std::min(wanted, limit.rlim_max);
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+    return limit.rlim_cur;
+}
+
+int CountFds(pid_t pid) {
+    int count = 0;
+    DIR* dir = opendir(("/proc/" + std::to_string(pid) + "/fd").c_str());
+    if (!dir) {
+        return 0;
+    }
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (entry->d_name[0] != '.') {
+            ++count;
+        }
+    }
+    closedir(dir);
+    return count;
+}
+
+/**
+ * @brief 建立一条阻塞连接；source_ip 非 0 时先绑定该源地址（端口由 connect 分配）
+ * @return fd，失败返回 -1 并设置 errno
+ */
+int ConnectFrom(const sockaddr_in& server, uint32_t source_ip) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (source_ip != 0) {
+#ifdef IP_BIND_ADDRESS_NO_PORT
+        // 否则 bind 就要占用端口，且不考虑目的地址，每个源地址的端口会先于 4 元组耗尽
+        int one = 1;
+        setsockopt(fd, IPPROTO_IP, IP_BIND_ADDRESS_NO_PORT, &one, sizeof(one));
+#endif
+        struct sockaddr_in local;
+        std::memset(&local, 0, sizeof(local));
+        local.sin_family = AF_INET;
+        local.sin_addr.s_addr = htonl(source_ip);
+        if (bind(fd, reinterpret_cast<struct sockaddr*>(&local), sizeof(local)) != 0) {
+            int saved = errno;
+            close(fd);
+            errno = saved;
+            return -1;
+        }
+    }
+    if (connect(fd, reinterpret_cast<const struct sockaddr*>(&server), sizeof(server)) != 0) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+    struct timeval tv = {5, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    return fd;
+}
+
+/**
+ * @brief 阻塞读取一个完整的 HTTP/1.1 响应（按 Content-Length 读完响应体）
+ */
+bool ReadResponse(int fd, std::string& buffer) {
+    buffer.clear();
+    char chunk[4096];
+    size_t header_end = std::string::npos;
+    size_t expected = 0;
+    while (true) {
+        if (header_end == std::string::npos) {
+            header_end = buffer.find("\r\n\r\n");
+            if (header_end != std::string::npos) {
+                size_t content_length = 0;
+                size_t pos = buffer.find("Content-Length:");
+                if (pos == std::string::npos) {
+                    pos = buffer.find("content-length:");
+                }
+                if (pos != std::string::npos && pos < header_end) {
+                    content_length = std::strtoull(buffer.c_str() + pos + 15, nullptr, 10);
+                }
+                expected = header_end + 4 + content_length;
+            }
+        }
+        if (header_end != std::string::npos && buffer.size() >= expected) {
+            return buffer.compare(0, 5, "HTTP/") == 0;
+        }
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) {
+            return false;
+        }
+        buffer.append(chunk, static_cast<size_t>(n));
+    }
+}
+
+/**
+ * @brief 连接规模内存基准测试
+ */
+class ConnectionMemoryBenchmark : public Benchmark {
+public:
+    std::string GetName() const override {
+        return "connection_memory_benchmark";
+    }
+
+    std::string GetDescription() const override {
+        return "测量每个空闲 keep-alive 连接的服务器内存占用及按子系统的拆分";
+    }
+
+    BenchmarkResult Run(const BenchmarkConfig& config) override {
+        BenchmarkResult result;
+        result.name = GetName();
+        result.start_time = std::chrono::system_clock::now();
+        auto finish = [&result](bool success) {
+            result.success = success;
+            result.end_time = std::chrono::system_clock::now();
+            result.duration_seconds = std::chrono::duration<double>(result.end_time - result.start_time).count();
+            return result;
+        };
+
+        auto errors = config.Validate();
+        if (!errors.empty()) {
+            result.error_message = "配置验证失败: ";
+            for (const auto& error : errors) {
+                result.error_message += error + "; ";
+            }
+            return finish(false);
+        }
+
+        struct sockaddr_in server_addr;
+        std::memset(&server_addr, 0, sizeof(server_addr));
+        server_addr.sin_family = AF_INET;
+        server_addr.sin_port = htons(static_cast<uint16_t>(config.server_port));
+        if (inet_pton(AF_INET, config.server_host.c_str(), &server_addr.sin_addr) <= 0) {
+            result.error_message = "无效的服务器地址: " + config.server_host;
+            return finish(false);
+        }
+
+        const bool in_process = !UseServerProcess(config);
+        const double settle_seconds = std::max(0.0, GetDoubleParam(config, "settle_seconds", 2));
+        const bool send_request = GetParam(config, "send_request", "true") != "false";
+        // keep-alive 超时须长于整个测量过程，否则空闲连接会在采样前被回收
+        const int keep_alive_timeout = static_cast<int>(config.duration_seconds + settle_seconds * 4) + 60;
+
+        // 进程内模式两端的 fd 都在本进程；独立进程模式下子进程继承抬高后的软限制
+        size_t target = static_cast<size_t>(config.concurrent_connections);
+        rlim_t fds_per_connection = in_process ? 2 : 1;
+        rlim_t fd_limit = RaiseFdLimit(static_cast<rlim_t>(target) * fds_per_connection + 1024);
+        if (fd_limit < static_cast<rlim_t>(target) * fds_per_connection + 1024) {
+            size_t capped = fd_limit > 1024 ? static_cast<size_t>((fd_limit - 1024) / fds_per_connection) : 0;
+            LOG_WARN("RLIMIT_NOFILE=%llu 不足以打开 %zu 条连接，减为 %zu（请调高 ulimit -n）",
+                     static_cast<unsigned long long>(fd_limit), target, capped);
+            target = capped;
+        }
+        if (target == 0) {
+            result.error_message = "RLIMIT_NOFILE 过低，无法建立连接";
+            return finish(false);
+        }
+
+        // 源地址：服务器在回环地址上时轮流绑定 127.0.0.1 ~ 127.0.0.N
+        int source_ips = static_cast<int>(GetDoubleParam(config, "source_ips", 0));
+        const bool loopback = (ntohl(server_addr.sin_addr.s_addr) >> 24) == 127;
+        if (!loopback) {
+            source_ips = 0;
+        } else if (source_ips <= 0) {
+            double per_ip = LocalPortCount() * kPortUsage;
+            source_ips = static_cast<int>(std::ceil(static_cast<double>(target) / per_ip));
+        }
+        source_ips = std::min(source_ips, kMaxSourceIps);
+
+        // 启动服务器
+        std::unique_ptr<ServerProcess> process;
+        std::unique_ptr<Server> server;
+        std::thread server_thread;
+        if (in_process) {
+            if (!StartInProcessServer(config, keep_alive_timeout, server, server_thread, result.error_message)) {
+                return finish(false);
+            }
+        } else {
+            auto options = ServerProcessOptions::FromConfig(config);
+            options.keep_alive_timeout = keep_alive_timeout;
+            process = std::make_unique<ServerProcess>(options);
+            if (!process->Start(result.error_message)) {
+                return finish(false);
+            }
+        }
+        auto stop_server = [&]() {
+            if (process) {
+                process->Stop();
+            }
+            if (server) {
+                server->Stop();
+            }
+            if (server_thread.joinable()) {
+                server_thread.join();
+            }
+            server.reset();
+        };
+
+        const pid_t pid = process ? process->Pid() : getpid();
+        SystemResourceMonitor monitor(process ? process->Pid() : 0);
+        // 服务器侧连接数：进程内读 ServerMetrics，独立进程数 /proc/<pid>/fd
+        const int64_t base_fds = CountFds(pid);
+        const int64_t base_active = static_cast<int64_t>(ServerMetrics::GetInstance().GetSnapshot().active_connections);
+        auto server_connections = [&]() -> int64_t {
+            if (in_process) {
+                return static_cast<int64_t>(ServerMetrics::GetInstance().GetSnapshot().active_connections) - base_active;
+            }
+            return CountFds(pid) - base_fds;
+        };
+        auto wait_connections = [&](std::function<bool(int64_t)> done, double timeout_seconds) {
+            auto deadline = std::chrono::steady_clock::now() +
+                std::chrono::milliseconds(static_cast<int64_t>(timeout_seconds * 1000));
+            while (!done(server_connections()) && std::chrono::steady_clock::now() < deadline) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        };
+        auto sample = [&]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int64_t>(settle_seconds * 1000)));
+            StageSample stage;
+            stage.rss_kb = monitor.GetCurrentMetrics().rss_kb;
+            stage.tcp_mem_pages = ReadTcpMemPages();
+            stage.server_connections = server_connections();
+            stage.heap = HeapSnapshot::Take();
+            return stage;
+        };
+
+        // 探针：空对象自身的堆占用（如 BufferChain 的 std::deque 在构造时即分配）
+        std::vector<int> fds;
+        fds.reserve(target);
+        std::string response;
+        response.reserve(64 * 1024);
+        g_tracking.store(true, std::memory_order_relaxed);
+        int64_t empty_chain_bytes = ProbeHeapBytes<BufferChain>();
+        int64_t empty_request_bytes = ProbeHeapBytes<HttpRequest>();
+
+        LOG_INFO("连接内存基准: 目标 %zu 条连接, 源地址 %d 个, %s", target, std::max(source_ips, 1),
+                 in_process ? "进程内服务器" : "独立进程服务器");
+        StageSample baseline = sample();
+
+        // 阶段1：建立连接，按批等待服务器 accept 跟上，避免溢出 accept 队列
+        auto connect_start = std::chrono::steady_clock::now();
+        int64_t connect_failures = 0;
+        int last_errno = 0;
+        while (fds.size() < target && connect_failures < 100) {
+            uint32_t source = source_ips > 0 ? (0x7f000001u + static_cast<uint32_t>(fds.size() % source_ips)) : 0;
+            int fd = ConnectFrom(server_addr, source);
+            if (fd < 0) {
+                ++connect_failures;
+                last_errno = errno;
+                continue;
+            }
+            fds.push_back(fd);
+            if (fds.size() % kConnectBatch == 0) {
+                int64_t connected = static_cast<int64_t>(fds.size());
+                wait_connections([connected](int64_t n) { return n + static_cast<int64_t>(kConnectBatch) >= connected; }, 5);
+            }
+        }
+        double connect_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - connect_start).count();
+        if (connect_failures > 0) {
+            LOG_WARN("连接内存基准: %lld 次连接失败，最后一次: %s",
+                     static_cast<long long>(connect_failures), strerror(last_errno));
+        }
+        const int64_t established = static_cast<int64_t>(fds.size());
+        wait_connections([established](int64_t n) { return n >= established; }, 10 + established / 10000.0);
+        StageSample idle = sample();
+        LOG_INFO("连接内存基准: idle 阶段 %lld 条连接, RSS %lld KB",
+                 static_cast<long long>(idle.server_connections), static_cast<long long>(idle.rss_kb));
+
+        // 阶段2：每条连接一次请求/响应后保持空闲
+        StageSample keepalive;
+        int64_t request_errors = 0;
+        if (send_request && established > 0) {
+            std::string request = config.request_method + " " + config.request_path + " HTTP/1.1\r\n"
+                                  "Host: " + config.server_host + "\r\nConnection: keep-alive\r\n\r\n";
+            for (size_t begin = 0; begin < fds.size(); begin += kConnectBatch) {
+                size_t end = std::min(fds.size(), begin + kConnectBatch);
+                std::vector<bool> sent(end - begin, false);
+                for (size_t i = begin; i < end; ++i) {
+                    sent[i - begin] = send(fds[i], request.data(), request.size(), MSG_NOSIGNAL) ==
+                                      static_cast<ssize_t>(request.size());
+                }
+                for (size_t i = begin; i < end; ++i) {
+                    if (!sent[i - begin] || !ReadResponse(fds[i], response)) {
+                        ++request_errors;
+                    }
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int64_t>(config.duration_seconds * 1000)));
+            keepalive = sample();
+            LOG_INFO("连接内存基准: keepalive 阶段 %lld 条连接, RSS %lld KB, 请求失败 %lld",
+                     static_cast<long long>(keepalive.server_connections), static_cast<long long>(keepalive.rss_kb),
+                     static_cast<long long>(request_errors));
+        }
+
+        // 阶段3：全部关闭，检查残留
+        for (int fd : fds) {
+            close(fd);
+        }
+        fds.clear();
+        wait_connections([](int64_t n) { return n <= 0; }, 10 + established / 10000.0);
+        StageSample closed = sample();
+        g_tracking.store(false, std::memory_order_relaxed);
+        stop_server();
+
+        if (established == 0) {
+            result.error_message = std::string("没有建立任何连接: ") + strerror(last_errno);
+            return finish(false);
+        }
+
+        const double n = static_cast<double>(established);
+        result.metrics.push_back({"established_connections", n, "count", "成功建立的连接数"});
+        result.metrics.push_back({"failed_connections", static_cast<double>(connect_failures), "count", "连接失败次数"});
+        result.metrics.push_back({"source_ips", static_cast<double>(std::max(source_ips, 1)), "count", "使用的源地址个数"});
+        result.metrics.push_back({"connect_rate", connect_seconds > 0 ? n / connect_seconds : 0, "conn/s", "建连速率"});
+        AppendStage("idle", "建立后未发请求", baseline, idle, n, in_process, result);
+        if (send_request) {
+            result.metrics.push_back({"request_errors", static_cast<double>(request_errors), "count",
+                                      "keepalive 阶段请求失败数"});
+            result.metrics.push_back({"keepalive_surviving_connections", static_cast<double>(keepalive.server_connections),
+                                      "count", "保持空闲 duration_seconds 后服务器侧仍存活的连接数"});
+            AppendStage("keepalive", "一次请求后空闲", baseline, keepalive, n, in_process, result);
+        }
+        result.metrics.push_back({"closed_rss_residual_kb", static_cast<double>(closed.rss_kb - baseline.rss_kb), "KB",
+                                  "全部关闭后服务器 RSS 相对基线的残留"});
+        if (in_process) {
+            result.metrics.push_back({"closed_heap_residual_per_conn_bytes",
+                                      (closed.heap.TotalBytes() - baseline.heap.TotalBytes()) / n, "bytes",
+                                      "全部关闭后存活堆字节相对基线的残留 / 连接（应接近 0）"});
+            result.metrics.push_back({"empty_buffer_chain_heap_bytes", static_cast<double>(empty_chain_bytes), "bytes",
+                                      "空 BufferChain 构造时的堆分配（计入 connection）"});
+            result.metrics.push_back({"empty_http_request_heap_bytes", static_cast<double>(empty_request_bytes), "bytes",
+                                      "空 HttpRequest 构造时的堆分配（不含对象本身）"});
+            result.metrics.push_back({"connection_object_bytes", static_cast<double>(sizeof(Connection)), "bytes",
+                                      "sizeof(Connection)"});
+        }
+
+        LOG_INFO("连接内存基准完成: %lld 条连接, idle RSS/连接 %.0f B",
+                 static_cast<long long>(established), (idle.rss_kb - baseline.rss_kb) * 1024.0 / n);
+        return finish(true);
+    }
+
+    void WarmUp(const BenchmarkConfig& /*config*/) override {
+        // 需要从空闲基线开始测量，不预热
+    }
+
+    void CleanUp(const BenchmarkConfig& /*config*/) override {
+    }
+
+private:
+    /// 构造一个空的 T，返回其构造期间新增的存活堆字节（不含对象本身）
+    template <typename T>
+    static int64_t ProbeHeapBytes() {
+        int64_t before = HeapSnapshot::Take().TotalBytes();
+        T object;
+        int64_t after = HeapSnapshot::Take().TotalBytes();
+        (void)object;
+        return after - before;
+    }
+
+    static bool StartInProcessServer(const BenchmarkConfig& config, int keep_alive_timeout,
+                                     std::unique_ptr<Server>& server, std::thread& server_thread,
+                                     std::string& error) {
+        system("mkdir -p public");
+        system("test -f public/index.html || echo '<h1>TinyWebServer Benchmark Test</h1>' > public/index.html");
+        nlohmann::json j = nlohmann::json::parse(ServerConfig().ToJsonString());
+        j["server"]["ip"] = config.server_host;
+        j["server"]["port"] = config.server_port;
+        int threads = static_cast<int>(GetDoubleParam(config, "server_threads", 0));
+        if (threads > 0) {
+            j["server"]["threads"] = threads;
+        }
+        j["static"]["root"] = kDocRoot;
+        j["limits"]["keep_alive_timeout"] = keep_alive_timeout;
+        j["metrics"]["enable_prometheus"] = false;
+        auto server_config = ServerConfig::LoadFromJson(j.dump());
+        if (!server_config) {
+            error = "无法生成服务器配置";
+            return false;
+        }
+        try {
+            server = std::make_unique<Server>(server_config, PluginManager::GetInstance());
+        } catch (const std::exception& e) {
+            error = std::string("启动服务器失败: ") + e.what();
+            return false;
+        }
+        // 与 main.cpp 相同的请求循环，连接经过 KeepAliveManager 的请求开始/完成通知
+        server->SetOnMessage([keep_alive_timeout](std::shared_ptr<Connection> conn, const std::string& /*data*/) {
+            auto parser = conn->GetHttpParser();
+            auto& buffer = conn->GetInputBuffer();
+            while (true) {
+                size_t header_end = buffer.find("\r\n\r\n");
+                if (header_end == std::string::npos) {
+                    break;
+                }
+                if (!parser->Parse(buffer)) {
+                    buffer.clear();
+                    conn->Shutdown();
+                    break;
+                }
+                conn->OnRequestStart(parser->IsKeepAlive(), keep_alive_timeout);
+                HttpResponse response;
+                response.Init(kDocRoot, parser->GetPath(), parser->IsKeepAlive(), -1, parser.get());
+                response.MakeResponse();
+                conn->Send(response.GetHeaderString());
+                if (response.HasFileBody()) {
+                    conn->Send(response.GetFileBody());
+                } else {
+                    conn->Send(response.GetBodyString());
+                }
+                buffer.erase(0, header_end + 4);
+                parser->Reset();
+                conn->OnRequestComplete();
+            }
+        });
+        Server* raw = server.get();
+        server_thread = std::thread([raw]() {
+            raw->Start();
+            raw->Run();
+        });
+        if (!WaitForHttpReady(config.server_host, config.server_port, 10)) {
+            error = "服务器端口无法连接，可能服务器未正确启动";
+            server->Stop();
+            server_thread.join();
+            server.reset();
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief 追加一个阶段相对基线的每连接指标
+     */
+    static void AppendStage(const std::string& stage, const std::string& label, const StageSample& baseline,
+                            const StageSample& sample, double connections, bool with_heap,
+                            BenchmarkResult& result) {
+        result.metrics.push_back({stage + "_rss_per_conn_bytes", (sample.rss_kb - baseline.rss_kb) * 1024.0 / connections,
+                                  "bytes", label + "：服务器 RSS 增量 / 连接"});
+        result.metrics.push_back({stage + "_kernel_tcp_per_conn_bytes",
+                                  (sample.tcp_mem_pages - baseline.tcp_mem_pages) * static_cast<double>(getpagesize()) /
+                                      connections,
+                                  "bytes", label + "：内核 TCP 缓冲区增量 / 连接（回环上含客户端一侧）"});
+        if (!with_heap) {
+            return;
+        }
+        result.metrics.push_back({stage + "_heap_per_conn_bytes",
+                                  (sample.heap.TotalBytes() - baseline.heap.TotalBytes()) / connections, "bytes",
+                                  label + "：存活堆字节增量 / 连接（按请求大小，不含分配器开销）"});
+        result.metrics.push_back({stage + "_heap_allocs_per_conn",
+                                  (sample.heap.TotalBlocks() - baseline.heap.TotalBlocks()) / connections, "count",
+                                  label + "：存活堆块数增量 / 连接"});
+        for (size_t i = 0; i < kTagCount; ++i) {
+            std::string name = AllocTagName(static_cast<AllocTag>(i));
+            result.metrics.push_back({stage + "_heap_" + name + "_per_conn_bytes",
+                                      (sample.heap.bytes[i] - baseline.heap.bytes[i]) / connections, "bytes",
+                                      label + "：" + name + " 子系统存活堆字节 / 连接"});
+        }
+    }
+};
+
+} // namespace
+
+std::unique_ptr<Benchmark> CreateConnectionMemoryBenchmark() {
+    return std::make_unique<ConnectionMemoryBenchmark>();
+}
+
+} // namespace benchmark
+} // namespace tinywebserver
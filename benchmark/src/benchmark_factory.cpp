@@ -18,6 +18,12 @@ std::unique_ptr<Benchmark> CreateLatencyBenchmark();
 std::unique_ptr<Benchmark> CreateMemoryBenchmark();
 std::unique_ptr<Benchmark> CreateConcurrentBenchmark();
 std::unique_ptr<Benchmark> CreateStepStressBenchmark();
+std::unique_ptr<Benchmark> CreateHttp2Benchmark();
+std::unique_ptr<Benchmark> CreatePipelineBenchmark();
+std::unique_ptr<Benchmark> CreateStaticMixBenchmark();
+std::unique_ptr<Benchmark> CreateLargeFileBenchmark();
+std::unique_ptr<Benchmark> CreateReplayBenchmark();
+std::unique_ptr<Benchmark> CreateConnectionMemoryBenchmark();
 
 } // namespace benchmark
 } // namespace tinywebserver
@@ -31,7 +37,13 @@ static const std::unordered_map<std::string, std::function<std::unique_ptr<Bench
     {"latency",    CreateLatencyBenchmark},
     {"memory",     CreateMemoryBenchmark},
     {"concurrent", CreateConcurrentBenchmark},
-    {"step_stress", CreateStepStressBenchmark}
+    {"step_stress", CreateStepStressBenchmark},
+    {"http2",      CreateHttp2Benchmark},
+    {"pipeline",   CreatePipelineBenchmark},
+    {"static_mix", CreateStaticMixBenchmark},
+    {"large_file", CreateLargeFileBenchmark},
+    {"replay",     CreateReplayBenchmark},
+    {"connection_memory", CreateConnectionMemoryBenchmark}
 };
 
 std::unique_ptr<Benchmark> CreateBenchmark(const std::string& type) {
@@ -0,0 +1,676 @@
+/**
+ * @file benchmark_http2.cpp
+ * @brief HTTP/2 多路复用基准测试实现（h2load 风格）
+ *
+ * 开 N 条 h2c 连接（先验知识模式），每条连接保持 M 个并发流，流结束后
+ * 立即补发新流。客户端直接复用服务器的 H2FrameParser 与 HPACK 编解码，
+ * 统计每个流的延迟分布与帧速率；可选地在同一服务器上以相同的在途请求数
+ * 跑一轮 HTTP/1.1 keep-alive 作为对照（由共用的 LoadGenerator 驱动）。
+ */
+
+#include "../../include/benchmark.h"
+#include "../../include/server.h"
+#include "../../include/Logger.h"
+#include "../../include/http_response.h"
+#include "../../include/http_request.h"
+#include "../../include/connection.h"
+#include "../../include/load_generator.h"
+#include "../../include/server_process.h"
+#include "../../include/http2/h2_connection.h"
+#include "../../include/http2/h2_frame_parser.h"
+#include "../../include/http2/h2_stream.h"
+#include "../../include/http2/hpack_decoder.h"
+#include "../../include/http2/hpack_encoder.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+#include <arpa/inet.h>
+
+namespace tinywebserver {
+namespace benchmark {
+
+namespace {
+
+using SteadyClock = std::chrono::steady_clock;
+
+constexpr char kClientPreface[] = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+constexpr size_t kFrameHeaderLen = 9;
+// 客户端接收窗口：流级与连接级都放大到 16MB，消费一半后归还
+constexpr uint32_t kClientWindow = 16 * 1024 * 1024;
+
+/// 单个客户端（连接）的统计，结束后汇总
+struct ClientStats {
+    int64_t completed = 0;
+    int64_t failed = 0;
+    int64_t frames = 0;
+    int64_t bytes = 0;
+    std::vector<double> latencies_ms;
+};
+
+int ConnectTcp(const std::string& host, int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) <= 0) {
+        close(fd);
+        return -1;
+    }
+
+    struct timeval tv;
+    tv.tv_sec = 2;
+    tv.tv_usec = 0;
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    if (connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool SendAll(int fd, const uint8_t* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+/**
+ * @brief 单条 h2c 连接上的基准测试客户端
+ *
+ * 阻塞式 socket，一个线程驱动一条连接；连接内保持固定数量的在途流。
+ */
+class H2BenchClient {
+public:
+    H2BenchClient(const std::string& host, int port, const std::string& path, int max_streams)
+        : host_(host), port_(port), path_(path), max_streams_(max_streams),
+          fd_(-1), next_stream_id_(1), conn_unacked_(0), continuation_stream_(0),
+          continuation_end_stream_(false), goaway_(false) {}
+
+    ~H2BenchClient() {
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+    }
+
+    /**
+     * @brief 建立连接并发送前言、SETTINGS 与连接级 WINDOW_UPDATE
+     */
+    bool Connect() {
+        fd_ = ConnectTcp(host_, port_);
+        if (fd_ < 0) {
+            return false;
+        }
+        out_.assign(kClientPreface, kClientPreface + sizeof(kClientPreface) - 1);
+        const std::vector<uint8_t> settings = {
+            0x00, 0x02, 0x00, 0x00, 0x00, 0x00,   // ENABLE_PUSH = 0
+            0x00, 0x04,                           // INITIAL_WINDOW_SIZE
+            static_cast<uint8_t>(kClientWindow >> 24), static_cast<uint8_t>(kClientWindow >> 16),
+            static_cast<uint8_t>(kClientWindow >> 8), static_cast<uint8_t>(kClientWindow)};
+        QueueFrame(http2::H2FrameType::SETTINGS, 0, 0, settings.data(), settings.size());
+        QueueWindowUpdate(0, kClientWindow - http2::H2Settings::INITIAL_WINDOW_SIZE);
+        return Flush();
+    }
+
+    /**
+     * @brief 持续发起请求直到 stop 置位，随后等待在途流结束
+     */
+    void Run(const std::atomic<bool>& stop, ClientStats& stats) {
+        while (!goaway_) {
+            while (!stop && static_cast<int>(inflight_.size()) < max_streams_) {
+                StartStream();
+            }
+            if (!Flush() || inflight_.empty()) {
+                break;
+            }
+            uint8_t buffer[65536];
+            ssize_t n = recv(fd_, buffer, sizeof(buffer), 0);
+            if (n <= 0) {
+                break;   // 连接关闭或 2 秒无响应
+            }
+            stats.bytes += n;
+            in_.insert(in_.end(), buffer, buffer + n);
+            if (!ProcessInput(stats)) {
+                break;
+            }
+        }
+        // 未完成的流计为失败
+        stats.failed += static_cast<int64_t>(inflight_.size());
+        inflight_.clear();
+    }
+
+private:
+    struct InflightStream {
+        SteadyClock::time_point start;
+        size_t unacked = 0;    ///< 尚未通过 WINDOW_UPDATE 归还的字节
+        int status = 0;
+    };
+
+    void QueueFrame(http2::H2FrameType type, uint8_t flags, uint32_t stream_id,
+                    const uint8_t* payload, size_t len) {
+        http2::H2FrameHeader header;
+        header.length = static_cast<uint32_t>(len);
+        header.type = static_cast<uint8_t>(type);
+        header.flags = flags;
+        header.stream_id = stream_id;
+        header.reserved = 0;
+        size_t offset = out_.size();
+        out_.resize(offset + kFrameHeaderLen + len);
+        http2::H2FrameParser::SerializeHeader(header, out_.data() + offset);
+        if (len > 0) {
+            std::memcpy(out_.data() + offset + kFrameHeaderLen, payload, len);
+        }
+    }
+
+    void QueueWindowUpdate(uint32_t stream_id, uint32_t increment) {
+        const uint8_t payload[4] = {static_cast<uint8_t>(increment >> 24), static_cast<uint8_t>(increment >> 16),
+                                    static_cast<uint8_t>(increment >> 8), static_cast<uint8_t>(increment)};
+        QueueFrame(http2::H2FrameType::WINDOW_UPDATE, 0, stream_id, payload, sizeof(payload));
+    }
+
+    bool Flush() {
+        if (out_.empty()) {
+            return true;
+        }
+        bool ok = SendAll(fd_, out_.data(), out_.size());
+        out_.clear();
+        return ok;
+    }
+
+    void StartStream() {
+        uint32_t stream_id = next_stream_id_;
+        next_stream_id_ += 2;
+
+        // 请求头部每次相同，编码器的头部块缓存直接命中
+        std::vector<http2::HpackHeader> headers = {
+            {":method", "GET"}, {":scheme", "http"},
+            {":authority", host_ + ":" + std::to_string(port_)}, {":path", path_}};
+        block_.clear();
+        encoder_.Encode(headers, block_);
+        QueueFrame(http2::H2FrameType::HEADERS,
+                   http2::H2FrameFlags::END_HEADERS | http2::H2FrameFlags::END_STREAM,
+                   stream_id, block_.data(), block_.size());
+        inflight_[stream_id].start = SteadyClock::now();
+    }
+
+    void FinishStream(uint32_t stream_id, ClientStats& stats) {
+        auto it = inflight_.find(stream_id);
+        if (it == inflight_.end()) {
+            return;
+        }
+        double latency_ms = std::chrono::duration<double, std::milli>(
+            SteadyClock::now() - it->second.start).count();
+        if (it->second.status >= 200 && it->second.status < 400) {
+            stats.completed++;
+            stats.latencies_ms.push_back(latency_ms);
+        } else {
+            stats.failed++;
+        }
+        inflight_.erase(it);
+    }
+
+    bool ProcessInput(ClientStats& stats) {
+        size_t offset = 0;
+        while (in_.size() - offset >= kFrameHeaderLen) {
+            auto header = http2::H2FrameParser::ParseHeader(in_.data() + offset, kFrameHeaderLen);
+            if (!header) {
+                return false;
+            }
+            if (in_.size() - offset < kFrameHeaderLen + header->length) {
+                break;
+            }
+            const uint8_t* payload = in_.data() + offset + kFrameHeaderLen;
+            stats.frames++;
+            if (!HandleFrame(*header, payload, stats)) {
+                return false;
+            }
+            offset += kFrameHeaderLen + header->length;
+        }
+        in_.erase(in_.begin(), in_.begin() + static_cast<std::ptrdiff_t>(offset));
+        return true;
+    }
+
+    bool HandleFrame(const http2::H2FrameHeader& header, const uint8_t* payload, ClientStats& stats) {
+        bool end_stream = header.HasFlag(http2::H2FrameFlags::END_STREAM);
+        switch (static_cast<http2::H2FrameType>(header.type)) {
+            case http2::H2FrameType::DATA: {
+                // 按整帧长度归还窗口，累计到一半时才发 WINDOW_UPDATE
+                conn_unacked_ += header.length;
+                if (conn_unacked_ >= kClientWindow / 2) {
+                    QueueWindowUpdate(0, static_cast<uint32_t>(conn_unacked_));
+                    conn_unacked_ = 0;
+                }
+                auto it = inflight_.find(header.stream_id);
+                if (it != inflight_.end() && !end_stream) {
+                    it->second.unacked += header.length;
+                    if (it->second.unacked >= kClientWindow / 2) {
+                        QueueWindowUpdate(header.stream_id, static_cast<uint32_t>(it->second.unacked));
+                        it->second.unacked = 0;
+                    }
+                }
+                break;
+            }
+            case http2::H2FrameType::HEADERS: {
+                const uint8_t* block = payload;
+                size_t len = header.length;
+                if (header.HasFlag(http2::H2FrameFlags::PADDED)) {
+                    if (len < 1 || block[0] >= len) {
+                        return false;
+                    }
+                    len -= 1 + block[0];
+                    block += 1;
+                }
+                if (header.HasFlag(http2::H2FrameFlags::PRIORITY)) {
+                    if (len < 5) {
+                        return false;
+                    }
+                    block += 5;
+                    len -= 5;
+                }
+                header_block_.assign(block, block + len);
+                continuation_stream_ = header.stream_id;
+                continuation_end_stream_ = end_stream;
+                if (header.HasFlag(http2::H2FrameFlags::END_HEADERS)) {
+                    return OnHeaderBlock(stats);
+                }
+                return true;
+            }
+            case http2::H2FrameType::CONTINUATION:
+                header_block_.insert(header_block_.end(), payload, payload + header.length);
+                if (header.HasFlag(http2::H2FrameFlags::END_HEADERS)) {
+                    return OnHeaderBlock(stats);
+                }
+                return true;
+            case http2::H2FrameType::SETTINGS:
+                if (!header.HasFlag(http2::H2FrameFlags::ACK)) {
+                    QueueFrame(http2::H2FrameType::SETTINGS, http2::H2FrameFlags::ACK, 0, nullptr, 0);
+                }
+                break;
+            case http2::H2FrameType::PING:
+                if (!header.HasFlag(http2::H2FrameFlags::ACK) && header.length == 8) {
+                    QueueFrame(http2::H2FrameType::PING, http2::H2FrameFlags::ACK, 0, payload, 8);
+                }
+                break;
+            case http2::H2FrameType::RST_STREAM:
+                if (inflight_.erase(header.stream_id) > 0) {
+                    stats.failed++;
+                }
+                break;
+            case http2::H2FrameType::GOAWAY:
+                goaway_ = true;
+                break;
+            default:
+                break;
+        }
+        if (end_stream && header.type == static_cast<uint8_t>(http2::H2FrameType::DATA)) {
+            FinishStream(header.stream_id, stats);
+        }
+        return true;
+    }
+
+    bool OnHeaderBlock(ClientStats& stats) {
+        uint32_t stream_id = continuation_stream_;
+        continuation_stream_ = 0;
+
+        // 必须解码以保持 HPACK 动态表同步
+        int status = 0;
+        auto err = decoder_.DecodeBlock(header_block_.data(), header_block_.size(),
+                                        [&status](const http2::HpackHeaderView& field) {
+                                            if (field.name == ":status") {
+                                                status = std::atoi(std::string(field.value).c_str());
+                                            }
+                                        });
+        if (err.IsFailure()) {
+            LOG_ERROR("HTTP/2 基准测试: HPACK 解码失败: %s", err.ToString().c_str());
+            return false;
+        }
+        auto it = inflight_.find(stream_id);
+        if (it != inflight_.end() && status != 0) {
+            it->second.status = status;
+        }
+        if (continuation_end_stream_) {
+            FinishStream(stream_id, stats);
+        }
+        return true;
+    }
+
+    std::string host_;
+    int port_;
+    std::string path_;
+    int max_streams_;
+    int fd_;
+
+    http2::HpackEncoder encoder_;
+    http2::HpackDecoder decoder_;
+    std::vector<uint8_t> out_;
+    std::vector<uint8_t> in_;
+    std::vector<uint8_t> block_;
+    std::vector<uint8_t> header_block_;
+
+    std::unordered_map<uint32_t, InflightStream> inflight_;
+    uint32_t next_stream_id_;
+    size_t conn_unacked_;
+    uint32_t continuation_stream_;
+    bool continuation_end_stream_;
+    bool goaway_;
+};
+
+/// 汇总各客户端统计
+ClientStats MergeStats(std::vector<ClientStats>& all) {
+    ClientStats total;
+    for (auto& stats : all) {
+        total.completed += stats.completed;
+        total.failed += stats.failed;
+        total.frames += stats.frames;
+        total.bytes += stats.bytes;
+        total.latencies_ms.insert(total.latencies_ms.end(), stats.latencies_ms.begin(), stats.latencies_ms.end());
+    }
+    std::sort(total.latencies_ms.begin(), total.latencies_ms.end());
+    return total;
+}
+
+/// 每个客户端一个线程，运行 duration 秒后停止并汇总
+template <typename Client>
+ClientStats RunClients(std::vector<std::unique_ptr<Client>>& clients, double duration_seconds,
+                       double& elapsed_seconds) {
+    std::atomic<bool> stop{false};
+    std::vector<ClientStats> stats(clients.size());
+    std::vector<std::thread> workers;
+    auto start = SteadyClock::now();
+    for (size_t i = 0; i < clients.size(); ++i) {
+        workers.emplace_back([&, i]() { clients[i]->Run(stop, stats[i]); });
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(duration_seconds));
+    stop = true;
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    elapsed_seconds = std::chrono::duration<double>(SteadyClock::now() - start).count();
+    return MergeStats(stats);
+}
+
+std::string GetParam(const BenchmarkConfig& config, const std::string& name, const std::string& default_value) {
+    for (const auto& param : config.custom_params) {
+        if (param.first == name) {
+            return param.second;
+        }
+    }
+    return default_value;
+}
+
+} // namespace
+
+/**
+ * @brief HTTP/2 多路复用基准测试
+ *
+ * custom_params:
+ * - streams_per_connection：每条连接的并发流数（默认 10）
+ * - compare_http1：为 "true" 时追加 HTTP/1.1 keep-alive 对照组（默认 true）
+ */
+class Http2Benchmark : public Benchmark {
+public:
+    std::string GetName() const override {
+        return "http2_benchmark";
+    }
+
+    std::string GetDescription() const override {
+        return "HTTP/2 多路复用吞吐与流延迟（N 连接 x M 并发流），可与 HTTP/1.1 keep-alive 对照";
+    }
+
+    BenchmarkResult Run(const BenchmarkConfig& config) override {
+        BenchmarkResult result;
+        result.name = GetName();
+        result.start_time = std::chrono::system_clock::now();
+
+        auto errors = config.Validate();
+        if (!errors.empty()) {
+            result.success = false;
+            result.error_message = "配置验证失败: ";
+            for (const auto& error : errors) {
+                result.error_message += error + "; ";
+            }
+            result.end_time = std::chrono::system_clock::now();
+            return result;
+        }
+
+        int streams = 10;
+        try {
+            streams = std::max(1, std::stoi(GetParam(config, "streams_per_connection", "10")));
+        } catch (...) {
+            LOG_WARN("无效的 streams_per_connection 配置，使用默认值 10");
+        }
+        bool compare_http1 = GetParam(config, "compare_http1", "true") == "true";
+
+        // 启动服务器：同一实例同时服务 h2c 与 HTTP/1.1；独立进程模式下 fork/exec server，只对服务器进程采样资源
+        std::unique_ptr<ServerProcess> process;
+        std::unique_ptr<Server> server;
+        std::thread server_thread;
+        system("mkdir -p public");
+        system("test -f public/index.html || echo '<h1>TinyWebServer Benchmark Test</h1>' > public/index.html");
+        if (UseServerProcess(config)) {
+            ServerProcessOptions options = ServerProcessOptions::FromConfig(config);
+            options.require_h2c = true;
+            process = std::make_unique<ServerProcess>(std::move(options));
+            if (!process->Start(result.error_message)) {
+                result.success = false;
+                result.end_time = std::chrono::system_clock::now();
+                return result;
+            }
+        } else {
+            try {
+                server = std::make_unique<Server>(config.server_host, config.server_port, PluginManager::GetInstance());
+                server->SetOnMessage([](std::shared_ptr<Connection> conn, const std::string& /*data*/) {
+                    auto parser = conn->GetHttpParser();
+                    auto& buffer = conn->GetInputBuffer();
+                    size_t header_end = buffer.find("\r\n\r\n");
+                    if (header_end == std::string::npos) {
+                        return;
+                    }
+                    if (!parser->Parse(buffer)) {
+                        buffer.clear();
+                        conn->Shutdown();
+                        return;
+                    }
+                    HttpResponse response;
+                    response.Init("./public", parser->GetPath(), true, -1, parser.get());
+                    response.MakeResponse();
+                    conn->Send(response.GetHeaderString());
+                    if (response.HasFileBody()) {
+                        conn->Send(response.GetFileBody());
+                    } else {
+                        conn->Send(response.GetBodyString());
+                    }
+                    buffer.erase(0, header_end + 4);
+                    parser->Reset();
+                });
+                server->SetOnH2Request([](std::shared_ptr<Connection> /*conn*/, std::shared_ptr<http2::H2Stream> stream) {
+                    const auto& request_headers = stream->GetRequestHeaders();
+                    auto path_it = request_headers.find(":path");
+                    HttpResponse response;
+                    response.Init("./public", path_it != request_headers.end() ? path_it->second : "/", true);
+                    response.MakeResponse();
+
+                    http2::H2Stream::Headers headers;
+                    headers[":status"] = std::to_string(response.GetCode());
+                    headers["content-type"] = response.GetContentType();
+                    headers["content-length"] = std::to_string(response.GetBodyLen());
+                    bool has_body = response.GetBodyLen() > 0;
+                    if (stream->SendHeaders(headers, !has_body).IsSuccess() && has_body) {
+                        if (response.HasFileBody()) {
+                            stream->SendFile(response.GetFileBody(), true);
+                        } else {
+                            const std::string& body = response.GetBodyString();
+                            stream->SendData(reinterpret_cast<const uint8_t*>(body.data()), body.size(), true);
+                        }
+                    }
+                });
+                server_thread = std::thread([&server]() {
+                    server->Start();
+                    server->Run();
+                });
+                std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+                LOG_INFO("HTTP/2 基准测试: 服务器已启动在 %s:%d", config.server_host.c_str(), config.server_port);
+            } catch (const std::exception& e) {
+                result.success = false;
+                result.error_message = std::string("启动服务器失败: ") + e.what();
+                result.end_time = std::chrono::system_clock::now();
+                return result;
+            }
+        }
+
+        // HTTP/2：N 连接 x M 并发流
+        std::vector<std::unique_ptr<H2BenchClient>> h2_clients;
+        for (int i = 0; i < config.concurrent_connections; ++i) {
+            auto client = std::make_unique<H2BenchClient>(config.server_host, config.server_port,
+                                                          config.request_path, streams);
+            if (client->Connect()) {
+                h2_clients.push_back(std::move(client));
+            }
+        }
+        if (h2_clients.empty()) {
+            StopServer(server, server_thread);
+            result.success = false;
+            result.error_message = "无法建立 HTTP/2 连接";
+            result.end_time = std::chrono::system_clock::now();
+            return result;
+        }
+
+        // 独立进程模式下只采样 HTTP/2 阶段的服务器资源
+        std::unique_ptr<SystemResourceMonitor> monitor;
+        if (process) {
+            monitor = std::make_unique<SystemResourceMonitor>(process->Pid());
+            monitor->Start();
+        }
+        double h2_elapsed = 0;
+        ClientStats h2 = RunClients(h2_clients, config.duration_seconds, h2_elapsed);
+        h2_clients.clear();
+        if (monitor) {
+            monitor->Stop();
+        }
+        LOG_INFO("HTTP/2 基准测试: %lld 个流完成, %lld 个失败", static_cast<long long>(h2.completed),
+                 static_cast<long long>(h2.failed));
+
+        // HTTP/1.1 对照组：相同的在途请求数（每连接一个请求），由共用的事件驱动客户端驱动
+        LoadGeneratorStats h1;
+        if (compare_http1) {
+            LoadGeneratorOptions options = LoadGeneratorOptions::FromConfig(config);
+            options.connections = config.concurrent_connections * streams;
+            options.target_rate = 0;
+            options.keep_alive = true;
+            options.requests = {LoadGenerator::BuildRequest("GET", config.request_path, config.server_host, "", true)};
+            h1 = LoadGenerator(options).Run();
+            result.metrics.push_back({"http1_connections", static_cast<double>(options.connections), "connections",
+                                      "HTTP/1.1 对照组连接数"});
+        }
+
+        if (process) {
+            process->Stop();
+        }
+        StopServer(server, server_thread);
+
+        if (h2.latencies_ms.empty()) {
+            result.success = false;
+            result.error_message = "没有完成任何 HTTP/2 流";
+            result.end_time = std::chrono::system_clock::now();
+            return result;
+        }
+
+        double h2_qps = h2_elapsed > 0 ? h2.completed / h2_elapsed : 0;
+        int64_t h2_total = h2.completed + h2.failed;
+        result.success = true;
+        result.duration_seconds = h2_elapsed;
+        result.end_time = std::chrono::system_clock::now();
+
+        result.metrics.push_back({"qps", h2_qps, "requests/second", "HTTP/2 每秒完成的流"});
+        result.metrics.push_back({"connections", static_cast<double>(config.concurrent_connections), "connections", "HTTP/2 连接数"});
+        result.metrics.push_back({"streams_per_connection", static_cast<double>(streams), "streams", "每连接并发流数"});
+        result.metrics.push_back({"total_requests", static_cast<double>(h2_total), "requests", "总请求数"});
+        result.metrics.push_back({"successful_requests", static_cast<double>(h2.completed), "requests", "成功请求数"});
+        result.metrics.push_back({"failed_requests", static_cast<double>(h2.failed), "requests", "失败请求数"});
+        result.metrics.push_back({"error_rate", h2_total > 0 ? 100.0 * h2.failed / h2_total : 0, "%", "错误率"});
+        result.metrics.push_back({"frames_per_second", h2_elapsed > 0 ? h2.frames / h2_elapsed : 0, "frames/second",
+                                  "客户端每秒收到的帧数"});
+        result.metrics.push_back({"throughput", h2_elapsed > 0 ? h2.bytes / h2_elapsed / (1024 * 1024) : 0, "MB/s",
+                                  "HTTP/2 接收吞吐"});
+        AddLatencyMetrics(result, "", h2.latencies_ms);
+        if (monitor) {
+            ServerProcess::AppendMetrics(*monitor, result);
+        }
+
+        if (compare_http1 && h1.completed > 0) {
+            double h1_qps = h1.Qps();
+            result.metrics.push_back({"http1_qps", h1_qps, "requests/second", "HTTP/1.1 keep-alive 每秒请求数"});
+            result.metrics.push_back({"http1_failed_requests", static_cast<double>(h1.Failed()), "requests",
+                                      "HTTP/1.1 失败请求数"});
+            result.metrics.push_back({"http1_mean_latency", h1.service.MeanNs() / 1e6, "ms", "平均延迟"});
+            result.metrics.push_back({"http1_max_latency", h1.service.max_value / 1e6, "ms", "最大延迟"});
+            const std::vector<std::pair<double, std::string>> percentiles = {
+                {0.50, "p50"}, {0.90, "p90"}, {0.99, "p99"}, {0.999, "p999"}};
+            for (const auto& [quantile, name] : percentiles) {
+                result.metrics.push_back({"http1_" + name + "_latency", h1.service.Percentile(quantile) / 1e6,
+                                          "ms", name + " 分位延迟"});
+            }
+            result.metrics.push_back({"h2_vs_http1_qps_ratio", h1_qps > 0 ? h2_qps / h1_qps : 0, "x",
+                                      "HTTP/2 与 HTTP/1.1 吞吐比"});
+        }
+
+        LOG_INFO("HTTP/2 基准测试完成: QPS=%.2f, P99=%.2fms", h2_qps,
+                 Statistics::CalculatePercentile(h2.latencies_ms, 99.0));
+        return result;
+    }
+
+private:
+    static void StopServer(std::unique_ptr<Server>& server, std::thread& server_thread) {
+        if (server) {
+            server->Stop();
+        }
+        if (server_thread.joinable()) {
+            server_thread.join();
+        }
+    }
+
+    static void AddLatencyMetrics(BenchmarkResult& result, const std::string& prefix,
+                                  const std::vector<double>& latencies) {
+        result.metrics.push_back({prefix + "mean_latency", Statistics::CalculateMean(latencies), "ms", "平均延迟"});
+        result.metrics.push_back({prefix + "max_latency", Statistics::CalculateMax(latencies), "ms", "最大延迟"});
+        const std::vector<std::pair<double, std::string>> percentiles = {
+            {50.0, "p50"}, {90.0, "p90"}, {99.0, "p99"}, {99.9, "p999"}};
+        for (const auto& [percentile, name] : percentiles) {
+            result.metrics.push_back({prefix + name + "_latency", Statistics::CalculatePercentile(latencies, percentile),
+                                      "ms", name + " 分位延迟"});
+        }
+    }
+};
+
+// 工厂函数
+std::unique_ptr<Benchmark> CreateHttp2Benchmark() {
+    return std::make_unique<Http2Benchmark>();
+}
+
+} // namespace benchmark
+} // namespace tinywebserver
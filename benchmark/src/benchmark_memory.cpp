@@ -6,6 +6,7 @@
 #include "../../include/benchmark.h"
 #include "../../include/server.h"
 #include "../../include/Logger.h"
+#include "../../include/server_process.h"
 
 #include <atomic>
 #include <chrono>
@@ -35,7 +36,9 @@ namespace benchmark {
  */
 class SystemResourceMonitor::Impl {
 public:
-    Impl() : running_(false), peak_rss_kb_(0), total_cpu_time_ms_(0) {
+    explicit Impl(int pid)
+        : proc_dir_(pid > 0 ? "/proc/" + std::to_string(pid) : "/proc/self"),
+          running_(false), peak_rss_kb_(0), total_cpu_time_ms_(0) {
         // 获取初始资源使用情况
         baseline_metrics_ = GetCurrentMetricsInternal();
     }
@@ -130,8 +133,8 @@ private:
         ResourceMetrics metrics;
         metrics.timestamp = std::chrono::steady_clock::now();
 
-        // 读取/proc/self/statm获取内存信息
-        std::ifstream statm_file("/proc/self/statm");
+        // 读取/proc/<pid>/statm获取内存信息
+        std::ifstream statm_file(proc_dir_ + "/statm");
         if (statm_file.is_open()) {
             long pages;
             statm_file >> pages; // 虚拟内存大小（页数）
@@ -149,21 +152,26 @@ private:
             }
         }
 
-        // 读取/proc/self/stat获取CPU时间
-        std::ifstream stat_file("/proc/self/stat");
+        // 读取/proc/<pid>/stat获取CPU时间（进程内全部线程之和）
+        std::ifstream stat_file(proc_dir_ + "/stat");
         if (stat_file.is_open()) {
             std::string line;
             std::getline(stat_file, line);
-            std::istringstream iss(line);
+            // comm 字段可能含空格，从右括号之后开始按空格切分（第3个字段起）
+            size_t comm_end = line.rfind(')');
+            std::istringstream iss(comm_end == std::string::npos ? line : line.substr(comm_end + 2));
 
-            // 跳过前13个字段
+            // 跳过第3~9个字段，第10个是 minflt，第12个是 majflt
             std::string token;
-            for (int i = 0; i < 13; ++i) {
+            for (int i = 3; i < 10; ++i) {
                 iss >> token;
             }
+            long minflt = 0, cminflt = 0, majflt = 0;
+            iss >> minflt >> cminflt >> majflt >> token;
+            metrics.page_faults = minflt + majflt;
 
             // 第14-15个字段是用户态和内核态CPU时间（时钟滴答数）
-            long utime, stime;
+            long utime = 0, stime = 0;
             iss >> utime >> stime;
 
             long clock_ticks_per_second = sysconf(_SC_CLK_TCK);
@@ -176,22 +184,15 @@ private:
         // 获取文件描述符数量
         metrics.fd_count = CountOpenFileDescriptors();
 
-        // 获取上下文切换和缺页次数（从/proc/self/status）
-        std::ifstream status_file("/proc/self/status");
+        // 上下文切换：/proc/<pid>/status 只含主线程，需累加每个线程的计数
+        metrics.context_switches = CountContextSwitches();
+
+        // 获取内存信息（从/proc/<pid>/status）
+        std::ifstream status_file(proc_dir_ + "/status");
         if (status_file.is_open()) {
             std::string line;
             while (std::getline(status_file, line)) {
-                if (line.find("voluntary_ctxt_switches:") == 0) {
-                    std::istringstream iss(line.substr(25));
-                    long voluntary, nonvoluntary;
-                    iss >> voluntary;
-                    if (line.find("nonvoluntary_ctxt_switches:") == 0) {
-                        std::getline(status_file, line);
-                        std::istringstream iss2(line.substr(29));
-                        iss2 >> nonvoluntary;
-                        metrics.context_switches = voluntary + nonvoluntary;
-                    }
-                } else if (line.find("VmPeak:") == 0) {
+                if (line.find("VmPeak:") == 0) {
                     std::istringstream iss(line.substr(7));
                     std::string value;
                     iss >> value;
@@ -224,9 +225,34 @@ private:
         return metrics;
     }
 
+    int64_t CountContextSwitches() const {
+        int64_t total = 0;
+        std::string task_dir = proc_dir_ + "/task";
+        DIR* dir = opendir(task_dir.c_str());
+        if (!dir) {
+            return 0;
+        }
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != nullptr) {
+            if (entry->d_name[0] == '.') {
+                continue;
+            }
+            std::ifstream status_file(task_dir + "/" + entry->d_name + "/status");
+            std::string line;
+            while (std::getline(status_file, line)) {
+                // 同时匹配 voluntary_ctxt_switches 与 nonvoluntary_ctxt_switches
+                if (line.find("voluntary_ctxt_switches:") != std::string::npos) {
+                    total += std::atoll(line.c_str() + line.find(':') + 1);
+                }
+            }
+        }
+        closedir(dir);
+        return total;
+    }
+
     int CountOpenFileDescriptors() const {
         int count = 0;
-        DIR* dir = opendir("/proc/self/fd");
+        DIR* dir = opendir((proc_dir_ + "/fd").c_str());
         if (dir) {
             struct dirent* entry;
             while ((entry = readdir(dir)) != nullptr) {
@@ -239,6 +265,7 @@ private:
         return count;
     }
 
+    std::string proc_dir_;
     mutable std::mutex metrics_mutex_;
     mutable std::mutex time_series_mutex_;
     std::atomic<bool> running_;
@@ -250,7 +277,7 @@ private:
 };
 
 // SystemResourceMonitor 实现
-SystemResourceMonitor::SystemResourceMonitor() : impl_(std::make_unique<Impl>()) {}
+SystemResourceMonitor::SystemResourceMonitor(int pid) : impl_(std::make_unique<Impl>(pid)) {}
 SystemResourceMonitor::~SystemResourceMonitor() = default;
 
 void SystemResourceMonitor::Start() { impl_->Start(); }
@@ -271,6 +298,9 @@ double SystemResourceMonitor::GetAverageCpuUsage() const { return impl_->GetAver
  * 1. 空闲状态内存使用
  * 2. 稳定负载下的内存使用
  * 3. 压力测试后的内存泄漏检测
+ *
+ * 独立进程模式（custom_params.server_mode = process）下各阶段只采样服务器进程，
+ * 读数不再混入客户端线程的内存与 CPU。
  */
 class MemoryBenchmark : public Benchmark {
 public:
@@ -302,7 +332,19 @@ public:
         // 阶段1：测量基线内存使用（服务器空闲）
         LOG_INFO("内存基准测试: 阶段1 - 测量基线内存使用");
 
-        SystemResourceMonitor baseline_monitor;
+        // 独立进程模式：先启动服务器进程，再按其 pid 采样
+        std::unique_ptr<ServerProcess> process;
+        if (UseServerProcess(config)) {
+            process = std::make_unique<ServerProcess>(ServerProcessOptions::FromConfig(config));
+            if (!process->Start(result.error_message)) {
+                result.success = false;
+                result.end_time = std::chrono::system_clock::now();
+                return result;
+            }
+        }
+        const int monitored_pid = process ? process->Pid() : 0;
+
+        SystemResourceMonitor baseline_monitor(monitored_pid);
         baseline_monitor.Start();
 
         // 启动服务器但不发送请求
@@ -310,12 +352,13 @@ public:
         std::thread server_thread;
 
         try {
-            server = std::make_unique<Server>(config.server_host, config.server_port, PluginManager::GetInstance());
-            server_thread = std::thread([&server]() {
-                server->Run();
-            });
-
-            std::this_thread::sleep_for(std::chrono::milliseconds(2000));
+            if (!process) {
+                server = std::make_unique<Server>(config.server_host, config.server_port, PluginManager::GetInstance());
+                server_thread = std::thread([&server]() {
+                    server->Run();
+                });
+                std::this_thread::sleep_for(std::chrono::milliseconds(2000));
+            }
             LOG_INFO("内存基准测试: 服务器已启动（空闲状态）");
         } catch (const std::exception& e) {
             result.success = false;
@@ -334,7 +377,7 @@ public:
         // 阶段2：测量稳定负载下的内存使用
         LOG_INFO("内存基准测试: 阶段2 - 测量稳定负载内存使用");
 
-        SystemResourceMonitor load_monitor;
+        SystemResourceMonitor load_monitor(monitored_pid);
         load_monitor.Start();
 
         // 运行稳定负载测试（简化版，复用QPS测试逻辑）
@@ -350,7 +393,7 @@ public:
         // 停止负载测试
         std::this_thread::sleep_for(std::chrono::seconds(3));
 
-        SystemResourceMonitor recovery_monitor;
+        SystemResourceMonitor recovery_monitor(monitored_pid);
         recovery_monitor.Start();
         std::this_thread::sleep_for(std::chrono::seconds(5));
         recovery_monitor.Stop();
@@ -361,6 +404,9 @@ public:
         // 阶段4：停止服务器，最终清理
         LOG_INFO("内存基准测试: 阶段4 - 停止服务器");
 
+        if (process) {
+            process->Stop();
+        }
         if (server) {
             server->Stop();
         }
@@ -391,6 +437,9 @@ public:
                                  "KB", "负载下峰值驻留内存"});
         result.metrics.push_back({"load_avg_cpu_usage", load_monitor.GetAverageCpuUsage(),
                                  "%", "负载下平均CPU使用率"});
+        if (process) {
+            ServerProcess::AppendMetrics(load_monitor, result);
+        }
 
         result.metrics.push_back({"recovery_rss_kb", static_cast<double>(recovery_metrics.rss_kb),
                                  "KB", "恢复后驻留内存"});
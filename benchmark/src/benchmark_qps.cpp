@@ -10,6 +10,8 @@
 #include "../../include/http_request.h"
 #include "../../include/request_validator.h"
 #include "../../include/connection.h"
+#include "../../include/load_generator.h"
+#include "../../include/server_process.h"
 
 #include <atomic>
 #include <chrono>
@@ -247,9 +249,12 @@ public:
         result.name = GetName();
         result.start_time = std::chrono::system_clock::now();
 
+        // 独立进程模式由就绪探测验证服务器，不再跑进程内的最小测试
+        const bool use_process = UseServerProcess(config);
+
         // 首先运行最小测试验证基本功能
         LOG_INFO("QPS基准测试: 开始运行最小测试验证");
-        if (!RunMinimalTest(config)) {
+        if (!use_process && !RunMinimalTest(config)) {
             result.success = false;
             result.error_message = "最小测试验证失败，服务器无法处理请求";
             result.end_time = std::chrono::system_clock::now();
@@ -268,6 +273,10 @@ public:
             return result;
         }
 
+        if (use_process) {
+            return RunWithServerProcess(config, result);
+        }
+
         // 启动服务器（在独立线程中）
         std::unique_ptr<Server> server;
         std::thread server_thread;
@@ -300,7 +309,7 @@ public:
                         // 生成简单响应
                         HttpResponse response;
                         LOG_INFO("基准测试服务器回调: 初始化响应，路径=./public/index.html");
-                        response.Init("./public", "/index.html", false, -1, parser.get());
+                        response.Init("./public", "/index.html", parser->IsKeepAlive(), -1, parser.get());
                         response.MakeResponse();
 
                         LOG_INFO("基准测试服务器回调: 发送响应头部");
@@ -394,73 +403,10 @@ public:
         // 预热阶段
         WarmUp(config);
 
-        // 运行基准测试
-        std::atomic<int64_t> total_requests{0};
-        std::atomic<int64_t> successful_requests{0};
-        std::atomic<int64_t> failed_requests{0};
-        std::atomic<int64_t> total_bytes_received{0};
-
-        std::vector<double> latencies;
-        std::mutex latencies_mutex;
-
-        // 控制测试时间的标志
-        std::atomic<bool> stop_test{false};
-        auto test_start_time = std::chrono::steady_clock::now();
-
-        // 工作线程函数
-        auto worker_func = [&](int worker_id) {
-            std::random_device rd;
-            std::mt19937 gen(rd());
-
-            while (!stop_test) {
-                HttpClient client(config.server_host, config.server_port, config.keep_alive);
-
-                auto result = client.SendRequest(config.request_method, config.request_path,
-                                                config.request_body);
-
-                total_requests++;
-
-                if (result.success) {
-                    successful_requests++;
-                    total_bytes_received += result.response_size;
-
-                    std::lock_guard<std::mutex> lock(latencies_mutex);
-                    latencies.push_back(static_cast<double>(result.latency_ms));
-                } else {
-                    failed_requests++;
-                }
-
-                // 如果设置了目标QPS，控制发送速率
-                if (config.target_qps > 0) {
-                    int64_t requests_per_worker = config.target_qps / config.concurrent_connections;
-                    if (requests_per_worker > 0) {
-                        std::this_thread::sleep_for(std::chrono::milliseconds(1000 / requests_per_worker));
-                    }
-                }
-            }
-        };
-
-        // 启动工作线程
-        std::vector<std::thread> workers;
-        for (int i = 0; i < config.concurrent_connections; ++i) {
-            workers.emplace_back(worker_func, i);
-        }
-
-        // 运行指定时间
-        std::this_thread::sleep_for(std::chrono::duration<double>(config.duration_seconds));
-
-        // 停止测试
-        stop_test = true;
-
-        // 等待所有工作线程完成
-        for (auto& worker : workers) {
-            if (worker.joinable()) {
-                worker.join();
-            }
-        }
-
-        auto test_end_time = std::chrono::steady_clock::now();
-        double test_duration = std::chrono::duration<double>(test_end_time - test_start_time).count();
+        // 运行基准测试：事件驱动客户端，少量线程驱动全部连接；
+        // target_qps > 0 时按固定到达速率开环发送，延迟从计划发送时刻算起
+        LoadGenerator generator(LoadGeneratorOptions::FromConfig(config));
+        LoadGeneratorStats stats = generator.Run();
 
         // 停止服务器
         if (server) {
@@ -470,72 +416,55 @@ public:
             server_thread.join();
         }
 
-        // 计算结果指标
-        double qps = (test_duration > 0) ? successful_requests / test_duration : 0;
-        double throughput_mbps = (test_duration > 0) ?
-            (total_bytes_received * 8.0 / (1024 * 1024)) / test_duration : 0;
-        double error_rate = (total_requests > 0) ?
-            static_cast<double>(failed_requests) / total_requests : 0;
-
-        // 计算延迟统计
-        double avg_latency = 0;
-        double p50_latency = 0;
-        double p90_latency = 0;
-        double p95_latency = 0;
-        double p99_latency = 0;
-        double p999_latency = 0;
-        double min_latency = 0;
-        double max_latency = 0;
-        double stddev_latency = 0;
-
-        if (!latencies.empty()) {
-            std::sort(latencies.begin(), latencies.end());
-
-            double sum_latency = 0;
-            for (double latency : latencies) {
-                sum_latency += latency;
-            }
-            avg_latency = sum_latency / latencies.size();
-
-            p50_latency = Statistics::CalculatePercentile(latencies, 50.0);
-            p90_latency = Statistics::CalculatePercentile(latencies, 90.0);
-            p95_latency = Statistics::CalculatePercentile(latencies, 95.0);
-            p99_latency = Statistics::CalculatePercentile(latencies, 99.0);
-            p999_latency = Statistics::CalculatePercentile(latencies, 99.9);
-            min_latency = Statistics::CalculateMin(latencies);
-            max_latency = Statistics::CalculateMax(latencies);
-            stddev_latency = Statistics::CalculateStdDev(latencies);
+        FillResult(config, stats, result);
+
+        // 清理阶段
+        CleanUp(config);
+
+        return result;
+    }
+
+    /**
+     * @brief 独立进程模式：fork/exec server，只对服务器进程采样资源
+     */
+    BenchmarkResult RunWithServerProcess(const BenchmarkConfig& config, BenchmarkResult& result) {
+        system("mkdir -p public");
+        system("test -f public/index.html || echo '<h1>TinyWebServer Benchmark Test</h1>' > public/index.html");
+
+        ServerProcess process(ServerProcessOptions::FromConfig(config));
+        if (!process.Start(result.error_message)) {
+            result.success = false;
+            result.end_time = std::chrono::system_clock::now();
+            return result;
         }
 
-        // 填充结果
-        result.success = true;
-        result.duration_seconds = test_duration;
-        result.end_time = std::chrono::system_clock::now();
+        WarmUp(config);
 
-        // 添加指标
-        result.metrics.push_back({"qps", qps, "requests/second", "每秒查询数"});
-        result.metrics.push_back({"throughput_mbps", throughput_mbps, "Mbps", "网络吞吐量"});
-        result.metrics.push_back({"total_requests", static_cast<double>(total_requests), "requests", "总请求数"});
-        result.metrics.push_back({"successful_requests", static_cast<double>(successful_requests), "requests", "成功请求数"});
-        result.metrics.push_back({"failed_requests", static_cast<double>(failed_requests), "requests", "失败请求数"});
-        result.metrics.push_back({"error_rate", error_rate * 100, "%", "错误率"});
-        result.metrics.push_back({"avg_latency", avg_latency, "ms", "平均延迟"});
-        result.metrics.push_back({"p50_latency", p50_latency, "ms", "50%分位延迟"});
-        result.metrics.push_back({"p90_latency", p90_latency, "ms", "90%分位延迟"});
-        result.metrics.push_back({"p95_latency", p95_latency, "ms", "95%分位延迟"});
-        result.metrics.push_back({"p99_latency", p99_latency, "ms", "99%分位延迟"});
-        result.metrics.push_back({"p999_latency", p999_latency, "ms", "99.9%分位延迟"});
-        result.metrics.push_back({"min_latency", min_latency, "ms", "最小延迟"});
-        result.metrics.push_back({"max_latency", max_latency, "ms", "最大延迟"});
-        result.metrics.push_back({"stddev_latency", stddev_latency, "ms", "延迟标准差"});
-        result.metrics.push_back({"concurrent_connections", static_cast<double>(config.concurrent_connections), "connections", "并发连接数"});
+        SystemResourceMonitor monitor(process.Pid());
+        monitor.Start();
+        LoadGeneratorStats stats = LoadGenerator(LoadGeneratorOptions::FromConfig(config)).Run();
+        monitor.Stop();
+        process.Stop();
 
-        // 清理阶段
+        FillResult(config, stats, result);
+        ServerProcess::AppendMetrics(monitor, result);
         CleanUp(config);
+        return result;
+    }
+
+    void FillResult(const BenchmarkConfig& config, const LoadGeneratorStats& stats, BenchmarkResult& result) {
+        result.success = stats.completed > 0;
+        if (!result.success) {
+            result.error_message = "没有完成任何请求";
+        }
+        result.duration_seconds = stats.elapsed_seconds;
+        result.end_time = std::chrono::system_clock::now();
 
-        LOG_INFO("QPS基准测试完成: QPS=%.2f, 延迟P99=%.2fms", qps, p99_latency);
+        LoadGenerator::AppendMetrics(stats, result);
+        result.metrics.push_back({"concurrent_connections", static_cast<double>(config.concurrent_connections), "connections", "并发连接数"});
 
-        return result;
+        LOG_INFO("QPS基准测试完成: QPS=%.2f, 延迟P99=%.2fms", stats.Qps(),
+                 stats.corrected.Percentile(0.99) / 1e6);
     }
 
     void WarmUp(const BenchmarkConfig& config) override {
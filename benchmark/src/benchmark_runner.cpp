@@ -526,7 +526,9 @@ void PrintHelp() {
     std::cout << "  list     列出可用的基准测试类型\n";
     std::cout << "  help     显示此帮助信息\n\n";
     std::cout << "运行命令选项:\n";
-    std::cout << "  --type <type>          基准测试类型 (qps, latency, memory, concurrent)\n";
+    std::cout << "  --type <type>          基准测试类型 (qps, latency, memory, concurrent, step_stress, http2,\n";
+    std::cout << "                         pipeline, static_mix, large_file, replay,\n";
+    std::cout << "                         connection_memory)\n";
     std::cout << "  --config <file>        配置文件路径\n";
     std::cout << "  --output <dir>         输出目录 (默认: benchmark_results/<timestamp>)\n";
     std::cout << "  --baseline <dir>       基线结果目录，用于对比\n";
@@ -0,0 +1,853 @@
+/**
+ * @file benchmark_static_traffic.cpp
+ * @brief 贴近真实静态流量的基准测试：流水线、Zipf 混合对象、大文件传输、轨迹回放
+ *
+ * 四种类型共用一个按流水线循环处理请求的静态文件服务器：
+ * - pipeline：同一连接上一次写出 1~64 个 GET，按深度分阶段测 QPS 与延迟
+ * - static_mix：在生成的大/中/小文件语料上按 Zipf 分布取路径，
+ *   观察 StaticResourceManager 的命中率与淘汰
+ * - large_file：反复下载大文件，测 Gb/s 与每 GB 消耗的 CPU 时间
+ * - replay：回放服务器录下的访问轨迹，对照回放延迟与记录延迟
+ */
+
+#include "../../include/benchmark.h"
+#include "../../include/server.h"
+#include "../../include/Logger.h"
+#include "../../include/http_response.h"
+#include "../../include/http_request.h"
+#include "../../include/connection.h"
+#include "../../include/static_resource_manager.h"
+#include "../../include/load_generator.h"
+#include "../../include/access_trace.h"
+#include "../../include/server_process.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <netinet/in.h>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+namespace tinywebserver {
+namespace benchmark {
+
+namespace {
+
+const char kDocRoot[] = "./public";
+const char kCorpusDir[] = "bench_traffic";
+// StaticResourceManager 的默认缓存上限，static_mix 调小后恢复为该值
+constexpr size_t kDefaultCacheLimit = 512ull * 1024 * 1024;
+
+std::string GetParam(const BenchmarkConfig& config, const std::string& name, const std::string& default_value) {
+    for (const auto& param : config.custom_params) {
+        if (param.first == name) {
+            return param.second;
+        }
+    }
+    return default_value;
+}
+
+double GetDoubleParam(const BenchmarkConfig& config, const std::string& name, double default_value) {
+    try {
+        return std::stod(GetParam(config, name, std::to_string(default_value)));
+    } catch (...) {
+        LOG_WARN("无效的参数 %s，使用默认值 %.2f", name.c_str(), default_value);
+        return default_value;
+    }
+}
+
+bool BadConfig(const BenchmarkConfig& config, BenchmarkResult& result) {
+    auto errors = config.Validate();
+    if (errors.empty()) {
+        return false;
+    }
+    result.success = false;
+    result.error_message = "配置验证失败: ";
+    for (const auto& error : errors) {
+        result.error_message += error + "; ";
+    }
+    result.end_time = std::chrono::system_clock::now();
+    return true;
+}
+
+/// 进程 CPU 时间（用户态, 内核态），秒
+std::pair<double, double> ProcessCpuSeconds() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return {usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6,
+            usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6};
+}
+
+/**
+ * @brief 生成指定大小的文件；已存在且大小一致时直接复用
+ */
+bool EnsureFile(const std::string& path, size_t size) {
+    struct stat st;
+    if (::stat(path.c_str(), &st) == 0 && static_cast<size_t>(st.st_size) == size) {
+        return true;
+    }
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        LOG_ERROR("创建语料文件失败 %s: %s", path.c_str(), strerror(errno));
+        return false;
+    }
+    static const std::string kChunk = [] {
+        std::string chunk(1024 * 1024, '\0');
+        for (size_t i = 0; i < chunk.size(); ++i) {
+            chunk[i] = static_cast<char>('a' + i % 26);
+        }
+        return chunk;
+    }();
+    size_t left = size;
+    while (left > 0) {
+        size_t n = std::min(left, kChunk.size());
+        ssize_t written = ::write(fd, kChunk.data(), n);
+        if (written <= 0) {
+            LOG_ERROR("写入语料文件失败 %s: %s", path.c_str(), strerror(errno));
+            ::close(fd);
+            return false;
+        }
+        left -= static_cast<size_t>(written);
+    }
+    ::close(fd);
+    return true;
+}
+
+/**
+ * @brief 基准测试用静态文件服务器
+ *
+ * 与 main.cpp 相同，循环处理输入缓冲区中的全部完整请求，流水线请求按序应答。
+ * server_mode = process 时改为启动独立的 server 进程，并在运行期间采样其资源。
+ */
+class StaticFileServer {
+public:
+    ~StaticFileServer() { Stop(); }
+
+    bool Start(const BenchmarkConfig& config, std::string& error) {
+        system("mkdir -p public");
+        system("test -f public/index.html || echo '<h1>TinyWebServer Benchmark Test</h1>' > public/index.html");
+        if (UseServerProcess(config)) {
+            process_ = std::make_unique<ServerProcess>(ServerProcessOptions::FromConfig(config));
+            if (!process_->Start(error)) {
+                process_.reset();
+                return false;
+            }
+            monitor_ = std::make_unique<SystemResourceMonitor>(process_->Pid());
+            monitor_->Start();
+            return true;
+        }
+        try {
+
+            server_ = std::make_unique<Server>(config.server_host, config.server_port, PluginManager::GetInstance());
+            server_->SetOnMessage([](std::shared_ptr<Connection> conn, const std::string& /*data*/) {
+                auto parser = conn->GetHttpParser();
+                auto& buffer = conn->GetInputBuffer();
+                while (true) {
+                    size_t header_end = buffer.find("\r\n\r\n");
+                    if (header_end == std::string::npos) {
+                        break;
+                    }
+                    if (!parser->Parse(buffer)) {
+                        buffer.clear();
+                        conn->Shutdown();
+                        break;
+                    }
+                    HttpResponse response;
+                    response.SetResourceProvider([&conn](const std::string& full_path, bool& pending) {
+                        return conn->AcquireStaticResource(full_path, pending);
+                    });
+                    response.Init(kDocRoot, parser->GetPath(), parser->IsKeepAlive(), -1, parser.get());
+                    response.MakeResponse();
+                    if (response.IsPending()) {
+                        parser->Reset();   // 加载完成后连接重新调用本回调
+                        break;
+                    }
+                    conn->Send(response.GetHeaderString());
+                    if (response.HasFileBody()) {
+                        conn->Send(response.GetFileBody());
+                    } else {
+                        conn->Send(response.GetBodyString());
+                    }
+                    buffer.erase(0, header_end + 4);
+                    parser->Reset();
+                }
+            });
+            thread_ = std::thread([this]() {
+                server_->Start();
+                server_->Run();
+            });
+        } catch (const std::exception& e) {
+            error = std::string("启动服务器失败: ") + e.what();
+            return false;
+        }
+        if (!WaitListening(config)) {
+            error = "服务器端口无法连接，可能服务器未正确启动";
+            Stop();
+            return false;
+        }
+        return true;
+    }
+
+    void Stop() {
+        if (monitor_) {
+            monitor_->Stop();   // 先停采样，避免采到进程退出后的空读数
+        }
+        process_.reset();
+        if (server_) {
+            server_->Stop();
+        }
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+        server_.reset();
+    }
+
+    /// 独立进程模式下服务器进程的资源采样，进程内模式为 nullptr（Stop 后仍可读取）
+    const SystemResourceMonitor* Monitor() const { return monitor_.get(); }
+
+    /// 独立进程模式下追加 server_ 前缀的资源指标
+    void AppendServerMetrics(BenchmarkResult& result) const {
+        if (monitor_) {
+            ServerProcess::AppendMetrics(*monitor_, result);
+        }
+    }
+
+private:
+    /// 轮询连接端口直到服务器开始监听（最多 5 秒）
+    static bool WaitListening(const BenchmarkConfig& config) {
+        struct sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(config.server_port));
+        inet_pton(AF_INET, config.server_host.c_str(), &addr.sin_addr);
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (std::chrono::steady_clock::now() < deadline) {
+            int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            bool ok = fd >= 0 && connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == 0;
+            if (fd >= 0) {
+                close(fd);
+            }
+            if (ok) {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        return false;
+    }
+
+    std::unique_ptr<Server> server_;
+    std::thread thread_;
+    std::unique_ptr<ServerProcess> process_;
+    std::unique_ptr<SystemResourceMonitor> monitor_;
+};
+
+std::vector<int> ParseIntList(const std::string& text) {
+    std::vector<int> values;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        try {
+            int value = std::stoi(item);
+            if (value > 0) {
+                values.push_back(value);
+            }
+        } catch (...) {
+            LOG_WARN("忽略无效的列表项: %s", item.c_str());
+        }
+    }
+    return values;
+}
+
+} // namespace
+
+// ==================== pipeline ====================
+
+/**
+ * @brief HTTP/1.1 流水线基准测试
+ *
+ * custom_params:
+ * - depths：逗号分隔的流水线深度（默认 "1,4,16,64"），每个深度一个阶段
+ * - stage_duration：每阶段秒数（默认 duration_seconds / 阶段数）
+ */
+class PipelineBenchmark : public Benchmark {
+public:
+    std::string GetName() const override {
+        return "pipeline_benchmark";
+    }
+
+    std::string GetDescription() const override {
+        return "HTTP/1.1 流水线 GET（深度 1~64）下的 QPS 与延迟";
+    }
+
+    BenchmarkResult Run(const BenchmarkConfig& config) override {
+        BenchmarkResult result;
+        result.name = GetName();
+        result.start_time = std::chrono::system_clock::now();
+        if (BadConfig(config, result)) {
+            return result;
+        }
+
+        std::vector<int> depths = ParseIntList(GetParam(config, "depths", "1,4,16,64"));
+        if (depths.empty()) {
+            depths = {1};
+        }
+        double stage_duration = GetDoubleParam(config, "stage_duration",
+                                               std::max(1.0, config.duration_seconds / static_cast<double>(depths.size())));
+
+        StaticFileServer server;
+        if (!server.Start(config, result.error_message)) {
+            result.success = false;
+            result.end_time = std::chrono::system_clock::now();
+            return result;
+        }
+
+        double depth1_qps = 0;
+        double best_qps = 0;
+        int best_depth = 0;
+        int64_t total_completed = 0;
+        for (int depth : depths) {
+            LoadGeneratorOptions options = LoadGeneratorOptions::FromConfig(config);
+            options.pipeline_depth = depth;
+            options.duration_seconds = stage_duration;
+            LoadGeneratorStats stats = LoadGenerator(options).Run();
+            total_completed += stats.completed;
+
+            BenchmarkResult stage;
+            LoadGenerator::AppendMetrics(stats, stage);
+            std::string prefix = "depth_" + std::to_string(depth) + "_";
+            for (const auto& name : {"qps", "throughput_mbps", "error_rate", "p50_latency", "p99_latency", "max_latency"}) {
+                for (const auto& metric : stage.metrics) {
+                    if (metric.name == name) {
+                        BenchmarkResult::Metric renamed = metric;
+                        renamed.name = prefix + metric.name;
+                        renamed.description = "深度" + std::to_string(depth) + " " + metric.description;
+                        result.metrics.push_back(renamed);
+                    }
+                }
+            }
+
+            double qps = stats.Qps();
+            if (depth == 1) {
+                depth1_qps = qps;
+            }
+            if (qps > best_qps) {
+                best_qps = qps;
+                best_depth = depth;
+            }
+            LOG_INFO("流水线基准测试: 深度 %d, QPS=%.2f, P99=%.2fms, 失败 %lld", depth, qps,
+                     stats.corrected.Percentile(0.99) / 1e6, static_cast<long long>(stats.Failed()));
+        }
+        server.Stop();
+        server.AppendServerMetrics(result);
+
+        result.metrics.push_back({"qps", best_qps, "requests/second", "各深度中的最高 QPS"});
+        result.metrics.push_back({"best_depth", static_cast<double>(best_depth), "requests", "最高 QPS 对应的流水线深度"});
+        if (depth1_qps > 0) {
+            result.metrics.push_back({"pipeline_speedup", best_qps / depth1_qps, "x", "最高 QPS 相对深度 1 的倍数"});
+        }
+        result.metrics.push_back({"concurrent_connections", static_cast<double>(config.concurrent_connections),
+                                  "connections", "并发连接数"});
+
+        result.success = total_completed > 0;
+        if (!result.success) {
+            result.error_message = "没有完成任何请求";
+        }
+        result.end_time = std::chrono::system_clock::now();
+        result.duration_seconds = std::chrono::duration<double>(result.end_time - result.start_time).count();
+        return result;
+    }
+};
+
+// ==================== static_mix ====================
+
+/**
+ * @brief Zipf 分布的静态对象混合基准测试
+ *
+ * 生成 file_count 个文件：约 80% 为 512B~16KB，18% 为 32KB~256KB，2% 为 1MB~4MB，
+ * 大小与热度相互独立。请求序列按 Zipf(s) 抽样，缓存上限调小以触发淘汰。
+ * scan_ratio > 0 时按该比例插入按文件顺序遍历整个语料的爬虫式扫描请求。
+ *
+ * HTTP 负载之前，先把同一请求序列按顺序直接回放给 StaticResourceManager，
+ * 对 compare_policies 中的每种策略从冷缓存开始各跑一遍，得到确定性的
+ * 命中率与字节命中率（未命中字节即需要从磁盘读入的量）。
+ *
+ * custom_params:
+ * - file_count：语料文件数（默认 1000）
+ * - zipf_s：Zipf 指数（默认 1.0，越大越集中）
+ * - cache_limit_mb：测试期间的静态资源缓存上限（默认 32）
+ * - sequence_length：预生成的请求序列长度（默认 50000），各连接轮转使用
+ * - seed：随机种子（默认 42）
+ * - scan_ratio：扫描请求占比（默认 0）
+ * - cache_policy：HTTP 负载期间的缓存策略（默认 lru）
+ * - compare_policies：逐一回放比较的策略，逗号分隔（默认 lru,wtinylfu,wtinylfu_size，空串跳过）
+ */
+class StaticMixBenchmark : public Benchmark {
+public:
+    std::string GetName() const override {
+        return "static_mix_benchmark";
+    }
+
+    std::string GetDescription() const override {
+        return "Zipf 分布的大/中/小静态文件混合负载，观察缓存命中率与淘汰";
+    }
+
+    BenchmarkResult Run(const BenchmarkConfig& config) override {
+        BenchmarkResult result;
+        result.name = GetName();
+        result.start_time = std::chrono::system_clock::now();
+        if (BadConfig(config, result)) {
+            return result;
+        }
+
+        int file_count = std::max(1, static_cast<int>(GetDoubleParam(config, "file_count", 1000)));
+        double zipf_s = GetDoubleParam(config, "zipf_s", 1.0);
+        double cache_limit_mb = GetDoubleParam(config, "cache_limit_mb", 32);
+        int sequence_length = std::max(1, static_cast<int>(GetDoubleParam(config, "sequence_length", 50000)));
+        uint32_t seed = static_cast<uint32_t>(GetDoubleParam(config, "seed", 42));
+        double scan_ratio = std::min(1.0, std::max(0.0, GetDoubleParam(config, "scan_ratio", 0)));
+        CachePolicy cache_policy;
+        std::string policy_name = GetParam(config, "cache_policy", "lru");
+        if (!ParseCachePolicy(policy_name, cache_policy)) {
+            result.success = false;
+            result.error_message = "无效的 cache_policy: " + policy_name;
+            result.end_time = std::chrono::system_clock::now();
+            return result;
+        }
+        std::vector<CachePolicy> compare_policies;
+        std::stringstream policy_list(GetParam(config, "compare_policies", "lru,wtinylfu,wtinylfu_size"));
+        std::string item;
+        while (std::getline(policy_list, item, ',')) {
+            CachePolicy policy;
+            if (item.empty()) {
+                continue;
+            }
+            if (!ParseCachePolicy(item, policy)) {
+                result.success = false;
+                result.error_message = "无效的 compare_policies 项: " + item;
+                result.end_time = std::chrono::system_clock::now();
+                return result;
+            }
+            compare_policies.push_back(policy);
+        }
+
+        // 生成语料
+        std::mt19937 rng(seed);
+        std::string dir = std::string(kCorpusDir) + "/mix";
+        system(("mkdir -p " + std::string(kDocRoot) + "/" + dir).c_str());
+        std::vector<std::pair<std::string, size_t>> files;
+        uint64_t corpus_bytes = 0;
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        for (int i = 0; i < file_count; ++i) {
+            double pick = unit(rng);
+            size_t size;
+            if (pick < 0.80) {
+                size = std::uniform_int_distribution<size_t>(512, 16 * 1024)(rng);
+            } else if (pick < 0.98) {
+                size = std::uniform_int_distribution<size_t>(32 * 1024, 256 * 1024)(rng);
+            } else {
+                size = std::uniform_int_distribution<size_t>(1024 * 1024, 4 * 1024 * 1024)(rng);
+            }
+            std::string path = "/" + dir + "/obj_" + std::to_string(i) + "_" + std::to_string(size) + ".bin";
+            if (!EnsureFile(kDocRoot + path, size)) {
+                result.success = false;
+                result.error_message = "生成语料失败: " + path;
+                result.end_time = std::chrono::system_clock::now();
+                return result;
+            }
+            files.emplace_back(path, size);
+            corpus_bytes += size;
+        }
+        // 扫描按生成顺序遍历；热度排名与文件的对应关系随机打乱，避免热度与大小相关
+        std::vector<int> scan_order(file_count);
+        std::iota(scan_order.begin(), scan_order.end(), 0);
+        std::shuffle(scan_order.begin(), scan_order.end(), rng);
+        std::vector<std::string> paths;
+        std::vector<size_t> sizes;
+        for (int index : scan_order) {
+            paths.push_back(files[index].first);
+            sizes.push_back(files[index].second);
+        }
+        std::vector<int> scan_rank(file_count);   // 生成顺序 -> 热度排名
+        for (int rank = 0; rank < file_count; ++rank) {
+            scan_rank[scan_order[rank]] = rank;
+        }
+
+        // Zipf 累积分布，按排名抽样生成请求序列
+        std::vector<double> cdf(file_count);
+        double sum = 0;
+        for (int rank = 0; rank < file_count; ++rank) {
+            sum += 1.0 / std::pow(rank + 1, zipf_s);
+            cdf[rank] = sum;
+        }
+        LoadGeneratorOptions options = LoadGeneratorOptions::FromConfig(config);
+        options.requests.clear();
+        options.requests.reserve(sequence_length);
+        std::vector<bool> touched(file_count, false);
+        std::vector<int> sequence;
+        sequence.reserve(sequence_length);
+        int scan_position = 0;
+        for (int i = 0; i < sequence_length; ++i) {
+            int rank;
+            if (scan_ratio > 0 && unit(rng) < scan_ratio) {
+                rank = scan_rank[scan_position];
+                scan_position = (scan_position + 1) % file_count;
+            } else {
+                double u = unit(rng) * sum;
+                rank = static_cast<int>(std::lower_bound(cdf.begin(), cdf.end(), u) - cdf.begin());
+                rank = std::min(rank, file_count - 1);
+            }
+            touched[rank] = true;
+            sequence.push_back(rank);
+            options.requests.push_back(LoadGenerator::BuildRequest("GET", paths[rank], config.server_host,
+                                                                   "", config.keep_alive));
+        }
+
+        auto& manager = StaticResourceManager::GetInstance();
+        manager.SetCacheLimit(static_cast<size_t>(cache_limit_mb * 1024 * 1024));
+
+        // 各策略离线回放同一序列
+        for (CachePolicy policy : compare_policies) {
+            manager.SetCachePolicy(policy);
+            auto before = manager.GetStatus();
+            uint64_t total_bytes = 0;
+            uint64_t miss_bytes = 0;
+            for (int rank : sequence) {
+                uint64_t hits = manager.GetStatus().cache_hits;
+                manager.GetResource(kDocRoot + paths[rank]);
+                total_bytes += sizes[rank];
+                if (manager.GetStatus().cache_hits == hits) {
+                    miss_bytes += sizes[rank];
+                }
+            }
+            auto after = manager.GetStatus();
+            uint64_t lookups = after.total_requests - before.total_requests;
+            uint64_t hits = after.cache_hits - before.cache_hits;
+            std::string name = CachePolicyName(policy);
+            result.metrics.push_back({name + "_hit_ratio", lookups > 0 ? 100.0 * hits / lookups : 0, "%",
+                                      name + " 策略回放请求序列的命中率"});
+            result.metrics.push_back({name + "_byte_hit_ratio",
+                                      total_bytes > 0 ? 100.0 * (total_bytes - miss_bytes) / total_bytes : 0, "%",
+                                      name + " 策略回放请求序列的字节命中率"});
+            result.metrics.push_back({name + "_miss_mb", miss_bytes / (1024.0 * 1024.0), "MB",
+                                      name + " 策略未命中需从磁盘读入的字节"});
+            result.metrics.push_back({name + "_evictions", static_cast<double>(after.evictions - before.evictions),
+                                      "count", name + " 策略淘汰的文件数"});
+            LOG_INFO("混合对象基准测试: %s 回放命中率 %.1f%%", name.c_str(), lookups > 0 ? 100.0 * hits / lookups : 0);
+        }
+        manager.SetCachePolicy(cache_policy);
+
+        StaticFileServer server;
+        if (!server.Start(config, result.error_message)) {
+            manager.SetCacheLimit(kDefaultCacheLimit);
+            manager.SetCachePolicy(CachePolicy::kLru);
+            result.success = false;
+            result.end_time = std::chrono::system_clock::now();
+            return result;
+        }
+
+        auto status_before = manager.GetStatus();
+        LoadGeneratorStats stats = LoadGenerator(options).Run();
+        auto status_after = manager.GetStatus();
+        server.Stop();
+        manager.SetCacheLimit(kDefaultCacheLimit);
+        manager.SetCachePolicy(CachePolicy::kLru);
+
+        uint64_t lookups = status_after.total_requests - status_before.total_requests;
+        uint64_t hits = status_after.cache_hits - status_before.cache_hits;
+
+        LoadGenerator::AppendMetrics(stats, result);
+        if (server.Monitor()) {
+            // 缓存在服务器进程内，本进程读不到其命中率，cache_limit_mb 也不生效
+            LOG_WARN("混合对象基准测试: 独立进程模式下不报告缓存指标");
+            server.AppendServerMetrics(result);
+        } else {
+            result.metrics.push_back({"cache_hit_ratio", lookups > 0 ? 100.0 * hits / lookups : 0, "%",
+                                      "静态资源缓存命中率"});
+            result.metrics.push_back({"cache_misses", static_cast<double>(lookups - hits), "lookups",
+                                      "未命中（需 open + mmap）的查询数"});
+            result.metrics.push_back({"cache_memory_mb", status_after.current_memory_usage / (1024.0 * 1024.0), "MB",
+                                      "结束时缓存占用"});
+            result.metrics.push_back({"cached_files", static_cast<double>(status_after.cached_files_count), "files",
+                                      "结束时缓存的文件数"});
+            result.metrics.push_back({"cache_limit_mb", cache_limit_mb, "MB", "缓存上限"});
+            result.metrics.push_back({"cache_rejected_admissions",
+                                      static_cast<double>(status_after.rejected_admissions - status_before.rejected_admissions),
+                                      "count", "准入比较失败、未进入主区的文件数"});
+        }
+        result.metrics.push_back({"corpus_files", static_cast<double>(file_count), "files", "语料文件数"});
+        result.metrics.push_back({"corpus_mb", corpus_bytes / (1024.0 * 1024.0), "MB", "语料总大小"});
+        result.metrics.push_back({"distinct_files_requested",
+                                  static_cast<double>(std::count(touched.begin(), touched.end(), true)),
+                                  "files", "请求序列覆盖的文件数"});
+        result.metrics.push_back({"zipf_s", zipf_s, "", "Zipf 指数"});
+        result.metrics.push_back({"scan_ratio", scan_ratio * 100, "%", "爬虫式扫描请求占比"});
+
+        result.success = stats.completed > 0;
+        if (!result.success) {
+            result.error_message = "没有完成任何请求";
+        }
+        result.duration_seconds = stats.elapsed_seconds;
+        result.end_time = std::chrono::system_clock::now();
+        LOG_INFO("混合对象基准测试完成: QPS=%.2f, %s 命中率=%.1f%%", stats.Qps(), policy_name.c_str(),
+                 lookups > 0 ? 100.0 * hits / lookups : 0);
+        return result;
+    }
+};
+
+// ==================== large_file ====================
+
+/**
+ * @brief 大文件传输吞吐基准测试
+ *
+ * 每条连接反复下载同一个大文件，CPU 时间取整个进程（服务器与客户端在同一进程内），
+ * 因此 cpu_seconds_per_gb 是收发两端合计的上界；独立进程模式下它只含客户端，
+ * 另给出只含服务器的 server_cpu_seconds_per_gb。
+ *
+ * custom_params:
+ * - file_size_mb：文件大小（默认 256）
+ */
+class LargeFileBenchmark : public Benchmark {
+public:
+    std::string GetName() const override {
+        return "large_file_benchmark";
+    }
+
+    std::string GetDescription() const override {
+        return "大文件下载吞吐（Gb/s）与每 GB 的 CPU 时间";
+    }
+
+    BenchmarkResult Run(const BenchmarkConfig& config) override {
+        BenchmarkResult result;
+        result.name = GetName();
+        result.start_time = std::chrono::system_clock::now();
+        if (BadConfig(config, result)) {
+            return result;
+        }
+
+        double file_size_mb = std::max(1.0, GetDoubleParam(config, "file_size_mb", 256));
+        size_t file_size = static_cast<size_t>(file_size_mb * 1024 * 1024);
+        system(("mkdir -p " + std::string(kDocRoot) + "/" + kCorpusDir).c_str());
+        std::string path = "/" + std::string(kCorpusDir) + "/large_" + std::to_string(file_size) + ".bin";
+        if (!EnsureFile(kDocRoot + path, file_size)) {
+            result.success = false;
+            result.error_message = "生成大文件失败: " + path;
+            result.end_time = std::chrono::system_clock::now();
+            return result;
+        }
+
+        StaticFileServer server;
+        if (!server.Start(config, result.error_message)) {
+            result.success = false;
+            result.end_time = std::chrono::system_clock::now();
+            return result;
+        }
+
+        LoadGeneratorOptions options = LoadGeneratorOptions::FromConfig(config);
+        options.requests = {LoadGenerator::BuildRequest("GET", path, config.server_host, "", config.keep_alive)};
+        if (GetParam(config, "request_timeout_ms", "").empty()) {
+            options.request_timeout_ms = 120000;
+        }
+
+        auto cpu_before = ProcessCpuSeconds();
+        LoadGeneratorStats stats = LoadGenerator(options).Run();
+        auto cpu_after = ProcessCpuSeconds();
+        server.Stop();
+
+        double gigabytes = stats.bytes_received / 1e9;
+        double user = cpu_after.first - cpu_before.first;
+        double sys = cpu_after.second - cpu_before.second;
+
+        LoadGenerator::AppendMetrics(stats, result);
+        result.metrics.push_back({"transferred_gb", gigabytes, "GB", "接收字节数（含响应头）"});
+        result.metrics.push_back({"throughput_gbps", stats.elapsed_seconds > 0 ? gigabytes * 8 / stats.elapsed_seconds : 0,
+                                  "Gb/s", "传输吞吐"});
+        result.metrics.push_back({"cpu_seconds_per_gb", gigabytes > 0 ? (user + sys) / gigabytes : 0, "s/GB",
+                                  "每 GB 消耗的进程 CPU 时间（收发合计）"});
+        result.metrics.push_back({"user_cpu_seconds_per_gb", gigabytes > 0 ? user / gigabytes : 0, "s/GB",
+                                  "每 GB 用户态 CPU 时间"});
+        result.metrics.push_back({"sys_cpu_seconds_per_gb", gigabytes > 0 ? sys / gigabytes : 0, "s/GB",
+                                  "每 GB 内核态 CPU 时间"});
+        result.metrics.push_back({"file_size_mb", file_size_mb, "MB", "文件大小"});
+        if (const SystemResourceMonitor* monitor = server.Monitor()) {
+            auto series = monitor->GetTimeSeries();
+            double server_cpu = series.size() >= 2
+                ? (series.back().cpu_time_ms - series.front().cpu_time_ms) / 1000.0 : 0;
+            result.metrics.push_back({"server_cpu_seconds_per_gb", gigabytes > 0 ? server_cpu / gigabytes : 0, "s/GB",
+                                      "每 GB 消耗的服务器进程 CPU 时间"});
+            server.AppendServerMetrics(result);
+        }
+
+        result.success = stats.completed > 0;
+        if (!result.success) {
+            result.error_message = "没有完成任何下载";
+        }
+        result.duration_seconds = stats.elapsed_seconds;
+        result.end_time = std::chrono::system_clock::now();
+        LOG_INFO("大文件基准测试完成: %.2f GB, %.2f Gb/s", gigabytes,
+                 stats.elapsed_seconds > 0 ? gigabytes * 8 / stats.elapsed_seconds : 0);
+        return result;
+    }
+};
+
+// ==================== replay ====================
+
+/**
+ * @brief 访问轨迹回放基准测试
+ *
+ * 读取服务器以 metrics.access_trace_path 录下的轨迹，按原到达间隔（除以加速因子）
+ * 和每条连接上的请求顺序对本地静态文件服务器回放，并把测得延迟与轨迹中的
+ * 记录延迟对照。记录延迟在服务器侧测得（读入首字节到写出末字节），
+ * 对照时取回放的服务延迟；两者之比反映回放环境与录制环境的差异。
+ * 轨迹中的路径按 ./public 解析，不存在的文件计为非 2xx。
+ *
+ * custom_params:
+ * - trace_file：轨迹文件路径（必填）
+ * - speedup：时间加速因子（默认 1，2 表示以两倍速率回放）
+ * - max_connections：连接数上限（默认 1000），超出的连接编号取模复用
+ *
+ * duration_seconds 限制回放的时长（加速后），超出部分的记录不回放。
+ */
+class ReplayBenchmark : public Benchmark {
+public:
+    std::string GetName() const override {
+        return "replay_benchmark";
+    }
+
+    std::string GetDescription() const override {
+        return "按到达间隔与连接顺序回放访问轨迹，并与记录延迟对照";
+    }
+
+    BenchmarkResult Run(const BenchmarkConfig& config) override {
+        BenchmarkResult result;
+        result.name = GetName();
+        result.start_time = std::chrono::system_clock::now();
+        if (BadConfig(config, result)) {
+            return result;
+        }
+
+        std::string trace_file = GetParam(config, "trace_file", "");
+        double speedup = GetDoubleParam(config, "speedup", 1.0);
+        int max_connections = static_cast<int>(GetDoubleParam(config, "max_connections", 1000));
+        std::vector<AccessTraceRecord> records;
+        Error err = trace_file.empty()
+            ? Error(WebError::kInvalidArgument, "缺少参数 trace_file")
+            : AccessTraceReader::ReadAll(trace_file, records);
+        if (err.IsFailure() || records.empty() || speedup <= 0 || max_connections <= 0) {
+            result.success = false;
+            result.error_message = err.IsFailure() ? err.ToString() : "轨迹为空或参数无效";
+            result.end_time = std::chrono::system_clock::now();
+            return result;
+        }
+
+        // 轨迹按完成顺序写入，回放按到达顺序
+        std::stable_sort(records.begin(), records.end(), [](const AccessTraceRecord& a, const AccessTraceRecord& b) {
+            return a.timestamp_ns < b.timestamp_ns;
+        });
+
+        LoadGeneratorOptions options = LoadGeneratorOptions::FromConfig(config);
+        options.requests.clear();
+        std::unordered_map<std::string, size_t> request_index;
+        std::unordered_map<uint64_t, int> connection_index;
+        LatencyHistogram recorded;
+        uint64_t recorded_bytes = 0;
+        uint64_t first_ns = records.front().timestamp_ns;
+        double last_offset = 0;
+        for (const auto& record : records) {
+            double offset = (record.timestamp_ns - first_ns) / 1e9 / speedup;
+            if (offset > config.duration_seconds) {
+                break;
+            }
+            std::string method = record.method == TraceMethod::kOther ? "GET" : TraceMethodName(record.method);
+            std::string key = method + " " + record.path;
+            auto [it, inserted] = request_index.emplace(key, options.requests.size());
+            if (inserted) {
+                options.requests.push_back(LoadGenerator::BuildRequest(method, record.path, config.server_host,
+                                                                       "", config.keep_alive));
+            }
+            auto conn = connection_index.emplace(record.connection_id, static_cast<int>(connection_index.size())).first;
+            options.schedule.push_back({offset, conn->second % max_connections, it->second});
+            recorded.Record(record.latency_ns);
+            recorded_bytes += record.response_bytes;
+            last_offset = offset;
+        }
+        // 最后一个请求发出后留出一个请求超时用于收尾
+        options.duration_seconds = last_offset + options.request_timeout_ms / 1000.0 + 1;
+
+        StaticFileServer server;
+        if (!server.Start(config, result.error_message)) {
+            result.success = false;
+            result.end_time = std::chrono::system_clock::now();
+            return result;
+        }
+        LOG_INFO("回放 %zu 条请求（%zu 条连接，%.2fx）: %s", options.schedule.size(), connection_index.size(),
+                 speedup, trace_file.c_str());
+        LoadGeneratorStats stats = LoadGenerator(options).Run();
+        server.Stop();
+        server.AppendServerMetrics(result);
+
+        LatencyHistogram::Snapshot snapshot;
+        recorded.MergeInto(snapshot);
+        auto ms = [](uint64_t ns) { return static_cast<double>(ns) / 1e6; };
+        auto ratio = [](double replayed, double original) { return original > 0 ? replayed / original : 0; };
+
+        LoadGenerator::AppendMetrics(stats, result);
+        result.metrics.push_back({"recorded_requests", static_cast<double>(options.schedule.size()), "requests",
+                                  "回放的轨迹记录数"});
+        result.metrics.push_back({"recorded_connections", static_cast<double>(connection_index.size()), "count",
+                                  "轨迹中的连接数"});
+        result.metrics.push_back({"trace_duration", last_offset * speedup, "seconds", "回放部分的原始时长"});
+        result.metrics.push_back({"speedup", speedup, "x", "时间加速因子"});
+        result.metrics.push_back({"recorded_avg_latency", snapshot.MeanNs() / 1e6, "ms", "轨迹记录的平均延迟"});
+        result.metrics.push_back({"recorded_p50_latency", ms(snapshot.Percentile(0.50)), "ms", "轨迹记录的 p50 延迟"});
+        result.metrics.push_back({"recorded_p99_latency", ms(snapshot.Percentile(0.99)), "ms", "轨迹记录的 p99 延迟"});
+        result.metrics.push_back({"recorded_max_latency", ms(snapshot.max_value), "ms", "轨迹记录的最大延迟"});
+        result.metrics.push_back({"p50_latency_ratio", ratio(stats.service.Percentile(0.50), snapshot.Percentile(0.50)),
+                                  "x", "回放 p50 服务延迟 / 记录 p50 延迟"});
+        result.metrics.push_back({"p99_latency_ratio", ratio(stats.service.Percentile(0.99), snapshot.Percentile(0.99)),
+                                  "x", "回放 p99 服务延迟 / 记录 p99 延迟"});
+        result.metrics.push_back({"recorded_mb", recorded_bytes / (1024.0 * 1024.0), "MB", "轨迹记录的响应字节数"});
+        result.metrics.push_back({"received_mb", stats.bytes_received / (1024.0 * 1024.0), "MB", "回放收到的响应字节数"});
+
+        result.success = stats.completed > 0;
+        if (!result.success) {
+            result.error_message = "没有完成任何回放请求";
+        }
+        result.duration_seconds = stats.elapsed_seconds;
+        result.end_time = std::chrono::system_clock::now();
+        LOG_INFO("回放完成: %lld/%zu 请求, p99 %.3f ms（记录 %.3f ms）", static_cast<long long>(stats.completed),
+                 options.schedule.size(), ms(stats.service.Percentile(0.99)), ms(snapshot.Percentile(0.99)));
+        return result;
+    }
+};
+
+// 工厂函数
+std::unique_ptr<Benchmark> CreatePipelineBenchmark() {
+    return std::make_unique<PipelineBenchmark>();
+}
+
+std::unique_ptr<Benchmark> CreateStaticMixBenchmark() {
+    return std::make_unique<StaticMixBenchmark>();
+}
+
+std::unique_ptr<Benchmark> CreateLargeFileBenchmark() {
+    return std::make_unique<LargeFileBenchmark>();
+}
+
+std::unique_ptr<Benchmark> CreateReplayBenchmark() {
+    return std::make_unique<ReplayBenchmark>();
+}
+
+} // namespace benchmark
+} // namespace tinywebserver
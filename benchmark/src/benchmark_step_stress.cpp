@@ -15,6 +15,8 @@
 #include "../../include/request_validator.h"
 #include "../../include/connection.h"
 #include "../../include/plugin/plugin_manager.h"
+#include "../../include/load_generator.h"
+#include "../../include/server_process.h"
 
 #include <atomic>
 #include <chrono>
@@ -41,163 +43,6 @@
 namespace tinywebserver {
 namespace benchmark {
 
-// 复用QPS基准测试中的HttpClient类
-// 这里直接包含或复制，为简单起见我们复制基本结构
-class HttpClient {
-public:
-    struct RequestResult {
-        bool success;
-        int64_t latency_ms;  // 从发送到接收完整响应的延迟
-        int64_t response_size;
-        int status_code;      // HTTP状态码
-        std::string error_message;
-    };
-
-    HttpClient(const std::string& host, int port, bool keep_alive = true)
-        : host_(host), port_(port), keep_alive_(keep_alive), fd_(-1) {
-        Connect();
-    }
-
-    ~HttpClient() {
-        if (fd_ >= 0) {
-            close(fd_);
-        }
-    }
-
-    RequestResult SendRequest(const std::string& method, const std::string& path,
-                             const std::string& body = "") {
-        RequestResult result;
-        result.success = false;
-
-        // 确保连接有效
-        if (fd_ < 0 && !Connect()) {
-            result.error_message = "连接失败";
-            LOG_ERROR("HttpClient::SendRequest: 连接失败到 %s:%d", host_.c_str(), port_);
-            return result;
-        }
-
-        // 构造HTTP请求
-        std::string request = method + " " + path + " HTTP/1.1\r\n";
-        request += "Host: " + host_ + "\r\n";
-        if (!body.empty()) {
-            request += "Content-Length: " + std::to_string(body.size()) + "\r\n";
-        }
-        if (!keep_alive_) {
-            request += "Connection: close\r\n";
-        } else {
-            request += "Connection: keep-alive\r\n";
-        }
-        request += "\r\n";
-        if (!body.empty()) {
-            request += body;
-        }
-
-        // 发送请求并计时
-        auto start_time = std::chrono::steady_clock::now();
-
-        ssize_t sent = send(fd_, request.c_str(), request.size(), 0);
-        if (sent < 0) {
-            result.error_message = "发送失败: " + std::string(strerror(errno));
-            CloseConnection();
-            return result;
-        }
-
-        // 接收响应
-        std::string response;
-        char buffer[4096];
-        ssize_t received;
-
-        // 简单实现：接收直到连接关闭或超时
-        // 实际实现应该解析Content-Length或Transfer-Encoding
-        struct timeval tv;
-        tv.tv_sec = 5;  // 5秒超时
-        tv.tv_usec = 0;
-        setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
-
-        while ((received = recv(fd_, buffer, sizeof(buffer), 0)) > 0) {
-            response.append(buffer, received);
-        }
-
-        auto end_time = std::chrono::steady_clock::now();
-        result.latency_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
-        result.response_size = response.size();
-
-        // 简单检查响应是否有效（包含HTTP状态码）
-        if (response.find("HTTP/1.1") != std::string::npos ||
-            response.find("HTTP/1.0") != std::string::npos) {
-            result.success = true;
-            // 提取状态码
-            size_t space_pos = response.find(' ');
-            if (space_pos != std::string::npos) {
-                size_t code_start = space_pos + 1;
-                size_t code_end = response.find(' ', code_start);
-                if (code_end != std::string::npos) {
-                    result.status_code = std::stoi(response.substr(code_start, code_end - code_start));
-                }
-            }
-        } else {
-            result.error_message = "无效的HTTP响应";
-            CloseConnection();
-        }
-
-        // 如果不保持连接，关闭socket
-        if (!keep_alive_) {
-            CloseConnection();
-        }
-
-        return result;
-    }
-
-private:
-    bool Connect() {
-        fd_ = socket(AF_INET, SOCK_STREAM, 0);
-        if (fd_ < 0) {
-            LOG_ERROR("HttpClient::Connect: socket创建失败: %s", strerror(errno));
-            return false;
-        }
-
-        sockaddr_in addr{};
-        addr.sin_family = AF_INET;
-        addr.sin_port = htons(port_);
-        if (inet_pton(AF_INET, host_.c_str(), &addr.sin_addr) <= 0) {
-            LOG_ERROR("HttpClient::Connect: 地址转换失败: %s", host_.c_str());
-            close(fd_);
-            fd_ = -1;
-            return false;
-        }
-
-        // 设置超时
-        struct timeval tv;
-        tv.tv_sec = 5;
-        tv.tv_usec = 0;
-        setsockopt(fd_, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
-        setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
-
-        LOG_INFO("HttpClient: 正在连接到 %s:%d", host_.c_str(), port_);
-        if (connect(fd_, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
-            LOG_ERROR("HttpClient: 连接失败: %s (errno=%d)", strerror(errno), errno);
-            close(fd_);
-            fd_ = -1;
-            return false;
-        }
-
-        LOG_INFO("HttpClient: 连接成功到 %s:%d", host_.c_str(), port_);
-        return true;
-    }
-
-    void CloseConnection() {
-        if (fd_ >= 0) {
-            close(fd_);
-            fd_ = -1;
-        }
-    }
-
-    std::string host_;
-    int port_;
-    bool keep_alive_;
-    int fd_;
-};
-
 /**
  * @brief 阶梯式压力测试实现
  */
@@ -211,83 +56,11 @@ public:
         return "阶梯式压力测试：逐步增加并发连接数，观察服务器性能变化";
     }
 
-    // 最小测试验证：启动服务器，发送单个请求，验证基本功能
-    bool RunMinimalTest(const BenchmarkConfig& config) {
-        LOG_INFO("阶梯式压力测试: 开始运行最小测试验证");
-
-        // 创建测试目录和文件
-        system("mkdir -p public");
-        system("echo '<h1>TinyWebServer Step Stress Test</h1>' > public/index.html");
-
-        // 启动服务器
-        std::unique_ptr<Server> server;
-        try {
-            server = std::make_unique<Server>(config.server_host, config.server_port, PluginManager::GetInstance());
-            // 设置消息处理回调
-            server->SetOnMessage([](std::shared_ptr<Connection> conn, const std::string& data) {
-                auto parser = conn->GetHttpParser();
-                auto& buffer = conn->GetInputBuffer();
-
-                size_t header_end = buffer.find("\r\n\r\n");
-                if (header_end != std::string::npos) {
-                    if (parser->Parse(buffer)) {
-                        // 生成简单响应
-                        HttpResponse response;
-                        response.Init("./public", parser->GetPath(), false, 200, parser.get());
-                        response.MakeResponse();
-
-                        // 发送响应
-                        conn->Send(response.GetHeaderString());
-                        if (response.HasFileBody()) {
-                            conn->Send(response.GetFileBody());
-                        } else {
-                            conn->Send(response.GetBodyString());
-                        }
-                    }
-                }
-            });
-
-            server->Start();
-        } catch (const std::exception& e) {
-            LOG_ERROR("阶梯式压力测试: 服务器启动失败: %s", e.what());
-            return false;
-        }
-
-        // 等待服务器启动
-        std::this_thread::sleep_for(std::chrono::milliseconds(500));
-
-        // 发送测试请求
-        HttpClient client(config.server_host, config.server_port, false);
-        auto result = client.SendRequest("GET", "/index.html");
-
-        // 停止服务器
-        if (server) {
-            server->Stop();
-        }
-
-        if (!result.success) {
-            LOG_ERROR("阶梯式压力测试: 最小测试失败: %s", result.error_message.c_str());
-            return false;
-        }
-
-        LOG_INFO("阶梯式压力测试: 最小测试通过，状态码: %d", result.status_code);
-        return true;
-    }
-
     BenchmarkResult Run(const BenchmarkConfig& config) override {
         BenchmarkResult result;
         result.name = GetName();
         result.start_time = std::chrono::system_clock::now();
 
-        // 首先运行最小测试验证基本功能
-        LOG_INFO("阶梯式压力测试: 开始运行最小测试验证");
-        if (!RunMinimalTest(config)) {
-            result.success = false;
-            result.error_message = "最小测试验证失败，服务器无法处理请求";
-            result.end_time = std::chrono::system_clock::now();
-            return result;
-        }
-
         // 验证配置
         auto errors = config.Validate();
         if (!errors.empty()) {
@@ -345,51 +118,74 @@ public:
             LOG_INFO("  阶段 %zu: %d 并发连接", i + 1, stages[i]);
         }
 
-        // 启动服务器（在独立线程中）
+        // 启动服务器：独立进程模式下 fork/exec server，只对服务器进程采样资源
+        std::unique_ptr<ServerProcess> process;
         std::unique_ptr<Server> server;
         std::thread server_thread;
 
-        try {
-            // 确保public目录存在，包含测试文件
-            system("mkdir -p public");
-            system("echo '<h1>TinyWebServer Step Stress Test</h1>' > public/index.html");
-            LOG_INFO("创建测试文件完成");
-
-            server = std::make_unique<Server>(config.server_host, config.server_port, PluginManager::GetInstance());
-            // 设置消息处理回调
-            server->SetOnMessage([](std::shared_ptr<Connection> conn, const std::string& data) {
-                auto parser = conn->GetHttpParser();
-                auto& buffer = conn->GetInputBuffer();
-
-                size_t header_end = buffer.find("\r\n\r\n");
-                if (header_end != std::string::npos) {
-                    if (parser->Parse(buffer)) {
-                        // 生成简单响应
-                        HttpResponse response;
-                        response.Init("./public", parser->GetPath(), false, 200, parser.get());
-                        response.MakeResponse();
-
-                        // 发送响应
-                        conn->Send(response.GetHeaderString());
-                        if (response.HasFileBody()) {
-                            conn->Send(response.GetFileBody());
-                        } else {
-                            conn->Send(response.GetBodyString());
+        // 确保public目录存在，包含测试文件
+        system("mkdir -p public");
+        system("echo '<h1>TinyWebServer Step Stress Test</h1>' > public/index.html");
+        LOG_INFO("创建测试文件完成");
+
+        if (UseServerProcess(config)) {
+            process = std::make_unique<ServerProcess>(ServerProcessOptions::FromConfig(config));
+            if (!process->Start(result.error_message)) {
+                result.success = false;
+                result.end_time = std::chrono::system_clock::now();
+                return result;
+            }
+        } else {
+            try {
+                server = std::make_unique<Server>(config.server_host, config.server_port, PluginManager::GetInstance());
+                // 设置消息处理回调
+                server->SetOnMessage([](std::shared_ptr<Connection> conn, const std::string& data) {
+                    auto parser = conn->GetHttpParser();
+                    auto& buffer = conn->GetInputBuffer();
+
+                    size_t header_end = buffer.find("\r\n\r\n");
+                    if (header_end != std::string::npos) {
+                        if (parser->Parse(buffer)) {
+                            // 生成简单响应
+                            HttpResponse response;
+                            response.Init("./public", parser->GetPath(), parser->IsKeepAlive(), 200, parser.get());
+                            response.MakeResponse();
+
+                            // 发送响应
+                            conn->Send(response.GetHeaderString());
+                            if (response.HasFileBody()) {
+                                conn->Send(response.GetFileBody());
+                            } else {
+                                conn->Send(response.GetBodyString());
+                            }
+                            buffer.erase(0, header_end + 4);
+                            parser->Reset();
                         }
                     }
-                }
-            });
+                });
 
-            server_thread = std::thread([&server]() {
-                server->Start();
-            });
+                server_thread = std::thread([&server]() {
+                    server->Start();
+                    server->Run();
+                });
+
+                // 等待服务器启动
+                std::this_thread::sleep_for(std::chrono::seconds(1));
 
-            // 等待服务器启动
-            std::this_thread::sleep_for(std::chrono::seconds(1));
+            } catch (const std::exception& e) {
+                result.success = false;
+                result.error_message = std::string("服务器启动失败: ") + e.what();
+                result.end_time = std::chrono::system_clock::now();
+                return result;
+            }
+        }
 
-        } catch (const std::exception& e) {
+        // 先运行最小测试验证基本功能
+        LOG_INFO("阶梯式压力测试: 开始运行最小测试验证");
+        if (!RunMinimalTest(config)) {
+            StopServer(server, server_thread);
             result.success = false;
-            result.error_message = std::string("服务器启动失败: ") + e.what();
+            result.error_message = "最小测试验证失败，服务器无法处理请求";
             result.end_time = std::chrono::system_clock::now();
             return result;
         }
@@ -398,6 +194,12 @@ public:
         std::vector<BenchmarkResult::Metric> stage_metrics;
         int stage_num = 1;
 
+        std::unique_ptr<SystemResourceMonitor> monitor;
+        if (process) {
+            monitor = std::make_unique<SystemResourceMonitor>(process->Pid());
+            monitor->Start();
+        }
+
         for (int concurrent_connections : stages) {
             LOG_INFO("=========================================");
             LOG_INFO("开始测试阶段 %d: %d 并发连接", stage_num, concurrent_connections);
@@ -434,12 +236,14 @@ public:
         }
 
         // 停止服务器
-        if (server) {
-            server->Stop();
-            if (server_thread.joinable()) {
-                server_thread.join();
-            }
+        if (monitor) {
+            monitor->Stop();
+            ServerProcess::AppendMetrics(*monitor, result);
         }
+        if (process) {
+            process->Stop();
+        }
+        StopServer(server, server_thread);
 
         // 计算总体指标
         CalculateOverallMetrics(result, stages);
@@ -461,113 +265,40 @@ private:
         BenchmarkResult result;
         result.name = "stage_" + std::to_string(stage_num);
 
-        auto start_time = std::chrono::steady_clock::now();
-
-        std::atomic<int64_t> total_requests{0};
-        std::atomic<int64_t> failed_requests{0};
-        std::vector<double> latencies;
-        std::mutex latencies_mutex;
-
-        // 创建客户端线程
-        std::vector<std::thread> threads;
-        std::atomic<bool> stop_flag{false};
-
-        // 每个线程处理一部分连接
-        int threads_count = std::min(config.concurrent_connections, 50); // 最多50个线程
-        int connections_per_thread = config.concurrent_connections / threads_count;
-        int remaining_connections = config.concurrent_connections % threads_count;
+        // 全部连接由负载生成器的少量事件循环线程驱动，阶段并发数不再受线程数限制
+        LoadGenerator generator(LoadGeneratorOptions::FromConfig(config));
+        LoadGeneratorStats stats = generator.Run();
 
-        LOG_INFO("阶段 %d: 启动 %d 个线程，每个线程处理 %d 个连接",
-                stage_num, threads_count, connections_per_thread);
+        LOG_INFO("阶段 %d: 完成 %lld 个请求, 失败 %lld 个, QPS=%.2f", stage_num,
+                static_cast<long long>(stats.completed), static_cast<long long>(stats.Failed()), stats.Qps());
 
-        for (int i = 0; i < threads_count; ++i) {
-            int connections = connections_per_thread;
-            if (i == 0) {
-                connections += remaining_connections; // 第一个线程处理剩余的连接
-            }
-
-            threads.emplace_back([&, i, connections]() {
-                std::vector<std::unique_ptr<HttpClient>> clients;
-
-                // 创建客户端连接
-                for (int j = 0; j < connections; ++j) {
-                    clients.push_back(std::make_unique<HttpClient>(
-                        config.server_host, config.server_port, config.keep_alive));
-                }
-
-                // 运行测试
-                auto stage_start = std::chrono::steady_clock::now();
-                while (!stop_flag.load() &&
-                       std::chrono::duration_cast<std::chrono::seconds>(
-                           std::chrono::steady_clock::now() - stage_start).count() < config.duration_seconds) {
-
-                    // 每个客户端发送一个请求
-                    for (auto& client : clients) {
-                        auto request_result = client->SendRequest(
-                            config.request_method, config.request_path, config.request_body);
-
-                        total_requests.fetch_add(1, std::memory_order_relaxed);
-
-                        if (!request_result.success) {
-                            failed_requests.fetch_add(1, std::memory_order_relaxed);
-                        } else {
-                            std::lock_guard<std::mutex> lock(latencies_mutex);
-                            latencies.push_back(static_cast<double>(request_result.latency_ms));
-                        }
-
-                        // 短暂休眠以避免过度负载
-                        std::this_thread::sleep_for(std::chrono::milliseconds(10));
-                    }
-                }
-            });
-        }
+        LoadGenerator::AppendMetrics(stats, result);
+        result.metrics.push_back({"duration", stats.elapsed_seconds, "seconds", "测试持续时间"});
+        result.success = true;
+        return result;
+    }
 
-        // 等待测试阶段完成
-        std::this_thread::sleep_for(std::chrono::seconds(static_cast<int>(config.duration_seconds)));
-        stop_flag.store(true);
+    /**
+     * @brief 最小测试验证：单连接短时发送请求，确认服务器能返回成功响应
+     */
+    bool RunMinimalTest(const BenchmarkConfig& config) {
+        LoadGeneratorOptions options = LoadGeneratorOptions::FromConfig(config);
+        options.connections = 1;
+        options.target_rate = 0;
+        options.duration_seconds = 0.3;
+        LoadGeneratorStats stats = LoadGenerator(options).Run();
+        LOG_INFO("最小测试: 成功 %lld, 失败 %lld", static_cast<long long>(stats.Successful()),
+                static_cast<long long>(stats.Failed()));
+        return stats.Successful() > 0;
+    }
 
-        // 等待所有线程完成
-        for (auto& thread : threads) {
-            if (thread.joinable()) {
-                thread.join();
-            }
+    static void StopServer(std::unique_ptr<Server>& server, std::thread& server_thread) {
+        if (server) {
+            server->Stop();
         }
-
-        auto end_time = std::chrono::steady_clock::now();
-        double duration_seconds = std::chrono::duration_cast<std::chrono::milliseconds>(
-            end_time - start_time).count() / 1000.0;
-
-        // 计算指标
-        if (duration_seconds > 0) {
-            double qps = total_requests.load() / duration_seconds;
-            double error_rate = (total_requests.load() > 0) ?
-                (failed_requests.load() * 100.0 / total_requests.load()) : 0.0;
-
-            // 计算延迟统计
-            double avg_latency = 0.0;
-            double p99_latency = 0.0;
-
-            if (!latencies.empty()) {
-                std::sort(latencies.begin(), latencies.end());
-                avg_latency = std::accumulate(latencies.begin(), latencies.end(), 0.0) / latencies.size();
-
-                size_t p99_index = static_cast<size_t>(latencies.size() * 0.99);
-                if (p99_index >= latencies.size()) p99_index = latencies.size() - 1;
-                p99_latency = latencies[p99_index];
-            }
-
-            // 添加指标到结果
-            result.metrics.push_back({"qps", qps, "requests/second", "每秒查询数"});
-            result.metrics.push_back({"total_requests", static_cast<double>(total_requests.load()), "requests", "总请求数"});
-            result.metrics.push_back({"failed_requests", static_cast<double>(failed_requests.load()), "requests", "失败请求数"});
-            result.metrics.push_back({"error_rate", error_rate, "%", "错误率"});
-            result.metrics.push_back({"avg_latency", avg_latency, "ms", "平均延迟"});
-            result.metrics.push_back({"p99_latency", p99_latency, "ms", "P99延迟"});
-            result.metrics.push_back({"duration", duration_seconds, "seconds", "测试持续时间"});
+        if (server_thread.joinable()) {
+            server_thread.join();
         }
-
-        result.success = true;
-        return result;
     }
 
     /**
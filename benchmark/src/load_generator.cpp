@@ -0,0 +1,878 @@
+/**
+ * @file load_generator.cpp
+ * @brief 事件驱动开环负载生成器实现
+ */
+
+#include "../../include/load_generator.h"
+#include "../../include/benchmark.h"
+#include "../../include/Logger.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <queue>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <thread>
+#include <unistd.h>
+
+namespace tinywebserver {
+namespace benchmark {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr auto kConnectRetryDelay = std::chrono::milliseconds(100);
+constexpr auto kSweepInterval = std::chrono::milliseconds(10);
+// 开始计时前等待连接建立的上限
+constexpr auto kConnectPhaseLimit = std::chrono::seconds(2);
+constexpr int kMaxEvents = 256;
+constexpr size_t kReadBufferSize = 64 * 1024;
+
+bool HeaderEquals(const char* begin, const char* end, const char* name) {
+    size_t len = std::strlen(name);
+    return static_cast<size_t>(end - begin) == len && strncasecmp(begin, name, len) == 0;
+}
+
+bool ValueContains(const char* begin, const char* end, const char* token) {
+    size_t len = std::strlen(token);
+    for (const char* p = begin; p + len <= end; ++p) {
+        if (strncasecmp(p, token, len) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 增量解析单个 HTTP/1.1 响应
+ *
+ * 只保留头部，响应体（Content-Length / chunked / 读到关闭）按长度跳过，
+ * 大文件下载不会在客户端堆积内存。
+ */
+class ResponseParser {
+public:
+    void Reset() {
+        state_ = State::kHeader;
+        line_.clear();
+        remaining_ = 0;
+        status_ = 0;
+        close_ = false;
+    }
+
+    /**
+     * @brief 消费数据，返回已消费的字节数（响应完整后停止消费）
+     */
+    size_t Consume(const char* data, size_t len) {
+        size_t used = 0;
+        while (used < len && state_ != State::kDone && state_ != State::kError) {
+            const char* p = data + used;
+            size_t n = len - used;
+            switch (state_) {
+                case State::kHeader:
+                    used += ConsumeHeader(p, n);
+                    break;
+                case State::kBody:
+                case State::kChunkData: {
+                    size_t take = static_cast<size_t>(std::min<uint64_t>(remaining_, n));
+                    remaining_ -= take;
+                    used += take;
+                    if (remaining_ == 0) {
+                        state_ = state_ == State::kBody ? State::kDone : State::kChunkSize;
+                    }
+                    break;
+                }
+                case State::kChunkSize:
+                case State::kTrailer:
+                    used += ConsumeLine(p, n);
+                    break;
+                case State::kUntilClose:
+                    used += n;
+                    break;
+                default:
+                    break;
+            }
+        }
+        return used;
+    }
+
+    /**
+     * @brief 对端关闭：以关闭界定长度的响应到此完整
+     */
+    void OnEof() {
+        state_ = state_ == State::kUntilClose ? State::kDone : State::kError;
+    }
+
+    bool Done() const { return state_ == State::kDone; }
+    bool Failed() const { return state_ == State::kError; }
+    int Status() const { return status_; }
+    bool CloseAfter() const { return close_; }
+
+private:
+    enum class State { kHeader, kBody, kChunkSize, kChunkData, kTrailer, kUntilClose, kDone, kError };
+
+    size_t ConsumeHeader(const char* data, size_t len) {
+        size_t old_size = line_.size();
+        line_.append(data, len);
+        size_t pos = line_.find("\r\n\r\n", old_size >= 3 ? old_size - 3 : 0);
+        if (pos == std::string::npos) {
+            if (line_.size() > 64 * 1024) {
+                state_ = State::kError;
+            }
+            return len;
+        }
+        size_t header_len = pos + 4;
+        line_.resize(header_len);
+        ParseHeader();
+        line_.clear();
+        return header_len - old_size;
+    }
+
+    void ParseHeader() {
+        if (line_.compare(0, 5, "HTTP/") != 0 || line_.size() < 12) {
+            state_ = State::kError;
+            return;
+        }
+        status_ = std::atoi(line_.c_str() + 9);
+        bool http10 = line_.compare(5, 3, "1.0") == 0;
+        bool keep_alive = false;
+        bool chunked = false;
+        int64_t content_length = -1;
+
+        size_t line_start = line_.find("\r\n") + 2;
+        while (line_start + 2 < line_.size()) {
+            size_t line_end = line_.find("\r\n", line_start);
+            size_t colon = line_.find(':', line_start);
+            if (colon != std::string::npos && colon < line_end) {
+                const char* name = line_.data() + line_start;
+                const char* name_end = line_.data() + colon;
+                const char* value = line_.data() + colon + 1;
+                const char* value_end = line_.data() + line_end;
+                if (HeaderEquals(name, name_end, "content-length")) {
+                    content_length = std::strtoll(value, nullptr, 10);
+                } else if (HeaderEquals(name, name_end, "transfer-encoding")) {
+                    chunked = ValueContains(value, value_end, "chunked");
+                } else if (HeaderEquals(name, name_end, "connection")) {
+                    close_ = ValueContains(value, value_end, "close");
+                    keep_alive = ValueContains(value, value_end, "keep-alive");
+                }
+            }
+            line_start = line_end + 2;
+        }
+        if (http10 && !keep_alive) {
+            close_ = true;
+        }
+
+        if ((status_ >= 100 && status_ < 200) || status_ == 204 || status_ == 304) {
+            state_ = State::kDone;
+        } else if (chunked) {
+            state_ = State::kChunkSize;
+        } else if (content_length >= 0) {
+            remaining_ = static_cast<uint64_t>(content_length);
+            state_ = remaining_ == 0 ? State::kDone : State::kBody;
+        } else {
+            close_ = true;
+            state_ = State::kUntilClose;
+        }
+    }
+
+    size_t ConsumeLine(const char* data, size_t len) {
+        const char* lf = static_cast<const char*>(std::memchr(data, '\n', len));
+        if (lf == nullptr) {
+            line_.append(data, len);
+            return len;
+        }
+        line_.append(data, lf - data);
+        if (!line_.empty() && line_.back() == '\r') {
+            line_.pop_back();
+        }
+        if (state_ == State::kChunkSize) {
+            uint64_t size = std::strtoull(line_.c_str(), nullptr, 16);
+            remaining_ = size + 2;   // 数据后的 CRLF
+            state_ = size == 0 ? State::kTrailer : State::kChunkData;
+        } else if (line_.empty()) {
+            state_ = State::kDone;   // 尾部头部以空行结束
+        }
+        line_.clear();
+        return static_cast<size_t>(lf - data) + 1;
+    }
+
+    State state_ = State::kHeader;
+    std::string line_;
+    uint64_t remaining_ = 0;
+    int status_ = 0;
+    bool close_ = false;
+};
+
+struct ClientConn {
+    enum class State { kClosed, kConnecting, kIdle, kBusy };
+
+    int fd = -1;
+    State state = State::kClosed;
+    Clock::time_point retry_at;
+    Clock::time_point sent_at;    ///< 本批实际发出（或开始连接）时刻
+    std::vector<Clock::time_point> intended;   ///< 本批各请求的计划发送时刻
+    size_t answered = 0;          ///< 本批已收到的响应数
+    const std::string* request = nullptr;
+    std::string batch;            ///< 流水线时拼接的多个请求
+    size_t written = 0;
+    ResponseParser parser;
+
+    /// 回放脚本：计划时刻（相对开始计时）与请求报文
+    struct ScriptItem {
+        Clock::duration offset;
+        const std::string* request;
+    };
+    std::vector<ScriptItem> script;
+    size_t script_pos = 0;
+
+    int64_t Unanswered() const { return static_cast<int64_t>(intended.size() - answered); }
+};
+
+/**
+ * @brief 单线程事件循环：一个 epoll 实例 + 一个 timerfd 驱动本线程的全部连接
+ */
+class Worker {
+public:
+    Worker(const LoadGeneratorOptions& options, const sockaddr_in& addr, int connections,
+           double rate, Clock::duration phase)
+        : options_(options), addr_(addr), conns_(connections), rate_(rate), phase_(phase),
+          epoll_fd_(epoll_create1(EPOLL_CLOEXEC)),
+          timer_fd_(timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)),
+          read_buffer_(kReadBufferSize) {
+        struct epoll_event ev;
+        std::memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.ptr = nullptr;   // nullptr 表示定时器
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, timer_fd_, &ev);
+        intervals_.resize(static_cast<size_t>(options_.duration_seconds) + 2);
+    }
+
+    /// 为本线程第 index 条连接追加脚本请求（须按计划时刻顺序调用）
+    void AddScripted(size_t index, Clock::duration offset, const std::string* request) {
+        conns_[index].script.push_back({offset, request});
+        scripted_ = true;
+    }
+
+    ~Worker() {
+        for (auto& conn : conns_) {
+            if (conn.fd >= 0) {
+                close(conn.fd);
+            }
+        }
+        close(timer_fd_);
+        close(epoll_fd_);
+    }
+
+    void Run() {
+        // 先建立连接，再开始计时，避免握手时间混入前几个请求的延迟
+        auto connect_deadline = Clock::now() + kConnectPhaseLimit;
+        for (auto& conn : conns_) {
+            Connect(conn, Clock::now());
+        }
+        while (idle_.size() < conns_.size() && Clock::now() < connect_deadline && HasPendingConnect()) {
+            Poll(Clock::now() + kSweepInterval);
+        }
+
+        start_ = Clock::now();
+        for (ClientConn* conn : idle_) {
+            ArmScript(*conn);
+        }
+        auto end = start_ + std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(options_.duration_seconds));
+        auto interval = rate_ > 0 ? std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(1.0 / rate_)) : Clock::duration::zero();
+        auto next_arrival = start_ + phase_;
+        auto next_sweep = start_;
+
+        while (true) {
+            auto now = Clock::now();
+            if (now >= end) {
+                break;
+            }
+            if (rate_ > 0) {
+                while (next_arrival <= now) {
+                    backlog_.push_back(next_arrival);
+                    next_arrival += interval;
+                }
+            }
+            if (scripted_) {
+                DispatchScript(now);
+            } else {
+                Dispatch(now);
+            }
+            if (now >= next_sweep) {
+                if (scripted_ && ScriptFinished()) {
+                    break;
+                }
+                Sweep(now);
+                next_sweep = now + kSweepInterval;
+            }
+
+            auto deadline = std::min(end, next_sweep);
+            if (rate_ > 0 && !idle_.empty()) {
+                deadline = std::min(deadline, next_arrival);
+            }
+            if (!script_due_.empty()) {
+                deadline = std::min(deadline, script_due_.top().first);
+            }
+            Poll(deadline);
+        }
+
+        elapsed_seconds_ = std::chrono::duration<double>(Clock::now() - start_).count();
+        unsent_ = static_cast<int64_t>(backlog_.size());
+        for (const auto& conn : conns_) {
+            unsent_ += static_cast<int64_t>(conn.script.size() - conn.script_pos);
+        }
+    }
+
+    void MergeInto(LoadGeneratorStats& stats) const {
+        stats.completed += completed_;
+        stats.non_2xx += non_2xx_;
+        stats.connect_errors += connect_errors_;
+        stats.io_errors += io_errors_;
+        stats.timeouts += timeouts_;
+        stats.unsent += unsent_;
+        stats.bytes_received += bytes_received_;
+        stats.elapsed_seconds = std::max(stats.elapsed_seconds, elapsed_seconds_);
+        corrected_.MergeInto(stats.corrected);
+        service_.MergeInto(stats.service);
+        if (stats.intervals.size() < intervals_.size()) {
+            stats.intervals.resize(intervals_.size());
+        }
+        for (size_t i = 0; i < intervals_.size(); ++i) {
+            stats.intervals[i].completed += intervals_[i].completed;
+            stats.intervals[i].latency_sum_ns += intervals_[i].latency_sum_ns;
+        }
+    }
+
+private:
+    bool HasPendingConnect() const {
+        return std::any_of(conns_.begin(), conns_.end(), [](const ClientConn& conn) {
+            return conn.state == ClientConn::State::kConnecting;
+        });
+    }
+
+    /// 等待事件直到 deadline（timerfd 提供亚毫秒精度的唤醒）
+    void Poll(Clock::time_point deadline) {
+        if (deadline != armed_deadline_) {
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+            struct itimerspec spec;
+            std::memset(&spec, 0, sizeof(spec));
+            spec.it_value.tv_sec = ns / 1000000000;
+            spec.it_value.tv_nsec = ns % 1000000000;
+            if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0) {
+                spec.it_value.tv_nsec = 1;   // 全零会解除定时器
+            }
+            timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &spec, nullptr);
+            armed_deadline_ = deadline;
+        }
+
+        struct epoll_event events[kMaxEvents];
+        int n = epoll_wait(epoll_fd_, events, kMaxEvents, -1);
+        for (int i = 0; i < n; ++i) {
+            if (events[i].data.ptr == nullptr) {
+                uint64_t expirations;
+                while (read(timer_fd_, &expirations, sizeof(expirations)) > 0) {
+                }
+                armed_deadline_ = Clock::time_point();
+                continue;
+            }
+            OnEvent(*static_cast<ClientConn*>(events[i].data.ptr), events[i].events);
+        }
+    }
+
+    void Dispatch(Clock::time_point now) {
+        size_t depth = static_cast<size_t>(std::max(1, options_.pipeline_depth));
+        while (!idle_.empty() && (rate_ <= 0 || !backlog_.empty())) {
+            ClientConn* conn = idle_.back();
+            idle_.pop_back();
+            conn->intended.clear();
+            if (rate_ > 0) {
+                // 开环：取走队列中已到期的请求，最多一个流水线深度
+                while (conn->intended.size() < depth && !backlog_.empty()) {
+                    conn->intended.push_back(backlog_.front());
+                    backlog_.pop_front();
+                }
+            } else {
+                conn->intended.assign(depth, now);
+            }
+            StartBatch(*conn, now);
+        }
+    }
+
+    /// 连接回到空闲：回放模式下按下一个脚本请求的计划时刻排队
+    void MarkIdle(ClientConn& conn) {
+        conn.state = ClientConn::State::kIdle;
+        idle_.push_back(&conn);
+        ArmScript(conn);
+    }
+
+    void ArmScript(ClientConn& conn) {
+        if (scripted_ && start_ != Clock::time_point() && conn.script_pos < conn.script.size()) {
+            script_due_.push({start_ + conn.script[conn.script_pos].offset, &conn});
+        }
+    }
+
+    /// 回放：发出计划时刻已到、且所在连接空闲的脚本请求
+    void DispatchScript(Clock::time_point now) {
+        while (!script_due_.empty() && script_due_.top().first <= now) {
+            auto [due, conn] = script_due_.top();
+            script_due_.pop();
+            if (conn->state != ClientConn::State::kIdle || conn->script_pos >= conn->script.size()) {
+                continue;   // 连接在排队期间被重连，重连后会重新排队
+            }
+            auto it = std::find(idle_.begin(), idle_.end(), conn);
+            if (it == idle_.end()) {
+                continue;
+            }
+            idle_.erase(it);
+            conn->intended.assign(1, due);
+            StartBatch(*conn, now, conn->script[conn->script_pos++].request);
+        }
+    }
+
+    bool ScriptFinished() const {
+        return std::all_of(conns_.begin(), conns_.end(), [](const ClientConn& conn) {
+            return conn.script_pos >= conn.script.size() && conn.state != ClientConn::State::kBusy;
+        });
+    }
+
+    const std::string& NextRequest() {
+        static const std::string kDefaultRequest = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+        return options_.requests.empty()
+            ? kDefaultRequest
+            : options_.requests[next_request_++ % options_.requests.size()];
+    }
+
+    void StartBatch(ClientConn& conn, Clock::time_point now, const std::string* request = nullptr) {
+        conn.state = ClientConn::State::kBusy;
+        conn.sent_at = now;
+        conn.answered = 0;
+        if (request != nullptr) {
+            conn.request = request;
+        } else if (conn.intended.size() == 1) {
+            conn.request = &NextRequest();
+        } else {
+            conn.batch.clear();
+            for (size_t i = 0; i < conn.intended.size(); ++i) {
+                conn.batch += NextRequest();
+            }
+            conn.request = &conn.batch;
+        }
+        conn.written = 0;
+        conn.parser.Reset();
+        Flush(conn);
+    }
+
+    void Flush(ClientConn& conn) {
+        while (conn.written < conn.request->size()) {
+            ssize_t n = send(conn.fd, conn.request->data() + conn.written,
+                             conn.request->size() - conn.written, MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (n > 0) {
+                conn.written += static_cast<size_t>(n);
+            } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                return;   // 边沿触发的 EPOLLOUT 会继续写
+            } else if (n < 0 && errno == EINTR) {
+                continue;
+            } else {
+                io_errors_ += conn.Unanswered();
+                Reconnect(conn, Clock::now());
+                return;
+            }
+        }
+    }
+
+    void OnEvent(ClientConn& conn, uint32_t events) {
+        auto now = Clock::now();
+        if (conn.state == ClientConn::State::kConnecting) {
+            int err = 0;
+            socklen_t len = sizeof(err);
+            getsockopt(conn.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+            if (err != 0 || (events & (EPOLLERR | EPOLLHUP))) {
+                connect_errors_++;
+                Close(conn, now + kConnectRetryDelay);
+                return;
+            }
+            if (events & EPOLLOUT) {
+                MarkIdle(conn);
+            }
+            return;
+        }
+        if ((events & EPOLLOUT) && conn.state == ClientConn::State::kBusy) {
+            Flush(conn);
+        }
+        if ((events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) &&
+            (conn.state == ClientConn::State::kBusy || conn.state == ClientConn::State::kIdle)) {
+            ReadAll(conn);
+        }
+    }
+
+    void ReadAll(ClientConn& conn) {
+        while (conn.fd >= 0) {
+            ssize_t n = recv(conn.fd, read_buffer_.data(), read_buffer_.size(), MSG_DONTWAIT);
+            if (n > 0) {
+                bytes_received_ += n;
+                // 一次读到的数据可能包含流水线中的多个响应
+                size_t offset = 0;
+                while (offset < static_cast<size_t>(n) && conn.state == ClientConn::State::kBusy) {
+                    offset += conn.parser.Consume(read_buffer_.data() + offset, static_cast<size_t>(n) - offset);
+                    if (conn.parser.Failed()) {
+                        io_errors_ += conn.Unanswered();
+                        Reconnect(conn, Clock::now());
+                        return;
+                    }
+                    if (!conn.parser.Done()) {
+                        break;
+                    }
+                    Complete(conn);
+                    if (conn.state == ClientConn::State::kBusy) {
+                        conn.parser.Reset();   // 本批还有响应未到
+                    } else if (conn.state != ClientConn::State::kIdle) {
+                        return;   // 已重连，新套接字等待下一次事件
+                    }
+                }
+                // 其余情况（空闲连接上的非预期数据）直接丢弃
+            } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                return;
+            } else if (n < 0 && errno == EINTR) {
+                continue;
+            } else {
+                // 对端关闭或出错
+                if (conn.state == ClientConn::State::kBusy) {
+                    conn.parser.OnEof();
+                    if (conn.parser.Done()) {
+                        conn.state = ClientConn::State::kClosed;   // Complete 后不回到空闲队列
+                        Complete(conn);
+                    }
+                    io_errors_ += conn.Unanswered();
+                } else if (conn.state == ClientConn::State::kIdle) {
+                    // 服务器关闭了空闲的 keep-alive 连接：静默重连
+                    idle_.erase(std::find(idle_.begin(), idle_.end(), &conn));
+                }
+                Reconnect(conn, Clock::now());
+                return;
+            }
+        }
+    }
+
+    /// 收到本批中的下一个响应
+    void Complete(ClientConn& conn) {
+        auto now = Clock::now();
+        Clock::time_point intended = conn.intended[conn.answered++];
+        uint64_t corrected_ns = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(now - intended).count());
+        uint64_t service_ns = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(now - conn.sent_at).count());
+        corrected_.Record(corrected_ns);
+        service_.Record(service_ns);
+        completed_++;
+        int status = conn.parser.Status();
+        if (status < 200 || status >= 400) {
+            non_2xx_++;
+        }
+
+        size_t second = static_cast<size_t>(std::chrono::duration_cast<std::chrono::seconds>(now - start_).count());
+        if (now >= start_ && second < intervals_.size()) {
+            intervals_[second].completed++;
+            intervals_[second].latency_sum_ns += corrected_ns;
+        }
+
+        if (conn.state != ClientConn::State::kBusy) {
+            return;
+        }
+        if (!options_.keep_alive || conn.parser.CloseAfter()) {
+            // 服务器关闭连接后，流水线中尚未应答的请求作废
+            io_errors_ += conn.Unanswered();
+            Reconnect(conn, now);
+        } else if (conn.Unanswered() == 0) {
+            MarkIdle(conn);
+        }
+    }
+
+    void Sweep(Clock::time_point now) {
+        auto timeout = std::chrono::milliseconds(options_.request_timeout_ms);
+        for (auto& conn : conns_) {
+            switch (conn.state) {
+                case ClientConn::State::kBusy:
+                    if (now - conn.sent_at > timeout) {
+                        timeouts_ += conn.Unanswered();
+                        Reconnect(conn, now);
+                    }
+                    break;
+                case ClientConn::State::kConnecting:
+                    if (now - conn.sent_at > timeout) {
+                        connect_errors_++;
+                        Close(conn, now + kConnectRetryDelay);
+                    }
+                    break;
+                case ClientConn::State::kClosed:
+                    if (conn.retry_at <= now) {
+                        Connect(conn, now);
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    void Connect(ClientConn& conn, Clock::time_point now) {
+        conn.sent_at = now;
+        conn.fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (conn.fd < 0) {
+            connect_errors_++;
+            conn.state = ClientConn::State::kClosed;
+            conn.retry_at = now + kConnectRetryDelay;
+            return;
+        }
+        int one = 1;
+        setsockopt(conn.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        int ret = connect(conn.fd, reinterpret_cast<const struct sockaddr*>(&addr_), sizeof(addr_));
+        if (ret < 0 && errno != EINPROGRESS) {
+            connect_errors_++;
+            Close(conn, now + kConnectRetryDelay);
+            return;
+        }
+        struct epoll_event ev;
+        std::memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        ev.data.ptr = &conn;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, conn.fd, &ev);
+        if (ret == 0) {
+            MarkIdle(conn);
+        } else {
+            conn.state = ClientConn::State::kConnecting;
+        }
+    }
+
+    void Close(ClientConn& conn, Clock::time_point retry_at) {
+        if (conn.fd >= 0) {
+            close(conn.fd);   // 关闭时自动移出 epoll
+            conn.fd = -1;
+        }
+        conn.state = ClientConn::State::kClosed;
+        conn.retry_at = retry_at;
+    }
+
+    /// 关闭后立即重连（服务器正常关闭或请求失败）
+    void Reconnect(ClientConn& conn, Clock::time_point now) {
+        Close(conn, now);
+        Connect(conn, now);
+    }
+
+    const LoadGeneratorOptions& options_;
+    sockaddr_in addr_;
+    std::vector<ClientConn> conns_;
+    double rate_;
+    Clock::duration phase_;
+    int epoll_fd_;
+    int timer_fd_;
+    std::vector<char> read_buffer_;
+
+    std::vector<ClientConn*> idle_;
+    std::deque<Clock::time_point> backlog_;
+    size_t next_request_ = 0;
+
+    // 回放模式：空闲连接按下一个脚本请求的计划时刻排成小顶堆
+    using ScriptDue = std::pair<Clock::time_point, ClientConn*>;
+    bool scripted_ = false;
+    std::priority_queue<ScriptDue, std::vector<ScriptDue>, std::greater<ScriptDue>> script_due_;
+    Clock::time_point start_;
+    Clock::time_point armed_deadline_;
+
+    LatencyHistogram corrected_;
+    LatencyHistogram service_;
+    std::vector<LoadGeneratorStats::Interval> intervals_;
+    int64_t completed_ = 0;
+    int64_t non_2xx_ = 0;
+    int64_t connect_errors_ = 0;
+    int64_t io_errors_ = 0;
+    int64_t timeouts_ = 0;
+    int64_t unsent_ = 0;
+    int64_t bytes_received_ = 0;
+    double elapsed_seconds_ = 0;
+};
+
+/// 连接数较多时抬高 RLIMIT_NOFILE 软限制
+void EnsureFdLimit(int connections) {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0) {
+        return;
+    }
+    rlim_t wanted = static_cast<rlim_t>(connections) * 2 + 256;
+    if (limit.rlim_cur < wanted) {
+        limit.rlim_cur = std::min(wanted, limit.rlim_max);
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+} // namespace
+
+LoadGeneratorOptions LoadGeneratorOptions::FromConfig(const BenchmarkConfig& config) {
+    LoadGeneratorOptions options;
+    options.host = config.server_host;
+    options.port = config.server_port;
+    options.connections = config.concurrent_connections;
+    options.target_rate = config.target_qps;
+    options.duration_seconds = config.duration_seconds;
+    options.keep_alive = config.keep_alive;
+    options.requests.push_back(LoadGenerator::BuildRequest(config.request_method, config.request_path,
+                                                           config.server_host, config.request_body,
+                                                           config.keep_alive));
+    for (const auto& param : config.custom_params) {
+        try {
+            if (param.first == "client_threads") {
+                options.threads = std::stoi(param.second);
+            } else if (param.first == "request_timeout_ms") {
+                options.request_timeout_ms = std::stoll(param.second);
+            } else if (param.first == "pipeline_depth") {
+                options.pipeline_depth = std::max(1, std::stoi(param.second));
+            }
+        } catch (...) {
+            LOG_WARN("无效的负载生成器参数 %s=%s，忽略", param.first.c_str(), param.second.c_str());
+        }
+    }
+    return options;
+}
+
+LoadGenerator::LoadGenerator(LoadGeneratorOptions options)
+    : options_(std::move(options)) {
+}
+
+std::string LoadGenerator::BuildRequest(const std::string& method, const std::string& path,
+                                        const std::string& host, const std::string& body, bool keep_alive) {
+    std::string request = method + " " + path + " HTTP/1.1\r\n";
+    request += "Host: " + host + "\r\n";
+    if (!body.empty()) {
+        request += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+    }
+    request += keep_alive ? "Connection: keep-alive\r\n" : "Connection: close\r\n";
+    request += "\r\n";
+    request += body;
+    return request;
+}
+
+LoadGeneratorStats LoadGenerator::Run() {
+    LoadGeneratorStats stats;
+
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(options_.port));
+    if (inet_pton(AF_INET, options_.host.c_str(), &addr.sin_addr) <= 0) {
+        LOG_ERROR("LoadGenerator: 无效的地址 %s", options_.host.c_str());
+        return stats;
+    }
+
+    int connections = std::max(1, options_.connections);
+    if (!options_.schedule.empty()) {
+        int max_connection = 0;
+        for (const auto& item : options_.schedule) {
+            max_connection = std::max(max_connection, item.connection);
+        }
+        connections = max_connection + 1;
+    }
+    int threads = options_.threads;
+    if (threads <= 0) {
+        threads = std::min(4, static_cast<int>(std::max(1u, std::thread::hardware_concurrency())));
+    }
+    threads = std::min(threads, connections);
+    EnsureFdLimit(connections);
+
+    // 各线程均分速率，起始相位错开一个全局间隔，合起来仍是均匀的到达序列
+    double rate = options_.target_rate > 0 && options_.schedule.empty() ? options_.target_rate / threads : 0;
+    auto global_interval = options_.target_rate > 0
+        ? std::chrono::duration<double>(1.0 / options_.target_rate) : std::chrono::duration<double>(0);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (int i = 0; i < threads; ++i) {
+        int share = connections / threads + (i < connections % threads ? 1 : 0);
+        workers.push_back(std::make_unique<Worker>(
+            options_, addr, share, rate,
+            std::chrono::duration_cast<Clock::duration>(global_interval * i)));
+    }
+
+    // 回放：连接 c 归第 c % threads 个线程，为其第 c / threads 条连接
+    std::vector<const ScheduledRequest*> ordered;
+    for (const auto& item : options_.schedule) {
+        if (item.connection >= 0 && item.request < options_.requests.size()) {
+            ordered.push_back(&item);
+        }
+    }
+    std::stable_sort(ordered.begin(), ordered.end(), [](const ScheduledRequest* a, const ScheduledRequest* b) {
+        return a->offset_seconds < b->offset_seconds;
+    });
+    for (const ScheduledRequest* item : ordered) {
+        workers[item->connection % threads]->AddScripted(
+            static_cast<size_t>(item->connection / threads),
+            std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(item->offset_seconds)),
+            &options_.requests[item->request]);
+    }
+
+    LOG_INFO("LoadGenerator: %d 线程, %d 连接, 目标速率 %s", threads, connections,
+             !options_.schedule.empty() ? "按脚本回放"
+             : options_.target_rate > 0 ? std::to_string(options_.target_rate).c_str() : "闭环满载");
+
+    std::vector<std::thread> runners;
+    for (auto& worker : workers) {
+        runners.emplace_back([&worker]() { worker->Run(); });
+    }
+    for (auto& runner : runners) {
+        runner.join();
+    }
+    for (const auto& worker : workers) {
+        worker->MergeInto(stats);
+    }
+    return stats;
+}
+
+void LoadGenerator::AppendMetrics(const LoadGeneratorStats& stats, BenchmarkResult& result) {
+    auto ms = [](uint64_t ns) { return static_cast<double>(ns) / 1e6; };
+    int64_t attempted = stats.completed + stats.io_errors + stats.timeouts + stats.connect_errors;
+    double error_rate = attempted > 0 ? 100.0 * stats.Failed() / attempted : 0;
+    double throughput_mbps = stats.elapsed_seconds > 0
+        ? stats.bytes_received * 8.0 / (1024 * 1024) / stats.elapsed_seconds : 0;
+
+    result.metrics.push_back({"qps", stats.Qps(), "requests/second", "每秒成功请求数"});
+    result.metrics.push_back({"throughput_mbps", throughput_mbps, "Mbps", "网络吞吐量"});
+    result.metrics.push_back({"total_requests", static_cast<double>(stats.completed + stats.io_errors + stats.timeouts),
+                              "requests", "总请求数"});
+    result.metrics.push_back({"successful_requests", static_cast<double>(stats.Successful()), "requests", "成功请求数"});
+    result.metrics.push_back({"failed_requests", static_cast<double>(stats.Failed()), "requests", "失败请求数"});
+    result.metrics.push_back({"error_rate", error_rate, "%", "错误率"});
+    result.metrics.push_back({"connect_errors", static_cast<double>(stats.connect_errors), "count", "连接失败次数"});
+    result.metrics.push_back({"timeout_requests", static_cast<double>(stats.timeouts), "requests", "超时请求数"});
+    result.metrics.push_back({"unsent_requests", static_cast<double>(stats.unsent), "requests",
+                              "结束时仍排队未发出的计划请求"});
+
+    // 主延迟指标：从计划发送时刻算起
+    const auto& corrected = stats.corrected;
+    result.metrics.push_back({"avg_latency", corrected.MeanNs() / 1e6, "ms", "平均延迟（已修正协调遗漏）"});
+    const std::vector<std::pair<double, std::string>> percentiles = {
+        {0.50, "p50"}, {0.90, "p90"}, {0.95, "p95"}, {0.99, "p99"}, {0.999, "p999"}, {0.9999, "p9999"}};
+    for (const auto& [quantile, name] : percentiles) {
+        result.metrics.push_back({name + "_latency", ms(corrected.Percentile(quantile)), "ms",
+                                  name + " 分位延迟（已修正协调遗漏）"});
+    }
+    result.metrics.push_back({"max_latency", ms(corrected.max_value), "ms", "最大延迟"});
+
+    // 对照：从实际发出时刻算起
+    const auto& service = stats.service;
+    result.metrics.push_back({"service_avg_latency", service.MeanNs() / 1e6, "ms", "平均服务延迟（未修正）"});
+    result.metrics.push_back({"service_p50_latency", ms(service.Percentile(0.50)), "ms", "p50 服务延迟（未修正）"});
+    result.metrics.push_back({"service_p99_latency", ms(service.Percentile(0.99)), "ms", "p99 服务延迟（未修正）"});
+    result.metrics.push_back({"service_p999_latency", ms(service.Percentile(0.999)), "ms", "p999 服务延迟（未修正）"});
+}
+
+} // namespace benchmark
+} // namespace tinywebserver
@@ -0,0 +1,615 @@
+/**
+ * @file micro_benchmarks.cpp
+ * @brief 热路径组件的微基准测试
+ *
+ * 不经过 socket，直接在进程内反复调用单个组件，测每次操作的耗时与内存分配：
+ * - HttpRequest::Parse：抓取的浏览器请求头，单个请求与 16 个流水线请求
+ * - BufferChain::GetIov / Advance：HTTP/2 DATA 帧式的共享缓冲区切片
+ * - TimerWheel::AddTimeout / Tick：10 万定时器的续期与到期
+ * - HpackDecoder：首个请求（全字面量）与后续请求（动态表命中）
+ * - StaticResourceManager::GetResource：命中、淘汰，以及多线程下的扩展曲线
+ *
+ * 分配次数由本文件替换的全局 operator new 统计（线程局部计数），
+ * 改写热路径前后各跑一次即可对比。
+ *
+ * 用法：micro_benchmarks [--filter 子串] [--min-time 秒] [--quick]
+ */
+
+#include "../../include/http_request.h"
+#include "../../include/buffer_chain.h"
+#include "../../include/static_resource_manager.h"
+#include "../../include/timer/timer_wheel.h"
+#include "../../include/http2/hpack_decoder.h"
+#include "../../include/http2/hpack_encoder.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <sys/uio.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// ==================== 分配计数钩子 ====================
+
+namespace {
+thread_local uint64_t t_alloc_count = 0;
+thread_local uint64_t t_alloc_bytes = 0;
+
+void* CountedAlloc(size_t size) {
+    ++t_alloc_count;
+    t_alloc_bytes += size;
+    void* p = std::malloc(size == 0 ? 1 : size);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+} // namespace
+
+void* operator new(size_t size) { return CountedAlloc(size); }
+void* operator new[](size_t size) { return CountedAlloc(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    ++t_alloc_count;
+    t_alloc_bytes += size;
+    return std::malloc(size == 0 ? 1 : size);
+}
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept { return operator new(size, tag); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+using namespace tinywebserver;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) throw std::runtime_error(std::string("CHECK failed: ") + #cond); \
+    } while (0)
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    std::string filter;
+    double min_time_seconds = 0.5;
+};
+
+Options g_options;
+
+/**
+ * @brief 防止编译器把基准循环的结果优化掉
+ */
+template <typename T>
+void DoNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+bool Selected(const std::string& name) {
+    return g_options.filter.empty() || name.find(g_options.filter) != std::string::npos;
+}
+
+void PrintHeader() {
+    std::cout << std::left << std::setw(40) << "benchmark" << std::right
+              << std::setw(12) << "ns/op" << std::setw(12) << "allocs/op"
+              << std::setw(12) << "bytes/op" << std::setw(14) << "ops" << "\n"
+              << std::string(90, '-') << std::endl;
+}
+
+/**
+ * @brief 运行一个基准用例
+ *
+ * body(n) 执行 n 次操作；迭代次数从 1 开始倍增，直到单轮耗时达到 min_time。
+ * 每次操作内部处理 items_per_op 个条目时（如一批流水线请求），
+ * 结果按条目折算，便于与单条目用例直接比较。
+ */
+void RunCase(const std::string& name, const std::function<void(int64_t)>& body, int items_per_op = 1) {
+    if (!Selected(name)) {
+        return;
+    }
+
+    body(1);  // 预热：填满缓存、动态表等一次性状态
+
+    int64_t iterations = 1;
+    double seconds = 0;
+    uint64_t allocs = 0;
+    uint64_t bytes = 0;
+    while (true) {
+        uint64_t allocs_before = t_alloc_count;
+        uint64_t bytes_before = t_alloc_bytes;
+        auto start = Clock::now();
+        body(iterations);
+        seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        allocs = t_alloc_count - allocs_before;
+        bytes = t_alloc_bytes - bytes_before;
+        if (seconds >= g_options.min_time_seconds || iterations >= (int64_t(1) << 40)) {
+            break;
+        }
+        // 按已测速度估算下一轮迭代数，留 20% 余量，且至少翻倍
+        double scale = seconds > 0 ? g_options.min_time_seconds * 1.2 / seconds : 100.0;
+        iterations = static_cast<int64_t>(iterations * std::max(2.0, std::min(scale, 100.0)));
+    }
+
+    double items = static_cast<double>(iterations) * items_per_op;
+    std::cout << std::left << std::setw(40) << name << std::right << std::fixed
+              << std::setw(12) << std::setprecision(1) << seconds * 1e9 / items
+              << std::setw(12) << std::setprecision(2) << allocs / items
+              << std::setw(12) << std::setprecision(1) << bytes / items
+              << std::setw(14) << static_cast<int64_t>(items) << std::endl;
+}
+
+// ==================== HttpRequest::Parse ====================
+
+// Chrome 访问首页时抓取的请求头
+const char kBrowserRequest[] =
+    "GET /articles/2024/http2-header-compression?ref=home HTTP/1.1\r\n"
+    "Host: www.example.com\r\n"
+    "Connection: keep-alive\r\n"
+    "Cache-Control: max-age=0\r\n"
+    "sec-ch-ua: \"Chromium\";v=\"120\", \"Google Chrome\";v=\"120\", \"Not?A_Brand\";v=\"99\"\r\n"
+    "sec-ch-ua-mobile: ?0\r\n"
+    "sec-ch-ua-platform: \"Linux\"\r\n"
+    "Upgrade-Insecure-Requests: 1\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) "
+    "Chrome/120.0.0.0 Safari/537.36\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,"
+    "image/apng,*/*;q=0.8,application/signed-exchange;v=b3;q=0.7\r\n"
+    "Sec-Fetch-Site: same-origin\r\n"
+    "Sec-Fetch-Mode: navigate\r\n"
+    "Sec-Fetch-User: ?1\r\n"
+    "Sec-Fetch-Dest: document\r\n"
+    "Referer: https://www.example.com/\r\n"
+    "Accept-Encoding: gzip, deflate, br\r\n"
+    "Accept-Language: en-US,en;q=0.9,zh-CN;q=0.8,zh;q=0.7\r\n"
+    "Cookie: session_id=8f14e45fceea167a5a36dedd4bea2543; theme=dark; "
+    "_ga=GA1.2.1234567890.1700000000\r\n"
+    "If-None-Match: \"5d8c72a5edda8d6a\"\r\n"
+    "\r\n";
+
+// 页面加载后浏览器对子资源的请求，用于流水线批次
+std::string SubresourceRequest(int index) {
+    static const char* kPaths[] = {
+        "/static/css/main.8c1f2a.css", "/static/js/app.3f9a1c2e.bundle.js", "/static/js/vendor.77ab01.js",
+        "/images/logo.svg", "/images/hero@2x.webp", "/fonts/inter-var.woff2", "/favicon.ico",
+        "/api/session",
+    };
+    std::string path = kPaths[index % (sizeof(kPaths) / sizeof(kPaths[0]))];
+    return "GET " + path + " HTTP/1.1\r\n"
+           "Host: www.example.com\r\n"
+           "Connection: keep-alive\r\n"
+           "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) "
+           "Chrome/120.0.0.0 Safari/537.36\r\n"
+           "Accept: */*\r\n"
+           "Sec-Fetch-Site: same-origin\r\n"
+           "Sec-Fetch-Mode: no-cors\r\n"
+           "Referer: https://www.example.com/articles/2024/http2-header-compression\r\n"
+           "Accept-Encoding: gzip, deflate, br\r\n"
+           "Accept-Language: en-US,en;q=0.9,zh-CN;q=0.8,zh;q=0.7\r\n"
+           "Cookie: session_id=8f14e45fceea167a5a36dedd4bea2543; theme=dark\r\n"
+           "\r\n";
+}
+
+void BenchHttpParse() {
+    // 与连接回调相同的用法：解析后由调用者消耗缓冲区并重置解析器
+    RunCase("http_parse/browser_get", [](int64_t n) {
+        HttpRequest parser;
+        std::string buffer(kBrowserRequest);
+        for (int64_t i = 0; i < n; ++i) {
+            bool ok = parser.Parse(buffer);
+            DoNotOptimize(ok);
+            parser.Reset();
+        }
+    });
+
+    const int kPipelineDepth = 16;
+    std::string batch;
+    for (int i = 0; i < kPipelineDepth; ++i) {
+        batch += SubresourceRequest(i);
+    }
+    {
+        HttpRequest parser;
+        std::string buffer = batch;
+        int parsed = 0;
+        while (parser.Parse(buffer)) {
+            buffer.erase(0, buffer.find("\r\n\r\n") + 4);
+            parser.Reset();
+            ++parsed;
+        }
+        CHECK(parsed == kPipelineDepth && buffer.empty());
+    }
+
+    RunCase("http_parse/pipelined_x16", [&batch](int64_t n) {
+        HttpRequest parser;
+        std::string buffer;
+        buffer.reserve(batch.size());
+        for (int64_t i = 0; i < n; ++i) {
+            buffer.assign(batch);
+            size_t header_end;
+            while ((header_end = buffer.find("\r\n\r\n")) != std::string::npos) {
+                bool ok = parser.Parse(buffer);
+                DoNotOptimize(ok);
+                buffer.erase(0, header_end + 4);
+                parser.Reset();
+            }
+        }
+    }, kPipelineDepth);
+}
+
+// ==================== BufferChain ====================
+
+void BenchBufferChain() {
+    // HTTP/2 式输出：每个 DATA 帧是“9 字节帧头 + 共享负载切片”两个节点
+    const size_t kFrameSize = 16384;
+    const int kFrames = 16;
+    auto payload = std::make_shared<const std::string>(kFrameSize * kFrames, 'x');
+    auto fill = [&payload](BufferChain& chain) {
+        for (int i = 0; i < kFrames; ++i) {
+            chain.Append(std::string(9, '\0'));
+            chain.AppendShared(payload, i * kFrameSize, kFrameSize);
+        }
+    };
+
+    RunCase("buffer_chain/get_iov_32_nodes", [&fill](int64_t n) {
+        BufferChain chain;
+        fill(chain);
+        struct iovec iov[64];
+        for (int64_t i = 0; i < n; ++i) {
+            int count = chain.GetIov(iov, 64);
+            DoNotOptimize(count);
+        }
+    });
+
+    // 模拟套接字每次只写入 64KB：填充后反复 GetIov + Advance 直到清空
+    RunCase("buffer_chain/fill_drain_256KB", [&fill](int64_t n) {
+        BufferChain chain;
+        struct iovec iov[64];
+        const size_t kWriteSize = 65536;
+        for (int64_t i = 0; i < n; ++i) {
+            fill(chain);
+            while (!chain.IsEmpty()) {
+                int count = chain.GetIov(iov, 64);
+                DoNotOptimize(count);
+                chain.Advance(std::min(kWriteSize, chain.TotalBytes()));
+            }
+        }
+    });
+
+    // 小响应：头部字符串 + 正文字符串，一次写完
+    RunCase("buffer_chain/small_response", [](int64_t n) {
+        BufferChain chain;
+        struct iovec iov[8];
+        const std::string header = "HTTP/1.1 200 OK\r\nContent-Type: text/html\r\nContent-Length: 40\r\n\r\n";
+        const std::string body(40, 'b');
+        for (int64_t i = 0; i < n; ++i) {
+            chain.Append(header);
+            chain.Append(body);
+            int count = chain.GetIov(iov, 8);
+            DoNotOptimize(count);
+            chain.Advance(chain.TotalBytes());
+        }
+    });
+}
+
+// ==================== TimerWheel ====================
+
+void BenchTimerWheel() {
+    const int kTimers = 100000;
+    const int kWheelSize = 60;
+
+    // 连接活跃时续期：10 万个定时器已在轮上，逐个以新的超时重新加入
+    RunCase("timer_wheel/refresh_100k_armed", [&](int64_t n) {
+        TimerWheel wheel(kWheelSize, 1000);
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<int> timeout(1, kWheelSize);
+        for (int fd = 0; fd < kTimers; ++fd) {
+            wheel.AddTimeout(fd, timeout(rng), []() {});
+        }
+        for (int64_t i = 0; i < n; ++i) {
+            int fd = static_cast<int>(i % kTimers);
+            Error err = wheel.AddTimeout(fd, timeout(rng), []() {});
+            DoNotOptimize(err);
+        }
+    });
+
+    // 连接关闭：加入后立即移除
+    RunCase("timer_wheel/add_remove_100k_armed", [&](int64_t n) {
+        TimerWheel wheel(kWheelSize, 1000);
+        for (int fd = 0; fd < kTimers; ++fd) {
+            wheel.AddTimeout(fd, 1 + fd % kWheelSize, []() {});
+        }
+        for (int64_t i = 0; i < n; ++i) {
+            int fd = kTimers + static_cast<int>(i % 1024);
+            wheel.AddTimeout(fd, 30, []() {});
+            wheel.RemoveTimeout(fd);
+        }
+    });
+
+    // 批量到期：10 万个定时器分散在整圈，转一圈全部触发；按每个到期定时器折算
+    RunCase("timer_wheel/tick_expire_100k", [&](int64_t n) {
+        for (int64_t i = 0; i < n; ++i) {
+            TimerWheel wheel(kWheelSize, 1000);
+            int64_t fired = 0;
+            for (int fd = 0; fd < kTimers; ++fd) {
+                wheel.AddTimeout(fd, 1 + fd % kWheelSize, [&fired]() { ++fired; });
+            }
+            for (int tick = 0; tick <= kWheelSize; ++tick) {
+                wheel.Tick();
+            }
+            CHECK(fired == kTimers);
+        }
+    }, kTimers);
+}
+
+// ==================== HpackDecoder ====================
+
+std::vector<http2::HpackHeader> BrowserHeaders(const std::string& path) {
+    return {
+        {":method", "GET"},
+        {":authority", "www.example.com"},
+        {":scheme", "https"},
+        {":path", path},
+        {"sec-ch-ua", "\"Chromium\";v=\"120\", \"Google Chrome\";v=\"120\", \"Not?A_Brand\";v=\"99\""},
+        {"sec-ch-ua-mobile", "?0"},
+        {"sec-ch-ua-platform", "\"Linux\""},
+        {"user-agent", "Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) "
+                       "Chrome/120.0.0.0 Safari/537.36"},
+        {"accept", "*/*"},
+        {"sec-fetch-site", "same-origin"},
+        {"sec-fetch-mode", "no-cors"},
+        {"referer", "https://www.example.com/articles/2024/http2-header-compression"},
+        {"accept-encoding", "gzip, deflate, br"},
+        {"accept-language", "en-US,en;q=0.9,zh-CN;q=0.8,zh;q=0.7"},
+        {"cookie", "session_id=8f14e45fceea167a5a36dedd4bea2543; theme=dark"},
+    };
+}
+
+void BenchHpack() {
+    // 同一连接上的前两个请求：第一个全部字面量并写入动态表，第二个几乎全部命中索引
+    http2::HpackEncoder encoder;
+    std::vector<uint8_t> first_block;
+    std::vector<uint8_t> second_block;
+    encoder.Encode(BrowserHeaders("/static/js/app.3f9a1c2e.bundle.js"), first_block);
+    encoder.Encode(BrowserHeaders("/static/css/main.8c1f2a.css"), second_block);
+
+    const size_t kFieldCount = BrowserHeaders("/").size();
+    {
+        http2::HpackDecoder decoder;
+        auto first = decoder.Decode(first_block.data(), first_block.size());
+        auto second = decoder.Decode(second_block.data(), second_block.size());
+        CHECK(first && first->size() == kFieldCount);
+        CHECK(second && second->size() == kFieldCount);
+    }
+
+    RunCase("hpack/decode_block_first_request", [&](int64_t n) {
+        http2::HpackDecoder decoder;
+        size_t fields = 0;
+        auto on_field = [&fields](const http2::HpackHeaderView&) { ++fields; };
+        for (int64_t i = 0; i < n; ++i) {
+            decoder.Reset();
+            Error err = decoder.DecodeBlock(first_block.data(), first_block.size(), on_field);
+            DoNotOptimize(err);
+        }
+        DoNotOptimize(fields);
+    });
+
+    RunCase("hpack/decode_block_indexed", [&](int64_t n) {
+        http2::HpackDecoder decoder;
+        size_t fields = 0;
+        auto on_field = [&fields](const http2::HpackHeaderView&) { ++fields; };
+        decoder.DecodeBlock(first_block.data(), first_block.size(), on_field);
+        for (int64_t i = 0; i < n; ++i) {
+            Error err = decoder.DecodeBlock(second_block.data(), second_block.size(), on_field);
+            DoNotOptimize(err);
+        }
+        DoNotOptimize(fields);
+    });
+
+    // 拷贝成 HpackHeader 列表的旧接口，对照字段视图回调的分配开销
+    RunCase("hpack/decode_to_vector_indexed", [&](int64_t n) {
+        http2::HpackDecoder decoder;
+        decoder.Decode(first_block.data(), first_block.size());
+        for (int64_t i = 0; i < n; ++i) {
+            auto headers = decoder.Decode(second_block.data(), second_block.size());
+            DoNotOptimize(headers);
+        }
+    });
+}
+
+// ==================== StaticResourceManager ====================
+
+/**
+ * @brief 临时目录中的一组静态文件，析构时删除
+ */
+class StaticFiles {
+public:
+    StaticFiles(int count, size_t size) {
+        char dir_template[] = "/tmp/micro_bench_XXXXXX";
+        CHECK(mkdtemp(dir_template) != nullptr);
+        dir_ = dir_template;
+        std::string content(size, 'c');
+        for (int i = 0; i < count; ++i) {
+            std::string path = dir_ + "/file_" + std::to_string(i) + ".html";
+            int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            CHECK(fd >= 0);
+            CHECK(::write(fd, content.data(), content.size()) == static_cast<ssize_t>(content.size()));
+            ::close(fd);
+            paths_.push_back(path);
+        }
+    }
+
+    ~StaticFiles() {
+        for (const auto& path : paths_) {
+            ::unlink(path.c_str());
+        }
+        ::rmdir(dir_.c_str());
+    }
+
+    const std::vector<std::string>& Paths() const { return paths_; }
+
+private:
+    std::string dir_;
+    std::vector<std::string> paths_;
+};
+
+/**
+ * @brief 多线程并发命中查询：各线程轮询同一组热文件，输出总吞吐与扩展效率
+ */
+void RunCacheScaling(const std::vector<std::string>& paths) {
+    const std::string name = "static_cache/get_hit_scaling";
+    if (!Selected(name)) {
+        return;
+    }
+
+    unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+    std::cout << "\n" << name << " (hardware threads: " << hardware << ")\n"
+              << std::setw(8) << "threads" << std::setw(14) << "Mops/s" << std::setw(14) << "ns/op"
+              << std::setw(12) << "allocs/op" << std::setw(10) << "speedup" << std::setw(12) << "efficiency"
+              << "\n" << std::string(70, '-') << std::endl;
+
+    auto& manager = StaticResourceManager::GetInstance();
+    double single_thread_rate = 0;
+    for (int threads : {1, 2, 4, 8, 16}) {
+        std::atomic<bool> start{false};
+        std::atomic<bool> stop{false};
+        std::atomic<int> ready{0};
+        std::vector<int64_t> ops(threads, 0);
+        std::vector<uint64_t> allocs(threads, 0);
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t]() {
+                ready.fetch_add(1);
+                while (!start.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+                uint64_t allocs_before = t_alloc_count;
+                int64_t count = 0;
+                size_t index = static_cast<size_t>(t);
+                while (!stop.load(std::memory_order_relaxed)) {
+                    for (int k = 0; k < 64; ++k) {
+                        auto resource = manager.GetResource(paths[index++ % paths.size()]);
+                        DoNotOptimize(resource);
+                    }
+                    count += 64;
+                }
+                ops[t] = count;
+                allocs[t] = t_alloc_count - allocs_before;
+            });
+        }
+        while (ready.load() < threads) {
+            std::this_thread::yield();
+        }
+        auto begin = Clock::now();
+        start.store(true, std::memory_order_release);
+        std::this_thread::sleep_for(std::chrono::duration<double>(g_options.min_time_seconds));
+        stop.store(true);
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+
+        int64_t total_ops = 0;
+        uint64_t total_allocs = 0;
+        for (int t = 0; t < threads; ++t) {
+            total_ops += ops[t];
+            total_allocs += allocs[t];
+        }
+        double rate = total_ops / seconds;
+        if (threads == 1) {
+            single_thread_rate = rate;
+        }
+        double speedup = single_thread_rate > 0 ? rate / single_thread_rate : 0;
+        std::cout << std::fixed << std::setw(8) << threads
+                  << std::setw(14) << std::setprecision(2) << rate / 1e6
+                  << std::setw(14) << std::setprecision(1) << 1e9 / rate
+                  << std::setw(12) << std::setprecision(2) << static_cast<double>(total_allocs) / total_ops
+                  << std::setw(9) << std::setprecision(2) << speedup << "x"
+                  << std::setw(11) << std::setprecision(0)
+                  << 100.0 * speedup / std::min<unsigned>(threads, hardware) << "%" << std::endl;
+    }
+}
+
+void BenchStaticCache() {
+    StaticFiles files(64, 4096);
+    const auto& paths = files.Paths();
+    auto& manager = StaticResourceManager::GetInstance();
+    manager.SetCacheLimit(64 * 1024 * 1024);
+
+    RunCase("static_cache/get_hit", [&paths, &manager](int64_t n) {
+        for (int64_t i = 0; i < n; ++i) {
+            auto resource = manager.GetResource(paths[static_cast<size_t>(i) % paths.size()]);
+            DoNotOptimize(resource);
+        }
+    });
+
+    // 缓存只容得下 4 个文件，轮询另一组 64 个文件时每次都要 open + mmap 并淘汰最旧条目
+    StaticFiles cold_files(64, 4096);
+    const auto& cold_paths = cold_files.Paths();
+    manager.SetCacheLimit(4 * 4096);
+    RunCase("static_cache/get_miss_evict", [&cold_paths, &manager](int64_t n) {
+        for (int64_t i = 0; i < n; ++i) {
+            auto resource = manager.GetResource(cold_paths[static_cast<size_t>(i) % cold_paths.size()]);
+            DoNotOptimize(resource);
+        }
+    });
+
+    manager.SetCacheLimit(64 * 1024 * 1024);
+    for (const auto& path : paths) {
+        CHECK(manager.GetResource(path) != nullptr);
+    }
+    RunCacheScaling(paths);
+}
+
+void PrintUsage(const char* program) {
+    std::cout << "用法: " << program << " [--filter 子串] [--min-time 秒] [--quick]\n"
+              << "  --filter    只运行名称包含该子串的用例\n"
+              << "  --min-time  每个用例的最短测量时间，默认 0.5 秒\n"
+              << "  --quick     min-time 取 0.02 秒，用于冒烟检查" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc) {
+            g_options.filter = argv[++i];
+        } else if (arg == "--min-time" && i + 1 < argc) {
+            g_options.min_time_seconds = std::max(0.001, std::atof(argv[++i]));
+        } else if (arg == "--quick") {
+            g_options.min_time_seconds = 0.02;
+        } else if (arg == "--help" || arg == "-h") {
+            PrintUsage(argv[0]);
+            return 0;
+        } else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    try {
+        PrintHeader();
+        BenchHttpParse();
+        BenchBufferChain();
+        BenchTimerWheel();
+        BenchHpack();
+        BenchStaticCache();
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Micro benchmark failed: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,349 @@
+/**
+ * @file server_process.cpp
+ * @brief 独立进程服务器模式实现
+ */
+
+#include "../../include/server_process.h"
+#include "../../include/config/server_config.h"
+#include "../../include/Logger.h"
+#include "json.hpp"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <limits.h>
+#include <netinet/in.h>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace tinywebserver {
+namespace benchmark {
+
+namespace {
+
+constexpr auto kProbeInterval = std::chrono::milliseconds(20);
+constexpr auto kStopTimeout = std::chrono::seconds(5);
+
+std::string GetParam(const BenchmarkConfig& config, const std::string& name, const std::string& default_value) {
+    for (const auto& param : config.custom_params) {
+        if (param.first == name) {
+            return param.second;
+        }
+    }
+    return default_value;
+}
+
+/// 单次探测：连接并发送 GET /，收到 "HTTP/" 开头的响应即就绪
+bool ProbeOnce(const sockaddr_in& addr) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+    struct timeval tv = {1, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    bool ready = false;
+    if (connect(fd, reinterpret_cast<const struct sockaddr*>(&addr), sizeof(addr)) == 0) {
+        static const char kProbe[] = "GET / HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n";
+        char buffer[16];
+        if (send(fd, kProbe, sizeof(kProbe) - 1, MSG_NOSIGNAL) == static_cast<ssize_t>(sizeof(kProbe) - 1)) {
+            size_t got = 0;
+            while (got < 5) {
+                ssize_t n = recv(fd, buffer + got, sizeof(buffer) - got, 0);
+                if (n <= 0) {
+                    break;
+                }
+                got += static_cast<size_t>(n);
+            }
+            ready = got >= 5 && std::memcmp(buffer, "HTTP/", 5) == 0;
+        }
+    }
+    close(fd);
+    return ready;
+}
+
+} // namespace
+
+bool UseServerProcess(const BenchmarkConfig& config) {
+    return GetParam(config, "server_mode", "in_process") == "process";
+}
+
+bool ParseCpuList(const std::string& text, cpu_set_t& set) {
+    CPU_ZERO(&set);
+    std::stringstream ss(text);
+    std::string item;
+    bool any = false;
+    while (std::getline(ss, item, ',')) {
+        if (item.empty()) {
+            continue;
+        }
+        size_t dash = item.find('-');
+        try {
+            int first = std::stoi(item.substr(0, dash));
+            int last = dash == std::string::npos ? first : std::stoi(item.substr(dash + 1));
+            if (first < 0 || last < first || last >= CPU_SETSIZE) {
+                return false;
+            }
+            for (int cpu = first; cpu <= last; ++cpu) {
+                CPU_SET(cpu, &set);
+                any = true;
+            }
+        } catch (...) {
+            return false;
+        }
+    }
+    return any;
+}
+
+bool PinCurrentProcess(const std::string& cpus) {
+    cpu_set_t set;
+    if (!ParseCpuList(cpus, set)) {
+        LOG_WARN("无效的 CPU 列表: %s", cpus.c_str());
+        return false;
+    }
+    // sched_setaffinity 只作用于单个线程，逐个设置本进程已有的线程
+    bool ok = true;
+    DIR* dir = opendir("/proc/self/task");
+    if (!dir) {
+        return sched_setaffinity(0, sizeof(set), &set) == 0;
+    }
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        pid_t tid = static_cast<pid_t>(std::atoi(entry->d_name));
+        if (sched_setaffinity(tid, sizeof(set), &set) != 0) {
+            ok = false;
+        }
+    }
+    closedir(dir);
+    return ok;
+}
+
+bool WaitForHttpReady(const std::string& host, int port, double timeout_seconds, pid_t pid, bool* child_exited) {
+    if (child_exited) {
+        *child_exited = false;
+    }
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) <= 0) {
+        return false;
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(timeout_seconds));
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (pid > 0 && waitpid(pid, nullptr, WNOHANG) == pid) {
+            if (child_exited) {
+                *child_exited = true;
+            }
+            return false;   // 子进程已退出（例如端口被占用）
+        }
+        if (ProbeOnce(addr)) {
+            return true;
+        }
+        std::this_thread::sleep_for(kProbeInterval);
+    }
+    return false;
+}
+
+ServerProcessOptions ServerProcessOptions::FromConfig(const BenchmarkConfig& config) {
+    ServerProcessOptions options;
+    options.binary = GetParam(config, "server_binary", "");
+    options.base_config = GetParam(config, "server_config", "");
+    options.host = config.server_host;
+    options.port = config.server_port;
+    options.server_cpus = GetParam(config, "server_cpus", "");
+    options.client_cpus = GetParam(config, "client_cpus", "");
+    options.cache_policy = GetParam(config, "cache_policy", "");
+    try {
+        options.threads = std::stoi(GetParam(config, "server_threads", "0"));
+    } catch (...) {
+        LOG_WARN("无效的 server_threads，沿用模板配置");
+    }
+    try {
+        options.loader_threads = std::stoi(GetParam(config, "loader_threads", "-1"));
+    } catch (...) {
+        LOG_WARN("无效的 loader_threads，沿用模板配置");
+    }
+    return options;
+}
+
+ServerProcess::ServerProcess(ServerProcessOptions options)
+    : options_(std::move(options)) {
+}
+
+ServerProcess::~ServerProcess() {
+    Stop();
+}
+
+std::string ServerProcess::ResolveBinary() const {
+    if (!options_.binary.empty()) {
+        return options_.binary;
+    }
+    char path[PATH_MAX];
+    ssize_t len = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    if (len <= 0) {
+        return "./server";
+    }
+    std::string self(path, static_cast<size_t>(len));
+    return self.substr(0, self.rfind('/') + 1) + "server";
+}
+
+bool ServerProcess::WriteConfig(std::string& error) const {
+    std::shared_ptr<ServerConfig> base = options_.base_config.empty()
+        ? std::make_shared<ServerConfig>()
+        : ServerConfig::LoadFromFile(options_.base_config);
+    if (!base) {
+        error = "无法加载服务器模板配置: " + options_.base_config;
+        return false;
+    }
+    nlohmann::json j = nlohmann::json::parse(base->ToJsonString());
+    j["server"]["ip"] = options_.host;
+    j["server"]["port"] = options_.port;
+    if (options_.threads > 0) {
+        j["server"]["threads"] = options_.threads;
+    }
+    if (options_.require_h2c) {
+        j["server"]["enable_h2c"] = true;
+    }
+    if (options_.keep_alive_timeout > 0) {
+        j["limits"]["keep_alive_timeout"] = options_.keep_alive_timeout;
+    }
+    j["static"]["root"] = options_.doc_root;
+    if (!options_.cache_policy.empty()) {
+        j["static"]["cache_policy"] = options_.cache_policy;
+    }
+    if (options_.loader_threads >= 0) {
+        j["static"]["loader_threads"] = options_.loader_threads;
+    }
+    if (options_.base_config.empty()) {
+        // 默认配置会在 9090 上启动管理端口，基准测试不需要
+        j["metrics"]["enable_prometheus"] = false;
+    }
+    std::ofstream out(options_.config_path);
+    out << j.dump(2);
+    if (!out) {
+        error = "无法写入服务器配置: " + options_.config_path;
+        return false;
+    }
+    return true;
+}
+
+bool ServerProcess::Start(std::string& error) {
+    if (pid_ > 0) {
+        return true;
+    }
+    cpu_set_t server_set;
+    if (!options_.server_cpus.empty() && !ParseCpuList(options_.server_cpus, server_set)) {
+        error = "无效的 server_cpus: " + options_.server_cpus;
+        return false;
+    }
+    if (!WriteConfig(error)) {
+        return false;
+    }
+    std::string binary = ResolveBinary();
+    if (access(binary.c_str(), X_OK) != 0) {
+        error = "找不到 server 可执行文件: " + binary;
+        return false;
+    }
+
+    // exec 的参数在 fork 之前准备好，子进程只调用异步信号安全的函数
+    std::vector<std::string> args = {binary, "--config", options_.config_path};
+    std::vector<char*> argv;
+    for (auto& arg : args) {
+        argv.push_back(&arg[0]);
+    }
+    argv.push_back(nullptr);
+
+    pid_ = fork();
+    if (pid_ < 0) {
+        error = std::string("fork 失败: ") + strerror(errno);
+        pid_ = -1;
+        return false;
+    }
+    if (pid_ == 0) {
+        if (!options_.server_cpus.empty()) {
+            sched_setaffinity(0, sizeof(server_set), &server_set);
+        }
+        execv(argv[0], argv.data());
+        _exit(127);
+    }
+
+    LOG_INFO("独立进程服务器: pid=%d, %s --config %s%s%s", static_cast<int>(pid_), binary.c_str(),
+             options_.config_path.c_str(), options_.server_cpus.empty() ? "" : ", CPU ",
+             options_.server_cpus.c_str());
+    bool exited = false;
+    if (!WaitForHttpReady(options_.host, options_.port, options_.ready_timeout_seconds, pid_, &exited)) {
+        if (exited) {
+            // 已被探测循环回收，pid 可能已被复用，不能再 kill/waitpid
+            pid_ = -1;
+            error = "独立进程服务器启动后立即退出（端口被占用或配置无效？）";
+            return false;
+        }
+        error = "独立进程服务器未就绪（探测超时）";
+        Stop();
+        return false;
+    }
+    if (!options_.client_cpus.empty() && !PinCurrentProcess(options_.client_cpus)) {
+        LOG_WARN("客户端绑定 CPU %s 失败", options_.client_cpus.c_str());
+    }
+    return true;
+}
+
+void ServerProcess::Stop() {
+    if (pid_ <= 0) {
+        return;
+    }
+    kill(pid_, SIGTERM);
+    auto deadline = std::chrono::steady_clock::now() + kStopTimeout;
+    int status = 0;
+    while (waitpid(pid_, &status, WNOHANG) == 0) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            LOG_WARN("服务器进程 %d 未响应 SIGTERM，强制结束", static_cast<int>(pid_));
+            kill(pid_, SIGKILL);
+            waitpid(pid_, &status, 0);
+            break;
+        }
+        std::this_thread::sleep_for(kProbeInterval);
+    }
+    pid_ = -1;
+}
+
+void ServerProcess::AppendMetrics(const SystemResourceMonitor& monitor, BenchmarkResult& result) {
+    auto series = monitor.GetTimeSeries();
+    if (series.size() < 2) {
+        return;
+    }
+    const auto& first = series.front();
+    const auto& last = series.back();
+    double seconds = std::chrono::duration<double>(last.timestamp - first.timestamp).count();
+    double cpu_seconds = (last.cpu_time_ms - first.cpu_time_ms) / 1000.0;
+    int peak_fds = 0;
+    for (const auto& sample : series) {
+        peak_fds = std::max(peak_fds, sample.fd_count);
+    }
+    result.metrics.push_back({"server_cpu_seconds", cpu_seconds, "seconds", "服务器进程 CPU 时间（用户态+内核态）"});
+    result.metrics.push_back({"server_cpu_percent", seconds > 0 ? cpu_seconds / seconds * 100 : 0, "%",
+                              "服务器进程平均 CPU 使用率（100% = 一个核）"});
+    result.metrics.push_back({"server_peak_rss_mb", monitor.GetPeakMemoryKb() / 1024.0, "MB", "服务器进程峰值 RSS"});
+    result.metrics.push_back({"server_rss_mb", last.rss_kb / 1024.0, "MB", "负载结束时服务器进程 RSS"});
+    result.metrics.push_back({"server_context_switches", static_cast<double>(last.context_switches - first.context_switches),
+                              "count", "服务器进程上下文切换次数（全部线程）"});
+    result.metrics.push_back({"server_page_faults", static_cast<double>(last.page_faults - first.page_faults),
+                              "count", "服务器进程缺页次数"});
+    result.metrics.push_back({"server_peak_fds", static_cast<double>(peak_fds), "count", "服务器进程峰值 fd 数"});
+}
+
+} // namespace benchmark
+} // namespace tinywebserver
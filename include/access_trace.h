@@ -0,0 +1,188 @@
+#pragma once
+
+/**
+ * @file access_trace.h
+ * @brief 紧凑二进制访问轨迹（access trace）的写入与读取
+ *
+ * 服务器在每个 HTTP/1.x 响应完全写出时追加一条记录（h2 流暂不记录），
+ * 基准测试的 replay 类型读取后按原到达间隔和每条连接的请求顺序回放。
+ *
+ * 文件格式（小端）：
+ *   文件头 16 字节：魔数 "TWTRACE1"（8 字节）+ 开始时刻的 UNIX 纳秒（uint64）
+ *   每条记录：
+ *     varint  timestamp 与上一条记录之差（zigzag，记录按完成顺序写入，到达时刻可能回退）
+ *     varint  connection_id
+ *     uint8   method（TraceMethod）
+ *     varint  path 长度，随后是 path 字节
+ *     varint  response_bytes
+ *     varint  latency_ns
+ */
+
+#include "error/error.h"
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tinywebserver {
+
+/**
+ * @brief 请求方法编码（未知方法记为 kOther）
+ */
+enum class TraceMethod : uint8_t {
+    kOther = 0,
+    kGet,
+    kHead,
+    kPost,
+    kPut,
+    kDelete,
+    kOptions,
+    kPatch,
+};
+
+TraceMethod TraceMethodFromString(const std::string& method);
+const char* TraceMethodName(TraceMethod method);
+
+/**
+ * @brief 一条访问记录
+ */
+struct AccessTraceRecord {
+    uint64_t timestamp_ns = 0;     ///< 请求首字节读入时刻，相对轨迹开始
+    uint64_t connection_id = 0;    ///< 服务器进程内唯一的连接编号
+    TraceMethod method = TraceMethod::kOther;
+    std::string path;
+    uint64_t response_bytes = 0;   ///< 响应头 + 响应体字节数
+    uint64_t latency_ns = 0;       ///< 首字节读入到响应最后一字节写出
+};
+
+/**
+ * @brief 轨迹文件写入器（线程安全）
+ *
+ * 各线程把记录暂存在自己的分片里（只与后台线程竞争分片锁），后台线程每秒
+ * 或在某个分片积累满一批时收集、编码并写盘；调用 Append 的 EventLoop 线程上
+ * 没有文件 IO。同一线程的记录按追加顺序写入。
+ */
+class AccessTraceWriter {
+public:
+    AccessTraceWriter() = default;
+    ~AccessTraceWriter();
+
+    AccessTraceWriter(const AccessTraceWriter&) = delete;
+    AccessTraceWriter& operator=(const AccessTraceWriter&) = delete;
+
+    /**
+     * @brief 创建（截断）轨迹文件、写入文件头并启动后台写盘线程
+     */
+    Error Open(const std::string& path);
+
+    void Append(AccessTraceRecord record);
+
+    /// 收集全部分片并写盘（同步）
+    void Flush();
+
+    void Close();
+
+    bool IsOpen() const { return open_.load(std::memory_order_acquire); }
+
+    /// 已追加的记录数
+    uint64_t RecordCount() const { return records_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t kShardCount = 16;
+
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::vector<AccessTraceRecord> records;
+    };
+
+    void FlusherLoop();
+    /// 收集各分片暂存的记录，编码后写盘（调用方持有 mutex_）
+    void DrainLocked();
+
+    std::array<Shard, kShardCount> shards_;
+    std::atomic<bool> open_{false};
+    std::atomic<uint64_t> records_{0};
+
+    std::mutex mutex_;   ///< 保护以下成员
+    std::condition_variable cond_;
+    std::thread flusher_;
+    bool stopping_ = false;
+    std::FILE* file_ = nullptr;
+    std::string buffer_;
+    uint64_t last_timestamp_ns_ = 0;
+};
+
+/**
+ * @brief 轨迹文件顺序读取器
+ */
+class AccessTraceReader {
+public:
+    AccessTraceReader() = default;
+    ~AccessTraceReader();
+
+    AccessTraceReader(const AccessTraceReader&) = delete;
+    AccessTraceReader& operator=(const AccessTraceReader&) = delete;
+
+    /**
+     * @brief 打开文件并校验文件头
+     */
+    Error Open(const std::string& path);
+
+    /**
+     * @brief 读取下一条记录
+     * @return 读到记录返回 true；文件结束或出错返回 false（出错时 GetError() 非成功）
+     */
+    bool Next(AccessTraceRecord& record);
+
+    const Error& GetError() const { return error_; }
+
+    /// 轨迹开始时刻（UNIX 纳秒）
+    uint64_t StartUnixNs() const { return start_unix_ns_; }
+
+    /**
+     * @brief 读取整个文件
+     */
+    static Error ReadAll(const std::string& path, std::vector<AccessTraceRecord>& records);
+
+private:
+    bool ReadVarint(uint64_t& value);
+
+    std::FILE* file_ = nullptr;
+    Error error_ = Error::Success();
+    uint64_t start_unix_ns_ = 0;
+    uint64_t last_timestamp_ns_ = 0;
+};
+
+/**
+ * @brief 服务器全局轨迹开关
+ *
+ * 由 MetricsOptions::access_trace_path 启用；未启用时连接只做一次 relaxed 原子读。
+ */
+class AccessTrace {
+public:
+    static Error Start(const std::string& path);
+    static void Stop();
+    static bool IsEnabled() { return enabled_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 追加一条记录
+     * @param start_ns 请求首字节读入时刻（ServerMetrics::NowNs 时基）
+     */
+    static void Record(uint64_t start_ns, uint64_t connection_id, TraceMethod method,
+                       const std::string& path, uint64_t response_bytes, uint64_t latency_ns);
+
+    /// 为新连接分配编号
+    static uint64_t NextConnectionId() { return next_connection_id_.fetch_add(1, std::memory_order_relaxed); }
+
+private:
+    static std::atomic<bool> enabled_;
+    static std::atomic<uint64_t> next_connection_id_;
+};
+
+} // namespace tinywebserver
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "error/error.h"
+
+class EventLoop;
+class EventLoopThread;
+
+namespace tinywebserver {
+
+/**
+ * @brief 管理端口监听器（/metrics 与 /debug/ 下的调试端点）
+ *
+ * 运行在独立的 EventLoopThread 上，与数据面 Reactor 完全隔离：
+ * 抓取请求只读取各模块的原子计数或短暂持有各自的内部锁，
+ * 从不向数据面 EventLoop 投递任务。
+ *
+ * 仅支持最小化的 HTTP/1.x GET：每个连接处理一个请求后关闭（Connection: close）。
+ * 路由必须在 Start() 之前通过 RegisterHandler() 注册。
+ */
+class AdminServer {
+public:
+    /// 路由处理函数：在管理线程中执行，返回响应体
+    using Handler = std::function<std::string()>;
+
+    explicit AdminServer(int port, int backlog = 64);
+    ~AdminServer();
+
+    AdminServer(const AdminServer&) = delete;
+    AdminServer& operator=(const AdminServer&) = delete;
+
+    /**
+     * @brief 注册路由
+     * @param path 精确匹配的请求路径（忽略查询串）
+     * @param content_type 响应的 Content-Type
+     * @param handler 响应体生成函数
+     */
+    void RegisterHandler(const std::string& path, const std::string& content_type, Handler handler);
+
+    /**
+     * @brief 创建监听 socket 并启动管理线程
+     * @return 监听失败时返回 kSocketError
+     */
+    Error Start();
+
+    /**
+     * @brief 停止管理线程并关闭所有管理连接
+     */
+    void Stop();
+
+    int GetPort() const { return port_; }
+    bool IsRunning() const { return loop_ != nullptr; }
+
+private:
+    struct Route {
+        std::string content_type;
+        Handler handler;
+    };
+
+    /// 管理连接状态（仅在管理线程访问）
+    struct AdminConnection {
+        std::string input;
+        std::string output;
+        size_t output_offset = 0;
+    };
+
+    static constexpr size_t kMaxRequestSize = 8192;
+
+    void HandleAccept();
+    void HandleRead(int fd);
+    void HandleWrite(int fd);
+    void CloseConnection(int fd);
+    std::string BuildResponse(const std::string& request) const;
+    static std::string MakeHttpResponse(int code, const std::string& reason,
+                                        const std::string& content_type, const std::string& body);
+
+    int port_;
+    int backlog_;
+    int listen_fd_;
+
+    std::unique_ptr<EventLoopThread> loop_thread_;
+    EventLoop* loop_;
+
+    std::unordered_map<std::string, Route> routes_;
+    std::unordered_map<int, AdminConnection> connections_;
+};
+
+} // namespace tinywebserver
@@ -0,0 +1,53 @@
+#pragma once
+
+/**
+ * @file alloc_tag.h
+ * @brief 堆分配的子系统归属标记（连接内存画像用）
+ *
+ * 连接生命周期中的几个分配点用 AllocTagScope 标记当前线程正在为哪个子系统分配，
+ * 服务器本身不做任何统计：替换了全局 operator new 的程序（benchmark_runner 的
+ * connection_memory 类型）在每次分配时读取 CurrentAllocTag()，按子系统累计存活字节。
+ * 未替换分配器时每个作用域只是两次线程局部变量读写。
+ */
+
+#include <cstdint>
+
+namespace tinywebserver {
+
+/**
+ * @brief 分配归属的子系统
+ */
+enum class AllocTag : uint8_t {
+    kOther = 0,     ///< 未标记
+    kConnection,    ///< Connection 对象与控制块、成员容器、Server::connections_ 表项
+    kHttpRequest,   ///< HttpRequest 及解析/响应过程中留下的分配
+    kInputBuffer,   ///< 输入缓冲区 std::string
+    kOutputBuffer,  ///< BufferChain 节点
+    kEventLoop,     ///< EventLoop 的读写回调与 fd 注册表
+    kTimer,         ///< TimerWheel 节点与超时回调
+    kKeepAlive,     ///< KeepAliveManager 表项
+    kCount
+};
+
+/// 子系统名称（用于指标名）
+const char* AllocTagName(AllocTag tag);
+
+/// 当前线程的分配归属
+AllocTag CurrentAllocTag();
+
+/**
+ * @brief 作用域内把当前线程的分配记到指定子系统，析构时恢复外层标记（可嵌套）
+ */
+class AllocTagScope {
+public:
+    explicit AllocTagScope(AllocTag tag);
+    ~AllocTagScope();
+
+    AllocTagScope(const AllocTagScope&) = delete;
+    AllocTagScope& operator=(const AllocTagScope&) = delete;
+
+private:
+    AllocTag previous_;
+};
+
+} // namespace tinywebserver
@@ -176,7 +176,8 @@ class BenchmarkFactory {
 public:
     /**
      * @brief 创建基准测试实例
-     * @param benchmark_type 测试类型 ("qps", "latency", "memory", "concurrent")
+     * @param benchmark_type 测试类型 ("qps", "latency", "memory", "concurrent", "step_stress", "http2",
+     *        "pipeline", "static_mix", "large_file", "replay", "connection_memory")
      * @return 基准测试实例指针，失败返回nullptr
      */
     static std::unique_ptr<Benchmark> Create(const std::string& benchmark_type);
@@ -195,11 +196,14 @@ public:
  * - 内存使用（RSS, VmSize）
  * - CPU使用率
  * - 文件描述符数量
- * - 上下文切换次数
+ * - 上下文切换次数（全部线程之和）
  */
 class SystemResourceMonitor {
 public:
-    SystemResourceMonitor();
+    /**
+     * @param pid 被监控的进程，0 表示本进程；独立进程模式下传入服务器进程的 pid
+     */
+    explicit SystemResourceMonitor(int pid = 0);
     ~SystemResourceMonitor();
 
     /**
@@ -217,17 +221,17 @@ public:
      */
     struct ResourceMetrics {
         /// 驻留集大小（KB）
-        int64_t rss_kb;
+        int64_t rss_kb = 0;
         /// 虚拟内存大小（KB）
-        int64_t vm_size_kb;
+        int64_t vm_size_kb = 0;
         /// CPU使用时间（用户态+内核态，毫秒）
-        int64_t cpu_time_ms;
+        int64_t cpu_time_ms = 0;
         /// 文件描述符数量
-        int fd_count;
-        /// 上下文切换次数
-        int64_t context_switches;
+        int fd_count = 0;
+        /// 上下文切换次数（自愿 + 非自愿）
+        int64_t context_switches = 0;
         /// 缺页次数
-        int64_t page_faults;
+        int64_t page_faults = 0;
         /// 系统时间戳
         std::chrono::steady_clock::time_point timestamp;
     };
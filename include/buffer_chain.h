@@ -14,9 +14,10 @@
  * @brief 发送缓冲区的基本单元 (异构节点)
  * 可以是内存中的字符串 (Header/Dynamic Content)
  * 也可以是 mmap 的文件块 (Static Content)
+ * 或共享缓冲区中的一段 (HTTP/2 DATA 负载，多个帧引用同一缓冲区)
  */
 struct BufferNode {
-    enum Type { STRING, MMAP };
+    enum Type { STRING, MMAP, SHARED };
     Type type;
     
     // STRING 类型数据
@@ -24,6 +25,12 @@ struct BufferNode {
     
     // MMAP 类型数据
     std::shared_ptr<StaticResource> mmap_res;
+
+    // SHARED 类型数据
+    std::shared_ptr<const std::string> shared_data;
+
+    // MMAP / SHARED 类型引用 [offset, end) 区间
+    size_t end = 0;
     
     // 当前节点已发送的偏移量 (用于断点续传)
     size_t offset = 0;
@@ -34,14 +41,26 @@ struct BufferNode {
 
     // 构造函数：mmap 资源
     explicit BufferNode(std::shared_ptr<StaticResource> res) 
-        : type(MMAP), mmap_res(std::move(res)), offset(0) {}
+        : type(MMAP), mmap_res(std::move(res)), offset(0) {
+        end = mmap_res ? mmap_res->size : 0;
+    }
+
+    // 构造函数：mmap 资源片段 (HTTP/2 DATA 负载直接引用映射区，不拷贝)
+    BufferNode(std::shared_ptr<StaticResource> res, size_t begin, size_t len)
+        : type(MMAP), mmap_res(std::move(res)), end(begin + len), offset(begin) {}
+
+    // 构造函数：共享缓冲区片段
+    BufferNode(std::shared_ptr<const std::string> data, size_t begin, size_t len)
+        : type(SHARED), shared_data(std::move(data)), end(begin + len), offset(begin) {}
 
     // 获取当前节点剩余可读大小
     size_t LeftSize() const {
         if (type == STRING) {
             return str_data.size() - offset;
         } else if (type == MMAP && mmap_res) {
-            return mmap_res->size - offset;
+            return end - offset;
+        } else if (type == SHARED) {
+            return end - offset;
         }
         return 0;
     }
@@ -52,6 +71,8 @@ struct BufferNode {
             return str_data.data() + offset;
         } else if (type == MMAP && mmap_res) {
             return static_cast<const char*>(mmap_res->addr) + offset;
+        } else if (type == SHARED) {
+            return shared_data->data() + offset;
         }
         return nullptr;
     }
@@ -64,24 +85,56 @@ struct BufferNode {
  */
 class BufferChain {
 public:
+    /// 节点存储：libstdc++ 的 std::deque 构造即分配映射表与首个节点块，
+    /// 因此按需创建，空闲连接不持有；可由 ConnectionBufferPool 借出与回收
+    using Storage = std::deque<BufferNode>;
+
+    BufferChain() = default;
+    BufferChain(BufferChain&&) = default;
+    BufferChain& operator=(BufferChain&&) = default;
+
     // 添加数据到队尾
     void Append(const std::string& data) {
         if (!data.empty()) {
-            buffer_queue_.emplace_back(data);
+            Queue().emplace_back(data);
+            total_bytes_ += data.size();
+        }
+    }
+
+    void Append(std::string&& data) {
+        if (!data.empty()) {
             total_bytes_ += data.size();
+            Queue().emplace_back(std::move(data));
+        }
+    }
+
+    // 引用共享缓冲区的 [offset, offset + len)，不拷贝
+    void AppendShared(std::shared_ptr<const std::string> data, size_t offset, size_t len) {
+        if (data && len > 0) {
+            Queue().emplace_back(std::move(data), offset, len);
+            total_bytes_ += len;
         }
     }
 
     void Append(std::shared_ptr<StaticResource> res) {
         if (res && res->size > 0) {
-            buffer_queue_.emplace_back(res);
+            Queue().emplace_back(res);
             total_bytes_ += res->size;
         }
     }
 
+    // 追加任意类型的节点（如 mmap 片段）
+    void Append(BufferNode&& node) {
+        size_t len = node.LeftSize();
+        if (len > 0) {
+            Queue().push_back(std::move(node));
+            total_bytes_ += len;
+        }
+    }
+
     // 是否为空
     bool IsEmpty() const {
-        return buffer_queue_.empty();
+        return !queue_ || queue_->empty();
     }
 
     // 获取总剩余字节数
@@ -89,6 +142,28 @@ public:
         return total_bytes_;
     }
 
+    /// 是否持有节点存储
+    bool HasStorage() const {
+        return queue_ != nullptr;
+    }
+
+    /// 采用外部提供的空存储（已有存储时丢弃传入的）
+    void AdoptStorage(std::unique_ptr<Storage> storage) {
+        if (!queue_ && storage) {
+            storage->clear();
+            queue_ = std::move(storage);
+        }
+    }
+
+    /// 交出节点存储以便复用；仍有未发送数据时返回 nullptr
+    std::unique_ptr<Storage> ReleaseStorage() {
+        if (!IsEmpty()) {
+            return nullptr;
+        }
+        total_bytes_ = 0;
+        return std::move(queue_);
+    }
+
     /**
      * @brief 填充 iovec 数组，准备进行 writev
      * @param iov 输出参数，iovec 数组指针
@@ -96,10 +171,10 @@ public:
      * @return 实际填充的 iovec 数量
      */
     int GetIov(struct iovec* iov, int max_count) {
-        if (buffer_queue_.empty()) return 0;
+        if (IsEmpty()) return 0;
 
         int count = 0;
-        for (const auto& node : buffer_queue_) {
+        for (const auto& node : *queue_) {
             if (count >= max_count) break;
             
             size_t len = node.LeftSize();
@@ -119,21 +194,20 @@ public:
     void Advance(size_t len) {
         if (len > total_bytes_) {
             // 防御性编程：理论上不应发生，除非外部逻辑错误
-            buffer_queue_.clear();
-            total_bytes_ = 0;
+            Clear();
             return;
         }
 
         total_bytes_ -= len;
 
-        while (len > 0 && !buffer_queue_.empty()) {
-            BufferNode& front = buffer_queue_.front();
+        while (len > 0 && !IsEmpty()) {
+            BufferNode& front = queue_->front();
             size_t left = front.LeftSize();
 
             if (len >= left) {
                 // 当前节点已完全发完，移除
                 len -= left;
-                buffer_queue_.pop_front();
+                queue_->pop_front();
             } else {
                 // 当前节点只发了一部分，更新 offset
                 front.offset += len;
@@ -142,14 +216,36 @@ public:
         }
     }
 
-    // 清空缓冲区
+    // 把 other 的全部节点移到本链表尾部（other 随后为空）
+    void Splice(BufferChain& other) {
+        if (other.IsEmpty()) {
+            return;
+        }
+        Storage& queue = Queue();
+        for (auto& node : *other.queue_) {
+            queue.push_back(std::move(node));
+        }
+        total_bytes_ += other.total_bytes_;
+        other.Clear();
+    }
+
+    // 清空缓冲区（保留已有存储）
     void Clear() {
-        buffer_queue_.clear();
+        if (queue_) {
+            queue_->clear();
+        }
         total_bytes_ = 0;
     }
 
 private:
-    std::deque<BufferNode> buffer_queue_;
+    Storage& Queue() {
+        if (!queue_) {
+            queue_ = std::make_unique<Storage>();
+        }
+        return *queue_;
+    }
+
+    std::unique_ptr<Storage> queue_;
     size_t total_bytes_ = 0;
 };
 
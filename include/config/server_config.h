@@ -30,6 +30,7 @@ public:
         bool tcp_cork = false;
         bool use_so_reuseport = false;      // 启用 SO_REUSEPORT 多队列优化
         int so_reuseport_sockets = 0;       // SO_REUSEPORT 监听socket数量，0表示等于线程数
+        bool enable_h2c = true;             // 接受明文 HTTP/2（前言直连与 Upgrade: h2c）
     };
 
     // 资源限制配置
@@ -41,6 +42,8 @@ public:
         int keep_alive_timeout = 15;              // 秒
         size_t max_input_buffer = 65536;          // 64KB
         size_t max_output_buffer = 1048576;       // 1MB
+        uint64_t max_upload_size = 1073741824;    // 1GB，上传请求体上限（普通请求体受 max_request_size 限制）
+        size_t output_high_watermark = 262144;    // 256KB，流式响应积压超过即暂停生产，降到一半后恢复
     };
 
     // 日志配置
@@ -57,6 +60,14 @@ public:
         std::string root = "./public";
         size_t cache_size = 100;
         int cache_ttl = 300;                      // 秒
+        std::string cache_policy = "lru";         // lru / wtinylfu / wtinylfu_size
+        size_t loader_threads = 2;                // 缓存未命中的后台加载线程数，0 表示在 EventLoop 上同步加载
+        bool warmup = false;                      // 启动时预热缓存，完成（或超时）后才开始监听
+        int warmup_budget_ms = 5000;              // 预热时间预算（毫秒）
+        size_t warmup_threads = 4;                // 预热并行加载线程数
+        std::string hot_list_path;                // 热点列表文件：预热时优先加载，运行中定期保存；空表示不使用
+        int hot_list_save_interval = 60;          // 热点列表保存间隔（秒）
+        std::string upload_dir;                   // POST /upload/<name> 的保存目录，空表示不接受上传
     };
 
     // 监控指标配置
@@ -64,6 +75,9 @@ public:
         bool enable_prometheus = true;
         int prometheus_port = 9090;
         int collect_interval = 5;                   // 秒
+        int stall_threshold_ms = 500;               // 事件循环停顿阈值，0 表示关闭看门狗
+        bool enable_perf_counters = false;          // 按阶段采集硬件计数（perf_event_open）
+        std::string access_trace_path;              // 非空时把每个请求写入二进制访问轨迹（供 replay 基准回放）
     };
 
     /**
@@ -15,6 +15,7 @@
 #include "connection_limits.h"
 #include "error/error.h"
 #include "config/server_config.h"
+#include "access_trace.h"
 
 
 class HttpRequest;
@@ -22,6 +23,12 @@ class EventLoop;
 class StaticResource; // 确保 StaticResource 也能被识别
 namespace tinywebserver {
     class KeepAliveManager;
+    class BodyDecoder;
+    class BodySink;
+namespace http2 {
+    class H2Connection;
+    class H2Stream;
+}
 }
 
 enum class ConnState {
@@ -38,6 +45,13 @@ class Connection : public std::enable_shared_from_this<Connection> {
 public:
     using MessageCallback = std::function<void(std::shared_ptr<Connection>, const std::string&)>;
     using CloseCallback = std::function<void(int)>;
+    /// 请求体接收结束（成功或出错）；此时 sink 仍有效，请求体之后的输入尚未交给消息回调
+    using BodyCompleteCallback = std::function<void(std::shared_ptr<Connection>, const tinywebserver::Error&)>;
+    /// 输出积压降到低水位（或连接关闭）后的回调，见 NotifyWhenWritable
+    using WritableCallback = std::function<void()>;
+    /// HTTP/2 请求回调：流的请求头（及请求体）已完整到达
+    using H2RequestCallback = std::function<void(std::shared_ptr<Connection>,
+                                                 std::shared_ptr<tinywebserver::http2::H2Stream>)>;
 
     Connection(int fd, EventLoop* loop,
                std::shared_ptr<tinywebserver::ServerConfig> config = nullptr,
@@ -66,16 +80,79 @@ public:
 
     void SetMessageCallback(MessageCallback cb) { message_callback_ = std::move(cb); }
     void SetCloseCallback(CloseCallback cb) { close_callback_ = std::move(cb); }
+    /// 设置后启用 h2c（前言直连与 Upgrade: h2c），未设置时只处理 HTTP/1.x
+    void SetH2RequestCallback(H2RequestCallback cb) { h2_request_callback_ = std::move(cb); }
+
+    /// 连接是否已切换到 HTTP/2
+    bool IsHttp2() const { return h2_ != nullptr; }
 
     // 【新增】Keep-Alive 管理
     void UpdateKeepAliveState(bool keep_alive, int idle_timeout = 0);
+    /// 请求解析完成后调用（解析器仍保存本请求时），同时为访问轨迹记下方法与路径
     void OnRequestStart(bool keep_alive, int idle_timeout = 0);
     void OnRequestComplete();
     bool ShouldKeepAlive() const;
 
     // HTTP 相关辅助
     std::string& GetInputBuffer() { return input_buffer_; }
-    std::shared_ptr<HttpRequest> GetHttpParser() { return http_parser_; }
+    /// 请求解析器按需从本循环的缓冲区池借用，连接空闲时归还（须在 loop 线程调用）
+    std::shared_ptr<HttpRequest> GetHttpParser();
+
+    /**
+     * @brief 非阻塞获取静态资源（须在 loop 线程调用）
+     *
+     * 命中缓存时直接返回；未命中时交给后台加载线程并置 pending，此时消息回调应保留本请求
+     * 并返回。加载完成后连接在本 loop 上重新调用消息回调，再次调用本函数即得到该资源。
+     */
+    std::shared_ptr<StaticResource> AcquireStaticResource(const std::string& path, bool& pending);
+
+    /**
+     * @brief 挂起不在输入缓冲区中的请求（HTTP/2 流、请求体已读完的请求），等待 path 加载完成
+     *
+     * AcquireStaticResource 对 path 置 pending 后调用：加载完成时在本 loop 先调用 retry，
+     * 再处理输入缓冲区中等待的请求；retry 内再次获取 path 即得到该资源。连接关闭时丢弃。
+     */
+    void ParkUntilLoaded(const std::string& path, std::function<void()> retry);
+
+    /**
+     * @brief 开始接收请求体（须在 loop 线程、由消息回调在消费请求头后调用）
+     *
+     * 之后的输入先经 decoder 解码写入 sink，不在输入缓冲区中积累；sink 支持时载荷直接
+     * 从 socket 经 splice 搬运。结束后调用 on_complete，再把剩余输入交给消息回调。
+     * 消息回调调用本函数后应立即返回。
+     */
+    void StartRequestBody(std::unique_ptr<tinywebserver::BodyDecoder> decoder,
+                          std::unique_ptr<tinywebserver::BodySink> sink, BodyCompleteCallback on_complete);
+
+    /**
+     * @brief 直接把节点链移入输出缓冲区（须在 loop 线程调用），节点不再拷贝
+     */
+    void SendChain(BufferChain& chain);
+
+    /**
+     * @brief 输出积压与水位（流式响应的背压，须在 loop 线程调用）
+     *
+     * 积压超过高水位（LimitsOptions::output_high_watermark）时生产者应暂停写入，
+     * 积压降到低水位（高水位的一半）后经 NotifyWhenWritable 恢复。
+     */
+    size_t GetOutputBytes() const { return output_buffer_.TotalBytes(); }
+    size_t GetOutputHighWatermark() const;
+
+    /**
+     * @brief 下一次写出后积压不超过低水位时调用一次 cb（须在 loop 线程调用）
+     *
+     * 连接关闭时未触发的回调在下一轮事件循环中调用，此时连接已不可写。
+     */
+    void NotifyWhenWritable(WritableCallback cb);
+
+    /**
+     * @brief 流式响应期间暂停把后续请求交给消息回调（HTTP/1.1 响应不能交错）
+     *
+     * End 后在下一轮事件循环继续处理输入缓冲区中等待的请求；期间输入超过上限时暂停读取。
+     */
+    void BeginStreamingResponse() { response_streaming_ = true; }
+    void EndStreamingResponse();
+    bool IsStreamingResponse() const { return response_streaming_; }
 
     // 【新增】清空读缓冲区 (用于长连接复用)
     void ClearReadBuffer();
@@ -99,6 +176,7 @@ private:
     
     void SendInLoop(const std::string& data);
     void SendResourceInLoop(std::shared_ptr<StaticResource> res);
+    void SendChainInLoop(BufferChain& chain);
     void ShutdownInLoop();
 
     EventLoop* loop_;
@@ -129,11 +207,37 @@ private:
     // 【新增】统一关闭路径内部实现
     void CloseInLoop(const tinywebserver::Error& reason);
 
+    /// 【新增】记录已完全写出的请求延迟（total / queue_to_flush）
+    void RecordFlushedRequests();
+
+    /// 【新增】h2c 协议切换：检测前言或 Upgrade: h2c，返回输入是否归 HTTP/2 处理
+    bool TryStartHttp2();
+    bool TryUpgradeH2c();
+    void StartHttp2();
+    /// 将输入缓冲区交给 H2Connection 解帧
+    void ProcessHttp2Input();
 
-    // 读缓冲区：依然保持 string，处理 HTTP 文本协议头
+    /// 【新增】按需缓冲区：写入前借用输出节点存储，输入输出都排空后归还全部缓冲区
+    void AcquireOutputStorage();
+    void ReleaseIdleBuffers();
+
+    /// 【新增】后台加载完成（loop 线程）：交出结果并重新处理输入缓冲区中等待的请求
+    void OnStaticResourceLoaded(const std::string& path, std::shared_ptr<StaticResource> resource);
+
+    /// 【新增】把输入交给消息回调；正在接收请求体时先解码请求体，结束后继续交给回调
+    void DispatchInput();
+    /// 输入缓冲区中的字节全部交给请求体解码器
+    void ProcessRequestBody();
+    /// 从 socket 接收请求体，返回 true 表示请求体已结束，false 表示 socket 已读空或连接已关闭
+    bool ReadRequestBody(int fd);
+    void FinishRequestBody(const tinywebserver::Error& result);
+    size_t InputBufferLimit() const;
+
+
+    // 读缓冲区：依然保持 string，处理 HTTP 文本协议头；读入前从缓冲区池借用，空闲时归还
     std::string input_buffer_;
     
-    // 【修改】写缓冲区：升级为支持 Scatter/Gather 的链式缓冲
+    // 【修改】写缓冲区：升级为支持 Scatter/Gather 的链式缓冲；节点存储同样按需借用
     BufferChain output_buffer_;
     std::shared_ptr<tinywebserver::ServerConfig> config_;
     tinywebserver::KeepAliveManager* keep_alive_manager_;
@@ -147,6 +251,49 @@ private:
     bool idle_timeout_active_;
     std::chrono::steady_clock::time_point last_activity_time_;
 
+    // 【新增】请求延迟追踪：按输出字节偏移判断响应何时完全写出
+    struct PendingLatency {
+        uint64_t end_offset;   ///< 响应最后一字节在输出流中的累计偏移
+        uint64_t start_ns;     ///< 请求首字节读入时间
+        uint64_t queued_ns;    ///< 响应入队完成时间
+        // 访问轨迹（仅在 AccessTrace 启用时填写）
+        bool traced = false;
+        tinywebserver::TraceMethod method = tinywebserver::TraceMethod::kOther;
+        std::string path;
+        uint64_t response_bytes = 0;
+    };
+    uint64_t request_start_ns_ = 0;
+    uint64_t last_read_ns_ = 0;
+    uint64_t bytes_queued_ = 0;
+    uint64_t bytes_flushed_ = 0;
+    std::vector<PendingLatency> pending_latency_;
+
+    // 【新增】访问轨迹：OnRequestStart 记下，OnRequestComplete 移入 pending_latency_（仅在轨迹启用后分配）
+    struct TraceState;
+    std::unique_ptr<TraceState> trace_;
+
+    // 【新增】HTTP/2（h2c）：切换后所有输入交给 h2_ 处理
+    std::unique_ptr<tinywebserver::http2::H2Connection> h2_;
+    H2RequestCallback h2_request_callback_;
+    bool h2_preface_checked_ = false;   ///< 前言只可能出现在连接开头
+    bool h2_refilling_ = false;         ///< HandleWrite 正在向 h2_ 要下一批 DATA，帧只入队不重入写
+
+    // 【新增】静态资源异步加载：等待期间不再处理新输入，完成后结果经 load_ 交给重新执行的回调
+    bool load_pending_ = false;
+    struct LoadState;
+    std::unique_ptr<LoadState> load_;   ///< 仅在有挂起请求或交出加载结果期间分配
+
+    // 【新增】正在接收的请求体（仅在接收期间分配）
+    struct RequestBodyState;
+    std::unique_ptr<RequestBodyState> body_;
+    bool reading_paused_ = false;
+
+    // 【新增】流式响应：进行中不再分派新请求；等待积压降到低水位的生产者
+    bool response_streaming_ = false;
+    std::unique_ptr<std::vector<WritableCallback>> writable_callbacks_;   ///< 首次登记时分配
+    /// 积压不超过低水位时交出全部等待中的回调
+    void RunWritableCallbacks();
+
     std::shared_ptr<HttpRequest> http_parser_;
     MessageCallback message_callback_;
     CloseCallback close_callback_;
@@ -0,0 +1,69 @@
+#pragma once
+
+/**
+ * @file connection_buffer_pool.h
+ * @brief 单个 EventLoop 的连接缓冲区池
+ *
+ * 连接只在读写进行中借用输入缓冲区、输出节点存储和请求解析器，
+ * 输入与输出都排空后归还（参考 nginx 的按需缓冲区）。空闲的长连接因此
+ * 不再各自持有这几块分配，其内存只剩 Connection 对象本身、epoll 注册与定时器。
+ *
+ * 池归属于一个 EventLoop，只在该循环线程中使用，不加锁。
+ * 缓存数量与单个字符串的容量都有上限，流量峰值过后不会长期占住内存。
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "buffer_chain.h"
+#include "http_request.h"
+
+namespace tinywebserver {
+
+class ConnectionBufferPool {
+public:
+    /// 每类对象最多缓存的数量
+    static constexpr size_t kMaxCachedPerKind = 256;
+    /// 容量超过此值的输入缓冲区归还时直接释放（大请求体不占住池）
+    static constexpr size_t kMaxCachedStringCapacity = 16 * 1024;
+
+    struct Stats {
+        size_t cached_strings;     ///< 池中空闲的输入缓冲区
+        size_t cached_storages;    ///< 池中空闲的输出节点存储
+        size_t cached_requests;    ///< 池中空闲的请求解析器
+        uint64_t hits;             ///< 借用时命中缓存的次数
+        uint64_t misses;           ///< 借用时池为空的次数
+    };
+
+    ConnectionBufferPool() = default;
+    ConnectionBufferPool(const ConnectionBufferPool&) = delete;
+    ConnectionBufferPool& operator=(const ConnectionBufferPool&) = delete;
+
+    /// 借出输入缓冲区：buffer 尚未持有堆容量时换入池中的字符串（池空则不变）
+    void AcquireString(std::string& buffer);
+    /// 归还输入缓冲区，buffer 随后为空且不再持有堆容量
+    void ReleaseString(std::string& buffer);
+
+    /// 借出输出节点存储，池空时返回 nullptr（由 BufferChain 按需创建）
+    std::unique_ptr<BufferChain::Storage> AcquireStorage();
+    void ReleaseStorage(std::unique_ptr<BufferChain::Storage> storage);
+
+    /// 借出已重置的请求解析器，池空时新建
+    std::shared_ptr<HttpRequest> AcquireRequest();
+    /// 归还解析器并置空 request；仍被其它持有者引用时只放弃本引用
+    void ReleaseRequest(std::shared_ptr<HttpRequest>& request);
+
+    Stats GetStats() const;
+
+private:
+    std::vector<std::string> strings_;
+    std::vector<std::unique_ptr<BufferChain::Storage>> storages_;
+    std::vector<std::shared_ptr<HttpRequest>> requests_;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+};
+
+} // namespace tinywebserver
@@ -8,6 +8,8 @@ struct ConnectionLimits {
     static constexpr size_t kMaxInputBuffer = 64 * 1024;      // 64KB
     /// 最大输出缓冲区大小（字节）
     static constexpr size_t kMaxOutputBuffer = 1 * 1024 * 1024; // 1MB
+    /// 流式响应的输出高水位（字节），低水位为其一半
+    static constexpr size_t kOutputHighWatermark = 256 * 1024; // 256KB
     /// 单个HTTP请求最大大小（字节）
     static constexpr size_t kMaxRequestSize = 8 * 1024;       // 8KB
     /// HTTP头部最大大小（字节）
@@ -0,0 +1,56 @@
+#pragma once
+
+/**
+ * @file frequency_sketch.h
+ * @brief 带老化的 4 位 Count-Min 频率草图（W-TinyLFU 准入用）
+ *
+ * 每个 uint64 存 16 个 4 位计数器，按四行哈希各取一个计数器，估计值取四者最小。
+ * 计数器饱和于 15；累计增量达到采样上限（10 倍容量）时所有计数器减半，
+ * 使过去的热度随时间衰减，新热点能够取代旧热点。
+ *
+ * 非线程安全，由调用方（StaticResourceManager）加锁。
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace tinywebserver {
+
+class FrequencySketch {
+public:
+    static constexpr uint32_t kMaxFrequency = 15;
+
+    /// @param expected_entries 预计同时需要区分的键数，决定表宽
+    explicit FrequencySketch(size_t expected_entries = 1024);
+
+    /// 按新的预计键数重建（清空计数）
+    void Resize(size_t expected_entries);
+    void Clear();
+
+    /// 记录一次访问
+    void Increment(uint64_t hash);
+    /// 访问频率估计（0 ~ 15）
+    uint32_t Estimate(uint64_t hash) const;
+
+    /// 已执行的老化（减半）次数
+    uint64_t GetResetCount() const { return resets_; }
+    size_t GetSampleSize() const { return sample_size_; }
+
+private:
+    static constexpr int kDepth = 4;
+
+    /// 第 row 行计数器所在的字下标
+    size_t IndexOf(uint64_t hash, int row) const;
+    /// 第 row 行计数器在字内的 4 位槽号（每行固定占 4 个槽中的一个）
+    static int SlotOf(uint64_t hash, int row);
+    void Reset();
+
+    std::vector<uint64_t> table_;
+    size_t mask_ = 0;
+    size_t sample_size_ = 0;
+    size_t additions_ = 0;
+    uint64_t resets_ = 0;
+};
+
+} // namespace tinywebserver
@@ -0,0 +1,169 @@
+#pragma once
+
+/**
+ * @file request_body.h
+ * @brief HTTP/1.1 请求体的增量解码（Content-Length 与 chunked）与流式接收端
+ *
+ * BodyDecoder 每次只处理调用方给出的字节，解出的载荷立即交给回调，不缓存整个请求体。
+ * 载荷区间（Content-Length 剩余部分或当前分块的数据）可以不经解码器直接搬运，
+ * 由 ConsumeRaw 记账，FileUploadSink 借此用 splice 把 socket 数据经管道直接写入文件。
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "error/error.h"
+#include "http_request.h"
+
+namespace tinywebserver {
+
+class BodyDecoder {
+public:
+    enum class Mode {
+        kNone,            ///< 无请求体
+        kContentLength,
+        kChunked,
+    };
+
+    /// 解出的载荷片段
+    using DataCallback = std::function<Error(const char* data, size_t len)>;
+
+    /**
+     * @brief 按请求头确定请求体格式
+     * @param max_body_size 载荷总长上限，超出时返回 kRequestTooLarge
+     *
+     * 同时带 Transfer-Encoding 与 Content-Length、或 Transfer-Encoding 不是 chunked 时
+     * 视为非法请求（防止请求走私）。
+     */
+    Error Init(const HttpRequest& request, uint64_t max_body_size);
+
+    Mode GetMode() const { return mode_; }
+    bool HasBody() const { return mode_ != Mode::kNone && !done_; }
+    bool IsDone() const { return done_; }
+
+    /**
+     * @brief 输入一段字节，载荷经 on_data 交出
+     * @param consumed 本次消费的字节数；请求体结束后剩余字节属于下一个请求，不会被消费
+     */
+    Error Feed(const char* data, size_t len, const DataCallback& on_data, size_t& consumed);
+
+    /// 接下来可以不经 Feed 直接搬运的载荷字节数（0 表示下一段是分块头等帧字节）
+    uint64_t RawRemaining() const;
+    /// 记录已直接搬运的载荷字节（n 不超过 RawRemaining）
+    void ConsumeRaw(uint64_t n);
+
+    /// 已解出的载荷总字节数
+    uint64_t GetBodyBytes() const { return body_bytes_; }
+
+private:
+    enum class ChunkState {
+        kSize,          ///< 十六进制分块长度
+        kExtension,     ///< 分块扩展，忽略到行尾
+        kSizeLf,
+        kData,
+        kDataCr,
+        kDataLf,
+        kTrailer,       ///< 尾部字段行首
+        kTrailerLine,   ///< 尾部字段内容，忽略到行尾
+        kTrailerLf,
+        kEndLf,         ///< 空行后的 LF
+    };
+
+    Error FeedChunked(const char* data, size_t len, const DataCallback& on_data, size_t& consumed);
+    Error CheckLimit(uint64_t add) const;
+
+    Mode mode_ = Mode::kNone;
+    bool done_ = true;
+    uint64_t max_body_size_ = 0;
+    uint64_t remaining_ = 0;        ///< Content-Length 剩余或当前分块剩余
+    uint64_t body_bytes_ = 0;
+    ChunkState chunk_state_ = ChunkState::kSize;
+    int size_digits_ = 0;
+    size_t trailer_bytes_ = 0;
+};
+
+/**
+ * @brief 请求体接收端
+ */
+class BodySink {
+public:
+    virtual ~BodySink() = default;
+
+    virtual Error Write(const char* data, size_t len) = 0;
+
+    /// 是否支持从 socket 直接搬运（SpliceFrom）
+    virtual bool SupportsSplice() const { return false; }
+
+    /**
+     * @brief 从 socket 直接搬运至多 max_len 字节
+     * @param moved 实际搬运的字节数，为 0 且 eof 为 false 表示 socket 暂无数据
+     * @param eof 对端已关闭写方向
+     */
+    virtual Error SpliceFrom(int socket_fd, size_t max_len, size_t& moved, bool& eof);
+
+    /// 请求体完整收到后调用
+    virtual Error Finish() { return Error::Success(); }
+};
+
+/**
+ * @brief 丢弃载荷，只计字节数（普通请求带的请求体）
+ */
+class DiscardSink : public BodySink {
+public:
+    Error Write(const char* /*data*/, size_t len) override {
+        bytes_ += len;
+        return Error::Success();
+    }
+    uint64_t GetBytes() const { return bytes_; }
+
+private:
+    uint64_t bytes_ = 0;
+};
+
+/**
+ * @brief 写入文件的上传接收端：缓冲区中的字节用 write，其余 socket → 管道 → 文件用 splice
+ *
+ * 先写入同目录的临时文件，Finish 时 rename 到目标路径；未完成即销毁时删除临时文件。
+ */
+class FileUploadSink : public BodySink {
+public:
+    /// 单次 splice 的上限，与默认管道容量一致
+    static constexpr size_t kSpliceChunk = 64 * 1024;
+
+    FileUploadSink() = default;
+    ~FileUploadSink() override;
+
+    FileUploadSink(const FileUploadSink&) = delete;
+    FileUploadSink& operator=(const FileUploadSink&) = delete;
+
+    Error Open(const std::string& path);
+
+    Error Write(const char* data, size_t len) override;
+    /// 文件系统或 socket 不支持 splice（EINVAL）后退回 Write
+    bool SupportsSplice() const override { return splice_supported_; }
+    Error SpliceFrom(int socket_fd, size_t max_len, size_t& moved, bool& eof) override;
+    Error Finish() override;
+
+    uint64_t GetBytes() const { return bytes_; }
+    /// 经 splice 写入的字节数
+    uint64_t GetSplicedBytes() const { return spliced_bytes_; }
+
+private:
+    Error WriteFile(const char* data, size_t len);
+    /// 把管道中的 len 字节写入文件
+    Error DrainPipe(size_t len);
+    void CloseAll();
+
+    std::string path_;
+    std::string tmp_path_;
+    int file_fd_ = -1;
+    int pipe_fds_[2] = {-1, -1};
+    uint64_t bytes_ = 0;
+    uint64_t spliced_bytes_ = 0;
+    bool splice_supported_ = true;
+    bool finished_ = false;
+};
+
+} // namespace tinywebserver
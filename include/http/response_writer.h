@@ -0,0 +1,179 @@
+#pragma once
+
+/**
+ * @file response_writer.h
+ * @brief 流式响应：动态内容边生成边发送，HTTP/1.1 用 chunked 编码，HTTP/2 用 DATA 帧
+ *
+ * 处理器不必预先拼出完整响应体再计算 Content-Length。写入前检查 IsWritable，
+ * 积压超过连接输出高水位时停止生产，在 OnWritable 回调中继续，
+ * 因此一个响应占用的内存以水位为界。所有方法须在连接所属的 loop 线程调用。
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "error/error.h"
+#include "http_request.h"
+
+class Connection;
+
+namespace tinywebserver {
+
+namespace http2 {
+class H2Stream;
+}
+
+class ResponseWriter : public std::enable_shared_from_this<ResponseWriter> {
+public:
+    using Headers = std::vector<std::pair<std::string, std::string>>;
+    /// 响应结束（End 或中止）时调用一次：status_code 为已发送的状态码，result 为中止原因
+    using FinishCallback = std::function<void(int status_code, uint64_t body_bytes, const Error& result)>;
+
+    virtual ~ResponseWriter() = default;
+
+    ResponseWriter(const ResponseWriter&) = delete;
+    ResponseWriter& operator=(const ResponseWriter&) = delete;
+
+    /**
+     * @brief 立即发出状态行与响应头（首次 Write 或 End 前未调用时按 200 发送）
+     *
+     * 带 Content-Length 时响应体按原样发送，End 时校验长度；
+     * 否则 HTTP/1.1 使用 chunked，HTTP/1.0 以关闭连接结束响应体。
+     */
+    Error WriteHead(int status_code, Headers headers = {});
+
+    /// 发送一段响应体；积压超过高水位时仍会入队，调用方应据 IsWritable 暂停生产
+    Error Write(const char* data, size_t len);
+    Error Write(const std::string& data) { return Write(data.data(), data.size()); }
+    /// 接管字符串，大段数据不再拷贝
+    Error Write(std::string&& data);
+
+    /// 结束响应（chunked 发送终止块，HTTP/2 发送 END_STREAM）
+    Error End();
+
+    /**
+     * @brief 中止响应：响应头未发出时改发 500，否则关闭连接（HTTP/2 为重置流）
+     */
+    void Abort(const Error& reason);
+
+    /// 连接（或 HTTP/2 流）仍可写且响应未结束
+    bool IsOpen() const { return !finished_ && IsOpen_(); }
+    /// 积压未超过高水位，可以继续写入
+    bool IsWritable() const;
+    /**
+     * @brief 可写后调用一次 cb：积压降到低水位，或连接关闭（此时 IsOpen 为 false）
+     *
+     * 当前已可写或已关闭时在下一轮事件循环调用。
+     */
+    void OnWritable(std::function<void()> cb);
+
+    bool IsFinished() const { return finished_; }
+    bool IsHeadSent() const { return head_sent_; }
+    uint64_t GetBodyBytes() const { return body_bytes_; }
+    /// 当前积压（连接输出缓冲区，HTTP/2 另加流上等待窗口的字节）
+    size_t GetBacklog() const { return Backlog_(); }
+
+    void SetFinishCallback(FinishCallback cb) { finish_callback_ = std::move(cb); }
+
+protected:
+    ResponseWriter(std::shared_ptr<Connection> conn, bool head_only);
+
+    /// 按 status_code_ 发出响应头；no_body_ 为 true 时响应体为空（HEAD、1xx、204、304）
+    virtual Error SendHead_(const Headers& headers) = 0;
+    /// 发送非空的响应体片段
+    virtual Error SendBody_(std::string&& data) = 0;
+    virtual Error SendEnd_() = 0;
+    /// 中止：响应头未发出时改发 500，否则关闭连接或重置流（连接已关闭时只清理状态）
+    virtual void SendAbort_(const Error& reason) = 0;
+    virtual bool IsOpen_() const = 0;
+    virtual size_t Backlog_() const = 0;
+
+    /// 析构时仍未结束的响应按中止处理（由派生类析构函数调用，虚函数仍可用）
+    void AbortIfUnfinished_();
+    void Finish_(const Error& result);
+    /// 等待中的 OnWritable 回调满足条件（可写或已关闭）时交出
+    void CheckWritable_();
+
+    std::shared_ptr<Connection> conn_;
+    int status_code_ = 200;
+    bool head_only_ = false;
+    bool no_body_ = false;
+    bool head_sent_ = false;
+    bool finished_ = false;
+    int64_t content_length_ = -1;   ///< 响应头声明的长度，-1 表示未声明
+    uint64_t body_bytes_ = 0;
+    FinishCallback finish_callback_;
+
+private:
+    /// 在连接上登记一次写出后的检查
+    void ArmWritable_();
+
+    std::function<void()> writable_callback_;   ///< 同时只有一个等待者，后登记的替换先登记的
+    bool writable_armed_ = false;
+};
+
+/**
+ * @brief HTTP/1.x 流式响应：创建时暂停连接分派后续请求，结束后恢复
+ */
+class Http1ResponseWriter : public ResponseWriter {
+public:
+    /// 不超过该长度的片段与分块头、CRLF 合并为一个节点，更长的片段单独成节点不拷贝
+    static constexpr size_t kCoalesceLimit = 16 * 1024;
+
+    static std::shared_ptr<Http1ResponseWriter> Create(std::shared_ptr<Connection> conn, const HttpRequest& request);
+    ~Http1ResponseWriter() override;
+
+    bool IsChunked() const { return chunked_; }
+
+protected:
+    Http1ResponseWriter(std::shared_ptr<Connection> conn, bool head_only, bool keep_alive, bool http10);
+
+    Error SendHead_(const Headers& headers) override;
+    Error SendBody_(std::string&& data) override;
+    Error SendEnd_() override;
+    void SendAbort_(const Error& reason) override;
+    bool IsOpen_() const override;
+    size_t Backlog_() const override;
+
+private:
+    bool keep_alive_;
+    bool http10_;
+    bool chunked_ = false;
+};
+
+/**
+ * @brief HTTP/2 流式响应：DATA 经连接的调度器按流控窗口发送，流上等待窗口的字节计入积压
+ */
+class Http2ResponseWriter : public ResponseWriter {
+public:
+    static std::shared_ptr<Http2ResponseWriter> Create(std::shared_ptr<Connection> conn,
+                                                       std::shared_ptr<http2::H2Stream> stream, bool head_only);
+    ~Http2ResponseWriter() override;
+
+protected:
+    Http2ResponseWriter(std::shared_ptr<Connection> conn, std::shared_ptr<http2::H2Stream> stream, bool head_only);
+
+    Error SendHead_(const Headers& headers) override;
+    Error SendBody_(std::string&& data) override;
+    Error SendEnd_() override;
+    void SendAbort_(const Error& reason) override;
+    bool IsOpen_() const override;
+    size_t Backlog_() const override;
+
+private:
+    std::shared_ptr<http2::H2Stream> stream_;
+};
+
+/**
+ * @brief 流式响应处理器：请求头已完整收到（不接收请求体）
+ *
+ * 可在回调内同步写完并 End，也可保存 writer，按 IsWritable / OnWritable 分批生成。
+ */
+using StreamHandler = std::function<void(const HttpRequest& request, std::shared_ptr<ResponseWriter> writer)>;
+
+} // namespace tinywebserver
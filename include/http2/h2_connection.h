@@ -1,14 +1,19 @@
 #pragma once
 
 #include <unordered_map>
+#include <array>
 #include <memory>
 #include <vector>
 #include <queue>
 #include <atomic>
-#include <mutex>
 #include <functional>
+#include <string>
+#include "buffer_chain.h"
 #include "error/error.h"
 #include "http2/h2_frame_parser.h"
+#include "http2/h2_stream_table.h"
+#include "http2/hpack_decoder.h"
+#include "http2/hpack_encoder.h"
 
 namespace tinywebserver {
 namespace http2 {
@@ -51,12 +56,34 @@ struct H2Settings {
  * @brief HTTP/2 连接类
  *
  * 管理 HTTP/2 连接状态机，处理帧分发，管理流状态。
+ * 所有方法须在所属 EventLoop 线程调用。
+ *
+ * 输入：帧直接在调用方的输入缓冲区中解析（帧头 + 负载指针），不做拷贝，
+ * 调用方按 consumed 丢弃已处理的前缀、保留不完整的帧尾。
+ * 输出：帧序列化进 BufferChain，控制帧为一个字符串节点，DATA 帧为
+ * 9 字节帧头节点 + 引用流缓冲区或 mmap 映射区的负载节点；ProcessData
+ * 期间产生的帧攒在一起，处理结束后一次交给 FrameCallback。
+ *
+ * DATA 调度：有待发送数据的流进入就绪集合，调度器每次选虚拟时间最小、
+ * 窗口允许发送的流发出一个不超过固定份额（quantum）的帧，该流的虚拟
+ * 时间按帧长 / 权重推进（stride 调度），因此大文件与小资源按权重交错，
+ * 不会队头阻塞。上层输出队列超过 kOutputHighWatermark 时暂停调度，
+ * 写出后由上层调用 OnOutputDrained() 继续。
  */
 class H2Connection {
 public:
-    using FrameCallback = std::function<void(const H2FrameHeader& header,
-                                             const std::vector<uint8_t>& payload)>;
+    /// 写出回调：frames 中为完整的已序列化帧，回调应取走（Splice）其中的节点
+    using FrameCallback = std::function<void(BufferChain& frames)>;
     using CloseCallback = std::function<void(const Error& reason)>;
+    /// 请求完整到达（远端 END_STREAM）时回调，由上层生成响应
+    using StreamRequestCallback = std::function<void(std::shared_ptr<H2Stream> stream)>;
+    /// 查询上层输出队列中尚未写出的字节数，用于限制调度器一次产出的 DATA
+    using OutputSizeCallback = std::function<size_t()>;
+
+    /// 上层输出队列超过该值时暂停 DATA 调度
+    static constexpr size_t kOutputHighWatermark = 256 * 1024;
+    /// 单个 DATA 帧负载的固定份额（不超过对端 MAX_FRAME_SIZE）
+    static constexpr size_t kDataFrameQuantum = 16384;
 
     /**
      * @brief 构造函数
@@ -72,11 +99,12 @@ public:
 
     /**
      * @brief 处理接收到的数据
-     * @param data 原始字节数据
+     * @param data 输入缓冲区中未处理的字节（含上次剩下的不完整帧）
      * @param len 数据长度
+     * @param consumed 输出：已处理的字节数，剩余部分须在下次调用时重新传入
      * @return Error 对象，如果处理成功则返回 Success()
      */
-    Error ProcessData(const uint8_t* data, size_t len);
+    Error ProcessData(const uint8_t* data, size_t len, size_t& consumed);
 
     /**
      * @brief 处理单个 HTTP/2 帧
@@ -97,6 +125,20 @@ public:
     Error SendFrame(H2FrameType type, uint8_t flags, uint32_t stream_id,
                     const std::vector<uint8_t>& payload);
 
+    /**
+     * @brief 发送帧（负载拷贝进帧节点，适用于控制帧与头部块）
+     */
+    Error SendFrame(H2FrameType type, uint8_t flags, uint32_t stream_id,
+                    const uint8_t* payload, size_t len);
+
+    /**
+     * @brief 发送 DATA 帧，负载节点直接移入输出链，不拷贝
+     * @param flags 帧标志
+     * @param stream_id 流标识符
+     * @param payload 负载（SHARED 或 MMAP 片段），写出完成前由输出链保持底层缓冲区存活
+     */
+    Error SendDataFrame(uint8_t flags, uint32_t stream_id, BufferNode payload);
+
     /**
      * @brief 发送 SETTINGS 帧
      * @param settings 设置项列表
@@ -132,6 +174,61 @@ public:
      */
     bool ProcessPreface(const uint8_t* data, size_t len);
 
+    /**
+     * @brief 接受 HTTP/1.1 Upgrade: h2c（RFC 7540 Section 3.2）
+     *
+     * 上层已发送 101 响应后调用：应用 HTTP2-Settings 中的对端设置，发送服务器
+     * SETTINGS，并把升级请求登记为流 1（半关闭-远端）。客户端随后仍会发送
+     * 连接前言，由 ProcessData() 消费后再把流 1 交给请求回调。
+     *
+     * @param http2_settings HTTP2-Settings 头部值（base64url 编码的 SETTINGS 负载）
+     * @param request_headers 升级请求转换后的头部（含 :method/:path/:scheme/:authority）
+     * @return Error 对象
+     */
+    Error AcceptUpgrade(const std::string& http2_settings,
+                        const std::unordered_map<std::string, std::string>& request_headers);
+
+    /**
+     * @brief 发送头部块（HEADERS + 必要时的 CONTINUATION）
+     * @param stream_id 流标识符
+     * @param headers 头部映射表（伪头部优先编码）
+     * @param end_stream 是否结束流
+     * @return Error 对象
+     */
+    Error SendHeaderBlock(uint32_t stream_id,
+                          const std::unordered_map<std::string, std::string>& headers,
+                          bool end_stream);
+
+    /**
+     * @brief 流有新的待发送数据时由 H2Stream 调用，加入调度
+     *
+     * ProcessData 期间只登记，处理结束后统一调度；其他时候立即调度。
+     * @param stream_id 流标识符
+     * @return Error 对象
+     */
+    Error MarkStreamReady(uint32_t stream_id);
+
+    /**
+     * @brief 上层输出队列已降到低水位，继续调度 DATA
+     */
+    void OnOutputDrained();
+
+    /**
+     * @brief 是否有窗口允许、只因输出水位暂停的 DATA
+     */
+    bool HasPendingOutput() const;
+
+    /**
+     * @brief 流进入 CLOSED 后由 H2Stream 调用，从流表中移除
+     */
+    void OnStreamClosed(uint32_t stream_id);
+
+    /**
+     * @brief 查找流
+     * @return 流不存在（未创建或已关闭移除）时返回 nullptr
+     */
+    std::shared_ptr<H2Stream> FindStream(uint32_t stream_id) const;
+
     /**
      * @brief 获取连接状态
      */
@@ -159,10 +256,15 @@ public:
     size_t GetActiveStreamCount() const;
 
     /**
-     * @brief 获取连接设置
+     * @brief 获取连接设置（本端通告给对端的设置）
      */
     const H2Settings& GetSettings() const { return settings_; }
 
+    /**
+     * @brief 获取对端设置（决定本端发送时的帧大小与初始窗口）
+     */
+    const H2Settings& GetPeerSettings() const { return peer_settings_; }
+
     /**
      * @brief 更新连接设置
      */
@@ -178,6 +280,21 @@ public:
      */
     void SetCloseCallback(CloseCallback cb) { close_callback_ = std::move(cb); }
 
+    /**
+     * @brief 设置请求回调
+     */
+    void SetStreamRequestCallback(StreamRequestCallback cb) { request_callback_ = std::move(cb); }
+
+    /**
+     * @brief 设置单个流的请求体上限（对应 limits.max_request_size），超出时回 413 并重置流
+     */
+    void SetMaxRequestBodySize(uint64_t size) { max_request_body_size_ = size; }
+
+    /**
+     * @brief 设置输出队列查询回调（未设置时只按本次调度产出的字节计）
+     */
+    void SetOutputSizeCallback(OutputSizeCallback cb) { output_size_callback_ = std::move(cb); }
+
     /**
      * @brief 获取文件描述符
      */
@@ -189,6 +306,12 @@ public:
     bool IsServer() const { return is_server_; }
 
 private:
+    // 解析并处理 data 中的完整帧（调用方负责前言与输出批处理）
+    Error ProcessFrames(const uint8_t* data, size_t len, size_t& consumed);
+    // 把攒下的帧交给上层
+    void FlushOutput();
+    H2FrameHeader MakeFrameHeader(H2FrameType type, uint8_t flags, uint32_t stream_id, size_t len) const;
+
     // 内部帧处理方法
     Error HandleDataFrame(const H2FrameHeader& header, const uint8_t* payload);
     Error HandleHeadersFrame(const H2FrameHeader& header, const uint8_t* payload);
@@ -205,25 +328,76 @@ private:
     void TransitionState(H2ConnectionState new_state, const std::string& reason);
     bool CanTransition(H2ConnectionState new_state) const;
 
-    // 流管理
+    // 流管理（流对象从 stream_pool_ 回收复用）
     std::shared_ptr<H2Stream> GetOrCreateStream(uint32_t stream_id);
     void RemoveStream(uint32_t stream_id);
     void CloseAllStreams(const Error& reason);
 
+    // 头部块接收完整（END_HEADERS）后解码并交给流
+    Error OnHeaderBlockComplete();
+    // 请求完整到达后交给上层
+    void DispatchRequest(const std::shared_ptr<H2Stream>& stream);
+
+    // 设置与流控制
+    Error SendInitialSettings();
+    Error ApplyPeerSettings(const std::vector<std::pair<uint16_t, uint32_t>>& settings);
+    Error SendWindowUpdate(uint32_t stream_id, uint32_t increment);
+
+    // DATA 调度：按权重交错发送就绪流的数据，直到窗口耗尽或输出达到高水位
+    Error ScheduleData();
+    size_t QueuedOutputBytes() const;
+    Error ParsePriority(uint32_t stream_id, const uint8_t* data);
+
+    // 错误处理：连接错误记录 GOAWAY 错误码后返回失败，流错误发送 RST_STREAM
+    Error ConnectionError(uint32_t error_code, const std::string& message);
+    Error ResetStream(uint32_t stream_id, uint32_t error_code);
+
     int fd_;
     bool is_server_;
     std::atomic<H2ConnectionState> state_;
 
-    H2Settings settings_;
-    std::unordered_map<uint32_t, std::shared_ptr<H2Stream>> streams_;
-    mutable std::mutex streams_mutex_;
+    H2Settings settings_;        ///< 本端设置
+    H2Settings peer_settings_;   ///< 对端设置
+    bool settings_sent_;
+    H2StreamTable streams_;   ///< 只在所属 EventLoop 线程访问，不加锁
+
+    // 已关闭流的对象池：没有外部引用（use_count 为 1）的才可复用
+    static constexpr size_t kStreamPoolSize = 16;
+    std::vector<std::shared_ptr<H2Stream>> stream_pool_;
 
-    // 帧处理缓冲区（用于处理跨帧的数据）
-    std::vector<uint8_t> read_buffer_;
     size_t preface_remaining_;
 
+    // 待交给上层的已序列化帧；ProcessData 期间只攒不交
+    BufferChain out_frames_;
+    bool batching_output_;
+
+    // 头部块（HEADERS + CONTINUATION）拼接状态
+    HpackDecoder hpack_decoder_;
+    HpackEncoder hpack_encoder_;
+    std::vector<uint8_t> header_block_;
+    uint32_t continuation_stream_id_;   ///< 非 0 表示正在等待 CONTINUATION
+    bool continuation_end_stream_;
+    std::array<uint8_t, 5> pending_priority_;   ///< HEADERS 携带的优先级字段，流创建后应用
+    bool has_pending_priority_;
+
+    // 连接级流控制窗口（RFC 7540 Section 6.9）
+    int64_t conn_send_window_;
+    int64_t conn_recv_window_;
+    uint64_t max_request_body_size_;   ///< 单个流的请求体上限，默认与 limits.max_request_size 一致
+
+    // 有待发送数据的流（窗口耗尽的也留在其中，WINDOW_UPDATE 后继续）
+    std::vector<std::shared_ptr<H2Stream>> ready_streams_;
+    uint64_t schedule_clock_;   ///< 最近一次被调度流的虚拟时间，新就绪的流从这里起步
+    bool scheduling_;
+
+    uint32_t last_peer_stream_id_;
+    uint32_t goaway_error_code_;
+    bool upgrade_dispatch_pending_;   ///< h2c 升级的流 1 等待客户端前言后再分派
+
     FrameCallback frame_callback_;
     CloseCallback close_callback_;
+    StreamRequestCallback request_callback_;
+    OutputSizeCallback output_size_callback_;
 };
 
 } // namespace http2
@@ -37,6 +37,22 @@ enum H2FrameFlags : uint8_t {
     PRIORITY = 0x20
 };
 
+/**
+ * @brief HTTP/2 错误码（RFC 7540 Section 7），用于 RST_STREAM 与 GOAWAY
+ */
+enum H2ErrorCode : uint32_t {
+    H2_NO_ERROR = 0x0,
+    H2_PROTOCOL_ERROR = 0x1,
+    H2_INTERNAL_ERROR = 0x2,
+    H2_FLOW_CONTROL_ERROR = 0x3,
+    H2_SETTINGS_TIMEOUT = 0x4,
+    H2_STREAM_CLOSED = 0x5,
+    H2_FRAME_SIZE_ERROR = 0x6,
+    H2_REFUSED_STREAM = 0x7,
+    H2_CANCEL = 0x8,
+    H2_COMPRESSION_ERROR = 0x9
+};
+
 /**
  * @brief HTTP/2 帧头（9字节）
  *
@@ -100,6 +116,13 @@ public:
      */
     static std::vector<uint8_t> SerializeHeader(const H2FrameHeader& header);
 
+    /**
+     * @brief 序列化帧头到调用方提供的缓冲区
+     * @param header 帧头
+     * @param out 输出位置（至少9字节）
+     */
+    static void SerializeHeader(const H2FrameHeader& header, uint8_t* out);
+
     /**
      * @brief 解析 SETTINGS 帧负载
      * @param payload 帧负载数据
@@ -2,11 +2,13 @@
 
 #include <cstdint>
 #include <vector>
+#include <deque>
 #include <string>
 #include <unordered_map>
 #include <memory>
 #include <atomic>
 #include <functional>
+#include "buffer_chain.h"
 #include "error/error.h"
 
 namespace tinywebserver {
@@ -34,7 +36,7 @@ enum class H2StreamState {
 struct H2Priority {
     bool exclusive = false;
     uint32_t stream_dependency = 0;
-    uint8_t weight = 16;  // 默认权重 16 (值 1-256)
+    uint16_t weight = 16;  // 默认权重 16 (值 1-256，线上编码为 weight - 1)
 };
 
 /**
@@ -45,7 +47,7 @@ struct H2Priority {
 class H2Stream {
 public:
     using Headers = std::unordered_map<std::string, std::string>;
-    using DataCallback = std::function<void(const std::vector<uint8_t>& data, bool end_stream)>;
+    using DataCallback = std::function<void(const uint8_t* data, size_t len, bool end_stream)>;
     using HeadersCallback = std::function<void(const Headers& headers, bool end_stream)>;
     using CloseCallback = std::function<void(uint32_t error_code)>;
 
@@ -53,14 +55,25 @@ public:
      * @brief 构造函数
      * @param stream_id 流标识符
      * @param connection 所属连接
+     * @param initial_send_window 对端 SETTINGS_INITIAL_WINDOW_SIZE
+     * @param initial_recv_window 本端 SETTINGS_INITIAL_WINDOW_SIZE
      */
-    H2Stream(uint32_t stream_id, H2Connection* connection);
+    H2Stream(uint32_t stream_id, H2Connection* connection,
+             uint32_t initial_send_window = 65535, uint32_t initial_recv_window = 65535);
     ~H2Stream();
 
     // 禁止拷贝
     H2Stream(const H2Stream&) = delete;
     H2Stream& operator=(const H2Stream&) = delete;
 
+    /**
+     * @brief 复用已关闭的流对象：恢复为新建状态，保留容器已分配的容量
+     * @param stream_id 新的流标识符
+     * @param initial_send_window 对端 SETTINGS_INITIAL_WINDOW_SIZE
+     * @param initial_recv_window 本端 SETTINGS_INITIAL_WINDOW_SIZE
+     */
+    void Reset(uint32_t stream_id, uint32_t initial_send_window, uint32_t initial_recv_window);
+
     /**
      * @brief 处理 HEADERS 帧
      * @param headers 头部块
@@ -71,11 +84,12 @@ public:
 
     /**
      * @brief 处理 DATA 帧
-     * @param data 数据负载
+     * @param data 数据负载（指向连接输入缓冲区，仅在调用期间有效）
+     * @param len 负载长度（不含填充）
      * @param end_stream 是否结束流
      * @return Error 对象
      */
-    Error HandleData(const std::vector<uint8_t>& data, bool end_stream);
+    Error HandleData(const uint8_t* data, size_t len, bool end_stream);
 
     /**
      * @brief 发送 HEADERS 帧
@@ -93,6 +107,89 @@ public:
      */
     Error SendData(const std::vector<uint8_t>& data, bool end_stream);
 
+    /**
+     * @brief 发送 DATA 帧（原始字节）
+     *
+     * 数据拷贝一次后进入流的待发送队列，由 H2Connection 的调度器按权重
+     * 与其他流交错、按连接级/流级发送窗口切分成帧；窗口耗尽时剩余数据
+     * 等待 WINDOW_UPDATE。
+     */
+    Error SendData(const uint8_t* data, size_t len, bool end_stream);
+
+    /**
+     * @brief 发送 DATA 帧（接管字符串，不拷贝，用于流式生成的响应体）
+     */
+    Error SendData(std::string&& data, bool end_stream);
+
+    /**
+     * @brief 发送 mmap 文件作为 DATA（不拷贝，DATA 帧负载直接引用映射区）
+     * @param file 静态资源，写出完成前由待发送队列与输出链保持存活
+     * @param end_stream 是否结束流
+     * @return Error 对象
+     */
+    Error SendFile(std::shared_ptr<StaticResource> file, bool end_stream);
+
+    /**
+     * @brief 发送一个 DATA 帧（由 H2Connection 的调度器调用）
+     * @param conn_window 连接级发送窗口（输入/输出）
+     * @param quantum 单帧负载上限
+     * @param sent 输出：本帧负载字节数（只剩 END_STREAM 时发送空帧，为 0）
+     * @return Error 对象
+     */
+    Error SendNextFrame(int64_t& conn_window, size_t quantum, size_t& sent);
+
+    /**
+     * @brief 是否还有未发送的数据（含未发出的 END_STREAM）
+     */
+    bool HasPendingData() const { return pending_bytes_ > 0 || pending_end_stream_; }
+
+    /**
+     * @brief 等待发送窗口的响应字节数
+     */
+    size_t GetPendingBytes() const { return pending_bytes_; }
+
+    /**
+     * @brief 当前窗口下能否发出下一帧（只剩 END_STREAM 时不占用窗口）
+     */
+    bool CanSend(int64_t conn_window) const {
+        return pending_bytes_ > 0 ? (send_window_ > 0 && conn_window > 0) : pending_end_stream_;
+    }
+
+    /**
+     * @brief 调度器虚拟时间（按已发字节 / 权重推进，由 H2Connection 维护）
+     */
+    uint64_t GetSchedulePass() const { return schedule_pass_; }
+    void SetSchedulePass(uint64_t pass) { schedule_pass_ = pass; }
+
+    /**
+     * @brief 调整流级发送窗口（WINDOW_UPDATE 或 SETTINGS_INITIAL_WINDOW_SIZE 变化）
+     * @return 窗口超过 2^31-1 时返回错误（FLOW_CONTROL_ERROR）
+     */
+    Error AdjustSendWindow(int64_t delta);
+
+    /**
+     * @brief 扣减流级接收窗口（收到 DATA 时）
+     * @return 超出窗口时返回错误（FLOW_CONTROL_ERROR）
+     */
+    Error ConsumeRecvWindow(uint32_t len);
+
+    /**
+     * @brief 登记已消费（处理或丢弃）的接收字节，只有这部分可经 WINDOW_UPDATE 归还
+     */
+    void MarkRecvConsumed(uint32_t len) { recv_consumed_ += len; }
+
+    /**
+     * @brief 归还流级接收窗口（发送 WINDOW_UPDATE 后），len 不超过 GetRecvConsumed()
+     */
+    void ReleaseRecvWindow(uint32_t len) {
+        recv_window_ += len;
+        recv_consumed_ -= len;
+    }
+
+    int64_t GetSendWindow() const { return send_window_; }
+    int64_t GetRecvWindow() const { return recv_window_; }
+    uint64_t GetRecvConsumed() const { return recv_consumed_; }
+
     /**
      * @brief 发送 RST_STREAM 帧
      * @param error_code 错误码
@@ -127,9 +224,9 @@ public:
     const Headers& GetResponseHeaders() const { return response_headers_; }
 
     /**
-     * @brief 获取已接收的请求体数据
+     * @brief 获取已接收的请求体字节数（负载经数据回调交出后不保留）
      */
-    const std::vector<uint8_t>& GetRequestBody() const { return request_body_; }
+    uint64_t GetRequestBodyBytes() const { return request_body_bytes_; }
 
     /**
      * @brief 获取优先级信息
@@ -158,6 +255,13 @@ public:
      */
     bool IsClosed() const { return state_ == H2StreamState::CLOSED; }
 
+    /**
+     * @brief 检查远端是否已结束发送（请求已完整接收）
+     */
+    bool IsRemoteClosed() const {
+        return state_ == H2StreamState::HALF_CLOSED_REMOTE || state_ == H2StreamState::CLOSED;
+    }
+
     /**
      * @brief 设置数据回调（接收到 DATA 帧时调用）
      */
@@ -181,6 +285,10 @@ private:
     // 验证状态转移
     Error ValidateTransition(H2StreamState new_state) const;
 
+    // END_STREAM 收发后的状态推进（OPEN -> HALF_CLOSED_*，HALF_CLOSED_* -> CLOSED）
+    void OnEndStreamReceived();
+    void OnEndStreamSent();
+
     uint32_t stream_id_;
     H2Connection* connection_;
     std::atomic<H2StreamState> state_;
@@ -188,12 +296,19 @@ private:
     H2Priority priority_;
     Headers request_headers_;
     Headers response_headers_;
-    std::vector<uint8_t> request_body_;
-    std::vector<uint8_t> response_body_;
-
-    // 流控制窗口
-    int32_t send_window_;
-    int32_t recv_window_;
+    uint64_t request_body_bytes_;
+
+    // 待发送的响应数据（受流控制窗口约束）：SHARED 或 MMAP 节点，
+    // 每个 DATA 帧的负载是队首节点的一个片段，与输出链共享底层缓冲区
+    std::deque<BufferNode> pending_chunks_;
+    size_t pending_bytes_;
+    bool pending_end_stream_;
+    uint64_t schedule_pass_;
+
+    // 流控制窗口（发送窗口可因 SETTINGS 变化暂时为负）
+    int64_t send_window_;
+    int64_t recv_window_;
+    uint64_t recv_consumed_;   ///< 已消费、尚未经 WINDOW_UPDATE 归还的接收字节
 
     DataCallback data_callback_;
     HeadersCallback headers_callback_;
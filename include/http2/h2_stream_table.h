@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace tinywebserver {
+namespace http2 {
+
+class H2Stream;
+
+/**
+ * @brief 单连接的流表（开放寻址 + 线性探测）
+ *
+ * 连接只在所属 EventLoop 线程访问，表本身不加锁。对端发起的流 ID 是
+ * 递增的奇数，槽位取 (id - 1) / 2 的低位：同时活跃的一段连续 ID 落在
+ * 相邻槽位上，相当于按 ID 窗口直接寻址的稠密数组，窗口回绕冲突时才
+ * 线性探测。负载因子不超过 1/2，删除用后移（backward shift）而不留墓碑，
+ * 查找长度不会随流的开关而退化。
+ */
+class H2StreamTable {
+public:
+    H2StreamTable();
+
+    /**
+     * @brief 查找流
+     * @return 不存在时返回 nullptr
+     */
+    const std::shared_ptr<H2Stream>& Find(uint32_t stream_id) const;
+
+    /**
+     * @brief 插入流（stream_id 不能为 0，调用方保证不重复）
+     */
+    void Insert(uint32_t stream_id, std::shared_ptr<H2Stream> stream);
+
+    /**
+     * @brief 移除流
+     * @return 被移除的流，不存在时返回 nullptr
+     */
+    std::shared_ptr<H2Stream> Erase(uint32_t stream_id);
+
+    /**
+     * @brief 取出全部流（遍历期间可能增删表项的调用方先拷出再处理）
+     */
+    std::vector<std::shared_ptr<H2Stream>> Snapshot() const;
+
+    void Clear();
+    size_t Size() const { return size_; }
+    bool Empty() const { return size_ == 0; }
+
+private:
+    struct Slot {
+        uint32_t stream_id = 0;   ///< 0 表示空槽（流 0 是连接本身，不入表）
+        std::shared_ptr<H2Stream> stream;
+    };
+
+    size_t HomeOf(uint32_t stream_id) const { return ((stream_id - 1) >> 1) & mask_; }
+    void Grow();
+
+    std::vector<Slot> slots_;
+    size_t mask_;
+    size_t size_;
+};
+
+} // namespace http2
+} // namespace tinywebserver
@@ -3,8 +3,8 @@
 #include <cstdint>
 #include <vector>
 #include <string>
-#include <unordered_map>
-#include <list>
+#include <string_view>
+#include <functional>
 #include <optional>
 #include "error/error.h"
 
@@ -20,20 +20,50 @@ struct HpackHeader {
     bool sensitive = false;  // 是否属于敏感头部（需要保护）
 };
 
+/**
+ * @brief 解码出的头部字段视图
+ *
+ * name / value 指向帧数据、动态表环形缓冲区或解码器的哈夫曼暂存区，
+ * 只在字段回调期间有效，需要保留时由调用方自行拷贝。
+ */
+struct HpackHeaderView {
+    std::string_view name;
+    std::string_view value;
+    bool sensitive = false;
+};
+
 /**
  * @brief HPACK 解码器（RFC 7541）
  *
  * 实现 HTTP/2 头部压缩解码功能，支持静态表和动态表。
+ *
+ * 动态表存放在预分配的字节环形缓冲区中，另有一个偏移环记录每个条目的
+ * 位置与长度：按索引取条目是 O(1)，插入只做拷贝、驱逐只移动环尾，
+ * 运行期不再分配内存。环容量为表上限的两倍，条目在尾部放不下时
+ * 回绕到开头，容量余量保证条目总能连续存放（见 PlaceEntry）。
  */
 class HpackDecoder {
 public:
+    /// 字段回调：每解出一个字段调用一次，参数中的视图只在回调期间有效
+    using FieldCallback = std::function<void(const HpackHeaderView& field)>;
+
     /**
      * @brief 构造函数
-     * @param max_dynamic_table_size 动态表最大大小（字节）
+     * @param max_dynamic_table_size 动态表最大大小（字节），即本端通告的
+     *        SETTINGS_HEADER_TABLE_SIZE，对端的表大小更新不能超过此值
      */
     explicit HpackDecoder(uint32_t max_dynamic_table_size = 4096);
     ~HpackDecoder();
 
+    /**
+     * @brief 解码头部块，逐字段回调（不拷贝字段内容）
+     * @param data 原始字节数据
+     * @param len 数据长度
+     * @param on_field 字段回调
+     * @return Error 对象，失败时动态表状态不再可靠，应以 COMPRESSION_ERROR 关闭连接
+     */
+    Error DecodeBlock(const uint8_t* data, size_t len, const FieldCallback& on_field);
+
     /**
      * @brief 解码 HPACK 编码的头部块
      * @param data 原始字节数据
@@ -43,30 +73,26 @@ public:
     std::optional<std::vector<HpackHeader>> Decode(const uint8_t* data, size_t len);
 
     /**
-     * @brief 解码单个 HPACK 编码的头部字段
-     * @param data 数据指针（输入/输出，解码后指针会移动）
-     * @param remaining 剩余数据长度（输入/输出）
-     * @param header 输出头部字段
+     * @brief 更新动态表大小限制
+     * @param new_size 新的最大表大小（字节），不能超过构造时的上限
      * @return Error 对象
      */
-    Error DecodeHeaderField(const uint8_t*& data, size_t& remaining, HpackHeader& header);
+    Error UpdateDynamicTableSize(uint32_t new_size);
 
     /**
-     * @brief 更新动态表大小限制
-     * @param new_size 新的最大表大小（字节）
-     * @return Error 对象
+     * @brief 获取当前动态表条目数
      */
-    Error UpdateDynamicTableSize(uint32_t new_size);
+    uint32_t GetDynamicTableSize() const { return entry_count_; }
 
     /**
-     * @brief 获取当前动态表大小
+     * @brief 获取动态表使用量（RFC 7541 Section 4.1 口径）
      */
-    uint32_t GetDynamicTableSize() const { return dynamic_table_size_; }
+    uint32_t GetDynamicTableUsage() const { return table_usage_; }
 
     /**
-     * @brief 获取动态表使用量
+     * @brief 获取当前动态表大小限制
      */
-    uint32_t GetDynamicTableUsage() const { return dynamic_table_usage_; }
+    uint32_t GetDynamicTableCapacity() const { return table_capacity_; }
 
     /**
      * @brief 清空动态表
@@ -74,7 +100,7 @@ public:
     void ClearDynamicTable();
 
     /**
-     * @brief 重置解码器状态（清空动态表）
+     * @brief 重置解码器状态（清空动态表，恢复初始大小限制）
      */
     void Reset();
 
@@ -91,33 +117,45 @@ public:
     static std::optional<HpackHeader> GetStaticTableEntry(uint32_t index);
 
 private:
+    /// 偏移环中的条目：名称与值在字节环中连续存放
+    struct RingSlot {
+        uint32_t offset;
+        uint32_t name_len;
+        uint32_t value_len;
+    };
+
     // HPACK 解码辅助方法
+    Error DecodeField(const uint8_t*& data, size_t& remaining, HpackHeaderView& field,
+                      bool& incremental);
     Error DecodeInteger(const uint8_t*& data, size_t& remaining,
                         uint8_t prefix_bits, uint32_t& result);
-    Error DecodeString(const uint8_t*& data, size_t& remaining, std::string& result);
+    Error DecodeString(const uint8_t*& data, size_t& remaining, std::string& scratch,
+                       std::string_view& result);
 
     // 动态表管理
-    void AddToDynamicTable(const HpackHeader& header);
-    void EvictDynamicTable();
-    std::optional<HpackHeader> GetDynamicTableEntry(uint32_t index) const;
-    std::optional<HpackHeader> GetTableEntry(uint32_t index) const;
+    void AddToDynamicTable(std::string_view name, std::string_view value);
+    void EvictOldest();
+    uint32_t PlaceEntry(uint32_t len);
+    size_t SlotOf(uint32_t dynamic_index) const;
+    bool GetTableEntry(uint32_t index, std::string_view& name, std::string_view& value) const;
 
-    // 静态表（RFC 7541 Appendix A）
+    // 静态表大小（表本身见 hpack_static_table.h）
     static const size_t STATIC_TABLE_SIZE = 61;
-    static const HpackHeader STATIC_TABLE[];
 
-    struct DynamicTableEntry {
-        HpackHeader header;
-        uint32_t size;  // 占用空间大小（RFC 7541 Section 4.1）
-    };
+    const uint32_t max_dynamic_table_size_;   // 本端允许的上限
+    uint32_t table_capacity_;                 // 当前大小限制（对端可通过大小更新调整）
+    uint32_t table_usage_;                    // 当前动态表使用量
+    uint32_t entry_count_;                    // 当前条目数
 
-    std::list<DynamicTableEntry> dynamic_table_;  // 新的条目添加到前端
-    uint32_t max_dynamic_table_size_;
-    uint32_t dynamic_table_size_;   // 当前动态表大小
-    uint32_t dynamic_table_usage_;  // 当前动态表使用量
+    std::vector<char> ring_;            // 字节环，容量为上限的两倍
+    std::vector<RingSlot> slots_;       // 偏移环，容量为上限 / 32 + 1
+    size_t newest_slot_;                // 最新条目在偏移环中的下标
+    uint32_t write_pos_;                // 字节环写位置
 
-    // 解码状态
-    bool decoding_started_;
+    // 解码暂存区（哈夫曼解码结果、插入时被驱逐的名称副本）
+    std::string name_scratch_;
+    std::string value_scratch_;
+    std::string insert_scratch_;
 };
 
 } // namespace http2
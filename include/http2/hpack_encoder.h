@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "http2/hpack_decoder.h"
+
+namespace tinywebserver {
+namespace http2 {
+
+/**
+ * @brief HPACK 编码器（RFC 7541）
+ *
+ * - 静态表：名称经编译期完美哈希定位到静态表中的连续区间，再比较值
+ * - 动态表：按插入策略把可复用的字段写入对端动态表，本端维护镜像
+ * - 字符串字面值在哈夫曼编码更短时使用哈夫曼编码
+ * - 头部块缓存：字段数较少的头部列表（典型为 :status / content-type /
+ *   content-length）全部命中索引后缓存其编码，动态表未变化时直接复用
+ *
+ * 每个连接一个实例，须在所属 EventLoop 线程使用。
+ */
+class HpackEncoder {
+public:
+    /**
+     * @brief 构造函数
+     * @param max_dynamic_table_size 本端允许使用的动态表上限（字节）
+     */
+    explicit HpackEncoder(uint32_t max_dynamic_table_size = 4096);
+
+    /**
+     * @brief 编码头部列表
+     * @param headers 头部字段（按顺序编码，sensitive 字段使用永不索引表示）
+     * @param out 头部块（追加写入）
+     */
+    void Encode(const std::vector<HpackHeader>& headers, std::vector<uint8_t>& out);
+
+    /**
+     * @brief 应用对端 SETTINGS_HEADER_TABLE_SIZE
+     *
+     * 实际上限取对端设置与本端上限的较小值；变化时下一个头部块
+     * 以动态表大小更新开头（RFC 7541 Section 6.3）。
+     */
+    void SetMaxDynamicTableSize(uint32_t size);
+
+    uint32_t GetMaxDynamicTableSize() const { return max_table_size_; }
+    uint32_t GetDynamicTableUsage() const { return table_usage_; }
+    size_t GetDynamicTableEntryCount() const { return dynamic_table_.size(); }
+
+    /// 头部块缓存命中次数
+    uint64_t GetCacheHits() const { return cache_hits_; }
+
+    /**
+     * @brief 静态表查找
+     * @return {索引, 值是否匹配}；名称不在静态表中时索引为 0
+     */
+    static std::pair<uint32_t, bool> FindStatic(std::string_view name, std::string_view value);
+
+private:
+    struct DynamicEntry {
+        std::string name;
+        std::string value;
+    };
+
+    /// 缓存的头部块，仅在动态表代数未变化时有效
+    struct CachedBlock {
+        std::vector<uint8_t> bytes;
+        uint64_t generation;
+    };
+
+    void EncodeField(const HpackHeader& header, std::vector<uint8_t>& out);
+    bool ShouldIndex(const std::string& name, size_t entry_size) const;
+    void AddToDynamicTable(const std::string& name, const std::string& value);
+    void EvictTo(uint32_t size);
+
+    static void EncodeInteger(std::vector<uint8_t>& out, uint8_t first_byte_flags,
+                              uint8_t prefix_bits, uint32_t value);
+    static void EncodeString(std::vector<uint8_t>& out, std::string_view str);
+
+    static constexpr size_t kMaxCachedFields = 4;
+    static constexpr size_t kMaxCacheEntries = 64;
+
+    const uint32_t local_max_table_size_;
+    uint32_t max_table_size_;
+    uint32_t table_usage_;
+    std::deque<DynamicEntry> dynamic_table_;   ///< 前端为最新条目（索引 62）
+
+    // 待发送的动态表大小更新：期间出现过的最小值与最终值
+    bool size_update_pending_;
+    uint32_t min_pending_size_;
+
+    uint64_t generation_;   ///< 动态表每次变化递增
+    std::unordered_map<std::string, CachedBlock> block_cache_;
+    std::string cache_key_;
+    uint64_t cache_hits_;
+};
+
+} // namespace http2
+} // namespace tinywebserver
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "error/error.h"
+
+namespace tinywebserver {
+namespace http2 {
+
+/**
+ * @brief HPACK 静态哈夫曼码（RFC 7541 Appendix B）
+ *
+ * 解码使用编译期由码表生成的状态机，每次消耗 4 位：状态为哈夫曼树的
+ * 内部节点，查表得到下一状态与可能输出的符号（最短码 5 位，4 位内至多
+ * 完成一个符号）。按位推进的规范码解码保留为 DecodeReference()，
+ * 作为正确性与性能对照。
+ */
+class HpackHuffman {
+public:
+    /// 码表项：code 右对齐存放，bits 为码长（5..30）
+    struct Code {
+        uint32_t code;
+        uint8_t bits;
+    };
+
+    static constexpr uint16_t kEosSymbol = 256;
+    static const Code kCodes[257];
+
+    /**
+     * @brief 解码哈夫曼编码的字符串字面值
+     * @param data 编码数据
+     * @param len 数据长度
+     * @param out 解码结果（追加写入）
+     * @return 遇到 EOS、超过 7 位或非全 1 的填充时返回 kParseError
+     */
+    static Error Decode(const uint8_t* data, size_t len, std::string& out);
+
+    /**
+     * @brief 按位解码（规范码逐位比较首码），语义与 Decode() 相同
+     */
+    static Error DecodeReference(const uint8_t* data, size_t len, std::string& out);
+
+    /**
+     * @brief 计算哈夫曼编码后的字节数（含末尾填充）
+     */
+    static size_t EncodedLength(std::string_view input);
+
+    /**
+     * @brief 哈夫曼编码，末尾不足一字节的部分以 EOS 前缀（全 1）填充
+     * @param input 原始字符串
+     * @param out 编码结果（追加写入）
+     */
+    static void Encode(std::string_view input, std::vector<uint8_t>& out);
+
+private:
+    HpackHuffman() = delete;
+};
+
+} // namespace http2
+} // namespace tinywebserver
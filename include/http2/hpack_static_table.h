@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace tinywebserver {
+namespace http2 {
+
+/**
+ * @brief HPACK 静态表项（RFC 7541 Appendix A）
+ */
+struct HpackStaticEntry {
+    std::string_view name;
+    std::string_view value;
+};
+
+/// 静态表项数
+constexpr size_t kHpackStaticTableSize = 61;
+
+/**
+ * @brief HPACK 静态表，下标即索引（0 为占位）
+ *
+ * constexpr 定义，编码器据此在编译期生成名称的完美哈希表，
+ * 解码器按索引直接访问。
+ */
+inline constexpr HpackStaticEntry kHpackStaticTable[kHpackStaticTableSize + 1] = {
+    /* 0 */ {"", ""},
+    /* 1 */ {":authority", ""},
+    /* 2 */ {":method", "GET"},
+    /* 3 */ {":method", "POST"},
+    /* 4 */ {":path", "/"},
+    /* 5 */ {":path", "/index.html"},
+    /* 6 */ {":scheme", "http"},
+    /* 7 */ {":scheme", "https"},
+    /* 8 */ {":status", "200"},
+    /* 9 */ {":status", "204"},
+    /* 10 */ {":status", "206"},
+    /* 11 */ {":status", "304"},
+    /* 12 */ {":status", "400"},
+    /* 13 */ {":status", "404"},
+    /* 14 */ {":status", "500"},
+    /* 15 */ {"accept-charset", ""},
+    /* 16 */ {"accept-encoding", "gzip, deflate"},
+    /* 17 */ {"accept-language", ""},
+    /* 18 */ {"accept-ranges", ""},
+    /* 19 */ {"accept", ""},
+    /* 20 */ {"access-control-allow-origin", ""},
+    /* 21 */ {"age", ""},
+    /* 22 */ {"allow", ""},
+    /* 23 */ {"authorization", ""},
+    /* 24 */ {"cache-control", ""},
+    /* 25 */ {"content-disposition", ""},
+    /* 26 */ {"content-encoding", ""},
+    /* 27 */ {"content-language", ""},
+    /* 28 */ {"content-length", ""},
+    /* 29 */ {"content-location", ""},
+    /* 30 */ {"content-range", ""},
+    /* 31 */ {"content-type", ""},
+    /* 32 */ {"cookie", ""},
+    /* 33 */ {"date", ""},
+    /* 34 */ {"etag", ""},
+    /* 35 */ {"expect", ""},
+    /* 36 */ {"expires", ""},
+    /* 37 */ {"from", ""},
+    /* 38 */ {"host", ""},
+    /* 39 */ {"if-match", ""},
+    /* 40 */ {"if-modified-since", ""},
+    /* 41 */ {"if-none-match", ""},
+    /* 42 */ {"if-range", ""},
+    /* 43 */ {"if-unmodified-since", ""},
+    /* 44 */ {"last-modified", ""},
+    /* 45 */ {"link", ""},
+    /* 46 */ {"location", ""},
+    /* 47 */ {"max-forwards", ""},
+    /* 48 */ {"proxy-authenticate", ""},
+    /* 49 */ {"proxy-authorization", ""},
+    /* 50 */ {"range", ""},
+    /* 51 */ {"referer", ""},
+    /* 52 */ {"refresh", ""},
+    /* 53 */ {"retry-after", ""},
+    /* 54 */ {"server", ""},
+    /* 55 */ {"set-cookie", ""},
+    /* 56 */ {"strict-transport-security", ""},
+    /* 57 */ {"transfer-encoding", ""},
+    /* 58 */ {"user-agent", ""},
+    /* 59 */ {"vary", ""},
+    /* 60 */ {"via", ""},
+    /* 61 */ {"www-authenticate", ""}
+};
+
+} // namespace http2
+} // namespace tinywebserver
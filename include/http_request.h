@@ -24,6 +24,14 @@ public:
      */
     bool Parse(std::string& buffer);
 
+    /**
+     * @brief 由已解码的字段直接构造请求（HTTP/2 流使用，无需文本解析）
+     * @param headers 头部字段，名称须已为小写，不含伪头部
+     */
+    void InitFromFields(const std::string& method, const std::string& path,
+                        const std::string& version,
+                        std::unordered_map<std::string, std::string> headers);
+
     /**
      * @brief 获取请求的资源路径
      */
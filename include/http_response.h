@@ -7,6 +7,7 @@
 #include <unordered_map>
 #include <memory>
 #include <filesystem>
+#include <functional>
 #include "static_resource_manager.h"
 #include "http_request.h"
 
@@ -17,6 +18,12 @@
 class HttpResponse
 {
 public:
+    /**
+     * @brief 静态资源获取方式：命中时返回资源；需要等待异步加载时返回 nullptr 并置 pending
+     */
+    using ResourceProvider =
+        std::function<std::shared_ptr<StaticResource>(const std::string& full_path, bool& pending)>;
+
     HttpResponse();
     ~HttpResponse();
 
@@ -36,6 +43,21 @@ public:
      */
     void MakeResponse();
 
+    /**
+     * @brief 设置静态资源获取方式（默认同步调用 StaticResourceManager::GetResource），Init 不会清除
+     */
+    void SetResourceProvider(ResourceProvider provider) { resource_provider_ = std::move(provider); }
+
+    /**
+     * @brief 以生成的内容作为响应体（如上传结果），在 Init 之后、MakeResponse 之前调用
+     */
+    void SetBody(std::string body, const std::string& content_type);
+
+    /**
+     * @brief MakeResponse 是否因资源仍在后台加载而未完成；此时应在加载完成后重新 Init/MakeResponse
+     */
+    bool IsPending() const { return pending_; }
+
     // 状态查询接口
     std::string GetHeaderString() const;
     std::shared_ptr<StaticResource> GetFileBody() const { return file_body_; }
@@ -43,6 +65,10 @@ public:
     size_t GetBodyLen() const;
     bool HasFileBody() const { return file_body_ != nullptr; }
     int GetCode() const { return code_; }
+    /// 响应的 MIME 类型（SetBody 指定，否则按路径后缀推断）
+    std::string GetContentType() const;
+    /// 状态码对应的原因短语（未知状态码返回 "Unknown"）
+    static std::string GetStatusText(int code);
 
     /**
      * @brief 获取当前响应的诊断信息
@@ -54,10 +80,10 @@ private:
     void AddHeader_();
     void AddContent_();
     void ErrorHtml_();
-    std::string GetFileType_();
 
     int code_;
     bool is_keep_alive_;
+    bool pending_ = false;
     std::string path_;
     std::string src_dir_;
 
@@ -66,7 +92,9 @@ private:
     std::unordered_map<std::string, std::string> headers_;
     
     std::string body_string_; 
+    std::string content_type_;   // SetBody 指定的类型，空表示按路径推断
     std::shared_ptr<StaticResource> file_body_; 
+    ResourceProvider resource_provider_;
     
     static const std::unordered_map<std::string, std::string> SUFFIX_TYPE;
     static const std::unordered_map<int, std::string> CODE_STATUS;
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace tinywebserver {
+
+/**
+ * @brief 对数-线性（HDR 风格）延迟直方图
+ *
+ * 数值单位为纳秒。小于 2^kSubBucketBits 的值精确计数；更大的值按二进制
+ * 数量级分段，每段再线性划分为 kSubBucketHalf 个子桶，相对误差 <= 1/16。
+ * 上限为 2^kMaxValueBits 纳秒（约 18 分钟），超出部分记入最后一个桶。
+ *
+ * 单写者设计：每个线程只写自己的直方图（relaxed load + store，无锁前缀指令），
+ * 读者可并发调用 MergeInto() 获取无撕裂的近似快照。
+ */
+class LatencyHistogram
+{
+public:
+    static constexpr int kSubBucketBits = 5;
+    static constexpr uint64_t kSubBucketCount = 1ULL << kSubBucketBits;       // 32
+    static constexpr uint64_t kSubBucketHalf = kSubBucketCount / 2;           // 16
+    static constexpr int kMaxValueBits = 40;
+    static constexpr uint64_t kMaxValue = (1ULL << kMaxValueBits) - 1;
+    static constexpr size_t kBucketCount =
+        kSubBucketCount + (kMaxValueBits - kSubBucketBits + 1) * kSubBucketHalf;
+
+    /**
+     * @brief 合并后的只读快照，可跨线程累加
+     */
+    struct Snapshot
+    {
+        std::vector<uint64_t> counts = std::vector<uint64_t>(kBucketCount, 0);
+        uint64_t total_count = 0;
+        uint64_t total_sum = 0;    ///< 纳秒
+        uint64_t max_value = 0;    ///< 纳秒
+
+        /**
+         * @brief 计算分位数（返回所在桶的上界，纳秒）
+         * @param quantile 取值 [0, 1]
+         */
+        uint64_t Percentile(double quantile) const;
+
+        /**
+         * @brief 统计不超过 value_ns 的样本数（按桶上界判定，用于 Prometheus 的 le 桶）
+         */
+        uint64_t CountAtOrBelow(uint64_t value_ns) const;
+
+        double MeanNs() const {
+            return total_count == 0 ? 0.0 : static_cast<double>(total_sum) / static_cast<double>(total_count);
+        }
+    };
+
+    /**
+     * @brief 记录一个样本（仅由所属线程调用）
+     */
+    void Record(uint64_t value_ns)
+    {
+        if (value_ns > kMaxValue) {
+            value_ns = kMaxValue;
+        }
+        Bump(counts_[BucketIndex(value_ns)], 1);
+        Bump(total_count_, 1);
+        Bump(total_sum_, value_ns);
+        if (value_ns > max_value_.load(std::memory_order_relaxed)) {
+            max_value_.store(value_ns, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief 把本直方图累加到快照中（可与写者并发）
+     */
+    void MergeInto(Snapshot& out) const;
+
+    /**
+     * @brief 把另一个直方图累加进来（调用方保证本对象无并发写者）
+     */
+    void MergeFrom(const LatencyHistogram& other);
+
+    /**
+     * @brief 清零（用于测试）
+     */
+    void Clear();
+
+    /// 值 -> 桶下标
+    static size_t BucketIndex(uint64_t value)
+    {
+        if (value < kSubBucketCount) {
+            return static_cast<size_t>(value);
+        }
+        int msb = 63 - __builtin_clzll(value);
+        int shift = msb - (kSubBucketBits - 1);
+        uint64_t top = value >> shift;   // [kSubBucketHalf, kSubBucketCount)
+        return static_cast<size_t>(kSubBucketCount + (shift - 1) * kSubBucketHalf + (top - kSubBucketHalf));
+    }
+
+    /// 桶下标 -> 该桶可表示的最大值
+    static uint64_t BucketUpperBound(size_t index)
+    {
+        if (index < kSubBucketCount) {
+            return index;
+        }
+        uint64_t offset = index - kSubBucketCount;
+        int shift = static_cast<int>(offset / kSubBucketHalf) + 1;
+        uint64_t top = kSubBucketHalf + offset % kSubBucketHalf;
+        return ((top + 1) << shift) - 1;
+    }
+
+private:
+    static void Bump(std::atomic<uint64_t>& counter, uint64_t n)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> counts_[kBucketCount] = {};
+    std::atomic<uint64_t> total_count_{0};
+    std::atomic<uint64_t> total_sum_{0};
+    std::atomic<uint64_t> max_value_{0};
+};
+
+} // namespace tinywebserver
@@ -0,0 +1,145 @@
+#pragma once
+
+/**
+ * @file load_generator.h
+ * @brief 基准测试共用的事件驱动开环负载生成器
+ *
+ * 少量线程各自持有一个 epoll 实例，驱动成百上千条非阻塞 HTTP/1.1 连接。
+ * 设置了到达速率时按固定间隔生成请求的“计划发送时刻”，与连接是否空闲无关：
+ * 连接都忙时请求在队列中等待，延迟从计划时刻算起（修正协调遗漏，
+ * coordinated omission）；同时记录从实际发出时刻算起的服务延迟作对照。
+ * 未设置速率时退化为闭环满载：每条连接收到响应后立即发下一个请求。
+ */
+
+#include "latency_histogram.h"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tinywebserver {
+namespace benchmark {
+
+struct BenchmarkConfig;
+struct BenchmarkResult;
+
+/**
+ * @brief 回放脚本中的一个请求
+ */
+struct ScheduledRequest {
+    double offset_seconds = 0;   ///< 相对开始计时的计划发送时刻
+    int connection = 0;          ///< 连接序号，同一连接上的请求按脚本顺序逐个发送
+    size_t request = 0;          ///< LoadGeneratorOptions::requests 中的下标
+};
+
+/**
+ * @brief 负载生成器配置
+ */
+struct LoadGeneratorOptions {
+    std::string host = "127.0.0.1";
+    int port = 8080;
+
+    /// 总连接数（均分到各线程）
+    int connections = 100;
+
+    /// 事件循环线程数，0 表示 min(CPU 数, 4)，且不超过连接数
+    int threads = 0;
+
+    /// 固定到达速率（请求/秒），0 表示闭环满载
+    double target_rate = 0;
+
+    double duration_seconds = 10.0;
+
+    /// 原始请求报文，各连接按轮转顺序发送；为空时使用 GET /
+    std::vector<std::string> requests;
+
+    /// 为 false 时每个响应后关闭连接并重连（请求报文应带 Connection: close）
+    bool keep_alive = true;
+
+    /// HTTP/1.1 流水线深度：空闲连接一次写出最多这么多个请求，按序收齐响应后再发下一批
+    int pipeline_depth = 1;
+
+    /// 单个请求从计划时刻起的超时，超时后关闭该连接并重连
+    int64_t request_timeout_ms = 5000;
+
+    /**
+     * @brief 非空时按脚本回放
+     *
+     * 连接数取脚本中最大连接序号 + 1，忽略 target_rate 与 pipeline_depth；
+     * 每条连接在上一个响应到达且计划时刻已到后发出下一个请求，
+     * 延迟从计划时刻算起。全部脚本请求完成或到达 duration_seconds 时结束。
+     */
+    std::vector<ScheduledRequest> schedule;
+
+    /**
+     * @brief 从基准测试配置构造
+     *
+     * custom_params 中的 client_threads 覆盖线程数，pipeline_depth 指定流水线深度；
+     * target_qps 作为到达速率。
+     */
+    static LoadGeneratorOptions FromConfig(const BenchmarkConfig& config);
+};
+
+/**
+ * @brief 一次运行的汇总结果（各线程合并后）
+ */
+struct LoadGeneratorStats {
+    int64_t completed = 0;          ///< 收到完整响应的请求（含非 2xx）
+    int64_t non_2xx = 0;            ///< 状态码不在 [200, 400) 的响应
+    int64_t connect_errors = 0;
+    int64_t io_errors = 0;          ///< 请求途中连接被关闭或读写失败
+    int64_t timeouts = 0;
+    int64_t unsent = 0;             ///< 结束时仍在队列中、未能发出的计划请求
+    int64_t bytes_received = 0;
+    double elapsed_seconds = 0;
+
+    /// 从计划发送时刻到响应完成（已修正协调遗漏），纳秒
+    LatencyHistogram::Snapshot corrected;
+
+    /// 从实际发出时刻到响应完成，纳秒
+    LatencyHistogram::Snapshot service;
+
+    /// 每秒完成数与修正延迟之和（纳秒），用于时间序列
+    struct Interval {
+        int64_t completed = 0;
+        uint64_t latency_sum_ns = 0;
+    };
+    std::vector<Interval> intervals;
+
+    int64_t Successful() const { return completed - non_2xx; }
+    int64_t Failed() const { return non_2xx + connect_errors + io_errors + timeouts; }
+    double Qps() const { return elapsed_seconds > 0 ? Successful() / elapsed_seconds : 0; }
+};
+
+/**
+ * @brief 开环 HTTP/1.1 负载生成器
+ */
+class LoadGenerator {
+public:
+    explicit LoadGenerator(LoadGeneratorOptions options);
+
+    /**
+     * @brief 阻塞运行 duration_seconds 秒并返回统计
+     */
+    LoadGeneratorStats Run();
+
+    /**
+     * @brief 构造一条 HTTP/1.1 请求报文
+     */
+    static std::string BuildRequest(const std::string& method, const std::string& path,
+                                    const std::string& host, const std::string& body, bool keep_alive);
+
+    /**
+     * @brief 把统计写成基准测试指标
+     *
+     * 以修正后的延迟作为 *_latency 主指标，未修正的服务延迟以 service_ 前缀给出。
+     */
+    static void AppendMetrics(const LoadGeneratorStats& stats, BenchmarkResult& result);
+
+private:
+    LoadGeneratorOptions options_;
+};
+
+} // namespace benchmark
+} // namespace tinywebserver
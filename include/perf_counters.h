@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace tinywebserver {
+
+/**
+ * @brief 硬件计数采样值（用户态，按线程计数）
+ */
+struct PerfSample {
+    uint64_t cycles = 0;
+    uint64_t instructions = 0;
+    uint64_t cache_misses = 0;
+    uint64_t branch_misses = 0;
+
+    PerfSample operator-(const PerfSample& rhs) const {
+        return {cycles - rhs.cycles, instructions - rhs.instructions,
+                cache_misses - rhs.cache_misses, branch_misses - rhs.branch_misses};
+    }
+};
+
+/**
+ * @brief 硬件计数采样的请求阶段
+ */
+enum class PerfPhase : int {
+    kRead = 0,    ///< Connection::HandleRead 的 read() 循环
+    kParse,       ///< HTTP 头解析
+    kRespond,     ///< 校验 + 资源查找 + 响应生成
+    kWrite,       ///< Connection::HandleWrite 的 writev()
+    kCount
+};
+
+/// 阶段名称（用于导出标签）
+const char* PerfPhaseName(PerfPhase phase);
+
+/**
+ * @brief perf_event_open 计数组（每线程一组）
+ *
+ * 可选的诊断模式：启用后，每个 EventLoop 线程在进入循环前打开一组
+ * cycles / instructions / cache-misses / branch-misses 计数器（组读取，
+ * 只统计用户态）。每次采样是一次 read() 系统调用，因此默认关闭，
+ * 仅在需要按阶段分析 IPC 与缺失率时通过 MetricsOptions 开启。
+ *
+ * 内核不支持或 perf_event_paranoid 禁止时打开失败：整个进程只告警一次，
+ * 失败的线程不再重试，之后的采样静默跳过，不会按请求产生日志。
+ */
+class PerfCounters {
+public:
+    /// perf_event_open 的替换点（测试用）：返回计数器 fd，失败返回 -1 并设置 errno
+    using OpenFunction = int (*)(uint64_t config, int group_fd);
+
+    /// 全局开关（须在各 EventLoop 线程启动前设置）
+    static void SetEnabled(bool enabled) { enabled_.store(enabled, std::memory_order_relaxed); }
+    static bool IsEnabled() { return enabled_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 为当前线程打开计数组（未启用时直接返回 false）
+     * @return 是否成功打开；本线程此前打开失败过时直接返回 false，不再重试
+     */
+    static bool OpenForCurrentThread();
+
+    /**
+     * @brief 关闭当前线程的计数组并清除失败标记（线程退出时也会自动关闭）
+     */
+    static void CloseForCurrentThread();
+
+    /**
+     * @brief 读取当前线程计数
+     * @return 当前线程未打开计数组时把 out 置零并返回 false
+     */
+    static bool Read(PerfSample& out);
+
+    /**
+     * @brief 替换打开计数器的函数，传 nullptr 恢复 perf_event_open
+     */
+    static void SetOpenFunction(OpenFunction fn);
+
+private:
+    static std::atomic<bool> enabled_;
+};
+
+/**
+ * @brief 阶段采样 RAII：构造时读一次，析构时读一次并把差值计入 ServerMetrics
+ *
+ * 未启用时只有一次 relaxed 原子读的开销。
+ */
+class PerfPhaseScope {
+public:
+    explicit PerfPhaseScope(PerfPhase phase)
+        : phase_(phase), active_(PerfCounters::IsEnabled() && PerfCounters::Read(start_)) {}
+
+    ~PerfPhaseScope() {
+        if (active_) {
+            Finish();
+        }
+    }
+
+    PerfPhaseScope(const PerfPhaseScope&) = delete;
+    PerfPhaseScope& operator=(const PerfPhaseScope&) = delete;
+
+private:
+    void Finish();
+
+    PerfPhase phase_;
+    PerfSample start_;
+    bool active_;
+};
+
+} // namespace tinywebserver
@@ -12,6 +12,7 @@
  * - 记录请求开始和完成事件
  * - 添加自定义请求头部
  * - 添加自定义响应头部
+ * - 注册流式响应路由 /example/stream/<KB>：按背压分批生成指定大小的文本
  */
 class ExamplePlugin : public Plugin {
 public:
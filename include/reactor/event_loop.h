@@ -6,6 +6,7 @@
 
 #include <sys/epoll.h>
 #include <sys/eventfd.h>
+#include <pthread.h>
 #include <unistd.h>
 
 #include <atomic>
@@ -19,6 +20,10 @@
 #include "timer/timer_wheel.h"
 #include "reactor/batch_io_handler.h"
 
+namespace tinywebserver {
+class ConnectionBufferPool;
+}
+
 /**
  * @brief 核心事件循环类 (One Loop Per Thread)
  */
@@ -26,6 +31,17 @@ class EventLoop {
 public:
     using Functor = std::function<void()>;
 
+    /**
+     * @brief 运行时统计（原子读取，可从任意线程调用，不打扰 IO 线程）
+     */
+    struct Stats {
+        size_t registered_fds;      ///< 已注册 epoll 的 fd 数（不含 wakeup fd）
+        size_t connections;         ///< 归属本循环的活跃连接数
+        size_t pending_functors;    ///< 待执行的跨线程任务数
+        uint64_t iterations;        ///< 已完成的循环迭代次数
+        size_t active_timers;       ///< 时间轮中的定时任务数
+    };
+
     EventLoop();
     ~EventLoop();
 
@@ -48,8 +64,8 @@ public:
     
     // 设置回调
     void SetAcceptCallback(Functor cb) { accept_callback_ = std::move(cb); }
-    void SetReadCallback(int fd, std::function<void(int)> cb) { read_callbacks_[fd] = std::move(cb); }
-    void SetWriteCallback(int fd, std::function<void(int)> cb) { write_callbacks_[fd] = std::move(cb); }
+    void SetReadCallback(int fd, std::function<void(int)> cb) { fds_[fd].read = std::move(cb); }
+    void SetWriteCallback(int fd, std::function<void(int)> cb) { fds_[fd].write = std::move(cb); }
 
     // 定时器管理
     tinywebserver::Error AddTimer(int fd, int timeout_seconds, std::function<void()> callback);
@@ -61,6 +77,24 @@ public:
         return thread_id_ == std::this_thread::get_id();
     }
 
+    // 运行时诊断
+    Stats GetStats() const;
+    std::string GetTimerStats() const { return timer_wheel_.GetStats(); }
+
+    /// 本循环的连接缓冲区池（只能在循环线程中使用）
+    tinywebserver::ConnectionBufferPool& GetBufferPool() { return *buffer_pool_; }
+    void OnConnectionEstablished() { connection_count_.fetch_add(1, std::memory_order_relaxed); }
+    void OnConnectionClosed() { connection_count_.fetch_sub(1, std::memory_order_relaxed); }
+
+    // 心跳（供 LoopWatchdog 跨线程读取）
+    bool IsLooping() const { return looping_.load(std::memory_order_acquire); }
+    /// 本轮开始处理事件的时间（纳秒，单调时钟）；0 表示正阻塞在 epoll_wait
+    uint64_t GetBusySinceNs() const { return busy_since_ns_.load(std::memory_order_relaxed); }
+    /// 最近一次进入 epoll_wait 的时间（纳秒，单调时钟）
+    uint64_t GetHeartbeatNs() const { return heartbeat_ns_.load(std::memory_order_relaxed); }
+    pthread_t GetPthreadHandle() const { return pthread_handle_; }
+    int GetTid() const { return tid_.load(std::memory_order_relaxed); }
+
 private:
     void Wakeup();
     void HandleReadForWakeup();
@@ -84,20 +118,39 @@ private:
 
     mutable std::mutex mutex_;
     std::vector<Functor> pending_functors_;
+
+    // 诊断计数（只由本循环写，供其它线程无锁读取）
+    std::atomic<size_t> registered_fd_count_{0};
+    std::atomic<size_t> pending_functor_count_{0};
+    std::atomic<size_t> connection_count_{0};
+    std::atomic<uint64_t> iteration_count_{0};
+
+    // 心跳与线程标识（Loop() 开始时写入）
+    std::atomic<uint64_t> busy_since_ns_{0};
+    std::atomic<uint64_t> heartbeat_ns_{0};
+    std::atomic<int> tid_{0};
+    pthread_t pthread_handle_{};
     
     // 事件回调
     Functor accept_callback_;
-    std::unordered_map<int, std::function<void(int)>> read_callbacks_; // 新增
-    std::unordered_map<int, std::function<void(int)>> write_callbacks_; // 新增
-    
-    // 记录已注册的文件描述符
-    std::unordered_map<int, uint32_t> registered_fds_;
+
+    // 每个 fd 一个表项：读写回调与 epoll 注册状态放在同一节点，每条连接只占一次哈希节点
+    struct FdEntry {
+        uint32_t events = 0;
+        bool registered = false;   ///< 是否已加入 epoll（RemoveEvent 后回调保留到 fd 被复用）
+        std::function<void(int)> read;
+        std::function<void(int)> write;
+    };
+    std::unordered_map<int, FdEntry> fds_;
 
     // 批量 I/O 处理
     BatchIOHandler batch_io_handler_;
 
     // 定时器管理
     tinywebserver::TimerWheel timer_wheel_;
+
+    // 连接按需借用的输入/输出缓冲区与请求解析器
+    std::unique_ptr<tinywebserver::ConnectionBufferPool> buffer_pool_;
 };
 
 #endif
\ No newline at end of file
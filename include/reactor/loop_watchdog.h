@@ -0,0 +1,81 @@
+// 事件循环停顿检测：独立线程巡检各 EventLoop 的心跳
+
+#ifndef TINYWEBSERVER_REACTOR_LOOP_WATCHDOG_H_
+#define TINYWEBSERVER_REACTOR_LOOP_WATCHDOG_H_
+
+#include <atomic>
+#include <csignal>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class EventLoop;
+
+/**
+ * @brief 事件循环看门狗
+ *
+ * 每个 EventLoop 在离开 epoll_wait 时记录“忙碌起点”，进入 epoll_wait 前清零。
+ * 看门狗线程按 threshold/4 的周期巡检：若某循环忙碌超过阈值，则判定为停顿，
+ * 向该线程发送 kStackDumpSignal 抓取调用栈写入日志，并累加
+ * ServerMetrics 的停顿计数。同一次停顿只报告一次。
+ *
+ * 信号处理函数只调用 backtrace()（启动时预热，避免首次调用时分配内存），
+ * 符号化在看门狗线程内完成。
+ */
+class LoopWatchdog {
+public:
+    static constexpr int kStackDumpSignal = SIGUSR2;
+    static constexpr int kMaxStackFrames = 64;
+
+    explicit LoopWatchdog(int threshold_ms);
+    ~LoopWatchdog();
+
+    LoopWatchdog(const LoopWatchdog&) = delete;
+    LoopWatchdog& operator=(const LoopWatchdog&) = delete;
+
+    /**
+     * @brief 登记待监控的循环（须在 Start() 之前调用）
+     * @param name 日志中的循环名称
+     */
+    void Watch(EventLoop* loop, const std::string& name);
+
+    void Start();
+    void Stop();
+
+    /**
+     * @brief 以 now_ns 为当前时刻巡检一遍（巡检线程每个周期调用一次）
+     *
+     * 测试可以不启动巡检线程，直接传入构造的时刻驱动检测；不要与 Start() 同时使用。
+     * @param now_ns ServerMetrics::NowNs 时基
+     * @return 本次新发现的停顿数
+     */
+    size_t CheckOnce(uint64_t now_ns);
+
+    /// 已检测到的停顿次数
+    uint64_t GetStallCount() const { return stall_count_.load(std::memory_order_relaxed); }
+
+private:
+    struct WatchedLoop {
+        EventLoop* loop;
+        std::string name;
+        uint64_t reported_busy_since;   ///< 已报告过的停顿起点，避免重复计数
+    };
+
+    void Run();
+    bool CheckLoop(WatchedLoop& watched, uint64_t now_ns);
+    std::vector<std::string> CaptureStack(EventLoop* loop);
+
+    const uint64_t threshold_ns_;
+    std::vector<WatchedLoop> loops_;
+
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    bool running_;
+    std::atomic<uint64_t> stall_count_;
+};
+
+#endif
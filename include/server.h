@@ -6,6 +6,8 @@
 #include <memory>
 #include <vector>
 #include <mutex>
+#include <condition_variable>
+#include <thread>
 #include <unordered_map>
 #include "reactor/event_loop.h"
 #include "reactor/event_loop_thread_pool.h"
@@ -15,7 +17,10 @@
 #include "connection.h"
 #include "config/server_config.h"
 #include "http/keep_alive_manager.h"
+#include "http/response_writer.h"
 #include "plugin/plugin_manager.h"
+#include "admin/admin_server.h"
+#include "reactor/loop_watchdog.h"
 
 namespace tinywebserver {
 class ServerConfig;
@@ -46,6 +51,11 @@ public:
         on_message_ = std::move(cb);
     }
 
+    /**
+     * @brief 设置 HTTP/2 请求回调，启用 h2c（配置 server.enable_h2c 为 false 时忽略）
+     */
+    void SetOnH2Request(Connection::H2RequestCallback cb);
+
     // 获取 Keep-Alive 管理器
     tinywebserver::KeepAliveManager* GetKeepAliveManager() const {
         return keep_alive_manager_.get();
@@ -60,12 +70,28 @@ public:
      */
     size_t LoadPlugins();
 
+    /**
+     * @brief 注册流式响应路由：路径以 path_prefix 开头的请求交给 handler 边生成边发送
+     *
+     * 按注册顺序匹配第一个前缀。须在 Start 前调用（如插件的 OnLoad），之后只读。
+     */
+    void AddStreamRoute(const std::string& path_prefix, tinywebserver::StreamHandler handler);
+    /// 查找匹配的流式响应处理器，没有时返回 nullptr
+    const tinywebserver::StreamHandler* FindStreamRoute(const std::string& path) const;
+
     void SetupConnectionInLoop(std::shared_ptr<Connection> conn);
     void RemoveConnection(int fd);
 
+    /**
+     * @brief 各 EventLoop 的运行时统计（文本格式，供 /debug/loops 使用）
+     */
+    std::string GetLoopStatsString() const;
+
 private:
 
     Connection::MessageCallback on_message_;
+    Connection::H2RequestCallback on_h2_request_;
+    std::vector<std::pair<std::string, tinywebserver::StreamHandler>> stream_routes_;
     void HandleAccept(int listen_fd);
     void NewConnection(int fd);
     
@@ -89,6 +115,27 @@ private:
     SOReusePortOptions reuseport_opts_;
     std::unique_ptr<MultiListenSocket> multi_listen_socket_;
 
+    // 管理端口（/metrics、/debug/*），由 MetricsOptions 控制
+    std::unique_ptr<tinywebserver::AdminServer> admin_server_;
+    void StartAdminServer();
+
+    // 事件循环停顿检测
+    std::unique_ptr<LoopWatchdog> watchdog_;
+    void StartWatchdog();
+
+    // 访问轨迹（MetricsOptions::access_trace_path 非空时由本实例开启并在 Stop 时关闭）
+    bool owns_access_trace_ = false;
+    void StartAccessTrace();
+
+    // 静态缓存预热（StaticOptions::warmup，在创建监听 socket 前执行）与热点列表定期保存
+    void WarmUpStaticCache();
+    std::thread hot_list_thread_;
+    std::mutex hot_list_mutex_;
+    std::condition_variable hot_list_cv_;
+    bool hot_list_stop_ = false;
+    void StartHotListSaver();
+    void StopHotListSaver();
+
     // SO_REUSEPORT 模式相关方法
     void SetupSOReusePortMode();
     void SetupTraditionalMode();
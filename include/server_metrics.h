@@ -8,12 +8,100 @@
 #include <chrono>
 #include <vector>
 #include <map>
+#include <mutex>
+#include <functional>
+
+#include "latency_histogram.h"
+#include "perf_counters.h"
 
 namespace tinywebserver {
 
+/**
+ * @brief 请求处理阶段（延迟直方图维度）
+ */
+enum class RequestPhase : int
+{
+    kTotal = 0,      ///< 首字节读入 -> 最后一个响应字节写出
+    kParse,          ///< HTTP 头解析
+    kValidate,       ///< 请求安全校验
+    kLookup,         ///< 资源查找与响应生成（含静态缓存命中/未命中）
+    kQueueToFlush,   ///< 响应入队 -> 完全写出（反映写背压）
+    kCount
+};
+
+/// 阶段名称（用于导出标签）
+const char* RequestPhaseName(RequestPhase phase);
+
+/**
+ * @brief 单线程计数分片
+ *
+ * 每个线程独占一个分片，写路径只有本线程触达：relaxed load + relaxed store
+ * 在 x86/ARM 上编译为一次普通加法（无 lock 前缀），读线程汇总时也不会读到撕裂值。
+ * alignas(64) 保证不同线程的分片不落在同一缓存行，消除伪共享。
+ */
+struct alignas(64) MetricsShard
+{
+    using Counter = std::atomic<uint64_t>;
+
+    // 连接指标（活跃连接 = opened - closed，允许开/关发生在不同线程）
+    Counter connections_opened{0};
+    Counter connections_closed{0};
+
+    // 请求指标
+    Counter total_requests{0};
+    Counter requests_by_class[5] = {};   // 1xx..5xx
+
+    // 流量指标
+    Counter bytes_sent{0};
+    Counter bytes_received{0};
+
+    // 错误指标
+    Counter errors{0};
+
+    // 资源指标
+    Counter memory_allocated{0};
+    Counter memory_freed{0};
+    Counter epoll_wait_time_us{0};
+
+    // 事件循环健康指标
+    Counter loop_stalls{0};
+
+    // 延迟直方图（按阶段）
+    LatencyHistogram latency[static_cast<int>(RequestPhase::kCount)];
+
+    // 事件循环直方图：单次迭代忙碌时长（纳秒）与 DoPendingFunctors 批大小
+    LatencyHistogram loop_iteration;
+    LatencyHistogram functor_batch;
+
+    // 硬件计数（按阶段累计，仅在 PerfCounters 启用时写入）
+    struct PerfTotals {
+        Counter samples{0};
+        Counter cycles{0};
+        Counter instructions{0};
+        Counter cache_misses{0};
+        Counter branch_misses{0};
+    };
+    PerfTotals perf[static_cast<int>(PerfPhase::kCount)];
+
+    /// 仅由所属线程调用：单写者，无需原子 RMW
+    static void Add(Counter& counter, uint64_t n)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    /// 汇总/清零时使用（可能与写者并发，只需要无撕裂）
+    static uint64_t Read(const Counter& counter)
+    {
+        return counter.load(std::memory_order_relaxed);
+    }
+};
+
 /**
  * @brief 全局服务器指标监控类 (单例)
  * 符合功能安全要求，提供实时状态查询接口
+ *
+ * 计数按线程分片记录，GetSnapshot() 时惰性汇总所有分片；
+ * 线程退出时其分片累加到 retired_ 后释放，计数不会丢失。
  */
 class ServerMetrics
 {
@@ -28,56 +116,80 @@ public:
 
     // 连接层指标
     void OnNewConnection() {
-        active_connections_++;
-        total_connections_++;
+        MetricsShard::Add(LocalShard().connections_opened, 1);
     }
     void OnCloseConnection() {
-        active_connections_--;
+        MetricsShard::Add(LocalShard().connections_closed, 1);
     }
 
     // 请求层指标
     void OnRequest() {
-        total_requests_++;
+        MetricsShard::Add(LocalShard().total_requests, 1);
     }
     void OnRequestWithStatusCode(int status_code) {
-        total_requests_++;
-        if (status_code >= 100 && status_code < 200) {
-            requests_1xx_++;
-        } else if (status_code >= 200 && status_code < 300) {
-            requests_2xx_++;
-        } else if (status_code >= 300 && status_code < 400) {
-            requests_3xx_++;
-        } else if (status_code >= 400 && status_code < 500) {
-            requests_4xx_++;
-        } else if (status_code >= 500 && status_code < 600) {
-            requests_5xx_++;
+        MetricsShard& shard = LocalShard();
+        MetricsShard::Add(shard.total_requests, 1);
+        if (status_code >= 100 && status_code < 600) {
+            MetricsShard::Add(shard.requests_by_class[status_code / 100 - 1], 1);
         }
     }
 
     // 流量指标
     void OnBytesSent(size_t bytes) {
-        total_bytes_sent_ += bytes;
+        MetricsShard::Add(LocalShard().bytes_sent, bytes);
     }
     void OnBytesReceived(size_t bytes) {
-        total_bytes_received_ += bytes;
+        MetricsShard::Add(LocalShard().bytes_received, bytes);
     }
 
     // 错误指标
     void OnError() {
-        error_count_++;
+        MetricsShard::Add(LocalShard().errors, 1);
     }
 
     // 资源指标
     void OnMemoryAllocated(size_t bytes) {
-        memory_allocated_ += bytes;
+        MetricsShard::Add(LocalShard().memory_allocated, bytes);
     }
     void OnMemoryFreed(size_t bytes) {
-        memory_allocated_ -= bytes;
+        MetricsShard::Add(LocalShard().memory_freed, bytes);
     }
 
     // 性能指标
     void OnEpollWaitTime(uint64_t microseconds) {
-        epoll_wait_time_us_ += microseconds;
+        MetricsShard::Add(LocalShard().epoll_wait_time_us, microseconds);
+    }
+
+    // 事件循环指标
+    void OnLoopStall() {
+        MetricsShard::Add(LocalShard().loop_stalls, 1);
+    }
+    void OnLoopIteration(uint64_t busy_nanoseconds) {
+        LocalShard().loop_iteration.Record(busy_nanoseconds);
+    }
+    void OnPendingFunctorBatch(size_t batch_size) {
+        LocalShard().functor_batch.Record(batch_size);
+    }
+
+    // 硬件计数指标
+    void OnPerfSample(PerfPhase phase, const PerfSample& delta) {
+        MetricsShard::PerfTotals& totals = LocalShard().perf[static_cast<int>(phase)];
+        MetricsShard::Add(totals.samples, 1);
+        MetricsShard::Add(totals.cycles, delta.cycles);
+        MetricsShard::Add(totals.instructions, delta.instructions);
+        MetricsShard::Add(totals.cache_misses, delta.cache_misses);
+        MetricsShard::Add(totals.branch_misses, delta.branch_misses);
+    }
+
+    // 延迟指标（纳秒）
+    void OnRequestPhase(RequestPhase phase, uint64_t nanoseconds) {
+        LocalShard().latency[static_cast<int>(phase)].Record(nanoseconds);
+    }
+
+    /// 单调时钟（纳秒），用于阶段计时
+    static uint64_t NowNs() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
     }
 
     // ==================== 状态查询接口 ====================
@@ -106,33 +218,42 @@ public:
         // 资源指标
         int64_t memory_allocated;
         uint64_t epoll_wait_time_us;
+        uint64_t loop_stalls;
 
         // 运行时信息
         double uptime_sec;
     };
 
-    Snapshot GetSnapshot() const
+    /**
+     * @brief 汇总所有线程分片（加锁遍历分片列表，写路径不受影响）
+     */
+    Snapshot GetSnapshot() const;
+
+    /**
+     * @brief 合并所有线程分片的某阶段延迟直方图
+     */
+    LatencyHistogram::Snapshot GetLatencySnapshot(RequestPhase phase) const;
+
+    /**
+     * @brief 合并所有线程的事件循环迭代时长 / 任务批大小直方图
+     */
+    LatencyHistogram::Snapshot GetLoopIterationSnapshot() const;
+    LatencyHistogram::Snapshot GetFunctorBatchSnapshot() const;
+
+    /**
+     * @brief 某阶段的硬件计数累计值
+     */
+    struct PerfSnapshot
     {
-        auto now = std::chrono::steady_clock::now();
-        std::chrono::duration<double> diff = now - start_time_;
-
-        return {
-            active_connections_.load(),
-            total_connections_.load(),
-            total_requests_.load(),
-            requests_1xx_.load(),
-            requests_2xx_.load(),
-            requests_3xx_.load(),
-            requests_4xx_.load(),
-            requests_5xx_.load(),
-            total_bytes_sent_.load(),
-            total_bytes_received_.load(),
-            error_count_.load(),
-            memory_allocated_.load(),
-            epoll_wait_time_us_.load(),
-            diff.count()
-        };
-    }
+        uint64_t samples;
+        PerfSample totals;
+
+        double Ipc() const {
+            return totals.cycles == 0 ? 0.0 :
+                static_cast<double>(totals.instructions) / static_cast<double>(totals.cycles);
+        }
+    };
+    PerfSnapshot GetPerfSnapshot(PerfPhase phase) const;
 
     // ==================== 导出接口 ====================
 
@@ -151,6 +272,11 @@ public:
      */
     void Reset();
 
+    /**
+     * @brief 当前已注册的线程分片数量（用于测试/诊断）
+     */
+    size_t GetShardCount() const;
+
 private:
     ServerMetrics() : start_time_(std::chrono::steady_clock::now()) {}
 
@@ -158,31 +284,30 @@ private:
     ServerMetrics(const ServerMetrics&) = delete;
     ServerMetrics& operator=(const ServerMetrics&) = delete;
 
-    // 运行时信息
-    std::chrono::steady_clock::time_point start_time_;
+    friend class MetricsShardOwner;
 
-    // 连接指标
-    std::atomic<uint64_t> active_connections_{0};
-    std::atomic<uint64_t> total_connections_{0};
-
-    // 请求指标
-    std::atomic<uint64_t> total_requests_{0};
-    std::atomic<uint64_t> requests_1xx_{0};
-    std::atomic<uint64_t> requests_2xx_{0};
-    std::atomic<uint64_t> requests_3xx_{0};
-    std::atomic<uint64_t> requests_4xx_{0};
-    std::atomic<uint64_t> requests_5xx_{0};
+    /// 获取当前线程的分片，首次调用时注册
+    MetricsShard& LocalShard()
+    {
+        static thread_local MetricsShard* tls_shard = nullptr;
+        if (__builtin_expect(tls_shard == nullptr, 0)) {
+            tls_shard = RegisterThreadShard();
+        }
+        return *tls_shard;
+    }
 
-    // 流量指标
-    std::atomic<uint64_t> total_bytes_sent_{0};
-    std::atomic<uint64_t> total_bytes_received_{0};
+    MetricsShard* RegisterThreadShard();
+    LatencyHistogram::Snapshot MergeHistograms(
+        const std::function<const LatencyHistogram&(const MetricsShard&)>& select) const;
+    void RetireShard(MetricsShard* shard);
 
-    // 错误指标
-    std::atomic<uint64_t> error_count_{0};
+    // 运行时信息
+    std::chrono::steady_clock::time_point start_time_;
 
-    // 资源指标
-    std::atomic<int64_t> memory_allocated_{0};  // 可能为负（如果释放多于分配）
-    std::atomic<uint64_t> epoll_wait_time_us_{0};
+    // 分片注册表（只在线程首次记录、线程退出与汇总时加锁）
+    mutable std::mutex shards_mutex_;
+    std::vector<MetricsShard*> shards_;
+    MetricsShard retired_;   ///< 已退出线程的累计值
 };
 
 } // namespace tinywebserver
@@ -0,0 +1,119 @@
+#pragma once
+
+/**
+ * @file server_process.h
+ * @brief 基准测试的独立进程服务器模式
+ *
+ * 默认情况下各基准测试在客户端进程内用 std::thread 启动 Server，服务器与客户端
+ * 共享分配器、CPU 和 /proc/self 读数。独立进程模式（custom_params.server_mode = "process"）
+ * 改为 fork/exec 正式的 server 可执行文件：
+ * - 按基准配置生成服务器配置文件（端口、线程数、静态目录）
+ * - 服务器与客户端可分别绑定到互不相交的 CPU 集合
+ * - 以 HTTP 就绪探测代替固定时长的 sleep
+ * - 通过 /proc/<pid> 只采样服务器进程的 CPU、RSS、上下文切换与 fd 数
+ *
+ * custom_params:
+ * - server_mode：in_process（默认）或 process
+ * - server_binary：server 可执行文件，默认与 benchmark_runner 同目录
+ * - server_config：作为模板的服务器配置文件，默认使用内置默认值
+ * - server_threads：覆盖 server.threads
+ * - cache_policy：覆盖 static.cache_policy
+ * - loader_threads：覆盖 static.loader_threads（0 表示缓存未命中在 EventLoop 上同步加载）
+ * - server_cpus / client_cpus：CPU 列表，如 "0-1" 或 "2,3"
+ */
+
+#include "benchmark.h"
+
+#include <sched.h>
+#include <string>
+#include <sys/types.h>
+
+namespace tinywebserver {
+namespace benchmark {
+
+/**
+ * @brief 配置是否要求独立进程服务器
+ */
+bool UseServerProcess(const BenchmarkConfig& config);
+
+/**
+ * @brief 解析 "0-3,6" 形式的 CPU 列表
+ * @return 列表为空或格式错误时返回 false
+ */
+bool ParseCpuList(const std::string& text, cpu_set_t& set);
+
+/**
+ * @brief 把本进程现有的全部线程绑定到 CPU 列表（之后创建的线程继承该绑定）
+ */
+bool PinCurrentProcess(const std::string& cpus);
+
+/**
+ * @brief 就绪探测：反复连接并发送 GET /，直到收到 HTTP 状态行
+ * @param pid 非 0 时若该子进程提前退出则回收它并立即返回 false
+ * @param child_exited 非空时记录 pid 是否已在探测期间被回收（调用方不可再 kill/waitpid 该 pid）
+ */
+bool WaitForHttpReady(const std::string& host, int port, double timeout_seconds, pid_t pid = 0,
+                      bool* child_exited = nullptr);
+
+/**
+ * @brief 独立进程服务器配置
+ */
+struct ServerProcessOptions {
+    std::string binary;                 ///< 空表示 benchmark_runner 同目录下的 server
+    std::string base_config;            ///< 模板配置文件，空表示默认配置
+    std::string host = "127.0.0.1";
+    int port = 8080;
+    int threads = 0;                    ///< 0 表示沿用模板中的 server.threads
+    int keep_alive_timeout = 0;         ///< 秒，0 表示沿用模板中的 limits.keep_alive_timeout
+    std::string cache_policy;           ///< 空表示沿用模板中的 static.cache_policy
+    int loader_threads = -1;            ///< 负数表示沿用模板中的 static.loader_threads
+    bool require_h2c = false;           ///< true 时强制开启 server.enable_h2c（HTTP/2 基准测试）
+    std::string doc_root = "./public";
+    std::string server_cpus;            ///< 空表示不绑定
+    std::string client_cpus;            ///< 空表示不绑定
+    std::string config_path = "benchmark_server.json";   ///< 生成的配置文件
+    double ready_timeout_seconds = 10.0;
+
+    static ServerProcessOptions FromConfig(const BenchmarkConfig& config);
+};
+
+/**
+ * @brief fork/exec 出的 server 进程
+ */
+class ServerProcess {
+public:
+    explicit ServerProcess(ServerProcessOptions options);
+    ~ServerProcess();
+
+    ServerProcess(const ServerProcess&) = delete;
+    ServerProcess& operator=(const ServerProcess&) = delete;
+
+    /**
+     * @brief 生成配置、启动进程并等待就绪；设置了 client_cpus 时同时绑定本进程
+     */
+    bool Start(std::string& error);
+
+    /**
+     * @brief SIGTERM 后等待退出，超时则 SIGKILL；进程已被回收时什么都不做
+     */
+    void Stop();
+
+    pid_t Pid() const { return pid_; }
+
+    /**
+     * @brief 把服务器进程的资源采样写成 server_ 前缀的指标
+     *
+     * monitor 须以 Pid() 构造，并在负载期间运行。
+     */
+    static void AppendMetrics(const SystemResourceMonitor& monitor, BenchmarkResult& result);
+
+private:
+    bool WriteConfig(std::string& error) const;
+    std::string ResolveBinary() const;
+
+    ServerProcessOptions options_;
+    pid_t pid_ = -1;
+};
+
+} // namespace benchmark
+} // namespace tinywebserver
@@ -9,7 +9,14 @@
 #include <memory>
 #include <list>
 #include <atomic>
+#include <chrono>
 #include <mutex>
+#include <functional>
+#include <future>
+#include <vector>
+
+#include "frequency_sketch.h"
+#include "thread_pool.h"
 
 /**
  * @brief 封装 mmap 映射的资源块
@@ -21,9 +28,28 @@ struct StaticResource
     std::string path; 
 };
 
+/**
+ * @brief 缓存淘汰/准入策略（StaticOptions::cache_policy）
+ */
+enum class CachePolicy
+{
+    kLru,           ///< "lru"：纯 LRU，按字节上限淘汰最久未访问的文件
+    kWTinyLfu,      ///< "wtinylfu"：1% 准入窗口（LRU）+ 分段 LRU 主区，频率草图决定窗口淘汰者能否进入主区
+    kWTinyLfuSize   ///< "wtinylfu_size"：同上，但候选者须比它要挤出的全部文件合计更热（按每字节命中计价）
+};
+
+/// 解析策略名，未知名称返回 false
+bool ParseCachePolicy(const std::string& name, CachePolicy& policy);
+const char* CachePolicyName(CachePolicy policy);
+
 /**
  * @brief 静态资源管理器 (单例)
  * 阶段四特性：LRU 淘汰策略、内存上限控制、运行时统计
+ *
+ * W-TinyLFU 策略下缓存分三段：新文件先进入占 1% 字节的窗口 LRU；窗口溢出时
+ * 队尾文件作为候选者与主区试用段（probation）队尾的淘汰者比较频率草图估计，
+ * 赢家留下。试用段再次命中的文件升入保护段（protected，主区的 80%）。
+ * 爬虫式的一次性扫描频率只有 1，进不了主区，热点集合不会被冲掉。
  */
 class StaticResourceManager
 {
@@ -37,19 +63,79 @@ public:
     StaticResourceManager(const StaticResourceManager&) = delete;
     StaticResourceManager& operator=(const StaticResourceManager&) = delete;
 
+    /// 异步加载完成回调，在加载线程上调用；加载失败时参数为 nullptr
+    using LoadCallback = std::function<void(std::shared_ptr<StaticResource>)>;
+
     /**
      * @brief 获取静态资源 (带 LRU 更新)
+     *
+     * 未命中时在调用线程加载，加载期间不持有锁；同一路径的并发未命中只加载一次，
+     * 其余调用者等待同一个 future（single-flight）。
      */
     std::shared_ptr<StaticResource> GetResource(const std::string& path);
 
+    /**
+     * @brief 非阻塞获取静态资源（供 EventLoop 线程使用）
+     *
+     * 命中时直接返回资源。未命中时把 open/fstat/mmap 交给后台加载线程，返回 nullptr
+     * 并置 pending 为 true，加载完成后在加载线程上调用 on_loaded（调用方负责切回自己的
+     * EventLoop）；同一路径已在加载时只登记回调。加载线程数为 0 时退化为同步加载。
+     */
+    std::shared_ptr<StaticResource> GetResourceAsync(const std::string& path, LoadCallback on_loaded,
+                                                     bool& pending);
+
+    /**
+     * @brief 设置后台加载线程数（0 表示在调用线程同步加载），在首次异步加载前设置
+     */
+    void SetLoaderThreads(size_t threads);
+
+    /**
+     * @brief 启动预热参数
+     */
+    struct WarmUpOptions
+    {
+        std::string root;                       ///< 静态资源根目录（与请求拼接路径时相同）
+        std::string hot_list_path;              ///< 上次运行保存的热点列表，空或不存在时只按目录预热
+        size_t threads = 4;                     ///< 并行加载线程数
+        std::chrono::milliseconds budget{5000}; ///< 时间预算，到期后不再开始新的加载
+    };
+
+    struct WarmUpResult
+    {
+        size_t candidates = 0;      ///< 计划加载的文件数（按缓存上限截断后）
+        size_t files_loaded = 0;
+        size_t bytes_loaded = 0;
+        size_t hot_list_hits = 0;   ///< 来自热点列表的候选数
+        bool timed_out = false;
+        uint64_t elapsed_ms = 0;
+    };
+
+    /**
+     * @brief 启动预热：按热点列表优先、其余文件从小到大的顺序，并行加载到缓存上限为止
+     *
+     * 预热加载使用 MAP_POPULATE 预先建立页表并读入页面，服务请求时 writev 不再缺页。
+     * 阻塞到全部加载完成或时间预算到期（正在进行的加载会完成）。
+     */
+    WarmUpResult WarmUp(const WarmUpOptions& options);
+
+    /**
+     * @brief 把当前缓存内容按热度（保护段、试用段、窗口段，各自由新到旧）写入热点列表
+     *
+     * 先写临时文件再 rename，进程中途被杀也不会留下半个列表。
+     */
+    bool SaveHotList(const std::string& path) const;
+
     /**
      * @brief 设置缓存限制
      * @param max_mem_bytes 最大允许 mmap 的字节数
      */
-    void SetCacheLimit(size_t max_mem_bytes) 
-    { 
-        max_cache_size_ = max_mem_bytes; 
-    }
+    void SetCacheLimit(size_t max_mem_bytes);
+
+    /**
+     * @brief 切换淘汰/准入策略（清空缓存与频率草图，已发出的资源不受影响）
+     */
+    void SetCachePolicy(CachePolicy policy);
+    CachePolicy GetCachePolicy() const;
 
     /**
      * @brief 运行时状态查询接口 (生产级要求)
@@ -60,34 +146,95 @@ public:
         size_t cached_files_count;
         uint64_t total_requests;
         uint64_t cache_hits;
+        uint64_t evictions;            ///< 从缓存中淘汰的文件数
+        uint64_t rejected_admissions;  ///< 准入比较失败、未进入主区的候选文件数
+        uint64_t background_loads;     ///< 由后台加载线程完成的加载次数
+        uint64_t coalesced_loads;      ///< 并入同一路径进行中加载的未命中次数
+        CachePolicy policy;
     };
     Status GetStatus() const;
 
 private:
-    StaticResourceManager() : max_cache_size_(1024 * 1024 * 512) {} // 默认 512MB
+    StaticResourceManager(); // 默认 512MB，LRU
     ~StaticResourceManager() = default;
 
-    std::shared_ptr<StaticResource> Load_(const std::string& path);
-    void Evict_(); // 执行 LRU 淘汰
+    // 缓存项所在的分段
+    enum class Segment
+    {
+        kWindow,
+        kProbation,
+        kProtected
+    };
 
     // 结构定义：缓存项
     struct CacheItem
     {
         std::string path;
         std::shared_ptr<StaticResource> resource;
+        uint64_t hash = 0;
+        Segment segment = Segment::kWindow;
+    };
+    using ItemList = std::list<CacheItem>;
+
+    // 同一路径进行中的加载（single-flight）
+    struct PendingLoad
+    {
+        std::promise<std::shared_ptr<StaticResource>> promise;
+        std::shared_future<std::shared_ptr<StaticResource>> future;
+        std::vector<LoadCallback> waiters;
     };
 
+    /// populate 为 true 时用 MAP_POPULATE 同步读入全部页面，否则只发 MADV_WILLNEED 预读提示
+    std::shared_ptr<StaticResource> Load_(const std::string& path, bool populate = false);
+    /// 持锁查找：计入请求数与频率草图，命中时更新所在分段
+    std::shared_ptr<StaticResource> Lookup_(const std::string& path);
+    /// 不持锁加载，然后持锁放入缓存、结束 single-flight 并通知等待者
+    std::shared_ptr<StaticResource> LoadAndComplete_(const std::string& path, bool populate = false);
+    /// 预热加载一个路径（不计入请求统计），已缓存或正在加载时返回 nullptr
+    std::shared_ptr<StaticResource> Prefetch_(const std::string& path);
+    void Insert_(const std::string& path, const std::shared_ptr<StaticResource>& resource);
+    void OnHit_(ItemList::iterator it);
+    /// 窗口超限时把队尾交给准入比较，主区超限时从主区队尾淘汰
+    void Rebalance_();
+    void Admit_(ItemList::iterator candidate);
+    void Evict_(ItemList::iterator it); // 从所在分段移除
+    void UpdateLimits_();
+    void Clear_();
+    ItemList& ListOf_(Segment segment);
+    size_t& BytesOf_(Segment segment);
+    void MoveTo_(ItemList::iterator it, Segment segment);
+
     mutable std::shared_mutex mutex_;
     size_t max_cache_size_;
     std::atomic<size_t> current_cache_size_{0};
-    
-    // LRU 数据结构
-    std::list<CacheItem> lru_list_;
-    std::unordered_map<std::string, std::list<CacheItem>::iterator> cache_map_;
+    CachePolicy policy_ = CachePolicy::kLru;
+
+    // 分段 LRU（LRU 策略只使用窗口段，窗口上限即总上限）
+    ItemList window_list_;
+    ItemList probation_list_;
+    ItemList protected_list_;
+    size_t window_bytes_ = 0;
+    size_t probation_bytes_ = 0;
+    size_t protected_bytes_ = 0;
+    size_t window_limit_ = 0;
+    size_t protected_limit_ = 0;
+    std::unordered_map<std::string, ItemList::iterator> cache_map_;
+
+    // W-TinyLFU 频率草图（同时记录未缓存文件的访问）
+    tinywebserver::FrequencySketch sketch_;
 
     // 统计数据
     std::atomic<uint64_t> total_requests_{0};
     std::atomic<uint64_t> cache_hits_{0};
+    std::atomic<uint64_t> evictions_{0};
+    std::atomic<uint64_t> rejected_admissions_{0};
+    std::atomic<uint64_t> background_loads_{0};
+    std::atomic<uint64_t> coalesced_loads_{0};
+
+    std::unordered_map<std::string, std::shared_ptr<PendingLoad>> pending_loads_;
+    size_t loader_threads_ = 2;
+    // 最后声明：析构时先停止并回收加载线程，再销毁它们访问的成员
+    std::unique_ptr<ThreadPool> loader_pool_;
 };
 
 #endif
@@ -28,13 +28,15 @@ namespace tinywebserver {
 struct TimerTask {
     int fd;                             ///< 关联的文件描述符
     std::function<void()> callback;     ///< 超时回调函数
-    int remaining_ticks;                ///< 剩余滴答数（当超时时间超过轮子大小时使用）
+    int remaining_ticks;                ///< 剩余圈数（当超时时间超过轮子大小时使用）
+    std::size_t slot;                   ///< 所在槽位（删除时定位链表）
     std::chrono::steady_clock::time_point created_at;  ///< 创建时间戳
 
     TimerTask(int f, std::function<void()> cb, int ticks)
         : fd(f),
           callback(std::move(cb)),
           remaining_ticks(ticks),
+          slot(0),
           created_at(std::chrono::steady_clock::now()) {
     }
 };
@@ -87,10 +89,19 @@ public:
      * @brief 执行一个滴答（前进一个时间槽）
      *
      * 通常由外部定时器每秒调用一次，触发当前槽位的超时任务。
+     * 回调在释放内部锁之后执行，可以在回调中增删定时任务。
      * 返回触发的任务数量。
      */
     std::size_t Tick();
 
+    /**
+     * @brief 按实际经过的时间前进：距上次前进每满一个滴答间隔执行一次 Tick()
+     *
+     * 事件循环每次迭代都可调用，迭代频率不影响超时时长。
+     * @return 触发的任务数量
+     */
+    std::size_t Advance(std::chrono::steady_clock::time_point now);
+
     /**
      * @brief 获取下一个滴答的等待时间
      * @return 距离下一个滴答的毫秒数，如果时间轮为空则返回 -1
@@ -149,11 +160,12 @@ private:
     void AddTaskToSlot(std::size_t slot, TimerTask&& task);
 
     /**
-     * @brief 执行指定槽位的所有超时任务
+     * @brief 取出指定槽位中到期的任务（须持有锁，回调由调用方在锁外执行）
      * @param slot 槽位索引
-     * @return 触发的任务数量
+     * @param expired 输出参数：到期任务的回调
+     * @return 到期的任务数量
      */
-    std::size_t ProcessSlot(std::size_t slot);
+    std::size_t ProcessSlot(std::size_t slot, std::vector<std::function<void()>>& expired);
 
     /// 时间轮槽位数组
     std::vector<std::list<TimerTask>> wheel_;
@@ -173,6 +185,9 @@ private:
     /// 滴答间隔（毫秒）
     const int tick_interval_ms_;
 
+    /// 上次 Advance() 对齐到的滴答时刻
+    std::chrono::steady_clock::time_point last_tick_time_;
+
     /// 最大支持循环次数（用于处理超过时间轮大小的超时）
     static constexpr std::size_t kMaxCycles = 10;
 
@@ -117,13 +117,17 @@ void BatchIOHandler::GroupEvents(const std::vector<epoll_event>& events,
         bool has_write = IsWritable(revents);
         bool has_error = IsError(revents);
 
-        // Priority: errors first, then reads, then writes
+        // Errors take priority; an fd that is both readable and writable goes
+        // into both groups, otherwise an edge-triggered EPOLLOUT is lost
         if (has_error) {
             errors.push_back(fd);
-        } else if (has_read) {
-            readable.push_back(fd);
-        } else if (has_write) {
-            writable.push_back(fd);
+        } else if (has_read || has_write) {
+            if (has_read) {
+                readable.push_back(fd);
+            }
+            if (has_write) {
+                writable.push_back(fd);
+            }
         } else {
             // Unknown event type - log and treat as error
             LOG_WARN("BatchIOHandler::GroupEvents unknown event type 0x%x for fd=%d",
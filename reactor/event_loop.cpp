@@ -5,9 +5,12 @@
 #include "reactor/event_loop.h"
 #include "Logger.h"
 #include "error/error.h"
+#include "server_metrics.h"
+#include "connection_buffer_pool.h"
 
 #include <sys/eventfd.h>
 #include <sys/epoll.h>
+#include <sys/syscall.h>
 #include <unistd.h>
 #include <sstream>
 #include <thread>
@@ -21,7 +24,8 @@ EventLoop::EventLoop()
       thread_id_(std::this_thread::get_id()),
       epoll_fd_(epoll_create1(EPOLL_CLOEXEC)),
       wakeup_fd_(CreateEventFd()),
-      timer_wheel_(60, 1000) {  // 60秒时间轮，1秒精度
+      timer_wheel_(60, 1000),  // 60秒时间轮，1秒精度
+      buffer_pool_(std::make_unique<tinywebserver::ConnectionBufferPool>()) {
     
     if (epoll_fd_ < 0) {
         LOG_FATAL("EventLoop: epoll_create1 failed");
@@ -39,10 +43,11 @@ EventLoop::~EventLoop() {
 void EventLoop::Loop() {
     assert(!looping_);
     thread_id_ = std::this_thread::get_id(); // 在此处正式绑定执行线程
-    looping_ = true;
-
-    looping_ = true;
+    pthread_handle_ = ::pthread_self();
+    tid_.store(static_cast<int>(::syscall(SYS_gettid)), std::memory_order_relaxed);
+    busy_since_ns_.store(tinywebserver::ServerMetrics::NowNs(), std::memory_order_relaxed);
     quit_ = false;
+    looping_.store(true, std::memory_order_release);
 
     while (!quit_) {
         // 处理定时器
@@ -63,9 +68,11 @@ void EventLoop::Loop() {
 
         ProcessEvents(next_timeout);
         DoPendingFunctors();
+        iteration_count_.fetch_add(1, std::memory_order_relaxed);
     }
 
     looping_ = false;
+    busy_since_ns_.store(0, std::memory_order_relaxed);
 }
 
 void EventLoop::Quit() {
@@ -93,6 +100,7 @@ void EventLoop::QueueInLoop(Functor cb) {
     {
         std::lock_guard<std::mutex> lock(mutex_);
         pending_functors_.emplace_back(std::move(cb));
+        pending_functor_count_.store(pending_functors_.size(), std::memory_order_relaxed);
     }
     // 如果不在当前线程，或者当前线程正在执行 pending functors，都需要唤醒
     if (!IsInLoopThread() || calling_pending_functors_) {
@@ -108,14 +116,18 @@ void EventLoop::UpdateEvent(int fd, uint32_t events) {
         ev.events = events;
         ev.data.fd = fd;
         
-        auto it = registered_fds_.find(fd);
-        if (it == registered_fds_.end()) {
+        FdEntry& entry = fds_[fd];
+        if (!entry.registered) {
             // 新注册
             if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
                 LOG_ERROR("EventLoop::UpdateEvent epoll_ctl ADD failed for fd=%d", fd);
                 return;
             }
-            registered_fds_[fd] = events;
+            entry.registered = true;
+            entry.events = events;
+            if (fd != wakeup_fd_) {
+                registered_fd_count_.fetch_add(1, std::memory_order_relaxed);
+            }
             LOG_INFO("EventLoop::UpdateEvent: ADD fd=%d events=0x%x", fd, events);
         } else {
             // 修改
@@ -123,12 +135,12 @@ void EventLoop::UpdateEvent(int fd, uint32_t events) {
                 LOG_ERROR("EventLoop::UpdateEvent epoll_ctl MOD failed for fd=%d", fd);
                 return;
             }
-            registered_fds_[fd] = events;
+            entry.events = events;
             LOG_INFO("EventLoop::UpdateEvent: MOD fd=%d events=0x%x", fd, events);
         }
     } else {
         // 2. 如果不在 IO 线程，通过 RunInLoop 将操作转移（Dispatch）到 IO 线程执行
-        // 确保对 epoll_fd_ 和 registered_fds_ 的访问是单线程串行的
+        // 确保对 epoll_fd_ 和 fds_ 的访问是单线程串行的
         RunInLoop([this, fd, events]() {
             this->UpdateEvent(fd, events);
         });
@@ -136,15 +148,30 @@ void EventLoop::UpdateEvent(int fd, uint32_t events) {
 }
 
 void EventLoop::RemoveEvent(int fd) {
-    auto it = registered_fds_.find(fd);
-    if (it != registered_fds_.end()) {
+    auto it = fds_.find(fd);
+    if (it != fds_.end() && it->second.registered) {
         if (epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr) < 0) {
             LOG_ERROR("EventLoop::RemoveEvent epoll_ctl DEL failed for fd=%d", fd);
         }
-        registered_fds_.erase(it);
+        // 只撤销注册：可能正处于该 fd 的回调中，回调对象不能在此析构
+        it->second.registered = false;
+        it->second.events = 0;
+        if (fd != wakeup_fd_) {
+            registered_fd_count_.fetch_sub(1, std::memory_order_relaxed);
+        }
     }
 }
 
+EventLoop::Stats EventLoop::GetStats() const {
+    return {
+        registered_fd_count_.load(std::memory_order_relaxed),
+        connection_count_.load(std::memory_order_relaxed),
+        pending_functor_count_.load(std::memory_order_relaxed),
+        iteration_count_.load(std::memory_order_relaxed),
+        timer_wheel_.GetActiveTimerCount()
+    };
+}
+
 void EventLoop::Wakeup() {
     uint64_t one = 1;
     ssize_t n = write(wakeup_fd_, &one, sizeof(one));
@@ -168,12 +195,17 @@ void EventLoop::DoPendingFunctors() {
     {
         std::lock_guard<std::mutex> lock(mutex_);
         functors.swap(pending_functors_);
+        pending_functor_count_.store(0, std::memory_order_relaxed);
     }
 
     for (const auto& func : functors) {
         func();
     }
     calling_pending_functors_ = false;
+
+    if (!functors.empty()) {
+        tinywebserver::ServerMetrics::GetInstance().OnPendingFunctorBatch(functors.size());
+    }
 }
 
 int EventLoop::CreateEventFd() {
@@ -185,7 +217,23 @@ int EventLoop::CreateEventFd() {
 }
 
 void EventLoop::ProcessEvents(int timeout_ms) {
+    auto& metrics = tinywebserver::ServerMetrics::GetInstance();
+
+    // 上一轮的忙碌区间（事件分发 + pending functors + 定时器）到此结束
+    uint64_t wait_start = tinywebserver::ServerMetrics::NowNs();
+    uint64_t busy_since = busy_since_ns_.load(std::memory_order_relaxed);
+    if (busy_since != 0) {
+        metrics.OnLoopIteration(wait_start - busy_since);
+    }
+    heartbeat_ns_.store(wait_start, std::memory_order_relaxed);
+    // 阻塞在 epoll_wait 期间不算停顿
+    busy_since_ns_.store(0, std::memory_order_relaxed);
+
     int num_events = epoll_wait(epoll_fd_, events_, kMaxEvents, timeout_ms);
+
+    uint64_t wake_time = tinywebserver::ServerMetrics::NowNs();
+    busy_since_ns_.store(wake_time, std::memory_order_relaxed);
+    metrics.OnEpollWaitTime((wake_time - wait_start) / 1000);
     if (num_events < 0) {
         if (errno != EINTR) {
             LOG_ERROR("EventLoop::ProcessEvents epoll_wait error");
@@ -206,13 +254,15 @@ void EventLoop::ProcessEvents(int timeout_ms) {
     auto result = batch_io_handler_.ProcessBatch(
         events_vec,
         [this](int fd) {
-            if (read_callbacks_.count(fd)) {
-                read_callbacks_[fd](fd);
+            auto it = fds_.find(fd);
+            if (it != fds_.end() && it->second.read) {
+                it->second.read(fd);
             }
         },
         [this](int fd) {
-            if (write_callbacks_.count(fd)) {
-                write_callbacks_[fd](fd);
+            auto it = fds_.find(fd);
+            if (it != fds_.end() && it->second.write) {
+                it->second.write(fd);
             }
         },
         [this](int fd) {
@@ -236,15 +286,20 @@ void EventLoop::ProcessEvents(int timeout_ms) {
 }
 
 void EventLoop::HandleEvent(int fd, uint32_t events) {
-    LOG_INFO("EventLoop::HandleEvent: fd=%d, events=0x%x, read_callbacks_ has %lu entries",
-             fd, events, read_callbacks_.size());
-    // 根据事件类型调用相应的回调
-    if ((events & EPOLLIN) && read_callbacks_.count(fd)) {
+    LOG_INFO("EventLoop::HandleEvent: fd=%d, events=0x%x, fds_ has %lu entries",
+             fd, events, fds_.size());
+    // 根据事件类型调用相应的回调（表项引用在回调中插入新 fd 导致重哈希时仍然有效）
+    auto it = fds_.find(fd);
+    if (it == fds_.end()) {
+        return;
+    }
+    FdEntry& entry = it->second;
+    if ((events & EPOLLIN) && entry.read) {
         LOG_INFO("EventLoop::HandleEvent: calling read callback for fd=%d", fd);
-        read_callbacks_[fd](fd);
+        entry.read(fd);
     }
-    if ((events & EPOLLOUT) && write_callbacks_.count(fd)) {
-        write_callbacks_[fd](fd);
+    if ((events & EPOLLOUT) && entry.write) {
+        entry.write(fd);
     }
     // 注意：这里简化处理，实际应该处理EPOLLERR和EPOLLHUP
     if (events & (EPOLLERR | EPOLLHUP)) {
@@ -295,7 +350,7 @@ void EventLoop::ProcessTimers() {
         return;
     }
 
-    std::size_t triggered = timer_wheel_.Tick();
+    std::size_t triggered = timer_wheel_.Advance(std::chrono::steady_clock::now());
     if (triggered > 0) {
         LOG_DEBUG("EventLoop::ProcessTimers: triggered %zu timers", triggered);
     }
@@ -1,6 +1,7 @@
 //
 
 #include "reactor/event_loop_thread.h"
+#include "perf_counters.h"
 
 EventLoopThread::EventLoopThread()
     : loop_(nullptr),
@@ -43,6 +44,9 @@ void EventLoopThread::ThreadFunc() {
         cond_.notify_one();
     }
     
+    // 诊断模式：为本 IO 线程打开硬件计数组（未启用时为空操作）
+    tinywebserver::PerfCounters::OpenForCurrentThread();
+
     // 进入 epoll_wait 循环
     loop.Loop();
     
@@ -0,0 +1,176 @@
+// 事件循环停顿检测实现
+
+#include "reactor/loop_watchdog.h"
+#include "reactor/event_loop.h"
+#include "server_metrics.h"
+#include "Logger.h"
+
+#include <execinfo.h>
+#include <pthread.h>
+#include <signal.h>
+
+#include <chrono>
+#include <cerrno>
+#include <cstdlib>
+
+namespace {
+
+// 信号处理函数写入的调用栈（同一时刻只有看门狗线程发起抓取）
+void* g_stack_frames[LoopWatchdog::kMaxStackFrames];
+std::atomic<int> g_stack_depth{-1};
+
+void StackDumpSignalHandler(int /*signo*/) {
+    int saved_errno = errno;
+    int depth = ::backtrace(g_stack_frames, LoopWatchdog::kMaxStackFrames);
+    g_stack_depth.store(depth, std::memory_order_release);
+    errno = saved_errno;
+}
+
+void InstallStackDumpHandler() {
+    static std::once_flag once;
+    std::call_once(once, []() {
+        // 预热 backtrace：首次调用会加载 libgcc_s，不能发生在信号处理函数里
+        void* warmup[4];
+        ::backtrace(warmup, 4);
+
+        struct sigaction sa {};
+        sa.sa_handler = StackDumpSignalHandler;
+        sigemptyset(&sa.sa_mask);
+        sa.sa_flags = SA_RESTART;
+        if (::sigaction(LoopWatchdog::kStackDumpSignal, &sa, nullptr) < 0) {
+            LOG_ERROR("LoopWatchdog: sigaction failed, errno=%d", errno);
+        }
+    });
+}
+
+} // namespace
+
+LoopWatchdog::LoopWatchdog(int threshold_ms)
+    : threshold_ns_(static_cast<uint64_t>(threshold_ms) * 1000000ULL),
+      running_(false),
+      stall_count_(0) {
+}
+
+LoopWatchdog::~LoopWatchdog() {
+    Stop();
+}
+
+void LoopWatchdog::Watch(EventLoop* loop, const std::string& name) {
+    if (running_) {
+        LOG_WARN("LoopWatchdog: Watch(%s) ignored, watchdog already running", name.c_str());
+        return;
+    }
+    if (loop) {
+        loops_.push_back({loop, name, 0});
+    }
+}
+
+void LoopWatchdog::Start() {
+    if (running_ || threshold_ns_ == 0) {
+        return;
+    }
+    InstallStackDumpHandler();
+    running_ = true;
+    thread_ = std::thread([this]() { Run(); });
+    LOG_INFO("LoopWatchdog: watching %zu loops, threshold=%llu ms",
+             loops_.size(), static_cast<unsigned long long>(threshold_ns_ / 1000000ULL));
+}
+
+void LoopWatchdog::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+    }
+    cond_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void LoopWatchdog::Run() {
+    // 巡检周期取阈值的 1/4，停顿最迟在 1.25 倍阈值时被发现
+    auto interval = std::chrono::nanoseconds(threshold_ns_ / 4);
+    if (interval < std::chrono::milliseconds(5)) {
+        interval = std::chrono::milliseconds(5);
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_) {
+        cond_.wait_for(lock, interval, [this]() { return !running_; });
+        if (!running_) {
+            break;
+        }
+        lock.unlock();
+        CheckOnce(tinywebserver::ServerMetrics::NowNs());
+        lock.lock();
+    }
+}
+
+size_t LoopWatchdog::CheckOnce(uint64_t now_ns) {
+    size_t stalls = 0;
+    for (auto& watched : loops_) {
+        if (CheckLoop(watched, now_ns)) {
+            ++stalls;
+        }
+    }
+    return stalls;
+}
+
+bool LoopWatchdog::CheckLoop(WatchedLoop& watched, uint64_t now_ns) {
+    EventLoop* loop = watched.loop;
+    if (!loop->IsLooping()) {
+        return false;
+    }
+    uint64_t busy_since = loop->GetBusySinceNs();
+    if (busy_since == 0 || busy_since > now_ns || now_ns - busy_since < threshold_ns_) {
+        return false;
+    }
+    if (busy_since == watched.reported_busy_since) {
+        return false;  // 同一次停顿已报告
+    }
+    watched.reported_busy_since = busy_since;
+
+    stall_count_.fetch_add(1, std::memory_order_relaxed);
+    tinywebserver::ServerMetrics::GetInstance().OnLoopStall();
+
+    std::vector<std::string> stack = CaptureStack(loop);
+    LOG_WARN("LoopWatchdog: loop %s (tid=%d) stalled for %llu ms in one iteration, stack:",
+             watched.name.c_str(), loop->GetTid(),
+             static_cast<unsigned long long>((now_ns - busy_since) / 1000000ULL));
+    // 逐帧输出，避免单条日志超过 Logger 的消息缓冲区
+    for (size_t i = 0; i < stack.size(); ++i) {
+        LOG_WARN("  #%zu %s", i, stack[i].c_str());
+    }
+    return true;
+}
+
+std::vector<std::string> LoopWatchdog::CaptureStack(EventLoop* loop) {
+    g_stack_depth.store(-1, std::memory_order_release);
+    if (::pthread_kill(loop->GetPthreadHandle(), kStackDumpSignal) != 0) {
+        return {"<pthread_kill failed>"};
+    }
+
+    // 等待目标线程执行信号处理函数（最多 100ms）
+    int depth = -1;
+    for (int i = 0; i < 100; ++i) {
+        depth = g_stack_depth.load(std::memory_order_acquire);
+        if (depth >= 0) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if (depth < 0) {
+        return {"<stack capture timed out>"};
+    }
+
+    std::vector<std::string> frames;
+    char** symbols = ::backtrace_symbols(g_stack_frames, depth);
+    for (int i = 0; i < depth; ++i) {
+        frames.emplace_back(symbols ? symbols[i] : "?");
+    }
+    std::free(symbols);
+    return frames;
+}
@@ -0,0 +1,319 @@
+#include "access_trace.h"
+#include "server_metrics.h"
+#include "Logger.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <utility>
+
+namespace tinywebserver {
+
+std::atomic<bool> AccessTrace::enabled_{false};
+std::atomic<uint64_t> AccessTrace::next_connection_id_{1};
+
+namespace {
+
+constexpr char kMagic[8] = {'T', 'W', 'T', 'R', 'A', 'C', 'E', '1'};
+// 分片积累到这么多条记录时唤醒后台线程提前写盘
+constexpr size_t kBatchRecords = 512;
+// 记录最长暂存时间：进程被信号直接终止时最多丢失这段时间内的记录
+constexpr auto kFlushInterval = std::chrono::seconds(1);
+// 单条记录中路径的上限，防止损坏文件导致超大分配
+constexpr uint64_t kMaxPathLength = 64 * 1024;
+
+const char* const kMethodNames[] = {"OTHER", "GET", "HEAD", "POST", "PUT", "DELETE", "OPTIONS", "PATCH"};
+
+void PutVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+void PutUint64(std::string& out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+uint64_t ZigZag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t UnZigZag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+// 全局写入器与其轨迹起点（ServerMetrics::NowNs 时基）
+AccessTraceWriter g_writer;
+uint64_t g_start_ns = 0;
+
+// 线程按首次追加的顺序轮流分到各分片
+std::atomic<size_t> g_next_shard{0};
+
+size_t LocalShardIndex(size_t shard_count) {
+    static thread_local size_t index = g_next_shard.fetch_add(1, std::memory_order_relaxed);
+    return index % shard_count;
+}
+
+void EncodeRecord(std::string& out, const AccessTraceRecord& record, uint64_t& last_timestamp_ns) {
+    PutVarint(out, ZigZag(static_cast<int64_t>(record.timestamp_ns - last_timestamp_ns)));
+    last_timestamp_ns = record.timestamp_ns;
+    PutVarint(out, record.connection_id);
+    out.push_back(static_cast<char>(record.method));
+    PutVarint(out, record.path.size());
+    out.append(record.path);
+    PutVarint(out, record.response_bytes);
+    PutVarint(out, record.latency_ns);
+}
+
+} // namespace
+
+TraceMethod TraceMethodFromString(const std::string& method) {
+    for (size_t i = 1; i < sizeof(kMethodNames) / sizeof(kMethodNames[0]); ++i) {
+        if (method == kMethodNames[i]) {
+            return static_cast<TraceMethod>(i);
+        }
+    }
+    return TraceMethod::kOther;
+}
+
+const char* TraceMethodName(TraceMethod method) {
+    size_t index = static_cast<size_t>(method);
+    return index < sizeof(kMethodNames) / sizeof(kMethodNames[0]) ? kMethodNames[index] : kMethodNames[0];
+}
+
+// ============================================================================
+// AccessTraceWriter
+// ============================================================================
+
+AccessTraceWriter::~AccessTraceWriter() {
+    Close();
+}
+
+Error AccessTraceWriter::Open(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_) {
+        return Error(WebError::kStateError, "Access trace already open");
+    }
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) {
+        return Error::FromErrno(errno, "Failed to open access trace " + path);
+    }
+    for (Shard& shard : shards_) {
+        std::lock_guard<std::mutex> shard_lock(shard.mutex);
+        shard.records.clear();
+    }
+    buffer_.clear();
+    buffer_.append(kMagic, sizeof(kMagic));
+    auto unix_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    PutUint64(buffer_, static_cast<uint64_t>(unix_ns));
+    last_timestamp_ns_ = 0;
+    records_.store(0, std::memory_order_relaxed);
+    DrainLocked();
+    stopping_ = false;
+    open_.store(true, std::memory_order_release);
+    flusher_ = std::thread(&AccessTraceWriter::FlusherLoop, this);
+    return Error::Success();
+}
+
+void AccessTraceWriter::Append(AccessTraceRecord record) {
+    if (!open_.load(std::memory_order_acquire)) {
+        return;
+    }
+    Shard& shard = shards_[LocalShardIndex(kShardCount)];
+    size_t pending;
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.records.push_back(std::move(record));
+        pending = shard.records.size();
+    }
+    records_.fetch_add(1, std::memory_order_relaxed);
+    if (pending == kBatchRecords) {
+        cond_.notify_one();   // 错过的唤醒最多推迟到下一个 kFlushInterval
+    }
+}
+
+void AccessTraceWriter::Flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    DrainLocked();
+}
+
+void AccessTraceWriter::FlusherLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        cond_.wait_for(lock, kFlushInterval);
+        DrainLocked();
+    }
+}
+
+void AccessTraceWriter::DrainLocked() {
+    if (!file_) {
+        return;
+    }
+    // 与分片交换整个 vector，分片拿回的是上一轮清空但保留容量的 batch
+    std::vector<AccessTraceRecord> batch;
+    for (Shard& shard : shards_) {
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            batch.swap(shard.records);
+        }
+        for (const AccessTraceRecord& record : batch) {
+            EncodeRecord(buffer_, record, last_timestamp_ns_);
+        }
+        batch.clear();
+    }
+    if (buffer_.empty()) {
+        return;
+    }
+    if (std::fwrite(buffer_.data(), 1, buffer_.size(), file_) != buffer_.size()) {
+        LOG_ERROR("AccessTrace: write failed: %s", strerror(errno));
+    }
+    std::fflush(file_);
+    buffer_.clear();
+}
+
+void AccessTraceWriter::Close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        open_.store(false, std::memory_order_release);
+        stopping_ = true;
+    }
+    cond_.notify_all();
+    if (flusher_.joinable()) {
+        flusher_.join();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    DrainLocked();
+    if (file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+}
+
+// ============================================================================
+// AccessTraceReader
+// ============================================================================
+
+AccessTraceReader::~AccessTraceReader() {
+    if (file_) {
+        std::fclose(file_);
+    }
+}
+
+Error AccessTraceReader::Open(const std::string& path) {
+    file_ = std::fopen(path.c_str(), "rb");
+    if (!file_) {
+        return Error::FromErrno(errno, "Failed to open access trace " + path);
+    }
+    unsigned char header[16];
+    if (std::fread(header, 1, sizeof(header), file_) != sizeof(header) ||
+        std::memcmp(header, kMagic, sizeof(kMagic)) != 0) {
+        return Error(WebError::kParseError, "Not an access trace file: " + path);
+    }
+    start_unix_ns_ = 0;
+    for (int i = 0; i < 8; ++i) {
+        start_unix_ns_ |= static_cast<uint64_t>(header[8 + i]) << (8 * i);
+    }
+    last_timestamp_ns_ = 0;
+    error_ = Error::Success();
+    return Error::Success();
+}
+
+bool AccessTraceReader::ReadVarint(uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int c = std::fgetc(file_);
+        if (c == EOF) {
+            return false;
+        }
+        value |= static_cast<uint64_t>(c & 0x7f) << shift;
+        if ((c & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool AccessTraceReader::Next(AccessTraceRecord& record) {
+    if (!file_ || error_.IsFailure()) {
+        return false;
+    }
+    uint64_t delta;
+    if (!ReadVarint(delta)) {
+        if (!std::feof(file_)) {
+            error_ = Error(WebError::kParseError, "Corrupted access trace record");
+        }
+        return false;   // 正常结束
+    }
+    uint64_t path_len = 0;
+    int method = EOF;
+    bool ok = ReadVarint(record.connection_id) && (method = std::fgetc(file_)) != EOF &&
+              ReadVarint(path_len) && path_len <= kMaxPathLength;
+    if (ok) {
+        record.path.resize(path_len);
+        ok = std::fread(&record.path[0], 1, path_len, file_) == path_len &&
+             ReadVarint(record.response_bytes) && ReadVarint(record.latency_ns);
+    }
+    if (!ok) {
+        error_ = Error(WebError::kParseError, "Truncated access trace record");
+        return false;
+    }
+    last_timestamp_ns_ = static_cast<uint64_t>(static_cast<int64_t>(last_timestamp_ns_) + UnZigZag(delta));
+    record.timestamp_ns = last_timestamp_ns_;
+    record.method = static_cast<TraceMethod>(method);
+    return true;
+}
+
+Error AccessTraceReader::ReadAll(const std::string& path, std::vector<AccessTraceRecord>& records) {
+    AccessTraceReader reader;
+    Error err = reader.Open(path);
+    if (err.IsFailure()) {
+        return err;
+    }
+    AccessTraceRecord record;
+    while (reader.Next(record)) {
+        records.push_back(record);
+    }
+    return reader.GetError();
+}
+
+// ============================================================================
+// AccessTrace
+// ============================================================================
+
+Error AccessTrace::Start(const std::string& path) {
+    Error err = g_writer.Open(path);
+    if (err.IsFailure()) {
+        return err;
+    }
+    g_start_ns = ServerMetrics::NowNs();
+    enabled_.store(true, std::memory_order_release);
+    LOG_INFO("AccessTrace: recording to %s", path.c_str());
+    return Error::Success();
+}
+
+void AccessTrace::Stop() {
+    if (!enabled_.exchange(false)) {
+        return;
+    }
+    g_writer.Close();
+    LOG_INFO("AccessTrace: stopped, %llu records", static_cast<unsigned long long>(g_writer.RecordCount()));
+}
+
+void AccessTrace::Record(uint64_t start_ns, uint64_t connection_id, TraceMethod method,
+                         const std::string& path, uint64_t response_bytes, uint64_t latency_ns) {
+    AccessTraceRecord record;
+    record.timestamp_ns = start_ns > g_start_ns ? start_ns - g_start_ns : 0;
+    record.connection_id = connection_id;
+    record.method = method;
+    record.path = path;
+    record.response_bytes = response_bytes;
+    record.latency_ns = latency_ns;
+    g_writer.Append(std::move(record));
+}
+
+} // namespace tinywebserver
@@ -0,0 +1,224 @@
+#include "admin/admin_server.h"
+
+#include "reactor/event_loop.h"
+#include "reactor/event_loop_thread.h"
+#include "reactor/socket_utils.h"
+#include "Logger.h"
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include <cerrno>
+#include <sstream>
+
+namespace tinywebserver {
+
+AdminServer::AdminServer(int port, int backlog)
+    : port_(port),
+      backlog_(backlog),
+      listen_fd_(-1),
+      loop_thread_(nullptr),
+      loop_(nullptr) {
+}
+
+AdminServer::~AdminServer() {
+    Stop();
+}
+
+void AdminServer::RegisterHandler(const std::string& path, const std::string& content_type, Handler handler) {
+    if (loop_ != nullptr) {
+        LOG_WARN("AdminServer: RegisterHandler(%s) ignored, server already started", path.c_str());
+        return;
+    }
+    routes_[path] = Route{content_type, std::move(handler)};
+}
+
+Error AdminServer::Start() {
+    if (loop_ != nullptr) {
+        return Error::Success();
+    }
+
+    listen_fd_ = CreateListenSocket(static_cast<unsigned short>(port_), backlog_);
+    if (listen_fd_ < 0) {
+        return Error(WebError::kSocketError, "Failed to listen on admin port " + std::to_string(port_));
+    }
+
+    loop_thread_ = std::make_unique<EventLoopThread>();
+    loop_ = loop_thread_->StartLoop();
+
+    int listen_fd = listen_fd_;
+    loop_->RunInLoop([this, listen_fd]() {
+        loop_->SetReadCallback(listen_fd, [this](int) { HandleAccept(); });
+        loop_->UpdateEvent(listen_fd, EPOLLIN | EPOLLET);
+    });
+
+    LOG_INFO("AdminServer: listening on port %d (%zu routes)", port_, routes_.size());
+    return Error::Success();
+}
+
+void AdminServer::Stop() {
+    if (loop_thread_) {
+        loop_thread_->Stop();
+        loop_thread_->Join();
+        loop_thread_.reset();
+        loop_ = nullptr;
+    }
+
+    // 管理线程已退出，此处可安全清理
+    for (auto& entry : connections_) {
+        ::close(entry.first);
+    }
+    connections_.clear();
+
+    if (listen_fd_ >= 0) {
+        ::close(listen_fd_);
+        listen_fd_ = -1;
+    }
+}
+
+void AdminServer::HandleAccept() {
+    while (true) {
+        int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                LOG_ERROR("AdminServer: accept error, errno=%d", errno);
+            }
+            break;
+        }
+
+        connections_[fd] = AdminConnection{};
+        loop_->SetReadCallback(fd, [this](int conn_fd) { HandleRead(conn_fd); });
+        loop_->SetWriteCallback(fd, [this](int conn_fd) { HandleWrite(conn_fd); });
+        loop_->UpdateEvent(fd, EPOLLIN | EPOLLET);
+    }
+}
+
+void AdminServer::HandleRead(int fd) {
+    auto it = connections_.find(fd);
+    if (it == connections_.end()) {
+        return;
+    }
+    AdminConnection& conn = it->second;
+    if (!conn.output.empty()) {
+        return;  // 响应已生成，忽略后续输入
+    }
+
+    char buf[1024];
+    while (true) {
+        ssize_t n = ::read(fd, buf, sizeof(buf));
+        if (n > 0) {
+            conn.input.append(buf, static_cast<size_t>(n));
+            if (conn.input.size() > kMaxRequestSize) {
+                conn.output = MakeHttpResponse(431, "Request Header Fields Too Large", "text/plain", "request too large\n");
+                HandleWrite(fd);
+                return;
+            }
+        } else if (n == 0) {
+            CloseConnection(fd);
+            return;
+        } else {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            CloseConnection(fd);
+            return;
+        }
+    }
+
+    if (conn.input.find("\r\n\r\n") != std::string::npos) {
+        conn.output = BuildResponse(conn.input);
+        HandleWrite(fd);
+    }
+}
+
+void AdminServer::HandleWrite(int fd) {
+    auto it = connections_.find(fd);
+    if (it == connections_.end()) {
+        return;
+    }
+    AdminConnection& conn = it->second;
+
+    while (conn.output_offset < conn.output.size()) {
+        ssize_t n = ::write(fd, conn.output.data() + conn.output_offset,
+                            conn.output.size() - conn.output_offset);
+        if (n > 0) {
+            conn.output_offset += static_cast<size_t>(n);
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            loop_->UpdateEvent(fd, EPOLLIN | EPOLLOUT | EPOLLET);
+            return;
+        } else {
+            break;
+        }
+    }
+    CloseConnection(fd);
+}
+
+void AdminServer::CloseConnection(int fd) {
+    if (connections_.erase(fd) == 0) {
+        return;
+    }
+    loop_->RemoveEvent(fd);
+    ::close(fd);
+}
+
+std::string AdminServer::BuildResponse(const std::string& request) const {
+    // 请求行: METHOD SP PATH SP VERSION
+    size_t line_end = request.find("\r\n");
+    std::istringstream line(request.substr(0, line_end));
+    std::string method, target, version;
+    line >> method >> target >> version;
+
+    if (method.empty() || target.empty() || version.compare(0, 5, "HTTP/") != 0) {
+        return MakeHttpResponse(400, "Bad Request", "text/plain", "bad request\n");
+    }
+    if (method != "GET" && method != "HEAD") {
+        return MakeHttpResponse(405, "Method Not Allowed", "text/plain", "method not allowed\n");
+    }
+
+    std::string path = target.substr(0, target.find('?'));
+    auto route = routes_.find(path);
+    if (route == routes_.end()) {
+        std::string body = "not found\navailable:\n";
+        for (const auto& entry : routes_) {
+            body += "  " + entry.first + "\n";
+        }
+        return MakeHttpResponse(404, "Not Found", "text/plain", body);
+    }
+
+    std::string body;
+    try {
+        body = route->second.handler();
+    } catch (const std::exception& e) {
+        LOG_ERROR("AdminServer: handler for %s failed: %s", path.c_str(), e.what());
+        return MakeHttpResponse(500, "Internal Server Error", "text/plain", "internal error\n");
+    }
+
+    std::string response = MakeHttpResponse(200, "OK", route->second.content_type, body);
+    if (method == "HEAD") {
+        response.resize(response.size() - body.size());
+    }
+    return response;
+}
+
+std::string AdminServer::MakeHttpResponse(int code, const std::string& reason,
+                                          const std::string& content_type, const std::string& body) {
+    std::string response;
+    response.reserve(body.size() + 128);
+    response += "HTTP/1.1 " + std::to_string(code) + " " + reason + "\r\n";
+    response += "Content-Type: " + content_type + "\r\n";
+    response += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+    response += "Cache-Control: no-cache\r\n";
+    response += "Connection: close\r\n\r\n";
+    response += body;
+    return response;
+}
+
+} // namespace tinywebserver
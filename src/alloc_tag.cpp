@@ -0,0 +1,34 @@
+#include "alloc_tag.h"
+
+#include <cstddef>
+
+namespace tinywebserver {
+
+namespace {
+
+// 常量初始化，替换的 operator new 在线程启动早期读取也安全
+thread_local AllocTag t_alloc_tag = AllocTag::kOther;
+
+const char* const kTagNames[] = {"other", "connection", "http_request", "input_buffer",
+                                 "output_buffer", "event_loop", "timer", "keep_alive"};
+
+} // namespace
+
+const char* AllocTagName(AllocTag tag) {
+    size_t index = static_cast<size_t>(tag);
+    return index < sizeof(kTagNames) / sizeof(kTagNames[0]) ? kTagNames[index] : kTagNames[0];
+}
+
+AllocTag CurrentAllocTag() {
+    return t_alloc_tag;
+}
+
+AllocTagScope::AllocTagScope(AllocTag tag) : previous_(t_alloc_tag) {
+    t_alloc_tag = tag;
+}
+
+AllocTagScope::~AllocTagScope() {
+    t_alloc_tag = previous_;
+}
+
+} // namespace tinywebserver
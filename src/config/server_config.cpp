@@ -1,4 +1,5 @@
 #include "config/server_config.h"
+#include "static_resource_manager.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -197,6 +198,12 @@ std::vector<std::string> ServerConfig::Validate() const {
     if (limits_.max_output_buffer > 500 * 1024 * 1024) {
         errors.push_back("Max output buffer cannot exceed 500MB");
     }
+    if (limits_.max_upload_size == 0) {
+        errors.push_back("Max upload size must be positive");
+    }
+    if (limits_.output_high_watermark < 1024 || limits_.output_high_watermark > limits_.max_output_buffer) {
+        errors.push_back("Output high watermark must be between 1KB and max output buffer");
+    }
 
     // logging 配置验证
     if (logging_.queue_size < 1) {
@@ -224,6 +231,22 @@ std::vector<std::string> ServerConfig::Validate() const {
     if (static_.cache_ttl > 86400) { // 24 hours
         errors.push_back("Static cache TTL cannot exceed 86400 seconds (24 hours)");
     }
+    CachePolicy cache_policy;
+    if (!ParseCachePolicy(static_.cache_policy, cache_policy)) {
+        errors.push_back("Static cache policy must be one of: lru, wtinylfu, wtinylfu_size");
+    }
+    if (static_.loader_threads > 64) {
+        errors.push_back("Static loader threads cannot exceed 64");
+    }
+    if (static_.warmup_budget_ms < 0 || static_.warmup_budget_ms > 600000) {
+        errors.push_back("Static warm-up budget must be between 0 and 600000 ms");
+    }
+    if (static_.warmup_threads < 1 || static_.warmup_threads > 64) {
+        errors.push_back("Static warm-up threads must be between 1 and 64");
+    }
+    if (static_.hot_list_save_interval < 1) {
+        errors.push_back("Static hot list save interval must be at least 1 second");
+    }
 
     // metrics 配置验证
     if (metrics_.prometheus_port < 1 || metrics_.prometheus_port > 65535) {
@@ -236,6 +259,9 @@ std::vector<std::string> ServerConfig::Validate() const {
     if (metrics_.collect_interval > 3600) {
         errors.push_back("Metrics collect interval cannot exceed 3600 seconds");
     }
+    if (metrics_.stall_threshold_ms < 0 || metrics_.stall_threshold_ms > 60000) {
+        errors.push_back("Event loop stall threshold must be between 0 and 60000 ms");
+    }
 
     // 交叉验证
     if (metrics_.prometheus_port == server_.port) {
@@ -259,6 +285,7 @@ std::string ServerConfig::ToJsonString() const {
         server_json["tcp_cork"] = server_.tcp_cork;
         server_json["use_so_reuseport"] = server_.use_so_reuseport;
         server_json["so_reuseport_sockets"] = server_.so_reuseport_sockets;
+        server_json["enable_h2c"] = server_.enable_h2c;
         j["server"] = server_json;
 
         // limits
@@ -270,6 +297,8 @@ std::string ServerConfig::ToJsonString() const {
         limits_json["keep_alive_timeout"] = limits_.keep_alive_timeout;
         limits_json["max_input_buffer"] = limits_.max_input_buffer;
         limits_json["max_output_buffer"] = limits_.max_output_buffer;
+        limits_json["max_upload_size"] = limits_.max_upload_size;
+        limits_json["output_high_watermark"] = limits_.output_high_watermark;
         j["limits"] = limits_json;
 
         // logging
@@ -286,6 +315,14 @@ std::string ServerConfig::ToJsonString() const {
         static_json["root"] = static_.root;
         static_json["cache_size"] = static_.cache_size;
         static_json["cache_ttl"] = static_.cache_ttl;
+        static_json["cache_policy"] = static_.cache_policy;
+        static_json["loader_threads"] = static_.loader_threads;
+        static_json["warmup"] = static_.warmup;
+        static_json["warmup_budget_ms"] = static_.warmup_budget_ms;
+        static_json["warmup_threads"] = static_.warmup_threads;
+        static_json["hot_list_path"] = static_.hot_list_path;
+        static_json["hot_list_save_interval"] = static_.hot_list_save_interval;
+        static_json["upload_dir"] = static_.upload_dir;
         j["static"] = static_json;
 
         // metrics
@@ -293,6 +330,9 @@ std::string ServerConfig::ToJsonString() const {
         metrics_json["enable_prometheus"] = metrics_.enable_prometheus;
         metrics_json["prometheus_port"] = metrics_.prometheus_port;
         metrics_json["collect_interval"] = metrics_.collect_interval;
+        metrics_json["stall_threshold_ms"] = metrics_.stall_threshold_ms;
+        metrics_json["enable_perf_counters"] = metrics_.enable_perf_counters;
+        metrics_json["access_trace_path"] = metrics_.access_trace_path;
         j["metrics"] = metrics_json;
 
         return j.dump(2); // 缩进2个空格，便于阅读
@@ -331,6 +371,9 @@ bool ServerConfig::LoadFromJsonObject(const nlohmann::json& j) {
             if (server.contains("so_reuseport_sockets") && server["so_reuseport_sockets"].is_number_integer()) {
                 server_.so_reuseport_sockets = server["so_reuseport_sockets"];
             }
+            if (server.contains("enable_h2c") && server["enable_h2c"].is_boolean()) {
+                server_.enable_h2c = server["enable_h2c"];
+            }
         }
 
         // 解析 limits 部分
@@ -357,6 +400,12 @@ bool ServerConfig::LoadFromJsonObject(const nlohmann::json& j) {
             if (limits.contains("max_output_buffer") && limits["max_output_buffer"].is_number_integer()) {
                 limits_.max_output_buffer = limits["max_output_buffer"];
             }
+            if (limits.contains("max_upload_size") && limits["max_upload_size"].is_number_unsigned()) {
+                limits_.max_upload_size = limits["max_upload_size"];
+            }
+            if (limits.contains("output_high_watermark") && limits["output_high_watermark"].is_number_integer()) {
+                limits_.output_high_watermark = limits["output_high_watermark"];
+            }
         }
 
         // 解析 logging 部分
@@ -391,6 +440,30 @@ bool ServerConfig::LoadFromJsonObject(const nlohmann::json& j) {
             if (static_.contains("cache_ttl") && static_["cache_ttl"].is_number_integer()) {
                 this->static_.cache_ttl = static_["cache_ttl"];
             }
+            if (static_.contains("cache_policy") && static_["cache_policy"].is_string()) {
+                this->static_.cache_policy = static_["cache_policy"];
+            }
+            if (static_.contains("loader_threads") && static_["loader_threads"].is_number_unsigned()) {
+                this->static_.loader_threads = static_["loader_threads"];
+            }
+            if (static_.contains("warmup") && static_["warmup"].is_boolean()) {
+                this->static_.warmup = static_["warmup"];
+            }
+            if (static_.contains("warmup_budget_ms") && static_["warmup_budget_ms"].is_number_integer()) {
+                this->static_.warmup_budget_ms = static_["warmup_budget_ms"];
+            }
+            if (static_.contains("warmup_threads") && static_["warmup_threads"].is_number_unsigned()) {
+                this->static_.warmup_threads = static_["warmup_threads"];
+            }
+            if (static_.contains("hot_list_path") && static_["hot_list_path"].is_string()) {
+                this->static_.hot_list_path = static_["hot_list_path"];
+            }
+            if (static_.contains("hot_list_save_interval") && static_["hot_list_save_interval"].is_number_integer()) {
+                this->static_.hot_list_save_interval = static_["hot_list_save_interval"];
+            }
+            if (static_.contains("upload_dir") && static_["upload_dir"].is_string()) {
+                this->static_.upload_dir = static_["upload_dir"];
+            }
         }
 
         // 解析 metrics 部分
@@ -405,6 +478,15 @@ bool ServerConfig::LoadFromJsonObject(const nlohmann::json& j) {
             if (metrics.contains("collect_interval") && metrics["collect_interval"].is_number_integer()) {
                 metrics_.collect_interval = metrics["collect_interval"];
             }
+            if (metrics.contains("stall_threshold_ms") && metrics["stall_threshold_ms"].is_number_integer()) {
+                metrics_.stall_threshold_ms = metrics["stall_threshold_ms"];
+            }
+            if (metrics.contains("enable_perf_counters") && metrics["enable_perf_counters"].is_boolean()) {
+                metrics_.enable_perf_counters = metrics["enable_perf_counters"];
+            }
+            if (metrics.contains("access_trace_path") && metrics["access_trace_path"].is_string()) {
+                metrics_.access_trace_path = metrics["access_trace_path"];
+            }
         }
 
         // 注意：metrics 部分暂不解析，由单独的指标系统处理
@@ -1,17 +1,67 @@
 //
 
 #include "connection.h"
+#include "alloc_tag.h"
+#include "connection_buffer_pool.h"
 #include "http_request.h"
 #include "server_metrics.h"
+#include "perf_counters.h"
 #include "reactor/event_loop.h"
 #include "Logger.h"
 #include "http/keep_alive_manager.h"
+#include "http2/h2_connection.h"
+#include "http2/h2_stream.h"
+#include "http/request_body.h"
 
 using namespace tinywebserver;
 
 #include <unistd.h>
 #include <sys/socket.h>
 #include <sys/uio.h> // writev
+#include <algorithm>
+#include <cctype>
+
+namespace {
+
+// HTTP/2 客户端连接前言（RFC 7540 Section 3.5）
+constexpr char kH2Preface[] = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+constexpr size_t kH2PrefaceLen = sizeof(kH2Preface) - 1;
+
+constexpr char kSwitchingProtocols[] =
+    "HTTP/1.1 101 Switching Protocols\r\n"
+    "Connection: Upgrade\r\n"
+    "Upgrade: h2c\r\n\r\n";
+
+// 逗号分隔的头部值中是否包含指定 token（大小写不敏感，token 须为小写）
+bool HasHeaderToken(const std::string& value, const std::string& token) {
+    std::string lower(value);
+    std::transform(lower.begin(), lower.end(), lower.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    size_t start = 0;
+    while (start <= lower.size()) {
+        size_t end = lower.find(',', start);
+        if (end == std::string::npos) {
+            end = lower.size();
+        }
+        std::string item = lower.substr(start, end - start);
+        item.erase(0, item.find_first_not_of(" \t"));
+        item.erase(item.find_last_not_of(" \t") + 1);
+        if (item == token) {
+            return true;
+        }
+        start = end + 1;
+    }
+    return false;
+}
+
+// 升级为 HTTP/2 时不转发到流 1 的 HTTP/1.1 逐跳头部（RFC 7540 Section 8.1.2.2）
+bool IsHopByHopHeader(const std::string& name) {
+    return name == "connection" || name == "upgrade" || name == "http2-settings" ||
+           name == "keep-alive" || name == "proxy-connection" || name == "transfer-encoding" ||
+           name == "te";
+}
+
+} // namespace
 
 
 Connection::Connection(int fd, EventLoop* loop,
@@ -26,9 +76,7 @@ Connection::Connection(int fd, EventLoop* loop,
       read_timeout_active_(false),
       write_timeout_active_(false),
       idle_timeout_active_(false),
-      last_activity_time_(std::chrono::steady_clock::now()),
-      http_parser_(new HttpRequest()) {
-
+      last_activity_time_(std::chrono::steady_clock::now()) {
     // 从配置设置超时和限制
     if (config_) {
         auto limits = config_->GetLimitsOptions();
@@ -49,8 +97,11 @@ void Connection::ConnectEstablished() {
     }
     
     Transition(ConnState::kConnected, "connection established");
+    ServerMetrics::GetInstance().OnNewConnection();
+    loop_->OnConnectionEstablished();
     std::weak_ptr<Connection> weak_self(shared_from_this());
-    
+    AllocTagScope tag(AllocTag::kEventLoop);
+
     loop_->SetReadCallback(fd_, [weak_self](int fd){
         if (auto self = weak_self.lock()) self->HandleRead(fd);
     });
@@ -106,7 +157,12 @@ void Connection::SendInLoop(const std::string& data) {
         HandleClose(fd_, tinywebserver::Error(tinywebserver::WebError::kTimeout, "connection timeout"));
         return;
     }
-    output_buffer_.Append(data);
+    {
+        AllocTagScope tag(AllocTag::kOutputBuffer);
+        AcquireOutputStorage();
+        output_buffer_.Append(data);
+    }
+    bytes_queued_ += data.size();
     // 尝试直接触发一次写操作，尽快将数据发出去
     // 只有当之前没有注册 EPOLLOUT 时才尝试直接写，避免乱序
     // 这里简化逻辑：直接调用 HandleWrite，它会处理好 writev 和事件注册
@@ -115,49 +171,509 @@ void Connection::SendInLoop(const std::string& data) {
 
 void Connection::SendResourceInLoop(std::shared_ptr<StaticResource> res) {
     if (!res || res->size == 0) return;
-    // 输出缓冲区边界检查（包含待添加资源大小）
-    size_t new_size = output_buffer_.TotalBytes() + res->size;
+    // 输出缓冲区边界检查：mmap 资源引用页缓存、不占堆内存，不计入本次新增，
+    // 只在已积压的数据超限时（客户端不读）拒绝，否则大于上限的文件永远发不出去
     size_t max_limit = ConnectionLimits::kMaxOutputBuffer;
     if (config_) {
         auto limits = config_->GetLimitsOptions();
         max_limit = limits.max_output_buffer;
     }
-    if (new_size > max_limit) {
+    if (output_buffer_.TotalBytes() > max_limit) {
         LOG_ERROR("Output buffer limit exceeded (current=%zu + resource=%zu > limit=%zu), closing connection fd=%d",
                   output_buffer_.TotalBytes(), res->size,
                   max_limit, fd_);
         HandleClose(fd_, tinywebserver::Error(tinywebserver::WebError::kTimeout, "connection timeout"));
         return;
     }
-    output_buffer_.Append(res);
+    {
+        AllocTagScope tag(AllocTag::kOutputBuffer);
+        AcquireOutputStorage();
+        output_buffer_.Append(res);
+    }
+    bytes_queued_ += res->size;
     HandleWrite(fd_);
 }
 
+void Connection::SendChainInLoop(BufferChain& chain) {
+    if (chain.IsEmpty()) return;
+    // 输出缓冲区边界检查（包含待添加节点）
+    size_t bytes = chain.TotalBytes();
+    size_t new_size = output_buffer_.TotalBytes() + bytes;
+    size_t max_limit = ConnectionLimits::kMaxOutputBuffer;
+    if (config_) {
+        auto limits = config_->GetLimitsOptions();
+        max_limit = limits.max_output_buffer;
+    }
+    if (new_size > max_limit) {
+        LOG_ERROR("Output buffer limit exceeded (current=%zu + chain=%zu > limit=%zu), closing connection fd=%d",
+                  output_buffer_.TotalBytes(), bytes,
+                  max_limit, fd_);
+        HandleClose(fd_, tinywebserver::Error(tinywebserver::WebError::kTimeout, "connection timeout"));
+        return;
+    }
+    {
+        AllocTagScope tag(AllocTag::kOutputBuffer);
+        AcquireOutputStorage();
+        output_buffer_.Splice(chain);
+    }
+    bytes_queued_ += bytes;
+    if (!h2_refilling_) {
+        HandleWrite(fd_);
+    }
+}
+
+void Connection::SendChain(BufferChain& chain) {
+    if (!IsConnected()) return;
+    SendChainInLoop(chain);
+}
+
 void Connection::HandleRead(int fd) {
     char buf[4096];
+    // 每次就绪事件取一次时间戳：缓冲区为空时读入的首字节即新请求的起点
+    last_read_ns_ = ServerMetrics::NowNs();
     while (true) {
-        ssize_t n = ::read(fd, buf, sizeof(buf));
+        // 请求体直接从 socket 接收，不进入下面的缓冲读取
+        if (body_ && !ReadRequestBody(fd)) {
+            ReleaseIdleBuffers();
+            return;
+        }
+        bool was_empty = input_buffer_.empty();
+        bool drained = true;
+        size_t limit = InputBufferLimit();
+        {
+            PerfPhaseScope perf_scope(PerfPhase::kRead);
+            AllocTagScope tag(AllocTag::kInputBuffer);
+            if (was_empty) {
+                loop_->GetBufferPool().AcquireString(input_buffer_);
+            }
+            while (true) {
+                ssize_t n = ::read(fd, buf, sizeof(buf));
+                if (n > 0) {
+                    input_buffer_.append(buf, n);
+                    ServerMetrics::GetInstance().OnBytesReceived(static_cast<size_t>(n));
+                    UpdateActivityTimestamp();  // 更新活动时间戳
+                    // 超过上限先处理已读部分（可能是请求体的开头），其余留在内核缓冲区
+                    if (!h2_ && input_buffer_.size() > limit) {
+                        drained = false;
+                        break;
+                    }
+                } else if (n == 0) {
+                    HandleClose(fd, tinywebserver::Error::Success());
+                    break;
+                } else {
+                    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                        break;
+                    }
+                    LOG_ERROR("HandleRead error on fd=%d, err=%d", fd, errno);
+                    HandleError(fd);
+                    break;
+                }
+            }
+        }
+        if (was_empty && !input_buffer_.empty()) {
+            request_start_ns_ = last_read_ns_;
+        }
+        if (input_buffer_.empty()) {
+            ReleaseIdleBuffers();
+            return;
+        }
+        // HTTP/2：输入每次全部交给 H2Connection，由流控制窗口限制积压，无需背压检查
+        if (h2_ || (h2_request_callback_ && TryStartHttp2())) {
+            ProcessHttp2Input();
+            if (drained) {
+                return;
+            }
+            continue;
+        }
+        // 等待静态资源加载期间只积累输入，加载完成后按序处理
+        DispatchInput();
+        if (body_ && IsConnected()) {
+            continue;   // 回调开始接收请求体：继续从 socket 读取
+        }
+        // 背压检查：处理后输入缓冲区仍超过限制，暂停读取
+        if (CheckInputBufferLimit()) {
+            PauseReading();
+            break;
+        }
+        if (drained || !IsConnected()) {
+            break;
+        }
+    }
+    ReleaseIdleBuffers();
+}
+
+void Connection::DispatchInput() {
+    while (message_callback_ && !load_pending_ && !response_streaming_ && !input_buffer_.empty()) {
+        if (body_) {
+            ProcessRequestBody();
+            if (body_) {
+                return;   // 请求体未收完，等待后续输入
+            }
+            continue;
+        }
+        {
+            AllocTagScope tag(AllocTag::kHttpRequest);
+            message_callback_(shared_from_this(), input_buffer_);
+        }
+        if (!body_) {
+            break;
+        }
+    }
+    // 因背压暂停读取后，处理完积压的输入即恢复
+    if (reading_paused_ && !load_pending_ && !response_streaming_ && input_buffer_.size() <= InputBufferLimit() &&
+        IsConnected()) {
+        ResumeReading();
+    }
+}
+
+struct Connection::RequestBodyState {
+    std::unique_ptr<tinywebserver::BodyDecoder> decoder;
+    std::unique_ptr<tinywebserver::BodySink> sink;
+    BodyCompleteCallback on_complete;
+};
+
+void Connection::StartRequestBody(std::unique_ptr<tinywebserver::BodyDecoder> decoder,
+                                  std::unique_ptr<tinywebserver::BodySink> sink,
+                                  BodyCompleteCallback on_complete) {
+    body_ = std::make_unique<RequestBodyState>();
+    body_->decoder = std::move(decoder);
+    body_->sink = std::move(sink);
+    body_->on_complete = std::move(on_complete);
+}
+
+void Connection::ProcessRequestBody() {
+    auto* sink = body_->sink.get();
+    size_t consumed = 0;
+    tinywebserver::Error err = body_->decoder->Feed(
+        input_buffer_.data(), input_buffer_.size(),
+        [sink](const char* data, size_t len) { return sink->Write(data, len); }, consumed);
+    input_buffer_.erase(0, consumed);
+    if (err.IsFailure()) {
+        // 帧已错乱，后续字节无法再按请求切分
+        input_buffer_.clear();
+        FinishRequestBody(err);
+    } else if (body_->decoder->IsDone()) {
+        FinishRequestBody(tinywebserver::Error::Success());
+    }
+}
+
+bool Connection::ReadRequestBody(int fd) {
+    // 分块头、CRLF 等帧字节每次只读一小段，尽量让载荷走 splice
+    constexpr size_t kFramingRead = 64;
+    char buf[4096];
+    while (body_) {
+        if (!input_buffer_.empty()) {
+            ProcessRequestBody();
+            continue;
+        }
+        auto& decoder = *body_->decoder;
+        auto& sink = *body_->sink;
+        uint64_t raw = decoder.RawRemaining();
+        if (raw > 0 && sink.SupportsSplice()) {
+            size_t moved = 0;
+            bool eof = false;
+            tinywebserver::Error err = sink.SpliceFrom(fd, static_cast<size_t>(std::min<uint64_t>(raw, SIZE_MAX)),
+                                                       moved, eof);
+            if (err.IsFailure()) {
+                FinishRequestBody(err);
+                return false;
+            }
+            if (eof) {
+                HandleClose(fd, tinywebserver::Error::Success());
+                return false;
+            }
+            if (moved == 0) {
+                if (sink.SupportsSplice()) {
+                    return false;   // socket 已读空
+                }
+                continue;           // splice 不可用，改为读取
+            }
+            ServerMetrics::GetInstance().OnBytesReceived(moved);
+            UpdateActivityTimestamp();
+            decoder.ConsumeRaw(moved);
+            if (decoder.IsDone()) {
+                FinishRequestBody(tinywebserver::Error::Success());
+            }
+            continue;
+        }
+
+        size_t want = sizeof(buf);
+        if (raw == 0 && sink.SupportsSplice()) {
+            want = kFramingRead;
+        }
+        ssize_t n = ::read(fd, buf, want);
         if (n > 0) {
+            AllocTagScope tag(AllocTag::kInputBuffer);
+            loop_->GetBufferPool().AcquireString(input_buffer_);
             input_buffer_.append(buf, n);
-            UpdateActivityTimestamp();  // 更新活动时间戳
+            ServerMetrics::GetInstance().OnBytesReceived(static_cast<size_t>(n));
+            UpdateActivityTimestamp();
         } else if (n == 0) {
             HandleClose(fd, tinywebserver::Error::Success());
-            break;
+            return false;
         } else {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                break;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                LOG_ERROR("HandleRead error on fd=%d, err=%d", fd, errno);
+                HandleError(fd);
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+void Connection::FinishRequestBody(const tinywebserver::Error& result) {
+    // 先移出状态：回调中可以开始下一个请求体
+    auto body = std::move(body_);
+    tinywebserver::Error err = result;
+    if (err.IsSuccess()) {
+        err = body->sink->Finish();
+    }
+    if (body->on_complete) {
+        AllocTagScope tag(AllocTag::kHttpRequest);
+        body->on_complete(shared_from_this(), err);
+    }
+}
+
+struct Connection::LoadState {
+    std::string loaded_path;
+    std::shared_ptr<StaticResource> loaded_resource;
+    std::vector<std::pair<std::string, std::function<void()>>> parked_requests;   ///< 路径 -> 挂起的请求
+};
+
+std::shared_ptr<StaticResource> Connection::AcquireStaticResource(const std::string& path, bool& pending) {
+    pending = false;
+    if (load_ && !load_->loaded_path.empty() && load_->loaded_path == path) {
+        // 重新执行的请求使用刚加载完成的结果（加载失败时为 nullptr），同一路径的多个请求共用
+        return load_->loaded_resource;
+    }
+
+    std::weak_ptr<Connection> weak_self = shared_from_this();
+    EventLoop* loop = loop_;
+    auto resource = StaticResourceManager::GetInstance().GetResourceAsync(
+        path,
+        [weak_self, loop, path](std::shared_ptr<StaticResource> loaded) {
+            // 加载线程上调用：切回连接所属的 loop
+            loop->QueueInLoop([weak_self, path, loaded]() {
+                if (auto self = weak_self.lock()) {
+                    self->OnStaticResourceLoaded(path, loaded);
+                }
+            });
+        },
+        pending);
+    if (pending) {
+        load_pending_ = true;
+    }
+    return resource;
+}
+
+void Connection::ParkUntilLoaded(const std::string& path, std::function<void()> retry) {
+    if (!load_) {
+        load_ = std::make_unique<LoadState>();
+    }
+    load_->parked_requests.emplace_back(path, std::move(retry));
+}
+
+void Connection::OnStaticResourceLoaded(const std::string& path, std::shared_ptr<StaticResource> resource) {
+    load_pending_ = false;
+    if (!IsConnected()) {
+        return;
+    }
+    std::vector<std::function<void()>> retries;
+    if (load_) {
+        auto& parked = load_->parked_requests;
+        for (auto it = parked.begin(); it != parked.end();) {
+            if (it->first == path) {
+                retries.push_back(std::move(it->second));
+                it = parked.erase(it);
+            } else {
+                ++it;
             }
-            LOG_ERROR("HandleRead error on fd=%d, err=%d", fd, errno);
-            HandleError(fd);
-            break;
         }
     }
-    // 背压检查：如果输入缓冲区超过限制，暂停读取
-    if (CheckInputBufferLimit()) {
-        PauseReading();
+    bool redispatch = !h2_ && !input_buffer_.empty() && message_callback_;
+    if (retries.empty() && !redispatch) {
+        return;
+    }
+    if (!load_) {
+        load_ = std::make_unique<LoadState>();
     }
-    if (!input_buffer_.empty() && message_callback_) {
-        message_callback_(shared_from_this(), input_buffer_);
+    load_->loaded_path = path;
+    load_->loaded_resource = std::move(resource);
+    // 挂起的请求先于缓冲区中的后续请求响应（HTTP/1.x 响应按请求顺序发送）
+    for (auto& retry : retries) {
+        retry();
+    }
+    if (redispatch && IsConnected()) {
+        DispatchInput();
+    }
+    // 没有其它路径的请求挂起时整块释放，空闲连接不保留加载状态
+    if (load_->parked_requests.empty()) {
+        load_.reset();
+    } else {
+        load_->loaded_path.clear();
+        load_->loaded_resource.reset();
+    }
+    ReleaseIdleBuffers();
+}
+
+std::shared_ptr<HttpRequest> Connection::GetHttpParser() {
+    if (!http_parser_) {
+        AllocTagScope tag(AllocTag::kHttpRequest);
+        http_parser_ = loop_->GetBufferPool().AcquireRequest();
+    }
+    return http_parser_;
+}
+
+void Connection::AcquireOutputStorage() {
+    if (!output_buffer_.HasStorage()) {
+        output_buffer_.AdoptStorage(loop_->GetBufferPool().AcquireStorage());
+    }
+}
+
+void Connection::ReleaseIdleBuffers() {
+    // HTTP/2 连接的输入由 H2Connection 逐帧消费，状态常驻，不参与借还
+    if (h2_ || !input_buffer_.empty() || !output_buffer_.IsEmpty() || !loop_->IsInLoopThread()) {
+        return;
+    }
+    auto& pool = loop_->GetBufferPool();
+    pool.ReleaseString(input_buffer_);
+    pool.ReleaseStorage(output_buffer_.ReleaseStorage());
+    if (http_parser_) {
+        pool.ReleaseRequest(http_parser_);
+    }
+    // 响应已全部写出，延迟追踪表为空，一并释放其容量
+    if (pending_latency_.empty() && pending_latency_.capacity() > 0) {
+        std::vector<PendingLatency>().swap(pending_latency_);
+    }
+}
+
+// ============================================================================
+// HTTP/2（h2c）
+// ============================================================================
+
+bool Connection::TryStartHttp2() {
+    // 前言直连（prior knowledge）：前言只可能出现在连接的第一批数据中
+    if (!h2_preface_checked_) {
+        size_t n = std::min(input_buffer_.size(), kH2PrefaceLen);
+        if (input_buffer_.compare(0, n, kH2Preface, n) == 0) {
+            if (n < kH2PrefaceLen) {
+                return true;  // 前言未收全，等待后续数据
+            }
+            h2_preface_checked_ = true;
+            LOG_DEBUG("HTTP/2 prior-knowledge preface on fd=%d", fd_);
+            StartHttp2();
+            return true;
+        }
+        h2_preface_checked_ = true;
+    }
+    return TryUpgradeH2c();
+}
+
+bool Connection::TryUpgradeH2c() {
+    size_t header_end = input_buffer_.find("\r\n\r\n");
+    if (header_end == std::string::npos) {
+        return false;
+    }
+    // 快速过滤：绝大多数 HTTP/1.x 请求不含 h2c，无需二次解析
+    size_t token_pos = input_buffer_.find("h2c");
+    if (token_pos == std::string::npos || token_pos > header_end) {
+        return false;
+    }
+
+    std::string head = input_buffer_.substr(0, header_end + 4);
+    HttpRequest request;
+    if (!request.Parse(head)) {
+        return false;
+    }
+
+    // 带请求体的升级请求不切换（服务器可忽略 Upgrade，RFC 7540 Section 3.2），按 HTTP/1.1 处理
+    std::string settings = request.GetHeader("http2-settings");
+    bool has_body = request.GetContentLength() > 0 || !request.GetHeader("transfer-encoding").empty();
+    if (request.GetVersion() != "HTTP/1.1" || settings.empty() || has_body ||
+        !HasHeaderToken(request.GetHeader("upgrade"), "h2c") ||
+        !HasHeaderToken(request.GetHeader("connection"), "upgrade")) {
+        return false;
+    }
+
+    // 升级请求转换为流 1 的请求头
+    http2::H2Stream::Headers headers;
+    headers[":method"] = request.GetMethod();
+    headers[":path"] = request.GetPath();
+    headers[":scheme"] = "http";
+    for (const auto& [name, value] : request.GetHeaders()) {
+        if (name == "host") {
+            headers[":authority"] = value;
+        } else if (!IsHopByHopHeader(name)) {
+            headers[name] = value;
+        }
+    }
+
+    LOG_DEBUG("HTTP/1.1 Upgrade: h2c on fd=%d, path=%s", fd_, request.GetPath().c_str());
+    input_buffer_.erase(0, header_end + 4);
+    SendInLoop(kSwitchingProtocols);
+    StartHttp2();
+
+    auto err = h2_->AcceptUpgrade(settings, headers);
+    if (err.IsFailure()) {
+        LOG_WARN("HTTP/2 upgrade failed on fd=%d: %s", fd_, err.ToString().c_str());
+        h2_->Close(err);
+    }
+    return true;
+}
+
+void Connection::StartHttp2() {
+    h2_ = std::make_unique<http2::H2Connection>(fd_, true);
+    if (config_) {
+        h2_->SetMaxRequestBodySize(config_->GetLimitsOptions().max_request_size);
+    }
+
+    // 已序列化的帧节点直接移入输出缓冲区（h2_ 归本连接所有，回调可直接捕获 this）
+    h2_->SetFrameCallback([this](BufferChain& frames) {
+        if (state_.load(std::memory_order_acquire) == ConnState::kClosed) {
+            return;
+        }
+        SendChainInLoop(frames);
+    });
+
+    // DATA 调度按本连接输出缓冲区的积压限流，写出后在 HandleWrite 中续发
+    h2_->SetOutputSizeCallback([this]() { return output_buffer_.TotalBytes(); });
+
+    // GOAWAY 已入队，发送完毕后半关闭
+    h2_->SetCloseCallback([this](const tinywebserver::Error& /*reason*/) {
+        if (IsConnected()) {
+            Shutdown();
+        }
+    });
+
+    std::weak_ptr<Connection> weak_self(shared_from_this());
+    h2_->SetStreamRequestCallback([this, weak_self](std::shared_ptr<http2::H2Stream> stream) {
+        if (auto self = weak_self.lock()) {
+            h2_request_callback_(self, std::move(stream));
+        }
+    });
+}
+
+void Connection::ProcessHttp2Input() {
+    if (!h2_ || input_buffer_.empty()) {
+        return;  // 前言未收全时 h2_ 尚未创建
+    }
+
+    // 帧直接在输入缓冲区中解析，处理完后只丢弃已消费的前缀：剩下的
+    // 至多是一个不完整的帧，每次读取最多搬移一帧，而不是每帧搬移一次。
+    // 流的请求回调在 ProcessData 内同步执行，期间输入缓冲区保持不变，
+    // 同一批数据中的多个流共用本次读取的时间戳作为延迟起点
+    size_t consumed = 0;
+    auto err = h2_->ProcessData(reinterpret_cast<const uint8_t*>(input_buffer_.data()),
+                                input_buffer_.size(), consumed);
+    if (consumed == input_buffer_.size() || err.IsFailure()) {
+        input_buffer_.clear();
+    } else {
+        input_buffer_.erase(0, consumed);
+    }
+    if (err.IsFailure()) {
+        LOG_WARN("HTTP/2 connection error on fd=%d: %s", fd_, err.ToString().c_str());
+        h2_->Close(err);
     }
 }
 
@@ -172,23 +688,46 @@ void Connection::HandleWrite(int fd)
     
     if (count > 0)
     {
-        ssize_t n = ::writev(fd, iov, count);
+        ssize_t n;
+        {
+            PerfPhaseScope perf_scope(PerfPhase::kWrite);
+            n = ::writev(fd, iov, count);
+        }
         if (n > 0)
         {
             // 修改处：output_buffer_chain_ -> output_buffer_
             output_buffer_.Advance(static_cast<size_t>(n));
             ServerMetrics::GetInstance().OnBytesSent(static_cast<size_t>(n));
+            bytes_flushed_ += static_cast<uint64_t>(n);
+            if (!pending_latency_.empty()) {
+                RecordFlushedRequests();
+            }
             UpdateActivityTimestamp();  // 更新活动时间戳
 
+            // HTTP/2：积压降到高水位一半以下时向调度器要下一批 DATA，
+            // 大文件按水位分批入队，而不是一次性占满输出缓冲区
+            if (h2_ && output_buffer_.TotalBytes() < http2::H2Connection::kOutputHighWatermark / 2 &&
+                h2_->HasPendingOutput()) {
+                h2_refilling_ = true;
+                h2_->OnOutputDrained();
+                h2_refilling_ = false;
+            }
+
             if (output_buffer_.IsEmpty())
             {
                 loop_->UpdateEvent(fd_, EPOLLIN | EPOLLET);
                 if (state_ == ConnState::kClosing) ShutdownInLoop();
+                ReleaseIdleBuffers();
             }
             else
             {
                 loop_->UpdateEvent(fd_, EPOLLIN | EPOLLOUT | EPOLLET);
             }
+
+            // 流式响应：积压降到低水位后唤醒暂停的生产者
+            if (writable_callbacks_) {
+                RunWritableCallbacks();
+            }
         }
         // ... 后续逻辑 ...
         else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
@@ -230,7 +769,12 @@ void Connection::HandleClose(int fd, const tinywebserver::Error& reason) {
         LOG_DEBUG("Connection fd=%d closed normally", fd);
     }
 
+    bool was_closed = (state_.load(std::memory_order_acquire) == ConnState::kClosed);
     Transition(ConnState::kClosed, "connection closed");
+    if (!was_closed) {
+        ServerMetrics::GetInstance().OnCloseConnection();
+        loop_->OnConnectionClosed();
+    }
     loop_->RemoveEvent(fd);
     // 通知 Keep-Alive 管理器连接关闭
     if (keep_alive_manager_) {
@@ -239,6 +783,24 @@ void Connection::HandleClose(int fd, const tinywebserver::Error& reason) {
     if (close_callback_) {
         close_callback_(fd);
     }
+    // 未收完的请求体随连接丢弃（上传的临时文件由 sink 删除）
+    body_.reset();
+    if (load_) {
+        load_->parked_requests.clear();
+    }
+    // 等待可写的生产者在下一轮得知连接已关闭，不在关闭路径中重入
+    if (writable_callbacks_) {
+        auto callbacks = std::move(writable_callbacks_);
+        for (auto& cb : *callbacks) {
+            loop_->QueueInLoop(std::move(cb));
+        }
+    }
+    // 未发送的数据随连接丢弃，缓冲区交还本循环的池
+    if (!was_closed && !h2_) {
+        input_buffer_.clear();
+        output_buffer_.Clear();
+        ReleaseIdleBuffers();
+    }
 }
 
 void Connection::HandleError(int fd) {
@@ -303,13 +865,17 @@ void Connection::Transition(ConnState new_state, const std::string& reason) {
 }
 
 // 资源限制检查实现
-bool Connection::CheckInputBufferLimit() const {
-    size_t current_size = input_buffer_.size();
+size_t Connection::InputBufferLimit() const {
     size_t max_limit = ConnectionLimits::kMaxInputBuffer; // 默认值
     if (config_) {
-        auto limits = config_->GetLimitsOptions();
-        max_limit = limits.max_input_buffer;
+        max_limit = config_->GetLimitsOptions().max_input_buffer;
     }
+    return max_limit;
+}
+
+bool Connection::CheckInputBufferLimit() const {
+    size_t current_size = input_buffer_.size();
+    size_t max_limit = InputBufferLimit();
     bool exceeded = current_size > max_limit;
     if (exceeded) {
         LOG_WARN("Input buffer limit exceeded: %zu > %zu, fd=%d",
@@ -318,6 +884,48 @@ bool Connection::CheckInputBufferLimit() const {
     return exceeded;
 }
 
+size_t Connection::GetOutputHighWatermark() const {
+    if (config_) {
+        return config_->GetLimitsOptions().output_high_watermark;
+    }
+    return ConnectionLimits::kOutputHighWatermark;
+}
+
+void Connection::NotifyWhenWritable(WritableCallback cb) {
+    if (!writable_callbacks_) {
+        writable_callbacks_ = std::make_unique<std::vector<WritableCallback>>();
+    }
+    writable_callbacks_->push_back(std::move(cb));
+}
+
+void Connection::RunWritableCallbacks() {
+    if (output_buffer_.TotalBytes() > GetOutputHighWatermark() / 2) {
+        return;
+    }
+    // 先换出：回调中继续写入并再次登记的回调等下一次写出
+    auto callbacks = std::move(writable_callbacks_);
+    for (auto& cb : *callbacks) {
+        cb();
+    }
+}
+
+void Connection::EndStreamingResponse() {
+    response_streaming_ = false;
+    if (input_buffer_.empty() || !IsConnected()) {
+        return;
+    }
+    // 可能在消息回调内同步结束：推迟到下一轮处理等待的请求，避免重入
+    std::weak_ptr<Connection> weak_self = shared_from_this();
+    loop_->QueueInLoop([weak_self]() {
+        auto self = weak_self.lock();
+        if (!self || self->response_streaming_ || !self->IsConnected()) {
+            return;
+        }
+        self->DispatchInput();
+        self->ReleaseIdleBuffers();
+    });
+}
+
 bool Connection::CheckOutputBufferLimit() const {
     size_t current_size = output_buffer_.TotalBytes();
     size_t max_limit = ConnectionLimits::kMaxOutputBuffer; // 默认值
@@ -336,12 +944,14 @@ bool Connection::CheckOutputBufferLimit() const {
 void Connection::PauseReading() {
     // 从 epoll 事件中移除 EPOLLIN，暂停读取
     loop_->UpdateEvent(fd_, EPOLLOUT | EPOLLET); // 只保留写事件
+    reading_paused_ = true;
     LOG_DEBUG("Pause reading on fd=%d due to backpressure", fd_);
 }
 
 void Connection::ResumeReading() {
     // 恢复 EPOLLIN 事件
     loop_->UpdateEvent(fd_, EPOLLIN | EPOLLOUT | EPOLLET);
+    reading_paused_ = false;
     LOG_DEBUG("Resume reading on fd=%d", fd_);
 }
 
@@ -418,9 +1028,11 @@ void Connection::SetupTimeout(int seconds, const std::string& timeout_type) {
         return;
     }
 
-    // 创建超时回调
-    auto callback = [self = shared_from_this(), timeout_type]() {
-        self->OnTimeout(timeout_type);
+    // 创建超时回调：捕获字面量而不是 std::string，每个空闲定时器的回调对象从 48 字节降到 24 字节
+    AllocTagScope tag(AllocTag::kTimer);
+    const char* kind = timeout_type == "read" ? "read" : (timeout_type == "write" ? "write" : "idle");
+    auto callback = [self = shared_from_this(), kind]() {
+        self->OnTimeout(kind);
     };
 
     // 添加定时器
@@ -601,20 +1213,85 @@ void Connection::UpdateKeepAliveState(bool keep_alive, int idle_timeout) {
     if (!keep_alive_manager_) {
         return;
     }
+    AllocTagScope tag(AllocTag::kKeepAlive);
     keep_alive_manager_->OnRequestStart(fd_, keep_alive, idle_timeout);
 }
 
+struct Connection::TraceState {
+    uint64_t connection_id = 0;
+    bool pending = false;
+    tinywebserver::TraceMethod method = tinywebserver::TraceMethod::kOther;
+    std::string path;
+    uint64_t bytes_start = 0;
+};
+
 void Connection::OnRequestStart(bool keep_alive, int idle_timeout) {
+    // 访问轨迹只覆盖 HTTP/1.x：h2 流的请求行不经过 http_parser_
+    if (tinywebserver::AccessTrace::IsEnabled() && http_parser_ && !h2_) {
+        if (!trace_) {
+            trace_ = std::make_unique<TraceState>();
+            trace_->connection_id = tinywebserver::AccessTrace::NextConnectionId();
+        }
+        trace_->pending = true;
+        trace_->method = tinywebserver::TraceMethodFromString(http_parser_->GetMethod());
+        trace_->path = http_parser_->GetPath();
+        trace_->bytes_start = bytes_queued_;
+    }
     UpdateKeepAliveState(keep_alive, idle_timeout);
 }
 
 void Connection::OnRequestComplete() {
+    // 延迟追踪：本请求的响应以当前已入队字节数为终点
+    if (loop_->IsInLoopThread() && request_start_ns_ != 0) {
+        PendingLatency entry;
+        entry.end_offset = bytes_queued_;
+        entry.start_ns = request_start_ns_;
+        entry.queued_ns = ServerMetrics::NowNs();
+        if (trace_ && trace_->pending) {
+            entry.traced = true;
+            entry.method = trace_->method;
+            entry.path = std::move(trace_->path);
+            entry.response_bytes = bytes_queued_ - trace_->bytes_start;
+            trace_->pending = false;
+        }
+        {
+            AllocTagScope tag(AllocTag::kConnection);
+            pending_latency_.push_back(std::move(entry));
+        }
+        // 流水线请求：剩余数据已在本次读入，起点记为该次读取时间
+        request_start_ns_ = input_buffer_.empty() ? 0 : last_read_ns_;
+        RecordFlushedRequests();
+    }
+
     if (!keep_alive_manager_) {
         return;
     }
+    AllocTagScope tag(AllocTag::kKeepAlive);
     keep_alive_manager_->OnRequestComplete(fd_);
 }
 
+void Connection::RecordFlushedRequests() {
+    size_t done = 0;
+    uint64_t now = 0;
+    while (done < pending_latency_.size() && pending_latency_[done].end_offset <= bytes_flushed_) {
+        if (now == 0) {
+            now = ServerMetrics::NowNs();
+        }
+        const PendingLatency& entry = pending_latency_[done];
+        auto& metrics = ServerMetrics::GetInstance();
+        metrics.OnRequestPhase(RequestPhase::kTotal, now - entry.start_ns);
+        metrics.OnRequestPhase(RequestPhase::kQueueToFlush, now - entry.queued_ns);
+        if (entry.traced) {
+            tinywebserver::AccessTrace::Record(entry.start_ns, trace_->connection_id, entry.method, entry.path,
+                                               entry.response_bytes, now - entry.start_ns);
+        }
+        ++done;
+    }
+    if (done > 0) {
+        pending_latency_.erase(pending_latency_.begin(), pending_latency_.begin() + done);
+    }
+}
+
 bool Connection::ShouldKeepAlive() const {
     if (!keep_alive_manager_) {
         return false;
@@ -0,0 +1,86 @@
+#include "connection_buffer_pool.h"
+
+namespace tinywebserver {
+
+namespace {
+
+// 空字符串的容量即小字符串优化的内联容量，不超过它说明没有堆分配
+bool HasHeapCapacity(const std::string& s) {
+    static const size_t kInlineCapacity = std::string().capacity();
+    return s.capacity() > kInlineCapacity;
+}
+
+} // namespace
+
+void ConnectionBufferPool::AcquireString(std::string& buffer) {
+    if (HasHeapCapacity(buffer)) {
+        return;
+    }
+    if (strings_.empty()) {
+        ++misses_;
+        return;
+    }
+    ++hits_;
+    std::string cached;
+    cached.swap(strings_.back());
+    strings_.pop_back();
+    cached.append(buffer);
+    buffer.swap(cached);
+}
+
+void ConnectionBufferPool::ReleaseString(std::string& buffer) {
+    std::string released;
+    released.swap(buffer);
+    if (!HasHeapCapacity(released) || released.capacity() > kMaxCachedStringCapacity ||
+        strings_.size() >= kMaxCachedPerKind) {
+        return;
+    }
+    released.clear();
+    strings_.push_back(std::move(released));
+}
+
+std::unique_ptr<BufferChain::Storage> ConnectionBufferPool::AcquireStorage() {
+    if (storages_.empty()) {
+        ++misses_;
+        return nullptr;
+    }
+    ++hits_;
+    auto storage = std::move(storages_.back());
+    storages_.pop_back();
+    return storage;
+}
+
+void ConnectionBufferPool::ReleaseStorage(std::unique_ptr<BufferChain::Storage> storage) {
+    if (!storage || storages_.size() >= kMaxCachedPerKind) {
+        return;
+    }
+    // clear 保留首个节点块，下次借出时无需重新分配
+    storage->clear();
+    storages_.push_back(std::move(storage));
+}
+
+std::shared_ptr<HttpRequest> ConnectionBufferPool::AcquireRequest() {
+    if (requests_.empty()) {
+        ++misses_;
+        return std::make_shared<HttpRequest>();
+    }
+    ++hits_;
+    auto request = std::move(requests_.back());
+    requests_.pop_back();
+    return request;
+}
+
+void ConnectionBufferPool::ReleaseRequest(std::shared_ptr<HttpRequest>& request) {
+    std::shared_ptr<HttpRequest> released = std::move(request);
+    if (!released || released.use_count() != 1 || requests_.size() >= kMaxCachedPerKind) {
+        return;
+    }
+    released->Reset();
+    requests_.push_back(std::move(released));
+}
+
+ConnectionBufferPool::Stats ConnectionBufferPool::GetStats() const {
+    return Stats{strings_.size(), storages_.size(), requests_.size(), hits_, misses_};
+}
+
+} // namespace tinywebserver
@@ -0,0 +1,86 @@
+#include "frequency_sketch.h"
+
+#include <algorithm>
+
+namespace tinywebserver {
+
+namespace {
+
+constexpr uint64_t kSeeds[] = {0xc3a5c85c97cb3127ULL, 0xb492b66fbe98f273ULL,
+                               0x9ae16a3b2f90404fULL, 0xcbf29ce484222325ULL};
+// 每个 4 位计数器去掉最高位，减半时防止相邻计数器的低位移入
+constexpr uint64_t kResetMask = 0x7777777777777777ULL;
+
+uint64_t Mix(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+} // namespace
+
+FrequencySketch::FrequencySketch(size_t expected_entries) {
+    Resize(expected_entries);
+}
+
+void FrequencySketch::Resize(size_t expected_entries) {
+    size_t width = 64;
+    while (width < expected_entries && width < (size_t(1) << 26)) {
+        width <<= 1;
+    }
+    table_.assign(width, 0);
+    mask_ = width - 1;
+    sample_size_ = std::max<size_t>(10, expected_entries * 10);
+    additions_ = 0;
+}
+
+void FrequencySketch::Clear() {
+    std::fill(table_.begin(), table_.end(), 0);
+    additions_ = 0;
+}
+
+size_t FrequencySketch::IndexOf(uint64_t hash, int row) const {
+    return static_cast<size_t>(Mix(hash + kSeeds[row])) & mask_;
+}
+
+int FrequencySketch::SlotOf(uint64_t hash, int row) {
+    return (row << 2) + static_cast<int>((hash >> (row * 8)) & 3);
+}
+
+void FrequencySketch::Increment(uint64_t hash) {
+    bool added = false;
+    for (int row = 0; row < kDepth; ++row) {
+        uint64_t& word = table_[IndexOf(hash, row)];
+        int shift = SlotOf(hash, row) << 2;
+        if (((word >> shift) & 0xf) < kMaxFrequency) {
+            word += uint64_t(1) << shift;
+            added = true;
+        }
+    }
+    if (added && ++additions_ >= sample_size_) {
+        Reset();
+    }
+}
+
+uint32_t FrequencySketch::Estimate(uint64_t hash) const {
+    uint32_t frequency = kMaxFrequency;
+    for (int row = 0; row < kDepth; ++row) {
+        uint64_t word = table_[IndexOf(hash, row)];
+        int shift = SlotOf(hash, row) << 2;
+        frequency = std::min(frequency, static_cast<uint32_t>((word >> shift) & 0xf));
+    }
+    return frequency;
+}
+
+void FrequencySketch::Reset() {
+    for (auto& word : table_) {
+        word = (word >> 1) & kResetMask;
+    }
+    additions_ /= 2;
+    ++resets_;
+}
+
+} // namespace tinywebserver
@@ -0,0 +1,384 @@
+#include "http/request_body.h"
+
+#include "connection_limits.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace tinywebserver {
+
+namespace {
+
+int HexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+Error Malformed(const std::string& what) {
+    return Error(WebError::kInvalidRequest, "Malformed chunked body: " + what);
+}
+
+} // namespace
+
+// ============================================================================
+// BodyDecoder
+// ============================================================================
+
+Error BodyDecoder::Init(const HttpRequest& request, uint64_t max_body_size) {
+    mode_ = Mode::kNone;
+    done_ = true;
+    max_body_size_ = max_body_size;
+    remaining_ = 0;
+    body_bytes_ = 0;
+    chunk_state_ = ChunkState::kSize;
+    size_digits_ = 0;
+    trailer_bytes_ = 0;
+
+    std::string encoding = request.GetHeader("transfer-encoding");
+    std::string length = request.GetHeader("content-length");
+    if (!encoding.empty()) {
+        std::transform(encoding.begin(), encoding.end(), encoding.begin(),
+                       [](unsigned char c) { return std::tolower(c); });
+        if (!length.empty()) {
+            return Error(WebError::kInvalidRequest, "Both Transfer-Encoding and Content-Length present");
+        }
+        if (encoding != "chunked") {
+            return Error(WebError::kInvalidRequest, "Unsupported Transfer-Encoding: " + encoding);
+        }
+        mode_ = Mode::kChunked;
+        done_ = false;
+        return Error::Success();
+    }
+
+    if (length.empty()) {
+        return Error::Success();
+    }
+    // 只接受纯十进制数字，拒绝符号、空格与溢出
+    if (length.size() > 19 || !std::all_of(length.begin(), length.end(),
+                                           [](unsigned char c) { return std::isdigit(c); })) {
+        return Error(WebError::kInvalidRequest, "Invalid Content-Length: " + length);
+    }
+    uint64_t value = std::strtoull(length.c_str(), nullptr, 10);
+    if (value > max_body_size_) {
+        return Error(WebError::kRequestTooLarge, "Request body too large: " + length + " > " +
+                     std::to_string(max_body_size_));
+    }
+    if (value > 0) {
+        mode_ = Mode::kContentLength;
+        remaining_ = value;
+        done_ = false;
+    }
+    return Error::Success();
+}
+
+Error BodyDecoder::Feed(const char* data, size_t len, const DataCallback& on_data, size_t& consumed) {
+    consumed = 0;
+    if (done_) {
+        return Error::Success();
+    }
+    if (mode_ == Mode::kChunked) {
+        return FeedChunked(data, len, on_data, consumed);
+    }
+
+    size_t n = static_cast<size_t>(std::min<uint64_t>(remaining_, len));
+    if (n > 0) {
+        Error err = on_data(data, n);
+        if (err.IsFailure()) {
+            return err;
+        }
+    }
+    consumed = n;
+    ConsumeRaw(n);
+    return Error::Success();
+}
+
+Error BodyDecoder::FeedChunked(const char* data, size_t len, const DataCallback& on_data, size_t& consumed) {
+    size_t i = 0;
+    while (i < len && !done_) {
+        char c = data[i];
+        switch (chunk_state_) {
+        case ChunkState::kSize: {
+            int v = HexValue(c);
+            if (v >= 0) {
+                // 15 位十六进制已远超任何合理上限，再多视为溢出
+                if (++size_digits_ > 15) {
+                    return Malformed("chunk size too long");
+                }
+                remaining_ = remaining_ * 16 + static_cast<uint64_t>(v);
+            } else if (size_digits_ > 0 && (c == ';' || c == ' ' || c == '\t')) {
+                chunk_state_ = ChunkState::kExtension;
+            } else if (size_digits_ > 0 && c == '\r') {
+                chunk_state_ = ChunkState::kSizeLf;
+            } else {
+                return Malformed("bad chunk size");
+            }
+            ++i;
+            break;
+        }
+        case ChunkState::kExtension:
+            if (c == '\r') {
+                chunk_state_ = ChunkState::kSizeLf;
+            } else if (c == '\n') {
+                return Malformed("bare LF in chunk extension");
+            }
+            ++i;
+            break;
+        case ChunkState::kSizeLf: {
+            if (c != '\n') {
+                return Malformed("expected LF after chunk size");
+            }
+            ++i;
+            size_digits_ = 0;
+            if (remaining_ == 0) {
+                chunk_state_ = ChunkState::kTrailer;
+                break;
+            }
+            Error err = CheckLimit(remaining_);
+            if (err.IsFailure()) {
+                return err;
+            }
+            chunk_state_ = ChunkState::kData;
+            break;
+        }
+        case ChunkState::kData: {
+            size_t n = static_cast<size_t>(std::min<uint64_t>(remaining_, len - i));
+            Error err = on_data(data + i, n);
+            if (err.IsFailure()) {
+                return err;
+            }
+            i += n;
+            ConsumeRaw(n);
+            break;
+        }
+        case ChunkState::kDataCr:
+            if (c != '\r') {
+                return Malformed("missing CRLF after chunk data");
+            }
+            chunk_state_ = ChunkState::kDataLf;
+            ++i;
+            break;
+        case ChunkState::kDataLf:
+            if (c != '\n') {
+                return Malformed("missing CRLF after chunk data");
+            }
+            chunk_state_ = ChunkState::kSize;
+            ++i;
+            break;
+        case ChunkState::kTrailer:
+            chunk_state_ = c == '\r' ? ChunkState::kEndLf : ChunkState::kTrailerLine;
+            ++i;
+            ++trailer_bytes_;
+            break;
+        case ChunkState::kTrailerLine:
+            // 尾部字段不使用，只限制总长
+            if (++trailer_bytes_ > ConnectionLimits::kMaxHeadersSize) {
+                return Error(WebError::kRequestTooLarge, "Chunked trailer too large");
+            }
+            if (c == '\r') {
+                chunk_state_ = ChunkState::kTrailerLf;
+            }
+            ++i;
+            break;
+        case ChunkState::kTrailerLf:
+            if (c != '\n') {
+                return Malformed("bad trailer line");
+            }
+            chunk_state_ = ChunkState::kTrailer;
+            ++i;
+            break;
+        case ChunkState::kEndLf:
+            if (c != '\n') {
+                return Malformed("expected LF after last chunk");
+            }
+            ++i;
+            done_ = true;
+            break;
+        }
+    }
+    consumed = i;
+    return Error::Success();
+}
+
+Error BodyDecoder::CheckLimit(uint64_t add) const {
+    if (body_bytes_ + add > max_body_size_) {
+        return Error(WebError::kRequestTooLarge, "Request body too large: > " + std::to_string(max_body_size_));
+    }
+    return Error::Success();
+}
+
+uint64_t BodyDecoder::RawRemaining() const {
+    if (done_) {
+        return 0;
+    }
+    if (mode_ == Mode::kContentLength || chunk_state_ == ChunkState::kData) {
+        return remaining_;
+    }
+    return 0;
+}
+
+void BodyDecoder::ConsumeRaw(uint64_t n) {
+    remaining_ -= n;
+    body_bytes_ += n;
+    if (remaining_ > 0) {
+        return;
+    }
+    if (mode_ == Mode::kContentLength) {
+        done_ = true;
+    } else {
+        chunk_state_ = ChunkState::kDataCr;
+    }
+}
+
+// ============================================================================
+// BodySink / FileUploadSink
+// ============================================================================
+
+Error BodySink::SpliceFrom(int /*socket_fd*/, size_t /*max_len*/, size_t& moved, bool& eof) {
+    moved = 0;
+    eof = false;
+    return Error(WebError::kInternalError, "Body sink does not support splice");
+}
+
+FileUploadSink::~FileUploadSink() {
+    CloseAll();
+    if (!finished_ && !tmp_path_.empty()) {
+        ::unlink(tmp_path_.c_str());
+    }
+}
+
+Error FileUploadSink::Open(const std::string& path) {
+    path_ = path;
+    std::vector<char> tmpl(path.begin(), path.end());
+    const char suffix[] = ".part.XXXXXX";
+    tmpl.insert(tmpl.end(), suffix, suffix + sizeof(suffix));
+    file_fd_ = ::mkostemp(tmpl.data(), O_CLOEXEC);
+    if (file_fd_ < 0) {
+        return Error::FromErrno(errno, "Cannot create upload file for " + path);
+    }
+    tmp_path_ = tmpl.data();
+    if (::pipe2(pipe_fds_, O_CLOEXEC | O_NONBLOCK) < 0) {
+        // 没有管道仍可用 write 接收
+        pipe_fds_[0] = pipe_fds_[1] = -1;
+        splice_supported_ = false;
+    }
+    return Error::Success();
+}
+
+Error FileUploadSink::Write(const char* data, size_t len) {
+    Error err = WriteFile(data, len);
+    if (err.IsSuccess()) {
+        bytes_ += len;
+    }
+    return err;
+}
+
+Error FileUploadSink::WriteFile(const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = ::write(file_fd_, data, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return Error::FromErrno(errno, "Write upload file failed");
+        }
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+    return Error::Success();
+}
+
+Error FileUploadSink::SpliceFrom(int socket_fd, size_t max_len, size_t& moved, bool& eof) {
+    moved = 0;
+    eof = false;
+    size_t want = std::min(max_len, kSpliceChunk);
+    ssize_t n;
+    do {
+        n = ::splice(socket_fd, nullptr, pipe_fds_[1], nullptr, want, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return Error::Success();
+        }
+        if (errno == EINVAL) {
+            splice_supported_ = false;
+            return Error::Success();
+        }
+        return Error::FromErrno(errno, "splice from socket failed");
+    }
+    if (n == 0) {
+        eof = true;
+        return Error::Success();
+    }
+    Error err = DrainPipe(static_cast<size_t>(n));
+    if (err.IsFailure()) {
+        return err;
+    }
+    moved = static_cast<size_t>(n);
+    spliced_bytes_ += moved;
+    return Error::Success();
+}
+
+Error FileUploadSink::DrainPipe(size_t len) {
+    while (len > 0) {
+        ssize_t n = -1;
+        if (splice_supported_) {
+            n = ::splice(pipe_fds_[0], nullptr, file_fd_, nullptr, len, SPLICE_F_MOVE);
+            if (n < 0 && errno == EINVAL) {
+                splice_supported_ = false;   // 目标文件系统不支持，改为读出再写
+            }
+        }
+        if (!splice_supported_) {
+            char buf[16 * 1024];
+            n = ::read(pipe_fds_[0], buf, std::min(len, sizeof(buf)));
+            if (n > 0) {
+                Error err = WriteFile(buf, static_cast<size_t>(n));
+                if (err.IsFailure()) {
+                    return err;
+                }
+            }
+        }
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return Error::FromErrno(errno, "Write upload file failed");
+        }
+        if (n == 0) {
+            return Error(WebError::kIoError, "Upload pipe drained unexpectedly");
+        }
+        len -= static_cast<size_t>(n);
+        bytes_ += static_cast<uint64_t>(n);
+    }
+    return Error::Success();
+}
+
+Error FileUploadSink::Finish() {
+    if (file_fd_ < 0) {
+        return Error(WebError::kStateError, "Upload file not open");
+    }
+    CloseAll();
+    if (::rename(tmp_path_.c_str(), path_.c_str()) < 0) {
+        return Error::FromErrno(errno, "Rename upload file failed");
+    }
+    finished_ = true;
+    return Error::Success();
+}
+
+void FileUploadSink::CloseAll() {
+    for (int* fd : {&file_fd_, &pipe_fds_[0], &pipe_fds_[1]}) {
+        if (*fd >= 0) {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+}
+
+} // namespace tinywebserver
@@ -0,0 +1,374 @@
+#include "http/response_writer.h"
+
+#include "buffer_chain.h"
+#include "connection.h"
+#include "http_response.h"
+#include "http2/h2_stream.h"
+#include "reactor/event_loop.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+
+namespace tinywebserver {
+
+namespace {
+
+std::string ToLower(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    return value;
+}
+
+// 由 ResponseWriter 管理的分帧头部，处理器给出的同名头部被忽略
+bool IsFramingHeader(const std::string& lower_name) {
+    return lower_name == "transfer-encoding" || lower_name == "connection" || lower_name == "keep-alive";
+}
+
+constexpr char kLastChunk[] = "0\r\n\r\n";
+constexpr uint32_t kH2InternalError = 0x2;
+
+} // namespace
+
+// ============================================================================
+// ResponseWriter
+// ============================================================================
+
+ResponseWriter::ResponseWriter(std::shared_ptr<Connection> conn, bool head_only)
+    : conn_(std::move(conn)), head_only_(head_only) {}
+
+Error ResponseWriter::WriteHead(int status_code, Headers headers) {
+    if (finished_ || head_sent_) {
+        return Error(WebError::kStateError, "Response head already sent");
+    }
+    if (!IsOpen_()) {
+        return Error(WebError::kStateError, "Response stream closed");
+    }
+    if (status_code < 100 || status_code > 999) {
+        return Error(WebError::kInvalidArgument, "Invalid status code: " + std::to_string(status_code));
+    }
+    for (const auto& [name, value] : headers) {
+        if (ToLower(name) != "content-length") {
+            continue;
+        }
+        if (value.empty() || value.size() > 18 ||
+            !std::all_of(value.begin(), value.end(), [](unsigned char c) { return std::isdigit(c); })) {
+            return Error(WebError::kInvalidArgument, "Invalid Content-Length: " + value);
+        }
+        content_length_ = std::stoll(value);
+    }
+    status_code_ = status_code;
+    no_body_ = head_only_ || status_code < 200 || status_code == 204 || status_code == 304;
+    head_sent_ = true;
+    return SendHead_(headers);
+}
+
+Error ResponseWriter::Write(const char* data, size_t len) {
+    if (len == 0) {
+        return IsOpen() ? Error::Success() : Error(WebError::kStateError, "Response stream closed");
+    }
+    return Write(std::string(data, len));
+}
+
+Error ResponseWriter::Write(std::string&& data) {
+    if (finished_) {
+        return Error(WebError::kStateError, "Response already finished");
+    }
+    if (!head_sent_) {
+        Error err = WriteHead(status_code_);
+        if (err.IsFailure()) {
+            return err;
+        }
+    }
+    if (!IsOpen_()) {
+        return Error(WebError::kStateError, "Response stream closed");
+    }
+    if (data.empty() || no_body_) {
+        return Error::Success();
+    }
+    if (content_length_ >= 0 && body_bytes_ + data.size() > static_cast<uint64_t>(content_length_)) {
+        return Error(WebError::kInvalidArgument, "Response body exceeds Content-Length");
+    }
+    body_bytes_ += data.size();
+    return SendBody_(std::move(data));
+}
+
+Error ResponseWriter::End() {
+    if (finished_) {
+        return Error(WebError::kStateError, "Response already finished");
+    }
+    if (!head_sent_ && IsOpen_()) {
+        // 没有响应体：以 Content-Length: 0 代替空的 chunked 响应
+        Error err = WriteHead(status_code_, {{"Content-Length", "0"}});
+        if (err.IsFailure()) {
+            Abort(err);
+            return err;
+        }
+    }
+    if (!head_sent_ || !IsOpen_()) {
+        Error err(WebError::kStateError, "Response stream closed");
+        Abort(err);
+        return err;
+    }
+    if (!no_body_ && content_length_ >= 0 && body_bytes_ != static_cast<uint64_t>(content_length_)) {
+        Error err(WebError::kStateError, "Response body shorter than Content-Length");
+        Abort(err);
+        return err;
+    }
+    finished_ = true;
+    Error err = SendEnd_();
+    Finish_(err);
+    return err;
+}
+
+void ResponseWriter::Abort(const Error& reason) {
+    if (finished_) {
+        return;
+    }
+    finished_ = true;
+    SendAbort_(reason);
+    Finish_(reason.IsFailure() ? reason : Error(WebError::kInternalError, "Response aborted"));
+}
+
+bool ResponseWriter::IsWritable() const {
+    return IsOpen() && Backlog_() < conn_->GetOutputHighWatermark();
+}
+
+void ResponseWriter::OnWritable(std::function<void()> cb) {
+    if (IsWritable() || !IsOpen()) {
+        conn_->GetLoop()->QueueInLoop(std::move(cb));
+        return;
+    }
+    writable_callback_ = std::move(cb);
+    if (!writable_armed_) {
+        ArmWritable_();
+    }
+}
+
+void ResponseWriter::ArmWritable_() {
+    writable_armed_ = true;
+    std::weak_ptr<ResponseWriter> weak_self = weak_from_this();
+    conn_->NotifyWhenWritable([weak_self]() {
+        if (auto self = weak_self.lock()) {
+            self->writable_armed_ = false;
+            self->CheckWritable_();
+        }
+    });
+}
+
+void ResponseWriter::CheckWritable_() {
+    if (!writable_callback_) {
+        return;
+    }
+    if (IsWritable() || !IsOpen()) {
+        auto cb = std::move(writable_callback_);
+        writable_callback_ = nullptr;
+        cb();
+    } else if (!writable_armed_) {
+        // 连接输出已降到低水位，但 HTTP/2 流仍有字节等待窗口：等下一次写出
+        ArmWritable_();
+    }
+}
+
+void ResponseWriter::AbortIfUnfinished_() {
+    if (!finished_) {
+        Abort(Error(WebError::kStateError, "Response writer released before End"));
+    }
+}
+
+void ResponseWriter::Finish_(const Error& result) {
+    if (finish_callback_) {
+        auto cb = std::move(finish_callback_);
+        finish_callback_ = nullptr;
+        cb(status_code_, body_bytes_, result);
+    }
+}
+
+// ============================================================================
+// Http1ResponseWriter
+// ============================================================================
+
+std::shared_ptr<Http1ResponseWriter> Http1ResponseWriter::Create(std::shared_ptr<Connection> conn,
+                                                                 const HttpRequest& request) {
+    bool head_only = request.GetMethod() == "HEAD";
+    bool http10 = request.GetVersion() == "HTTP/1.0";
+    return std::shared_ptr<Http1ResponseWriter>(
+        new Http1ResponseWriter(std::move(conn), head_only, request.IsKeepAlive(), http10));
+}
+
+Http1ResponseWriter::Http1ResponseWriter(std::shared_ptr<Connection> conn, bool head_only, bool keep_alive,
+                                         bool http10)
+    : ResponseWriter(std::move(conn), head_only), keep_alive_(keep_alive), http10_(http10) {
+    conn_->BeginStreamingResponse();
+}
+
+Http1ResponseWriter::~Http1ResponseWriter() {
+    AbortIfUnfinished_();
+}
+
+Error Http1ResponseWriter::SendHead_(const Headers& headers) {
+    std::string head = "HTTP/1.1 " + std::to_string(status_code_) + " " +
+                       HttpResponse::GetStatusText(status_code_) + "\r\n";
+    for (const auto& [name, value] : headers) {
+        if (!IsFramingHeader(ToLower(name))) {
+            head += name + ": " + value + "\r\n";
+        }
+    }
+    bool bodyless_status = status_code_ < 200 || status_code_ == 204 || status_code_ == 304;
+    if (!bodyless_status && content_length_ < 0) {
+        if (http10_) {
+            // HTTP/1.0 不支持 chunked：响应体以关闭连接结束
+            keep_alive_ = head_only_ && keep_alive_;
+        } else {
+            head += "Transfer-Encoding: chunked\r\n";
+            chunked_ = !head_only_;
+        }
+    }
+    head += keep_alive_ ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+
+    BufferChain chain;
+    chain.Append(std::move(head));
+    conn_->SendChain(chain);
+    return Error::Success();
+}
+
+Error Http1ResponseWriter::SendBody_(std::string&& data) {
+    BufferChain chain;
+    if (!chunked_) {
+        chain.Append(std::move(data));
+    } else {
+        char size_line[24];
+        int n = std::snprintf(size_line, sizeof(size_line), "%zx\r\n", data.size());
+        if (data.size() <= kCoalesceLimit) {
+            data.insert(0, size_line, static_cast<size_t>(n));
+            data.append("\r\n", 2);
+            chain.Append(std::move(data));
+        } else {
+            chain.Append(std::string(size_line, static_cast<size_t>(n)));
+            chain.Append(std::move(data));
+            chain.Append(std::string("\r\n", 2));
+        }
+    }
+    conn_->SendChain(chain);
+    return IsOpen_() ? Error::Success() : Error(WebError::kStateError, "Response stream closed");
+}
+
+Error Http1ResponseWriter::SendEnd_() {
+    if (chunked_) {
+        BufferChain chain;
+        chain.Append(std::string(kLastChunk, sizeof(kLastChunk) - 1));
+        conn_->SendChain(chain);
+    }
+    conn_->EndStreamingResponse();
+    if (!keep_alive_) {
+        conn_->Shutdown();
+    }
+    return Error::Success();
+}
+
+void Http1ResponseWriter::SendAbort_(const Error& reason) {
+    if (IsOpen_()) {
+        if (!head_sent_) {
+            head_sent_ = true;
+            status_code_ = 500;
+            BufferChain chain;
+            chain.Append(std::string("HTTP/1.1 500 Internal Server Error\r\n"
+                                     "Content-Length: 0\r\nConnection: close\r\n\r\n"));
+            conn_->SendChain(chain);
+            conn_->Shutdown();
+        } else {
+            // 响应体已部分发出，只能关闭连接让客户端得知响应不完整
+            conn_->Close(reason);
+        }
+    }
+    conn_->EndStreamingResponse();
+}
+
+bool Http1ResponseWriter::IsOpen_() const {
+    return conn_->IsConnected();
+}
+
+size_t Http1ResponseWriter::Backlog_() const {
+    return conn_->GetOutputBytes();
+}
+
+// ============================================================================
+// Http2ResponseWriter
+// ============================================================================
+
+std::shared_ptr<Http2ResponseWriter> Http2ResponseWriter::Create(std::shared_ptr<Connection> conn,
+                                                                 std::shared_ptr<http2::H2Stream> stream,
+                                                                 bool head_only) {
+    std::shared_ptr<Http2ResponseWriter> writer(
+        new Http2ResponseWriter(std::move(conn), std::move(stream), head_only));
+    // 流被对端重置时，等待可写的生产者在下一轮得知（流对象被本 writer 引用，不会被复用）
+    std::weak_ptr<ResponseWriter> weak_writer = writer;
+    EventLoop* loop = writer->conn_->GetLoop();
+    writer->stream_->SetCloseCallback([weak_writer, loop](uint32_t /*error_code*/) {
+        loop->QueueInLoop([weak_writer]() {
+            if (auto self = std::static_pointer_cast<Http2ResponseWriter>(weak_writer.lock())) {
+                self->CheckWritable_();
+            }
+        });
+    });
+    return writer;
+}
+
+Http2ResponseWriter::Http2ResponseWriter(std::shared_ptr<Connection> conn, std::shared_ptr<http2::H2Stream> stream,
+                                         bool head_only)
+    : ResponseWriter(std::move(conn), head_only), stream_(std::move(stream)) {}
+
+Http2ResponseWriter::~Http2ResponseWriter() {
+    AbortIfUnfinished_();
+    stream_->SetCloseCallback(nullptr);
+}
+
+Error Http2ResponseWriter::SendHead_(const Headers& headers) {
+    http2::H2Stream::Headers h2_headers;
+    h2_headers[":status"] = std::to_string(status_code_);
+    for (const auto& [name, value] : headers) {
+        std::string lower = ToLower(name);
+        if (!IsFramingHeader(lower)) {
+            h2_headers[lower] = value;
+        }
+    }
+    return stream_->SendHeaders(h2_headers, no_body_);
+}
+
+Error Http2ResponseWriter::SendBody_(std::string&& data) {
+    return stream_->SendData(std::move(data), false);
+}
+
+Error Http2ResponseWriter::SendEnd_() {
+    if (no_body_) {
+        return Error::Success();   // END_STREAM 已随 HEADERS 发出
+    }
+    return stream_->SendData(std::string(), true);
+}
+
+void Http2ResponseWriter::SendAbort_(const Error& /*reason*/) {
+    if (!IsOpen_()) {
+        return;
+    }
+    if (!head_sent_) {
+        head_sent_ = true;
+        status_code_ = 500;
+        stream_->SendHeaders({{":status", "500"}, {"content-length", "0"}}, true);
+    } else {
+        stream_->SendRstStream(kH2InternalError);
+    }
+}
+
+bool Http2ResponseWriter::IsOpen_() const {
+    if (!conn_->IsConnected()) {
+        return false;
+    }
+    // 无响应体时 END_STREAM 已随 HEADERS 发出，流不再可写，但响应尚未由 End 结束
+    return (head_sent_ && no_body_) || stream_->IsWritable();
+}
+
+size_t Http2ResponseWriter::Backlog_() const {
+    return conn_->GetOutputBytes() + stream_->GetPendingBytes();
+}
+
+} // namespace tinywebserver
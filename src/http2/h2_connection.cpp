@@ -1,6 +1,7 @@
 #include "http2/h2_connection.h"
 #include "http2/h2_stream.h"
 #include "Logger.h"
+#include <algorithm>
 #include <cstring>
 
 namespace tinywebserver {
@@ -10,21 +11,70 @@ namespace {
     // HTTP/2 客户端连接前言（RFC 7540 Section 3.5）
     constexpr char CLIENT_PREFACE[] = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
     constexpr size_t CLIENT_PREFACE_LEN = 24;
+
+    // 帧头长度与流控制窗口上限
+    constexpr size_t FRAME_HEADER_LEN = 9;
+    constexpr int64_t MAX_WINDOW_SIZE = 0x7FFFFFFF;
+
+    // stride 调度：虚拟时间增量 = 帧长（含帧头）* kStrideScale / 权重
+    constexpr uint64_t kStrideScale = 256;
+
+    uint32_t ReadUint32(const uint8_t* p) {
+        return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+               (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+    }
+
+    // HTTP2-Settings 头部使用 base64url 编码（RFC 4648 Section 5），允许省略填充
+    bool DecodeBase64Url(const std::string& input, std::vector<uint8_t>& out) {
+        uint32_t buffer = 0;
+        int bits = 0;
+        for (char c : input) {
+            int value;
+            if (c >= 'A' && c <= 'Z') value = c - 'A';
+            else if (c >= 'a' && c <= 'z') value = c - 'a' + 26;
+            else if (c >= '0' && c <= '9') value = c - '0' + 52;
+            else if (c == '-' || c == '+') value = 62;
+            else if (c == '_' || c == '/') value = 63;
+            else if (c == '=') break;
+            else return false;
+
+            buffer = (buffer << 6) | static_cast<uint32_t>(value);
+            bits += 6;
+            if (bits >= 8) {
+                bits -= 8;
+                out.push_back(static_cast<uint8_t>((buffer >> bits) & 0xFF));
+            }
+        }
+        return true;
+    }
 } // namespace
 
 H2Connection::H2Connection(int fd, bool is_server)
     : fd_(fd),
       is_server_(is_server),
       state_(H2ConnectionState::H2_IDLE),
-      preface_remaining_(is_server ? CLIENT_PREFACE_LEN : 0) {
+      settings_sent_(false),
+      preface_remaining_(is_server ? CLIENT_PREFACE_LEN : 0),
+      batching_output_(false),
+      hpack_decoder_(H2Settings::HEADER_TABLE_SIZE),
+      hpack_encoder_(H2Settings::HEADER_TABLE_SIZE),
+      continuation_stream_id_(0),
+      continuation_end_stream_(false),
+      pending_priority_{},
+      has_pending_priority_(false),
+      conn_send_window_(H2Settings::INITIAL_WINDOW_SIZE),
+      conn_recv_window_(H2Settings::INITIAL_WINDOW_SIZE),
+      max_request_body_size_(65536),
+      schedule_clock_(0),
+      scheduling_(false),
+      last_peer_stream_id_(0),
+      goaway_error_code_(H2_NO_ERROR),
+      upgrade_dispatch_pending_(false) {
 
     LOG_INFO("HTTP/2 connection created fd=%d, is_server=%s",
              fd_, is_server ? "true" : "false");
 
-    if (is_server) {
-        // 服务器等待客户端前言
-        read_buffer_.reserve(4096);
-    } else {
+    if (!is_server) {
         // 客户端需要发送前言
         // TODO: 发送客户端前言
         TransitionState(H2ConnectionState::H2_PREFACE_SENT, "Client connection");
@@ -36,59 +86,93 @@ H2Connection::~H2Connection() {
     LOG_DEBUG("HTTP/2 connection destroyed fd=%d", fd_);
 }
 
-Error H2Connection::ProcessData(const uint8_t* data, size_t len) {
+Error H2Connection::ProcessData(const uint8_t* data, size_t len, size_t& consumed) {
+    consumed = 0;
     if (IsClosed()) {
         return Error(WebError::kProtocolError, "Connection is closed");
     }
 
+    // 本批输入产生的帧（SETTINGS ACK、WINDOW_UPDATE、响应等）处理完后一次交出
+    batching_output_ = true;
+    Error result = Error::Success();
+
     // 如果还在等待前言，先处理前言
-    if (state_ == H2ConnectionState::H2_IDLE && is_server_) {
+    if (preface_remaining_ > 0 && is_server_) {
+        size_t before = preface_remaining_;
         if (!ProcessPreface(data, len)) {
-            // 前言不完整或错误
-            return Error(WebError::kProtocolError, "Invalid HTTP/2 preface");
+            // 前言错误
+            result = ConnectionError(H2_PROTOCOL_ERROR, "Invalid HTTP/2 preface");
+        } else {
+            // 消耗本次比较过的前言字节
+            size_t preface_consumed = before - preface_remaining_;
+            consumed = preface_consumed;
+            data += preface_consumed;
+            len -= preface_consumed;
+            // h2c 升级：收到客户端前言后再响应流 1，避免 101 之后的数据
+            // 在客户端切换协议前堆积（部分客户端对这段数据的缓冲有上限）
+            if (preface_remaining_ == 0 && upgrade_dispatch_pending_) {
+                upgrade_dispatch_pending_ = false;
+                if (auto stream = FindStream(1)) {
+                    DispatchRequest(stream);
+                }
+            }
         }
-        // 前言已处理，消耗前言字节
-        size_t preface_consumed = CLIENT_PREFACE_LEN - preface_remaining_;
-        data += preface_consumed;
-        len -= preface_consumed;
     }
 
-    // 将剩余数据添加到缓冲区
-    read_buffer_.insert(read_buffer_.end(), data, data + len);
+    if (result.IsSuccess() && preface_remaining_ == 0) {
+        size_t frames_consumed = 0;
+        result = ProcessFrames(data, len, frames_consumed);
+        consumed += frames_consumed;
+    }
 
-    // 处理缓冲区中的完整帧
-    while (!read_buffer_.empty()) {
-        if (read_buffer_.size() < 9) {
-            // 帧头不完整，等待更多数据
-            break;
-        }
+    // 本批新响应与 WINDOW_UPDATE / SETTINGS 放开的流统一调度
+    if (result.IsSuccess()) {
+        ScheduleData();
+    }
+
+    batching_output_ = false;
+    FlushOutput();
+    return result;
+}
+
+Error H2Connection::ProcessFrames(const uint8_t* data, size_t len, size_t& consumed) {
+    // 帧直接在调用方缓冲区中解析，HandleFrame 拿到的负载指针指向原数据
+    size_t offset = 0;
+    Error result = Error::Success();
+    while (len - offset >= FRAME_HEADER_LEN) {
+        const uint8_t* frame = data + offset;
 
         // 解析帧头
-        auto header_opt = H2FrameParser::ParseHeader(read_buffer_.data(), read_buffer_.size());
+        auto header_opt = H2FrameParser::ParseHeader(frame, FRAME_HEADER_LEN);
         if (!header_opt) {
-            return Error(WebError::kProtocolError, "Failed to parse HTTP/2 frame header");
+            result = ConnectionError(H2_PROTOCOL_ERROR, "Failed to parse HTTP/2 frame header");
+            break;
         }
 
         const auto& header = *header_opt;
-        size_t frame_size = 9 + header.length;
+        if (header.length > settings_.max_frame_size) {
+            result = ConnectionError(H2_FRAME_SIZE_ERROR,
+                                     "HTTP/2 frame exceeds SETTINGS_MAX_FRAME_SIZE: " +
+                                     std::to_string(header.length));
+            break;
+        }
 
-        if (read_buffer_.size() < frame_size) {
+        size_t frame_size = FRAME_HEADER_LEN + header.length;
+        if (len - offset < frame_size) {
             // 帧负载不完整，等待更多数据
             break;
         }
 
         // 处理完整帧
-        const uint8_t* payload = read_buffer_.data() + 9;
-        Error err = HandleFrame(header, payload);
-        if (!err.IsSuccess()) {
-            return err;
+        result = HandleFrame(header, frame + FRAME_HEADER_LEN);
+        if (!result.IsSuccess()) {
+            break;
         }
-
-        // 从缓冲区移除已处理的帧
-        read_buffer_.erase(read_buffer_.begin(), read_buffer_.begin() + frame_size);
+        offset += frame_size;
     }
 
-    return Error::Success();
+    consumed = offset;
+    return result;
 }
 
 bool H2Connection::ProcessPreface(const uint8_t* data, size_t len) {
@@ -107,19 +191,10 @@ bool H2Connection::ProcessPreface(const uint8_t* data, size_t len) {
 
     if (preface_remaining_ == 0) {
         // 前言处理完成，发送 SETTINGS 帧并进入 OPEN 状态
+        // （h2c 升级时 SETTINGS 已随 101 响应发出）
         TransitionState(H2ConnectionState::H2_OPEN, "Preface completed");
 
-        // 发送初始 SETTINGS 帧
-        std::vector<std::pair<uint16_t, uint32_t>> initial_settings = {
-            {1, settings_.header_table_size},
-            {2, settings_.enable_push},
-            {3, settings_.max_concurrent_streams},
-            {4, settings_.initial_window_size},
-            {5, settings_.max_frame_size},
-            {6, settings_.max_header_list_size}
-        };
-
-        auto err = SendSettings(initial_settings);
+        auto err = SendInitialSettings();
         if (!err.IsSuccess()) {
             LOG_ERROR("Failed to send initial SETTINGS frame: %s", err.ToString().c_str());
         }
@@ -128,6 +203,42 @@ bool H2Connection::ProcessPreface(const uint8_t* data, size_t len) {
     return true;
 }
 
+Error H2Connection::AcceptUpgrade(const std::string& http2_settings,
+                                  const std::unordered_map<std::string, std::string>& request_headers) {
+    if (!is_server_ || state_ != H2ConnectionState::H2_IDLE) {
+        return Error(WebError::kProtocolError, "HTTP/2 upgrade in invalid connection state");
+    }
+
+    std::vector<uint8_t> payload;
+    if (!DecodeBase64Url(http2_settings, payload)) {
+        return Error(WebError::kProtocolError, "Invalid HTTP2-Settings header");
+    }
+    auto settings_opt = H2FrameParser::ParseSettingsPayload(payload.data(), payload.size());
+    if (!settings_opt) {
+        return Error(WebError::kProtocolError, "Invalid HTTP2-Settings payload");
+    }
+    auto err = ApplyPeerSettings(*settings_opt);
+    if (!err.IsSuccess()) {
+        return err;
+    }
+
+    TransitionState(H2ConnectionState::H2_OPEN, "HTTP/1.1 Upgrade: h2c");
+    err = SendInitialSettings();
+    if (!err.IsSuccess()) {
+        return err;
+    }
+
+    // 升级请求即流 1，请求已完整到达（半关闭-远端）
+    last_peer_stream_id_ = 1;
+    auto stream = GetOrCreateStream(1);
+    err = stream->HandleHeaders(request_headers, true);
+    if (!err.IsSuccess()) {
+        return err;
+    }
+    upgrade_dispatch_pending_ = true;
+    return Error::Success();
+}
+
 Error H2Connection::HandleFrame(const H2FrameHeader& header, const uint8_t* payload) {
     LOG_DEBUG("Handling HTTP/2 frame: type=%s, stream_id=%u, length=%u, flags=0x%02x",
               header.TypeName().c_str(), header.stream_id, header.length, header.flags);
@@ -138,6 +249,13 @@ Error H2Connection::HandleFrame(const H2FrameHeader& header, const uint8_t* payl
         return length_err;
     }
 
+    // 头部块未结束时只允许同一流的 CONTINUATION（RFC 7540 Section 6.10）
+    if (continuation_stream_id_ != 0 &&
+        static_cast<H2FrameType>(header.type) != H2FrameType::CONTINUATION) {
+        return ConnectionError(H2_PROTOCOL_ERROR, "Expected CONTINUATION frame for stream " +
+                               std::to_string(continuation_stream_id_));
+    }
+
     // 根据帧类型分发处理
     switch (static_cast<H2FrameType>(header.type)) {
         case H2FrameType::DATA:
@@ -169,39 +287,94 @@ Error H2Connection::HandleFrame(const H2FrameHeader& header, const uint8_t* payl
 
 Error H2Connection::SendFrame(H2FrameType type, uint8_t flags, uint32_t stream_id,
                               const std::vector<uint8_t>& payload) {
+    return SendFrame(type, flags, stream_id, payload.data(), payload.size());
+}
+
+Error H2Connection::SendFrame(H2FrameType type, uint8_t flags, uint32_t stream_id,
+                              const uint8_t* payload, size_t len) {
     if (IsClosed()) {
         return Error(WebError::kProtocolError, "Connection is closed");
     }
+    if (!frame_callback_) {
+        LOG_ERROR("No frame callback set for HTTP/2 connection fd=%d", fd_);
+        return Error(WebError::kInternalError, "No frame callback");
+    }
 
-    H2FrameHeader header;
-    header.length = static_cast<uint32_t>(payload.size());
-    header.type = static_cast<uint8_t>(type);
-    header.flags = flags;
-    header.stream_id = stream_id;
-    header.reserved = 0;
-
+    H2FrameHeader header = MakeFrameHeader(type, flags, stream_id, len);
     auto err = header.Validate();
     if (!err.IsSuccess()) {
         return err;
     }
 
-    // 序列化帧头
-    auto header_bytes = H2FrameParser::SerializeHeader(header);
+    // 帧头与负载写入同一个节点
+    std::string frame(FRAME_HEADER_LEN + len, '\0');
+    H2FrameParser::SerializeHeader(header, reinterpret_cast<uint8_t*>(&frame[0]));
+    if (len > 0) {
+        std::memcpy(&frame[FRAME_HEADER_LEN], payload, len);
+    }
+    out_frames_.Append(std::move(frame));
 
-    // 通过回调发送帧
-    if (frame_callback_) {
-        frame_callback_(header, payload);
-    } else {
+    LOG_DEBUG("Sent HTTP/2 frame: type=%s, stream_id=%u, length=%zu",
+              header.TypeName().c_str(), stream_id, len);
+
+    if (!batching_output_) {
+        FlushOutput();
+    }
+    return Error::Success();
+}
+
+Error H2Connection::SendDataFrame(uint8_t flags, uint32_t stream_id, BufferNode payload) {
+    if (IsClosed()) {
+        return Error(WebError::kProtocolError, "Connection is closed");
+    }
+    if (!frame_callback_) {
         LOG_ERROR("No frame callback set for HTTP/2 connection fd=%d", fd_);
         return Error(WebError::kInternalError, "No frame callback");
     }
 
-    LOG_DEBUG("Sent HTTP/2 frame: type=%s, stream_id=%u, length=%zu",
-              header.TypeName().c_str(), stream_id, payload.size());
+    size_t len = payload.LeftSize();
+    H2FrameHeader header = MakeFrameHeader(H2FrameType::DATA, flags, stream_id, len);
+    auto err = header.Validate();
+    if (!err.IsSuccess()) {
+        return err;
+    }
+
+    // 9 字节帧头单独成节点，负载节点引用流的发送缓冲区或 mmap 映射区
+    std::string frame_header(FRAME_HEADER_LEN, '\0');
+    H2FrameParser::SerializeHeader(header, reinterpret_cast<uint8_t*>(&frame_header[0]));
+    out_frames_.Append(std::move(frame_header));
+    out_frames_.Append(std::move(payload));
+
+    LOG_DEBUG("Sent HTTP/2 DATA frame: stream_id=%u, length=%zu", stream_id, len);
 
+    if (!batching_output_) {
+        FlushOutput();
+    }
     return Error::Success();
 }
 
+H2FrameHeader H2Connection::MakeFrameHeader(H2FrameType type, uint8_t flags, uint32_t stream_id,
+                                            size_t len) const {
+    H2FrameHeader header;
+    header.length = static_cast<uint32_t>(len);
+    header.type = static_cast<uint8_t>(type);
+    header.flags = flags;
+    header.stream_id = stream_id;
+    header.reserved = 0;
+    return header;
+}
+
+void H2Connection::FlushOutput() {
+    if (out_frames_.IsEmpty()) {
+        return;
+    }
+    if (frame_callback_) {
+        frame_callback_(out_frames_);
+    }
+    // 回调未取走的帧（例如底层连接已关闭）直接丢弃
+    out_frames_.Clear();
+}
+
 Error H2Connection::SendSettings(const std::vector<std::pair<uint16_t, uint32_t>>& settings,
                                  bool ack) {
     std::vector<uint8_t> payload;
@@ -256,15 +429,16 @@ void H2Connection::Close(const Error& reason) {
 
     LOG_INFO("Closing HTTP/2 connection fd=%d: %s", fd_, reason.ToString().c_str());
 
-    // 发送 GOAWAY 帧（如果连接已打开）
+    // 发送 GOAWAY 帧（如果连接已打开），错误码来自最近一次连接错误，默认 NO_ERROR
     if (IsOpen()) {
-        SendGoaway(0, 1, {}); // 使用默认错误码 NO_ERROR (0x0)
+        SendGoaway(last_peer_stream_id_, goaway_error_code_, {});
     }
 
     TransitionState(H2ConnectionState::H2_CLOSED, reason.ToString());
 
     // 关闭所有流
     CloseAllStreams(reason);
+    ready_streams_.clear();
 
     // 通知上层
     if (close_callback_) {
@@ -273,8 +447,7 @@ void H2Connection::Close(const Error& reason) {
 }
 
 size_t H2Connection::GetActiveStreamCount() const {
-    std::lock_guard<std::mutex> lock(streams_mutex_);
-    return streams_.size();
+    return streams_.Size();
 }
 
 void H2Connection::UpdateSettings(const H2Settings& new_settings) {
@@ -323,57 +496,507 @@ bool H2Connection::CanTransition(H2ConnectionState new_state) const {
 }
 
 std::shared_ptr<H2Stream> H2Connection::GetOrCreateStream(uint32_t stream_id) {
-    std::lock_guard<std::mutex> lock(streams_mutex_);
-
-    auto it = streams_.find(stream_id);
-    if (it != streams_.end()) {
-        return it->second;
+    if (const auto& existing = streams_.Find(stream_id)) {
+        return existing;
     }
 
-    // 创建新流
-    auto stream = std::make_shared<H2Stream>(stream_id, this);
-    streams_[stream_id] = stream;
+    // 新流：发送窗口取对端设置，接收窗口取本端设置。优先复用池中
+    // 已无外部引用的流对象（连同其头部表与请求体缓冲区的容量）
+    std::shared_ptr<H2Stream> stream;
+    for (auto it = stream_pool_.rbegin(); it != stream_pool_.rend(); ++it) {
+        if (it->use_count() == 1) {
+            stream = std::move(*it);
+            stream_pool_.erase(std::next(it).base());
+            stream->Reset(stream_id, peer_settings_.initial_window_size, settings_.initial_window_size);
+            break;
+        }
+    }
+    if (!stream) {
+        stream = std::make_shared<H2Stream>(stream_id, this,
+                                            peer_settings_.initial_window_size,
+                                            settings_.initial_window_size);
+    }
+    streams_.Insert(stream_id, stream);
     LOG_DEBUG("Created new HTTP/2 stream id=%u, total streams=%zu",
-              stream_id, streams_.size());
+              stream_id, streams_.Size());
 
     return stream;
 }
 
+std::shared_ptr<H2Stream> H2Connection::FindStream(uint32_t stream_id) const {
+    return streams_.Find(stream_id);
+}
+
 void H2Connection::RemoveStream(uint32_t stream_id) {
-    std::lock_guard<std::mutex> lock(streams_mutex_);
-    streams_.erase(stream_id);
+    auto stream = streams_.Erase(stream_id);
+    if (stream && stream_pool_.size() < kStreamPoolSize) {
+        stream_pool_.push_back(std::move(stream));
+    }
     LOG_DEBUG("Removed HTTP/2 stream id=%u, remaining streams=%zu",
-              stream_id, streams_.size());
+              stream_id, streams_.Size());
+}
+
+void H2Connection::OnStreamClosed(uint32_t stream_id) {
+    ready_streams_.erase(std::remove_if(ready_streams_.begin(), ready_streams_.end(),
+                                        [stream_id](const std::shared_ptr<H2Stream>& stream) {
+                                            return stream->GetStreamId() == stream_id;
+                                        }),
+                         ready_streams_.end());
+    RemoveStream(stream_id);
 }
 
 void H2Connection::CloseAllStreams([[maybe_unused]] const Error& reason) {
-    std::lock_guard<std::mutex> lock(streams_mutex_);
-    for (auto& [stream_id, stream] : streams_) {
+    // 关闭回调可能回到连接，先拷出再逐个关闭
+    for (const auto& stream : streams_.Snapshot()) {
         stream->Close(1); // 使用默认错误码 INTERNAL_ERROR
     }
-    streams_.clear();
+    streams_.Clear();
+}
+
+Error H2Connection::SendInitialSettings() {
+    if (settings_sent_) {
+        return Error::Success();
+    }
+    settings_sent_ = true;
+
+    // 服务器不通告 SETTINGS_ENABLE_PUSH（RFC 9113 Section 6.5.2）
+    std::vector<std::pair<uint16_t, uint32_t>> initial_settings = {
+        {1, settings_.header_table_size},
+        {3, settings_.max_concurrent_streams},
+        {4, settings_.initial_window_size},
+        {5, settings_.max_frame_size},
+        {6, settings_.max_header_list_size}
+    };
+    return SendSettings(initial_settings);
 }
 
-// 帧类型处理实现（占位符）
-Error H2Connection::HandleDataFrame(const H2FrameHeader& header, [[maybe_unused]] const uint8_t* payload) {
+Error H2Connection::ApplyPeerSettings(const std::vector<std::pair<uint16_t, uint32_t>>& settings) {
+    for (const auto& [identifier, value] : settings) {
+        switch (identifier) {
+            case 1: // SETTINGS_HEADER_TABLE_SIZE
+                peer_settings_.header_table_size = value;
+                hpack_encoder_.SetMaxDynamicTableSize(value);
+                break;
+            case 2: // SETTINGS_ENABLE_PUSH
+                if (value > 1) {
+                    return ConnectionError(H2_PROTOCOL_ERROR, "Invalid SETTINGS_ENABLE_PUSH value");
+                }
+                peer_settings_.enable_push = value;
+                break;
+            case 3: // SETTINGS_MAX_CONCURRENT_STREAMS
+                peer_settings_.max_concurrent_streams = value;
+                break;
+            case 4: { // SETTINGS_INITIAL_WINDOW_SIZE
+                if (value > MAX_WINDOW_SIZE) {
+                    return ConnectionError(H2_FLOW_CONTROL_ERROR, "Invalid SETTINGS_INITIAL_WINDOW_SIZE value");
+                }
+                // 按差值调整所有已打开流的发送窗口（RFC 7540 Section 6.9.2）
+                int64_t delta = static_cast<int64_t>(value) - peer_settings_.initial_window_size;
+                peer_settings_.initial_window_size = value;
+                for (const auto& stream : streams_.Snapshot()) {
+                    if (!stream->AdjustSendWindow(delta).IsSuccess()) {
+                        return ConnectionError(H2_FLOW_CONTROL_ERROR, "Stream window overflow on SETTINGS");
+                    }
+                }
+                break;
+            }
+            case 5: // SETTINGS_MAX_FRAME_SIZE
+                if (value < H2Settings::MAX_FRAME_SIZE || value > 16777215) {
+                    return ConnectionError(H2_PROTOCOL_ERROR, "Invalid SETTINGS_MAX_FRAME_SIZE value");
+                }
+                peer_settings_.max_frame_size = value;
+                break;
+            case 6: // SETTINGS_MAX_HEADER_LIST_SIZE
+                peer_settings_.max_header_list_size = value;
+                break;
+            default:
+                LOG_WARN("Unknown SETTINGS identifier: %u", identifier);
+                // 根据 RFC 7540 Section 6.5.2，应忽略未知设置项
+                break;
+        }
+    }
+    return Error::Success();
+}
+
+Error H2Connection::SendWindowUpdate(uint32_t stream_id, uint32_t increment) {
+    std::vector<uint8_t> payload = {
+        static_cast<uint8_t>((increment >> 24) & 0x7F),
+        static_cast<uint8_t>((increment >> 16) & 0xFF),
+        static_cast<uint8_t>((increment >> 8) & 0xFF),
+        static_cast<uint8_t>(increment & 0xFF)
+    };
+    return SendFrame(H2FrameType::WINDOW_UPDATE, 0, stream_id, payload);
+}
+
+Error H2Connection::SendHeaderBlock(uint32_t stream_id,
+                                    const std::unordered_map<std::string, std::string>& headers,
+                                    bool end_stream) {
+    // 伪头部必须位于普通头部之前（RFC 7540 Section 8.1.2.1）
+    std::vector<HpackHeader> fields;
+    fields.reserve(headers.size());
+    for (int pass = 0; pass < 2; ++pass) {
+        for (const auto& [name, value] : headers) {
+            bool pseudo = !name.empty() && name[0] == ':';
+            if (pseudo == (pass == 0)) {
+                fields.push_back({name, value});
+            }
+        }
+    }
+    std::vector<uint8_t> block;
+    hpack_encoder_.Encode(fields, block);
+
+    // 超过对端 MAX_FRAME_SIZE 的头部块拆分为 HEADERS + CONTINUATION
+    size_t max_frame = peer_settings_.max_frame_size;
+    size_t offset = 0;
+    bool first = true;
+    do {
+        size_t chunk = std::min(max_frame, block.size() - offset);
+        bool last = offset + chunk == block.size();
+        uint8_t flags = last ? H2FrameFlags::END_HEADERS : 0;
+        if (first && end_stream) {
+            flags |= H2FrameFlags::END_STREAM;
+        }
+        auto err = SendFrame(first ? H2FrameType::HEADERS : H2FrameType::CONTINUATION,
+                             flags, stream_id, block.data() + offset, chunk);
+        if (!err.IsSuccess()) {
+            return err;
+        }
+        offset += chunk;
+        first = false;
+    } while (offset < block.size());
+
+    return Error::Success();
+}
+
+Error H2Connection::MarkStreamReady(uint32_t stream_id) {
+    auto stream = FindStream(stream_id);
+    if (!stream || stream->IsClosed()) {
+        return Error::Success();
+    }
+
+    if (std::find(ready_streams_.begin(), ready_streams_.end(), stream) == ready_streams_.end()) {
+        ready_streams_.push_back(stream);
+    }
+
+    // ProcessData 期间（包括请求回调内生成的响应）统一在处理结束后调度
+    if (batching_output_) {
+        return Error::Success();
+    }
+    return ScheduleData();
+}
+
+void H2Connection::OnOutputDrained() {
+    if (!IsClosed()) {
+        ScheduleData();
+    }
+}
+
+bool H2Connection::HasPendingOutput() const {
+    for (const auto& stream : ready_streams_) {
+        if (stream->CanSend(conn_send_window_)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t H2Connection::QueuedOutputBytes() const {
+    size_t queued = out_frames_.TotalBytes();
+    if (output_size_callback_) {
+        queued += output_size_callback_();
+    }
+    return queued;
+}
+
+Error H2Connection::ScheduleData() {
+    if (scheduling_ || IsClosed()) {
+        return Error::Success();
+    }
+    scheduling_ = true;
+    bool was_batching = batching_output_;
+    batching_output_ = true;
+
+    // 被 GOAWAY 等路径直接关闭的流不会经过 OnStreamClosed，先清理
+    ready_streams_.erase(std::remove_if(ready_streams_.begin(), ready_streams_.end(),
+                                        [](const std::shared_ptr<H2Stream>& stream) {
+                                            return !stream->HasPendingData();
+                                        }),
+                         ready_streams_.end());
+
+    size_t quantum = std::min<size_t>(peer_settings_.max_frame_size, kDataFrameQuantum);
+    Error result = Error::Success();
+    while (!ready_streams_.empty() && QueuedOutputBytes() < kOutputHighWatermark) {
+        // 选虚拟时间最小的可发送流；就绪集合很小（受 MAX_CONCURRENT_STREAMS 限制），线性扫描即可
+        std::shared_ptr<H2Stream> next;
+        for (const auto& stream : ready_streams_) {
+            if (!stream->CanSend(conn_send_window_)) {
+                continue;
+            }
+            // 新就绪或刚解除窗口阻塞的流从当前虚拟时间起步，不能凭旧值连续插队
+            if (stream->GetSchedulePass() < schedule_clock_) {
+                stream->SetSchedulePass(schedule_clock_);
+            }
+            if (!next || stream->GetSchedulePass() < next->GetSchedulePass()) {
+                next = stream;
+            }
+        }
+        if (!next) {
+            break;  // 全部被流控制窗口挡住，等待 WINDOW_UPDATE
+        }
+
+        size_t sent = 0;
+        result = next->SendNextFrame(conn_send_window_, quantum, sent);
+        schedule_clock_ = next->GetSchedulePass();
+        next->SetSchedulePass(schedule_clock_ +
+                              (sent + FRAME_HEADER_LEN) * kStrideScale / next->GetPriority().weight);
+
+        // 发完（流关闭时 OnStreamClosed 已移除）或出错的流退出就绪集合
+        if (!next->HasPendingData() || !result.IsSuccess()) {
+            ready_streams_.erase(std::remove(ready_streams_.begin(), ready_streams_.end(), next),
+                                 ready_streams_.end());
+        }
+        if (!result.IsSuccess()) {
+            LOG_WARN("HTTP/2 stream %u: failed to send DATA: %s",
+                     next->GetStreamId(), result.ToString().c_str());
+            break;
+        }
+    }
+
+    batching_output_ = was_batching;
+    scheduling_ = false;
+    if (!batching_output_) {
+        FlushOutput();
+    }
+    return result;
+}
+
+Error H2Connection::ConnectionError(uint32_t error_code, const std::string& message) {
+    goaway_error_code_ = error_code;
+    return Error(WebError::kProtocolError, message);
+}
+
+Error H2Connection::ResetStream(uint32_t stream_id, uint32_t error_code) {
+    LOG_DEBUG("Resetting HTTP/2 stream %u, error_code=%u", stream_id, error_code);
+    auto stream = FindStream(stream_id);
+    if (stream) {
+        return stream->SendRstStream(error_code);
+    }
+
+    std::vector<uint8_t> payload = {
+        static_cast<uint8_t>((error_code >> 24) & 0xFF),
+        static_cast<uint8_t>((error_code >> 16) & 0xFF),
+        static_cast<uint8_t>((error_code >> 8) & 0xFF),
+        static_cast<uint8_t>(error_code & 0xFF)
+    };
+    return SendFrame(H2FrameType::RST_STREAM, 0, stream_id, payload);
+}
+
+Error H2Connection::OnHeaderBlockComplete() {
+    uint32_t stream_id = continuation_stream_id_;
+    bool end_stream = continuation_end_stream_;
+    bool has_priority = has_pending_priority_;
+    continuation_stream_id_ = 0;
+    has_pending_priority_ = false;
+
+    // 无论流是否会被拒绝，头部块都必须解码以保持 HPACK 动态表同步
+    H2Stream::Headers headers;
+    auto decode_err = hpack_decoder_.DecodeBlock(
+        header_block_.data(), header_block_.size(), [&headers](const HpackHeaderView& field) {
+            std::string name(field.name);
+            auto it = headers.find(name);
+            if (it == headers.end()) {
+                headers.emplace(std::move(name), std::string(field.value));
+            } else {
+                // 重复字段合并；cookie 按 RFC 7540 Section 8.1.2.5 以 "; " 连接
+                it->second.append(field.name == "cookie" ? "; " : ", ").append(field.value);
+            }
+        });
+    header_block_.clear();
+    if (!decode_err.IsSuccess()) {
+        LOG_WARN("HPACK decoding failed: %s", decode_err.ToString().c_str());
+        return ConnectionError(H2_COMPRESSION_ERROR, "HPACK decoding failed");
+    }
+
+    auto stream = FindStream(stream_id);
+    if (!stream) {
+        if (stream_id <= last_peer_stream_id_) {
+            return ConnectionError(H2_STREAM_CLOSED, "HEADERS on closed stream " + std::to_string(stream_id));
+        }
+        last_peer_stream_id_ = stream_id;
+
+        if (state_ == H2ConnectionState::H2_CLOSING) {
+            return Error::Success(); // 已收到 GOAWAY，不再接受新流
+        }
+        if (GetActiveStreamCount() >= settings_.max_concurrent_streams) {
+            return ResetStream(stream_id, H2_REFUSED_STREAM);
+        }
+        stream = GetOrCreateStream(stream_id);
+    }
+
+    if (has_priority) {
+        auto err = ParsePriority(stream_id, pending_priority_.data());
+        if (!err.IsSuccess() || stream->IsClosed()) {
+            return err;
+        }
+    }
+
+    auto err = stream->HandleHeaders(headers, end_stream);
+    if (!err.IsSuccess()) {
+        LOG_WARN("HTTP/2 stream %u: %s", stream_id, err.ToString().c_str());
+        return ResetStream(stream_id, H2_PROTOCOL_ERROR);
+    }
+
+    if (end_stream) {
+        DispatchRequest(stream);
+    }
+    return Error::Success();
+}
+
+void H2Connection::DispatchRequest(const std::shared_ptr<H2Stream>& stream) {
+    if (stream->GetState() != H2StreamState::HALF_CLOSED_REMOTE) {
+        return; // 已响应或已重置
+    }
+
+    // 请求必须携带 :method、:scheme 与 :path（RFC 7540 Section 8.1.2.3）
+    const auto& headers = stream->GetRequestHeaders();
+    if (headers.count(":method") == 0 || headers.count(":scheme") == 0 || headers.count(":path") == 0) {
+        LOG_WARN("HTTP/2 stream %u: missing request pseudo-header", stream->GetStreamId());
+        ResetStream(stream->GetStreamId(), H2_PROTOCOL_ERROR);
+        return;
+    }
+
+    if (!request_callback_) {
+        ResetStream(stream->GetStreamId(), H2_REFUSED_STREAM);
+        return;
+    }
+    request_callback_(stream);
+}
+
+Error H2Connection::HandleDataFrame(const H2FrameHeader& header, const uint8_t* payload) {
     LOG_DEBUG("Handling DATA frame for stream %u", header.stream_id);
-    // TODO: 实现 DATA 帧处理
+
+    if (header.stream_id == 0) {
+        return ConnectionError(H2_PROTOCOL_ERROR, "DATA frame on stream 0");
+    }
+
+    // 连接级流控制按整帧长度（含填充）计算
+    if (static_cast<int64_t>(header.length) > conn_recv_window_) {
+        return ConnectionError(H2_FLOW_CONTROL_ERROR, "Connection receive window exceeded");
+    }
+    conn_recv_window_ -= header.length;
+    if (conn_recv_window_ < H2Settings::INITIAL_WINDOW_SIZE / 2) {
+        uint32_t increment = static_cast<uint32_t>(H2Settings::INITIAL_WINDOW_SIZE - conn_recv_window_);
+        SendWindowUpdate(0, increment);
+        conn_recv_window_ += increment;
+    }
+
+    const uint8_t* data = payload;
+    size_t len = header.length;
+    if (header.HasFlag(H2FrameFlags::PADDED)) {
+        if (len < 1 || payload[0] >= len) {
+            return ConnectionError(H2_PROTOCOL_ERROR, "Invalid DATA padding");
+        }
+        len -= 1 + payload[0];
+        data += 1;
+    }
+
+    auto stream = FindStream(header.stream_id);
+    if (!stream || !stream->IsReadable()) {
+        if (header.stream_id > last_peer_stream_id_) {
+            return ConnectionError(H2_PROTOCOL_ERROR, "DATA frame on idle stream");
+        }
+        return ResetStream(header.stream_id, H2_STREAM_CLOSED);
+    }
+
+    if (!stream->ConsumeRecvWindow(header.length).IsSuccess()) {
+        return ResetStream(header.stream_id, H2_FLOW_CONTROL_ERROR);
+    }
+
+    if (stream->GetRequestBodyBytes() + len > max_request_body_size_) {
+        LOG_WARN("HTTP/2 stream %u: request body exceeds %llu bytes", header.stream_id,
+                 static_cast<unsigned long long>(max_request_body_size_));
+        // 先给出完整的 413 响应，再以 NO_ERROR 重置流让客户端停止发送（RFC 7540 Section 8.1）
+        stream->SendHeaders({{":status", "413"}, {"content-length", "0"}}, true);
+        return ResetStream(header.stream_id, H2_NO_ERROR);
+    }
+
+    bool end_stream = header.HasFlag(H2FrameFlags::END_STREAM);
+    auto err = stream->HandleData(data, len, end_stream);
+    if (!err.IsSuccess()) {
+        return ResetStream(header.stream_id, H2_STREAM_CLOSED);
+    }
+    // 请求体没有缓存：负载交给数据回调后即丢弃，整帧（含填充）视为已消费
+    stream->MarkRecvConsumed(header.length);
+
+    if (end_stream) {
+        DispatchRequest(stream);
+    } else if (stream->GetRecvWindow() < settings_.initial_window_size / 2 && stream->GetRecvConsumed() > 0) {
+        // 只归还已消费的字节，未被读走的数据继续占用窗口，对端随之停发
+        uint32_t increment = static_cast<uint32_t>(stream->GetRecvConsumed());
+        SendWindowUpdate(header.stream_id, increment);
+        stream->ReleaseRecvWindow(increment);
+    }
     return Error::Success();
 }
 
-Error H2Connection::HandleHeadersFrame(const H2FrameHeader& header, [[maybe_unused]] const uint8_t* payload) {
+Error H2Connection::HandleHeadersFrame(const H2FrameHeader& header, const uint8_t* payload) {
     LOG_DEBUG("Handling HEADERS frame for stream %u", header.stream_id);
-    // TODO: 实现 HEADERS 帧处理
+
+    if (header.stream_id == 0 || (is_server_ && header.stream_id % 2 == 0)) {
+        return ConnectionError(H2_PROTOCOL_ERROR, "Invalid HEADERS stream id " + std::to_string(header.stream_id));
+    }
+
+    const uint8_t* block = payload;
+    size_t len = header.length;
+    uint8_t pad_length = 0;
+    if (header.HasFlag(H2FrameFlags::PADDED)) {
+        if (len < 1) {
+            return ConnectionError(H2_PROTOCOL_ERROR, "HEADERS frame too short for padding");
+        }
+        pad_length = block[0];
+        block += 1;
+        len -= 1;
+    }
+    const uint8_t* priority = nullptr;
+    if (header.HasFlag(H2FrameFlags::PRIORITY)) {
+        // 依赖流（31 位 + 独占标志）与权重，流创建后再应用
+        if (len < 5) {
+            return ConnectionError(H2_PROTOCOL_ERROR, "HEADERS frame too short for priority");
+        }
+        priority = block;
+        block += 5;
+        len -= 5;
+    }
+    if (pad_length > len) {
+        return ConnectionError(H2_PROTOCOL_ERROR, "Invalid HEADERS padding");
+    }
+    len -= pad_length;
+
+    header_block_.assign(block, block + len);
+    continuation_stream_id_ = header.stream_id;
+    continuation_end_stream_ = header.HasFlag(H2FrameFlags::END_STREAM);
+    if (priority) {
+        std::copy(priority, priority + 5, pending_priority_.begin());
+    }
+    has_pending_priority_ = priority != nullptr;
+
+    if (header.HasFlag(H2FrameFlags::END_HEADERS)) {
+        return OnHeaderBlockComplete();
+    }
     return Error::Success();
 }
 
 Error H2Connection::HandleSettingsFrame(const H2FrameHeader& header, const uint8_t* payload) {
     LOG_DEBUG("Handling SETTINGS frame, ACK=%s", header.HasFlag(H2FrameFlags::ACK) ? "true" : "false");
 
+    if (header.stream_id != 0) {
+        return ConnectionError(H2_PROTOCOL_ERROR, "SETTINGS frame must be on stream 0");
+    }
+
     if (header.HasFlag(H2FrameFlags::ACK)) {
         // ACK 帧，无需处理负载
         if (header.length != 0) {
-            return Error(WebError::kProtocolError, "SETTINGS ACK frame must have zero length");
+            return ConnectionError(H2_FRAME_SIZE_ERROR, "SETTINGS ACK frame must have zero length");
         }
         LOG_DEBUG("Received SETTINGS ACK");
         return Error::Success();
@@ -382,38 +1005,16 @@ Error H2Connection::HandleSettingsFrame(const H2FrameHeader& header, const uint8
     // 解析 SETTINGS 负载
     auto settings_opt = H2FrameParser::ParseSettingsPayload(payload, header.length);
     if (!settings_opt) {
-        return Error(WebError::kProtocolError, "Invalid SETTINGS payload");
+        return ConnectionError(H2_FRAME_SIZE_ERROR, "Invalid SETTINGS payload");
     }
 
-    // 应用设置
-    for (const auto& [identifier, value] : *settings_opt) {
-        switch (identifier) {
-            case 1: // SETTINGS_HEADER_TABLE_SIZE
-                settings_.header_table_size = value;
-                break;
-            case 2: // SETTINGS_ENABLE_PUSH
-                settings_.enable_push = value;
-                break;
-            case 3: // SETTINGS_MAX_CONCURRENT_STREAMS
-                settings_.max_concurrent_streams = value;
-                break;
-            case 4: // SETTINGS_INITIAL_WINDOW_SIZE
-                settings_.initial_window_size = value;
-                break;
-            case 5: // SETTINGS_MAX_FRAME_SIZE
-                settings_.max_frame_size = value;
-                break;
-            case 6: // SETTINGS_MAX_HEADER_LIST_SIZE
-                settings_.max_header_list_size = value;
-                break;
-            default:
-                LOG_WARN("Unknown SETTINGS identifier: %u", identifier);
-                // 根据 RFC 7540 Section 6.5.2，应忽略未知设置项
-                break;
-        }
+    // 应用对端设置
+    auto err = ApplyPeerSettings(*settings_opt);
+    if (!err.IsSuccess()) {
+        return err;
     }
 
-    // 发送 ACK
+    // 发送 ACK；初始窗口变大后挂起的流在本批输入处理完后继续调度
     return SendSettings({}, true);
 }
 
@@ -448,61 +1049,127 @@ Error H2Connection::HandleGoawayFrame(const H2FrameHeader& header, const uint8_t
     TransitionState(H2ConnectionState::H2_CLOSING, "Received GOAWAY");
 
     // 关闭所有流ID大于 last_stream_id 的流
-    {
-        std::lock_guard<std::mutex> lock(streams_mutex_);
-        for (auto it = streams_.begin(); it != streams_.end(); ) {
-            if (it->first > last_stream_id) {
-                it->second->Close(error_code);
-                it = streams_.erase(it);
-            } else {
-                ++it;
-            }
+    for (const auto& stream : streams_.Snapshot()) {
+        if (stream->GetStreamId() > last_stream_id) {
+            stream->Close(error_code);
+            RemoveStream(stream->GetStreamId());
         }
     }
 
     return Error::Success();
 }
 
-Error H2Connection::HandleWindowUpdateFrame(const H2FrameHeader& header, [[maybe_unused]] const uint8_t* payload) {
-    LOG_DEBUG("Handling WINDOW_UPDATE frame for stream %u", header.stream_id);
-    // TODO: 实现流控制窗口更新
+Error H2Connection::HandleWindowUpdateFrame(const H2FrameHeader& header, const uint8_t* payload) {
+    uint32_t increment = ReadUint32(payload) & 0x7FFFFFFF;
+    LOG_DEBUG("Handling WINDOW_UPDATE frame for stream %u, increment=%u", header.stream_id, increment);
+
+    if (header.stream_id == 0) {
+        // 连接级窗口
+        if (increment == 0) {
+            return ConnectionError(H2_PROTOCOL_ERROR, "WINDOW_UPDATE with zero increment");
+        }
+        if (conn_send_window_ + increment > MAX_WINDOW_SIZE) {
+            return ConnectionError(H2_FLOW_CONTROL_ERROR, "Connection send window overflow");
+        }
+        conn_send_window_ += increment;
+        return Error::Success();
+    }
+
+    auto stream = FindStream(header.stream_id);
+    if (!stream) {
+        if (header.stream_id > last_peer_stream_id_) {
+            return ConnectionError(H2_PROTOCOL_ERROR, "WINDOW_UPDATE on idle stream");
+        }
+        return Error::Success(); // 流已关闭，忽略
+    }
+    if (increment == 0) {
+        return ResetStream(header.stream_id, H2_PROTOCOL_ERROR);
+    }
+    if (!stream->AdjustSendWindow(increment).IsSuccess()) {
+        return ResetStream(header.stream_id, H2_FLOW_CONTROL_ERROR);
+    }
     return Error::Success();
 }
 
 Error H2Connection::HandleRstStreamFrame(const H2FrameHeader& header, const uint8_t* payload) {
     if (header.length != 4) {
-        return Error(WebError::kProtocolError, "RST_STREAM frame must have 4-byte payload");
+        return ConnectionError(H2_FRAME_SIZE_ERROR, "RST_STREAM frame must have 4-byte payload");
+    }
+    if (header.stream_id == 0) {
+        return ConnectionError(H2_PROTOCOL_ERROR, "RST_STREAM frame on stream 0");
     }
 
-    uint32_t error_code = (payload[0] << 24) | (payload[1] << 16) |
-                          (payload[2] << 8) | payload[3];
+    uint32_t error_code = ReadUint32(payload);
 
     LOG_DEBUG("Handling RST_STREAM frame for stream %u, error_code=%u",
               header.stream_id, error_code);
 
     // 关闭指定流
-    auto stream = GetOrCreateStream(header.stream_id);
+    auto stream = FindStream(header.stream_id);
+    if (!stream) {
+        if (header.stream_id > last_peer_stream_id_) {
+            return ConnectionError(H2_PROTOCOL_ERROR, "RST_STREAM on idle stream");
+        }
+        return Error::Success();
+    }
     stream->Close(error_code);
-    RemoveStream(header.stream_id);
+    OnStreamClosed(header.stream_id);
 
     return Error::Success();
 }
 
-Error H2Connection::HandlePriorityFrame(const H2FrameHeader& header, [[maybe_unused]] const uint8_t* payload) {
+Error H2Connection::HandlePriorityFrame(const H2FrameHeader& header, const uint8_t* payload) {
     LOG_DEBUG("Handling PRIORITY frame for stream %u", header.stream_id);
-    // TODO: 实现优先级处理
+    if (header.stream_id == 0) {
+        return ConnectionError(H2_PROTOCOL_ERROR, "PRIORITY frame on stream 0");
+    }
+    // 负载长度已由 ValidatePayloadLength 校验为 5 字节
+    return ParsePriority(header.stream_id, payload);
+}
+
+Error H2Connection::ParsePriority(uint32_t stream_id, const uint8_t* data) {
+    H2Priority priority;
+    uint32_t dependency = ReadUint32(data);
+    priority.exclusive = (dependency & 0x80000000) != 0;
+    priority.stream_dependency = dependency & 0x7FFFFFFF;
+    priority.weight = static_cast<uint16_t>(data[4]) + 1;
+    if (priority.stream_dependency == stream_id) {
+        // 流不能依赖自身（RFC 7540 Section 5.3.1）
+        return ResetStream(stream_id, H2_PROTOCOL_ERROR);
+    }
+
+    // 只采用权重：不维护依赖树，所有流按权重平级分享带宽。
+    // 尚未打开的流（PRIORITY 可先于 HEADERS 到达）不为其建表项
+    if (auto stream = FindStream(stream_id)) {
+        stream->UpdatePriority(priority);
+    }
     return Error::Success();
 }
 
 Error H2Connection::HandlePushPromiseFrame(const H2FrameHeader& header, [[maybe_unused]] const uint8_t* payload) {
     LOG_DEBUG("Handling PUSH_PROMISE frame for stream %u", header.stream_id);
+    if (is_server_) {
+        // 客户端不能推送（RFC 7540 Section 8.2）
+        return ConnectionError(H2_PROTOCOL_ERROR, "PUSH_PROMISE received from client");
+    }
     // TODO: 实现服务器推送
     return Error::Success();
 }
 
-Error H2Connection::HandleContinuationFrame(const H2FrameHeader& header, [[maybe_unused]] const uint8_t* payload) {
+Error H2Connection::HandleContinuationFrame(const H2FrameHeader& header, const uint8_t* payload) {
     LOG_DEBUG("Handling CONTINUATION frame for stream %u", header.stream_id);
-    // TODO: 实现 CONTINUATION 帧处理
+
+    if (continuation_stream_id_ == 0 || header.stream_id != continuation_stream_id_) {
+        return ConnectionError(H2_PROTOCOL_ERROR, "Unexpected CONTINUATION frame");
+    }
+    if (header_block_.size() + header.length > settings_.max_header_list_size) {
+        return ConnectionError(H2_PROTOCOL_ERROR, "Header block too large");
+    }
+
+    header_block_.insert(header_block_.end(), payload, payload + header.length);
+    if (header.HasFlag(H2FrameFlags::END_HEADERS)) {
+        return OnHeaderBlockComplete();
+    }
     return Error::Success();
 }
 
@@ -73,7 +73,11 @@ std::optional<H2FrameHeader> H2FrameParser::ParseHeader(const uint8_t* data, siz
 
 std::vector<uint8_t> H2FrameParser::SerializeHeader(const H2FrameHeader& header) {
     std::vector<uint8_t> result(9);
+    SerializeHeader(header, result.data());
+    return result;
+}
 
+void H2FrameParser::SerializeHeader(const H2FrameHeader& header, uint8_t* result) {
     // 序列化24位长度（大端）
     result[0] = (header.length >> 16) & 0xFF;
     result[1] = (header.length >> 8) & 0xFF;
@@ -93,8 +97,6 @@ std::vector<uint8_t> H2FrameParser::SerializeHeader(const H2FrameHeader& header)
     result[6] = (stream_id_and_reserved >> 16) & 0xFF;
     result[7] = (stream_id_and_reserved >> 8) & 0xFF;
     result[8] = stream_id_and_reserved & 0xFF;
-
-    return result;
 }
 
 std::optional<std::vector<std::pair<uint16_t, uint32_t>>>
@@ -263,10 +265,10 @@ Error H2FrameParser::ValidateFrameLength(uint32_t length, H2FrameType type) {
             break;
     }
 
-    // 通用长度限制：最大帧负载长度 2^14-1 (16383) 字节
+    // 通用长度限制：默认最大帧负载长度 2^14 (16384) 字节
     // 实际实现可能支持更大的帧，但规范要求默认限制
-    if (length > 16383) {
-        LOG_WARN("HTTP/2 frame length %u exceeds default max frame size (16383)", length);
+    if (length > 16384) {
+        LOG_WARN("HTTP/2 frame length %u exceeds default max frame size (16384)", length);
         // 注意：这不是致命错误，SETTINGS 帧可以协商更大的最大帧大小
     }
 
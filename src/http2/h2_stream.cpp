@@ -1,16 +1,28 @@
 #include "http2/h2_stream.h"
 #include "http2/h2_connection.h"
 #include "Logger.h"
+#include <algorithm>
 
 namespace tinywebserver {
 namespace http2 {
 
-H2Stream::H2Stream(uint32_t stream_id, H2Connection* connection)
+namespace {
+    // 流控制窗口上限（RFC 7540 Section 6.9.1）
+    constexpr int64_t MAX_WINDOW_SIZE = 0x7FFFFFFF;
+} // namespace
+
+H2Stream::H2Stream(uint32_t stream_id, H2Connection* connection,
+                   uint32_t initial_send_window, uint32_t initial_recv_window)
     : stream_id_(stream_id),
       connection_(connection),
       state_(H2StreamState::IDLE),
-      send_window_(65535),  // 默认初始窗口大小
-      recv_window_(65535),
+      request_body_bytes_(0),
+      pending_bytes_(0),
+      pending_end_stream_(false),
+      schedule_pass_(0),
+      send_window_(initial_send_window),
+      recv_window_(initial_recv_window),
+      recv_consumed_(0),
       data_callback_(nullptr),
       headers_callback_(nullptr),
       close_callback_(nullptr) {
@@ -22,24 +34,45 @@ H2Stream::~H2Stream() {
     LOG_DEBUG("HTTP/2 stream destroyed: id=%u", stream_id_);
 }
 
+void H2Stream::Reset(uint32_t stream_id, uint32_t initial_send_window, uint32_t initial_recv_window) {
+    stream_id_ = stream_id;
+    state_.store(H2StreamState::IDLE, std::memory_order_release);
+    priority_ = H2Priority();
+    // clear() 保留哈希桶与缓冲区容量，复用时不再重新分配
+    request_headers_.clear();
+    response_headers_.clear();
+    request_body_bytes_ = 0;
+    pending_chunks_.clear();
+    pending_bytes_ = 0;
+    pending_end_stream_ = false;
+    schedule_pass_ = 0;
+    send_window_ = initial_send_window;
+    recv_window_ = initial_recv_window;
+    recv_consumed_ = 0;
+    data_callback_ = nullptr;
+    headers_callback_ = nullptr;
+    close_callback_ = nullptr;
+
+    LOG_DEBUG("HTTP/2 stream reused: id=%u", stream_id_);
+}
+
 Error H2Stream::HandleHeaders(const Headers& headers, bool end_stream) {
     LOG_DEBUG("Stream %u: Handling HEADERS, end_stream=%s, header_count=%zu",
               stream_id_, end_stream ? "true" : "false", headers.size());
 
-    // 验证状态转移
-    auto err = ValidateTransition(end_stream ? H2StreamState::HALF_CLOSED_REMOTE : H2StreamState::OPEN);
-    if (!err.IsSuccess()) {
-        return err;
+    if (state_ == H2StreamState::IDLE) {
+        TransitionState(H2StreamState::OPEN, "Received HEADERS");
+    } else if (!IsReadable()) {
+        // 已打开的流再次收到 HEADERS 只能是尾部字段（trailers）
+        return Error(WebError::kProtocolError,
+                     "HEADERS received on stream " + std::to_string(stream_id_) + " in invalid state");
     }
 
     // 保存请求头部
     request_headers_.insert(headers.begin(), headers.end());
 
-    // 更新状态
     if (end_stream) {
-        TransitionState(H2StreamState::HALF_CLOSED_REMOTE, "Received HEADERS with END_STREAM");
-    } else {
-        TransitionState(H2StreamState::OPEN, "Received HEADERS");
+        OnEndStreamReceived();
     }
 
     // 调用回调
@@ -50,29 +83,25 @@ Error H2Stream::HandleHeaders(const Headers& headers, bool end_stream) {
     return Error::Success();
 }
 
-Error H2Stream::HandleData(const std::vector<uint8_t>& data, bool end_stream) {
+Error H2Stream::HandleData(const uint8_t* data, size_t len, bool end_stream) {
     LOG_DEBUG("Stream %u: Handling DATA, size=%zu, end_stream=%s",
-              stream_id_, data.size(), end_stream ? "true" : "false");
+              stream_id_, len, end_stream ? "true" : "false");
 
-    // 验证状态转移
-    if (end_stream) {
-        auto err = ValidateTransition(H2StreamState::HALF_CLOSED_REMOTE);
-        if (!err.IsSuccess()) {
-            return err;
-        }
+    if (!IsReadable()) {
+        return Error(WebError::kProtocolError,
+                     "DATA received on stream " + std::to_string(stream_id_) + " in invalid state");
     }
 
-    // 添加到请求体
-    request_body_.insert(request_body_.end(), data.begin(), data.end());
+    // 请求体不在流上缓存，只计数；需要内容的处理器经数据回调取走
+    request_body_bytes_ += len;
 
-    // 更新状态
     if (end_stream) {
-        TransitionState(H2StreamState::HALF_CLOSED_REMOTE, "Received DATA with END_STREAM");
+        OnEndStreamReceived();
     }
 
     // 调用回调
     if (data_callback_) {
-        data_callback_(data, end_stream);
+        data_callback_(data, len, end_stream);
     }
 
     return Error::Success();
@@ -81,64 +110,176 @@ Error H2Stream::HandleData(const std::vector<uint8_t>& data, bool end_stream) {
 Error H2Stream::SendHeaders(const Headers& headers, bool end_stream) {
     LOG_DEBUG("Stream %u: Sending HEADERS, end_stream=%s", stream_id_, end_stream ? "true" : "false");
 
-    // 验证状态转移
-    auto err = ValidateTransition(end_stream ? H2StreamState::HALF_CLOSED_LOCAL : H2StreamState::OPEN);
-    if (!err.IsSuccess()) {
-        return err;
+    if (!IsWritable() || pending_end_stream_) {
+        return Error(WebError::kProtocolError,
+                     "Stream " + std::to_string(stream_id_) + " is not writable");
     }
 
     // 保存响应头部
     response_headers_.insert(headers.begin(), headers.end());
 
-    // 更新状态
-    if (end_stream) {
-        TransitionState(H2StreamState::HALF_CLOSED_LOCAL, "Sent HEADERS with END_STREAM");
-    } else {
-        TransitionState(H2StreamState::OPEN, "Sent HEADERS");
+    auto err = connection_->SendHeaderBlock(stream_id_, headers, end_stream);
+    if (!err.IsSuccess()) {
+        return err;
     }
 
-    // TODO: 实际发送 HEADERS 帧
-    LOG_WARN("Stream %u: SendHeaders not fully implemented", stream_id_);
-
+    if (end_stream) {
+        OnEndStreamSent();
+    }
     return Error::Success();
 }
 
 Error H2Stream::SendData(const std::vector<uint8_t>& data, bool end_stream) {
+    return SendData(data.data(), data.size(), end_stream);
+}
+
+Error H2Stream::SendData(const uint8_t* data, size_t len, bool end_stream) {
+    LOG_DEBUG("Stream %u: Sending DATA, size=%zu, end_stream=%s",
+              stream_id_, len, end_stream ? "true" : "false");
+
+    if (!IsWritable() || pending_end_stream_) {
+        return Error(WebError::kProtocolError,
+                     "Stream " + std::to_string(stream_id_) + " is not writable");
+    }
+
+    if (len > 0) {
+        auto buffer = std::make_shared<const std::string>(reinterpret_cast<const char*>(data), len);
+        pending_chunks_.emplace_back(std::move(buffer), 0, len);
+        pending_bytes_ += len;
+    }
+    pending_end_stream_ = end_stream;
+
+    // 由连接的调度器按窗口与权重统一发送
+    return connection_->MarkStreamReady(stream_id_);
+}
+
+Error H2Stream::SendData(std::string&& data, bool end_stream) {
     LOG_DEBUG("Stream %u: Sending DATA, size=%zu, end_stream=%s",
               stream_id_, data.size(), end_stream ? "true" : "false");
 
-    // 验证状态转移
-    if (end_stream) {
-        auto err = ValidateTransition(H2StreamState::HALF_CLOSED_LOCAL);
+    if (!IsWritable() || pending_end_stream_) {
+        return Error(WebError::kProtocolError,
+                     "Stream " + std::to_string(stream_id_) + " is not writable");
+    }
+
+    if (!data.empty()) {
+        size_t len = data.size();
+        pending_chunks_.emplace_back(std::make_shared<const std::string>(std::move(data)), 0, len);
+        pending_bytes_ += len;
+    }
+    pending_end_stream_ = end_stream;
+
+    return connection_->MarkStreamReady(stream_id_);
+}
+
+Error H2Stream::SendFile(std::shared_ptr<StaticResource> file, bool end_stream) {
+    LOG_DEBUG("Stream %u: Sending file DATA, size=%zu, end_stream=%s",
+              stream_id_, file ? file->size : 0, end_stream ? "true" : "false");
+
+    if (!IsWritable() || pending_end_stream_) {
+        return Error(WebError::kProtocolError,
+                     "Stream " + std::to_string(stream_id_) + " is not writable");
+    }
+
+    if (file && file->size > 0) {
+        size_t size = file->size;
+        pending_chunks_.emplace_back(std::move(file), 0, size);
+        pending_bytes_ += size;
+    }
+    pending_end_stream_ = end_stream;
+
+    return connection_->MarkStreamReady(stream_id_);
+}
+
+Error H2Stream::SendNextFrame(int64_t& conn_window, size_t quantum, size_t& sent) {
+    sent = 0;
+    if (pending_chunks_.empty()) {
+        if (!pending_end_stream_) {
+            return Error::Success();
+        }
+        // 空 DATA 帧结束流，不占用流控制窗口
+        pending_end_stream_ = false;
+        auto err = connection_->SendFrame(H2FrameType::DATA, H2FrameFlags::END_STREAM, stream_id_, {});
         if (!err.IsSuccess()) {
             return err;
         }
+        OnEndStreamSent();
+        return Error::Success();
     }
 
-    // 添加到响应体
-    response_body_.insert(response_body_.end(), data.begin(), data.end());
+    int64_t allowed = std::min<int64_t>({send_window_, conn_window, static_cast<int64_t>(quantum)});
+    if (allowed <= 0) {
+        // 窗口耗尽，等待 WINDOW_UPDATE
+        LOG_DEBUG("Stream %u: DATA blocked by flow control (stream=%lld, conn=%lld)",
+                  stream_id_, static_cast<long long>(send_window_),
+                  static_cast<long long>(conn_window));
+        return Error::Success();
+    }
 
-    // 更新状态
-    if (end_stream) {
-        TransitionState(H2StreamState::HALF_CLOSED_LOCAL, "Sent DATA with END_STREAM");
+    // 帧负载是队首节点的一个片段，与待发送队列共享底层缓冲区或映射区
+    BufferNode& front = pending_chunks_.front();
+    size_t len = std::min(front.LeftSize(), static_cast<size_t>(allowed));
+    BufferNode payload = front.type == BufferNode::MMAP
+        ? BufferNode(front.mmap_res, front.offset, len)
+        : BufferNode(front.shared_data, front.offset, len);
+    front.offset += len;
+    if (front.LeftSize() == 0) {
+        pending_chunks_.pop_front();
+    }
+    pending_bytes_ -= len;
+
+    bool last = pending_end_stream_ && pending_bytes_ == 0;
+    auto err = connection_->SendDataFrame(last ? H2FrameFlags::END_STREAM : 0, stream_id_,
+                                          std::move(payload));
+    if (!err.IsSuccess()) {
+        return err;
+    }
+
+    sent = len;
+    send_window_ -= static_cast<int64_t>(len);
+    conn_window -= static_cast<int64_t>(len);
+
+    if (last) {
+        pending_end_stream_ = false;
+        OnEndStreamSent();
     }
+    return Error::Success();
+}
 
-    // TODO: 实际发送 DATA 帧
-    LOG_WARN("Stream %u: SendData not fully implemented", stream_id_);
+Error H2Stream::AdjustSendWindow(int64_t delta) {
+    if (send_window_ + delta > MAX_WINDOW_SIZE) {
+        return Error(WebError::kProtocolError,
+                     "Stream " + std::to_string(stream_id_) + " send window overflow");
+    }
+    send_window_ += delta;
+    return Error::Success();
+}
 
+Error H2Stream::ConsumeRecvWindow(uint32_t len) {
+    if (static_cast<int64_t>(len) > recv_window_) {
+        return Error(WebError::kProtocolError,
+                     "Stream " + std::to_string(stream_id_) + " receive window exceeded");
+    }
+    recv_window_ -= len;
     return Error::Success();
 }
 
 Error H2Stream::SendRstStream(uint32_t error_code) {
     LOG_DEBUG("Stream %u: Sending RST_STREAM, error_code=%u", stream_id_, error_code);
 
+    std::vector<uint8_t> payload = {
+        static_cast<uint8_t>((error_code >> 24) & 0xFF),
+        static_cast<uint8_t>((error_code >> 16) & 0xFF),
+        static_cast<uint8_t>((error_code >> 8) & 0xFF),
+        static_cast<uint8_t>(error_code & 0xFF)
+    };
+    auto err = connection_->SendFrame(H2FrameType::RST_STREAM, 0, stream_id_, payload);
+
     // 关闭流
     Close(error_code);
+    connection_->OnStreamClosed(stream_id_);
 
-    // TODO: 实际发送 RST_STREAM 帧
-    LOG_WARN("Stream %u: SendRstStream not fully implemented", stream_id_);
-
-    return Error::Success();
+    return err;
 }
 
 void H2Stream::Close(uint32_t error_code) {
@@ -148,6 +289,9 @@ void H2Stream::Close(uint32_t error_code) {
 
     LOG_DEBUG("Stream %u: Closing, error_code=%u", stream_id_, error_code);
     TransitionState(H2StreamState::CLOSED, "Stream closed");
+    pending_chunks_.clear();
+    pending_bytes_ = 0;
+    pending_end_stream_ = false;
 
     // 调用关闭回调
     if (close_callback_) {
@@ -171,6 +315,24 @@ bool H2Stream::IsWritable() const {
            state_ == H2StreamState::HALF_CLOSED_REMOTE;
 }
 
+void H2Stream::OnEndStreamReceived() {
+    if (state_ == H2StreamState::OPEN) {
+        TransitionState(H2StreamState::HALF_CLOSED_REMOTE, "Received END_STREAM");
+    } else if (state_ == H2StreamState::HALF_CLOSED_LOCAL) {
+        TransitionState(H2StreamState::CLOSED, "Received END_STREAM");
+        connection_->OnStreamClosed(stream_id_);
+    }
+}
+
+void H2Stream::OnEndStreamSent() {
+    if (state_ == H2StreamState::OPEN) {
+        TransitionState(H2StreamState::HALF_CLOSED_LOCAL, "Sent END_STREAM");
+    } else if (state_ == H2StreamState::HALF_CLOSED_REMOTE) {
+        TransitionState(H2StreamState::CLOSED, "Sent END_STREAM");
+        connection_->OnStreamClosed(stream_id_);
+    }
+}
+
 void H2Stream::TransitionState(H2StreamState new_state, const std::string& reason) {
     H2StreamState current = state_.load(std::memory_order_acquire);
     if (current == new_state) {
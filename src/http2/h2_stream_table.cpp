@@ -0,0 +1,108 @@
+#include "http2/h2_stream_table.h"
+
+namespace tinywebserver {
+namespace http2 {
+
+namespace {
+    // 初始槽位数（2 的幂），默认 MAX_CONCURRENT_STREAMS 下最多扩到 256
+    constexpr size_t kInitialSlots = 16;
+} // namespace
+
+H2StreamTable::H2StreamTable()
+    : slots_(kInitialSlots),
+      mask_(kInitialSlots - 1),
+      size_(0) {
+}
+
+const std::shared_ptr<H2Stream>& H2StreamTable::Find(uint32_t stream_id) const {
+    static const std::shared_ptr<H2Stream> kNone;
+    if (stream_id == 0) {
+        return kNone;
+    }
+    for (size_t i = HomeOf(stream_id);; i = (i + 1) & mask_) {
+        const Slot& slot = slots_[i];
+        if (slot.stream_id == stream_id) {
+            return slot.stream;
+        }
+        if (slot.stream_id == 0) {
+            return kNone;
+        }
+    }
+}
+
+void H2StreamTable::Insert(uint32_t stream_id, std::shared_ptr<H2Stream> stream) {
+    if ((size_ + 1) * 2 > slots_.size()) {
+        Grow();
+    }
+    size_t i = HomeOf(stream_id);
+    while (slots_[i].stream_id != 0) {
+        i = (i + 1) & mask_;
+    }
+    slots_[i].stream_id = stream_id;
+    slots_[i].stream = std::move(stream);
+    ++size_;
+}
+
+std::shared_ptr<H2Stream> H2StreamTable::Erase(uint32_t stream_id) {
+    if (stream_id == 0) {
+        return nullptr;
+    }
+    size_t i = HomeOf(stream_id);
+    while (slots_[i].stream_id != stream_id) {
+        if (slots_[i].stream_id == 0) {
+            return nullptr;
+        }
+        i = (i + 1) & mask_;
+    }
+
+    std::shared_ptr<H2Stream> removed = std::move(slots_[i].stream);
+    slots_[i].stream_id = 0;
+    --size_;
+
+    // 后移删除：把探测链上后续、且起始槽不在 (hole, j] 区间内的条目填回空洞
+    size_t hole = i;
+    for (size_t j = (i + 1) & mask_; slots_[j].stream_id != 0; j = (j + 1) & mask_) {
+        size_t home = HomeOf(slots_[j].stream_id);
+        bool reachable = hole <= j ? (home > hole && home <= j) : (home > hole || home <= j);
+        if (!reachable) {
+            slots_[hole] = std::move(slots_[j]);
+            slots_[j].stream_id = 0;
+            hole = j;
+        }
+    }
+    return removed;
+}
+
+std::vector<std::shared_ptr<H2Stream>> H2StreamTable::Snapshot() const {
+    std::vector<std::shared_ptr<H2Stream>> streams;
+    streams.reserve(size_);
+    for (const Slot& slot : slots_) {
+        if (slot.stream_id != 0) {
+            streams.push_back(slot.stream);
+        }
+    }
+    return streams;
+}
+
+void H2StreamTable::Clear() {
+    for (Slot& slot : slots_) {
+        slot.stream_id = 0;
+        slot.stream.reset();
+    }
+    size_ = 0;
+}
+
+void H2StreamTable::Grow() {
+    std::vector<Slot> old = std::move(slots_);
+    slots_ = std::vector<Slot>(old.size() * 2);
+    mask_ = slots_.size() - 1;
+    size_ = 0;
+    for (Slot& slot : old) {
+        if (slot.stream_id != 0) {
+            Insert(slot.stream_id, std::move(slot.stream));
+        }
+    }
+}
+
+} // namespace http2
+} // namespace tinywebserver
@@ -1,203 +1,135 @@
 #include "http2/hpack_decoder.h"
+#include "http2/hpack_huffman.h"
+#include "http2/hpack_static_table.h"
 #include "Logger.h"
 #include <cstring>
 
 namespace tinywebserver {
 namespace http2 {
 
-// 静态表定义（RFC 7541 Appendix A）
-const HpackHeader HpackDecoder::STATIC_TABLE[] = {
-    /* 1 */ {"", ""}, // 索引从1开始，0占位
-    /* 2 */ {":authority", ""},
-    /* 3 */ {":method", "GET"},
-    /* 4 */ {":method", "POST"},
-    /* 5 */ {":path", "/"},
-    /* 6 */ {":path", "/index.html"},
-    /* 7 */ {":scheme", "http"},
-    /* 8 */ {":scheme", "https"},
-    /* 9 */ {":status", "200"},
-    /* 10 */ {":status", "204"},
-    /* 11 */ {":status", "206"},
-    /* 12 */ {":status", "304"},
-    /* 13 */ {":status", "400"},
-    /* 14 */ {":status", "404"},
-    /* 15 */ {":status", "500"},
-    /* 16 */ {"accept-charset", ""},
-    /* 17 */ {"accept-encoding", "gzip, deflate"},
-    /* 18 */ {"accept-language", ""},
-    /* 19 */ {"accept-ranges", ""},
-    /* 20 */ {"accept", ""},
-    /* 21 */ {"access-control-allow-origin", ""},
-    /* 22 */ {"age", ""},
-    /* 23 */ {"allow", ""},
-    /* 24 */ {"authorization", ""},
-    /* 25 */ {"cache-control", ""},
-    /* 26 */ {"content-disposition", ""},
-    /* 27 */ {"content-encoding", ""},
-    /* 28 */ {"content-language", ""},
-    /* 29 */ {"content-length", ""},
-    /* 30 */ {"content-location", ""},
-    /* 31 */ {"content-range", ""},
-    /* 32 */ {"content-type", ""},
-    /* 33 */ {"cookie", ""},
-    /* 34 */ {"date", ""},
-    /* 35 */ {"etag", ""},
-    /* 36 */ {"expect", ""},
-    /* 37 */ {"expires", ""},
-    /* 38 */ {"from", ""},
-    /* 39 */ {"host", ""},
-    /* 40 */ {"if-match", ""},
-    /* 41 */ {"if-modified-since", ""},
-    /* 42 */ {"if-none-match", ""},
-    /* 43 */ {"if-range", ""},
-    /* 44 */ {"if-unmodified-since", ""},
-    /* 45 */ {"last-modified", ""},
-    /* 46 */ {"link", ""},
-    /* 47 */ {"location", ""},
-    /* 48 */ {"max-forwards", ""},
-    /* 49 */ {"proxy-authenticate", ""},
-    /* 50 */ {"proxy-authorization", ""},
-    /* 51 */ {"range", ""},
-    /* 52 */ {"referer", ""},
-    /* 53 */ {"refresh", ""},
-    /* 54 */ {"retry-after", ""},
-    /* 55 */ {"server", ""},
-    /* 56 */ {"set-cookie", ""},
-    /* 57 */ {"strict-transport-security", ""},
-    /* 58 */ {"transfer-encoding", ""},
-    /* 59 */ {"user-agent", ""},
-    /* 60 */ {"vary", ""},
-    /* 61 */ {"via", ""},
-    /* 62 */ {"www-authenticate", ""}
-};
+namespace {
+    // 动态表条目开销（RFC 7541 Section 4.1）
+    constexpr uint32_t ENTRY_OVERHEAD = 32;
+} // namespace
 
 HpackDecoder::HpackDecoder(uint32_t max_dynamic_table_size)
     : max_dynamic_table_size_(max_dynamic_table_size),
-      dynamic_table_size_(0),
-      dynamic_table_usage_(0),
-      decoding_started_(false) {
+      table_capacity_(max_dynamic_table_size),
+      table_usage_(0),
+      entry_count_(0),
+      ring_(static_cast<size_t>(max_dynamic_table_size) * 2),
+      slots_(max_dynamic_table_size / ENTRY_OVERHEAD + 1),
+      newest_slot_(0),
+      write_pos_(0) {
 
     LOG_DEBUG("HPACK decoder created with max dynamic table size: %u", max_dynamic_table_size_);
 }
 
-HpackDecoder::~HpackDecoder() {
-    ClearDynamicTable();
-}
+HpackDecoder::~HpackDecoder() = default;
 
-std::optional<std::vector<HpackHeader>> HpackDecoder::Decode(const uint8_t* data, size_t len) {
-    std::vector<HpackHeader> headers;
+Error HpackDecoder::DecodeBlock(const uint8_t* data, size_t len, const FieldCallback& on_field) {
     const uint8_t* current = data;
     size_t remaining = len;
-
-    decoding_started_ = true;
+    bool field_seen = false;
 
     while (remaining > 0) {
-        HpackHeader header;
-        Error err = DecodeHeaderField(current, remaining, header);
+        // 动态表大小更新（6.3）只能出现在头部块开头（RFC 7541 Section 4.2）
+        if ((current[0] & 0xE0) == 0x20) {
+            if (field_seen) {
+                return Error(WebError::kParseError, "Dynamic table size update after header field");
+            }
+            uint32_t new_size;
+            auto err = DecodeInteger(current, remaining, 5, new_size);
+            if (!err.IsSuccess()) {
+                return err;
+            }
+            err = UpdateDynamicTableSize(new_size);
+            if (!err.IsSuccess()) {
+                return err;
+            }
+            continue;
+        }
+
+        HpackHeaderView field;
+        bool incremental = false;
+        auto err = DecodeField(current, remaining, field, incremental);
         if (!err.IsSuccess()) {
-            LOG_ERROR("Failed to decode HPACK header field: %s", err.ToString().c_str());
-            return std::nullopt;
+            return err;
         }
+        field_seen = true;
 
-        headers.push_back(std::move(header));
+        // 先交给调用方再插入：插入可能驱逐（并覆盖）视图所指的条目
+        on_field(field);
+        if (incremental) {
+            AddToDynamicTable(field.name, field.value);
+        }
     }
 
-    return headers;
+    return Error::Success();
 }
 
-Error HpackDecoder::DecodeHeaderField(const uint8_t*& data, size_t& remaining, HpackHeader& header) {
-    if (remaining == 0) {
-        return Error(WebError::kParseError, "No data remaining for HPACK decoding");
+std::optional<std::vector<HpackHeader>> HpackDecoder::Decode(const uint8_t* data, size_t len) {
+    std::vector<HpackHeader> headers;
+    Error err = DecodeBlock(data, len, [&headers](const HpackHeaderView& field) {
+        headers.push_back({std::string(field.name), std::string(field.value), field.sensitive});
+    });
+    if (!err.IsSuccess()) {
+        LOG_ERROR("Failed to decode HPACK header block: %s", err.ToString().c_str());
+        return std::nullopt;
     }
+    return headers;
+}
 
+Error HpackDecoder::DecodeField(const uint8_t*& data, size_t& remaining, HpackHeaderView& field,
+                                bool& incremental) {
     uint8_t first_byte = data[0];
 
     // 检查索引字段表示（RFC 7541 Section 6.1）
     if ((first_byte & 0x80) != 0) {
-        // 索引字段（6.1）
         uint32_t index;
         auto err = DecodeInteger(data, remaining, 7, index);
         if (!err.IsSuccess()) {
             return err;
         }
-
-        auto entry = GetTableEntry(index);
-        if (!entry) {
+        if (!GetTableEntry(index, field.name, field.value)) {
             return Error(WebError::kParseError, "Invalid HPACK table index: " + std::to_string(index));
         }
-
-        header = *entry;
         return Error::Success();
     }
-    // 检查字面值字段（6.2）和动态表大小更新（6.3）
-    else if ((first_byte & 0xC0) == 0x40) {
-        // 字面值字段，带索引名称（6.2.1）
-        uint32_t name_index;
-        auto err = DecodeInteger(data, remaining, 6, name_index);
-        if (!err.IsSuccess()) {
-            return err;
-        }
-
-        auto name_entry = GetTableEntry(name_index);
-        if (!name_entry) {
-            return Error(WebError::kParseError, "Invalid HPACK name index: " + std::to_string(name_index));
-        }
-
-        header.name = name_entry->name;
 
-        // 解码值
-        err = DecodeString(data, remaining, header.value);
-        if (!err.IsSuccess()) {
-            return err;
-        }
-
-        // 添加到动态表
-        AddToDynamicTable(header);
-        return Error::Success();
+    // 字面值字段：带增量索引（6.2.1，6 位前缀）、不索引（6.2.2）、
+    // 永不索引（6.2.3）（后两者 4 位前缀）。名称索引为 0 表示新名称
+    if ((first_byte & 0xC0) != 0x40 && (first_byte & 0xE0) != 0x00) {
+        return Error(WebError::kParseError, "Unknown HPACK encoding: 0x" +
+                     std::to_string(static_cast<int>(first_byte)));
     }
-    else if ((first_byte & 0xF0) == 0x00) {
-        // 字面值字段，带新名称（6.2.2）
-        // 解码名称
-        auto err = DecodeString(data, remaining, header.name);
-        if (!err.IsSuccess()) {
-            return err;
-        }
-
-        // 解码值
-        err = DecodeString(data, remaining, header.value);
-        if (!err.IsSuccess()) {
-            return err;
-        }
 
-        // 添加到动态表
-        AddToDynamicTable(header);
-        return Error::Success();
+    incremental = (first_byte & 0xC0) == 0x40;
+    uint32_t name_index;
+    auto err = DecodeInteger(data, remaining, incremental ? 6 : 4, name_index);
+    if (!err.IsSuccess()) {
+        return err;
     }
-    else if ((first_byte & 0xE0) == 0x20) {
-        // 动态表大小更新（6.3）
-        if (!decoding_started_) {
-            return Error(WebError::kParseError, "Dynamic table size update at invalid position");
-        }
 
-        uint32_t new_size;
-        auto err = DecodeInteger(data, remaining, 5, new_size);
+    if (name_index == 0) {
+        err = DecodeString(data, remaining, name_scratch_, field.name);
         if (!err.IsSuccess()) {
             return err;
         }
-
-        err = UpdateDynamicTableSize(new_size);
-        if (!err.IsSuccess()) {
-            return err;
+    } else {
+        std::string_view unused;
+        if (!GetTableEntry(name_index, field.name, unused)) {
+            return Error(WebError::kParseError, "Invalid HPACK name index: " + std::to_string(name_index));
         }
-
-        // 递归解码下一个字段
-        return DecodeHeaderField(data, remaining, header);
     }
-    else {
-        // 未知编码
-        return Error(WebError::kParseError, "Unknown HPACK encoding: 0x" +
-                     std::to_string(static_cast<int>(first_byte)));
+
+    err = DecodeString(data, remaining, value_scratch_, field.value);
+    if (!err.IsSuccess()) {
+        return err;
     }
+
+    field.sensitive = (first_byte & 0xF0) == 0x10;
+    return Error::Success();
 }
 
 Error HpackDecoder::DecodeInteger(const uint8_t*& data, size_t& remaining,
@@ -237,7 +169,8 @@ Error HpackDecoder::DecodeInteger(const uint8_t*& data, size_t& remaining,
     return Error::Success();
 }
 
-Error HpackDecoder::DecodeString(const uint8_t*& data, size_t& remaining, std::string& result) {
+Error HpackDecoder::DecodeString(const uint8_t*& data, size_t& remaining, std::string& scratch,
+                                 std::string_view& result) {
     if (remaining == 0) {
         return Error(WebError::kParseError, "No data for string decoding");
     }
@@ -256,11 +189,16 @@ Error HpackDecoder::DecodeString(const uint8_t*& data, size_t& remaining, std::s
     }
 
     if (huffman_encoded) {
-        // TODO: 实现哈夫曼解码（RFC 7541 Appendix B）
-        LOG_WARN("Huffman decoding not implemented, using raw bytes");
-        result.assign(reinterpret_cast<const char*>(data), length);
+        // 哈夫曼编码的字符串解码到暂存区
+        scratch.clear();
+        err = HpackHuffman::Decode(data, length, scratch);
+        if (!err.IsSuccess()) {
+            return err;
+        }
+        result = scratch;
     } else {
-        result.assign(reinterpret_cast<const char*>(data), length);
+        // 原始字面值直接引用帧数据
+        result = std::string_view(reinterpret_cast<const char*>(data), length);
     }
 
     data += length;
@@ -277,94 +215,125 @@ Error HpackDecoder::UpdateDynamicTableSize(uint32_t new_size) {
                      std::to_string(max_dynamic_table_size_));
     }
 
-    max_dynamic_table_size_ = new_size;
-    EvictDynamicTable();
+    table_capacity_ = new_size;
+    while (table_usage_ > table_capacity_) {
+        EvictOldest();
+    }
 
     LOG_DEBUG("Updated dynamic table size to %u", new_size);
     return Error::Success();
 }
 
 void HpackDecoder::ClearDynamicTable() {
-    dynamic_table_.clear();
-    dynamic_table_size_ = 0;
-    dynamic_table_usage_ = 0;
+    entry_count_ = 0;
+    table_usage_ = 0;
+    write_pos_ = 0;
     LOG_DEBUG("Cleared dynamic table");
 }
 
 void HpackDecoder::Reset() {
     ClearDynamicTable();
-    decoding_started_ = false;
+    table_capacity_ = max_dynamic_table_size_;
 }
 
 std::optional<HpackHeader> HpackDecoder::GetStaticTableEntry(uint32_t index) {
     if (index == 0 || index > STATIC_TABLE_SIZE) {
         return std::nullopt;
     }
-    return STATIC_TABLE[index];
+    const auto& entry = kHpackStaticTable[index];
+    return HpackHeader{std::string(entry.name), std::string(entry.value)};
 }
 
-void HpackDecoder::AddToDynamicTable(const HpackHeader& header) {
+void HpackDecoder::AddToDynamicTable(std::string_view name, std::string_view value) {
     // 计算条目大小（RFC 7541 Section 4.1）
-    uint32_t entry_size = static_cast<uint32_t>(header.name.size() + header.value.size() + 32);
+    uint32_t entry_size = static_cast<uint32_t>(name.size() + value.size()) + ENTRY_OVERHEAD;
 
-    // 确保表有足够空间
-    if (entry_size > max_dynamic_table_size_) {
-        // 条目太大，无法添加到表中
-        LOG_DEBUG("HPACK entry too large for dynamic table: %u > %u",
-                  entry_size, max_dynamic_table_size_);
+    // 比整张表还大的条目：清空表且不插入（RFC 7541 Section 4.4）
+    if (entry_size > table_capacity_) {
+        LOG_DEBUG("HPACK entry too large for dynamic table: %u > %u", entry_size, table_capacity_);
+        ClearDynamicTable();
         return;
     }
 
+    // 名称可能引用即将被驱逐的条目（RFC 7541 Section 4.4），先拷出
+    if (!ring_.empty() && name.data() >= ring_.data() && name.data() < ring_.data() + ring_.size()) {
+        insert_scratch_.assign(name.data(), name.size());
+        name = insert_scratch_;
+    }
+
     // 驱逐旧条目直到有足够空间
-    while (!dynamic_table_.empty() &&
-           dynamic_table_usage_ + entry_size > max_dynamic_table_size_) {
-        EvictDynamicTable();
+    while (table_usage_ + entry_size > table_capacity_) {
+        EvictOldest();
     }
 
-    // 添加新条目到表前端
-    DynamicTableEntry entry{header, entry_size};
-    dynamic_table_.push_front(entry);
-    dynamic_table_usage_ += entry_size;
-    dynamic_table_size_++;
+    uint32_t len = static_cast<uint32_t>(name.size() + value.size());
+    uint32_t offset = PlaceEntry(len);
+    std::memcpy(ring_.data() + offset, name.data(), name.size());
+    std::memcpy(ring_.data() + offset + name.size(), value.data(), value.size());
+    write_pos_ = offset + len;
+
+    newest_slot_ = (newest_slot_ + 1) % slots_.size();
+    slots_[newest_slot_] = {offset, static_cast<uint32_t>(name.size()), static_cast<uint32_t>(value.size())};
+    ++entry_count_;
+    table_usage_ += entry_size;
 
-    LOG_DEBUG("Added HPACK entry to dynamic table: %s: %s (size=%u, usage=%u/%u)",
-              header.name.c_str(), header.value.c_str(),
-              entry_size, dynamic_table_usage_, max_dynamic_table_size_);
+    LOG_DEBUG("Added HPACK entry to dynamic table (size=%u, usage=%u/%u, entries=%u)",
+              entry_size, table_usage_, table_capacity_, entry_count_);
 }
 
-void HpackDecoder::EvictDynamicTable() {
-    if (dynamic_table_.empty()) {
+void HpackDecoder::EvictOldest() {
+    if (entry_count_ == 0) {
         return;
     }
 
-    auto& entry = dynamic_table_.back();
-    dynamic_table_usage_ -= entry.size;
-    dynamic_table_size_--;
-    dynamic_table_.pop_back();
-
-    LOG_DEBUG("Evicted HPACK entry from dynamic table, usage=%u/%u",
-              dynamic_table_usage_, max_dynamic_table_size_);
+    const RingSlot& oldest = slots_[SlotOf(entry_count_)];
+    table_usage_ -= oldest.name_len + oldest.value_len + ENTRY_OVERHEAD;
+    --entry_count_;
+    if (entry_count_ == 0) {
+        write_pos_ = 0;
+    }
 }
 
-std::optional<HpackHeader> HpackDecoder::GetDynamicTableEntry(uint32_t index) const {
-    // 动态表索引从1开始，对应表中最新的条目
-    if (index == 0 || index > dynamic_table_.size()) {
-        return std::nullopt;
+uint32_t HpackDecoder::PlaceEntry(uint32_t len) {
+    // 驱逐后存活字节 L <= C - len - 32（C 为表上限），环容量为 2C：
+    // - 未回绕时空闲区 [write_pos_, 2C) 与 [0, oldest) 合计 >= C + len + 32，
+    //   较大的一段 >= len，尾部放不下时开头一定放得下
+    // - 已回绕时尾部死区小于回绕条目本身的长度（该条目仍存活），
+    //   空闲区 [write_pos_, oldest) > 2C - 2L >= len
+    // 因此条目总能连续存放，不需要整理
+    if (entry_count_ == 0) {
+        return 0;
     }
+    uint32_t oldest = slots_[SlotOf(entry_count_)].offset;
+    if (oldest <= write_pos_ && write_pos_ + len > ring_.size()) {
+        return 0;
+    }
+    return write_pos_;
+}
 
-    // 动态表：索引1对应表前端（最新条目）
-    auto it = dynamic_table_.begin();
-    std::advance(it, index - 1);
-    return it->header;
+size_t HpackDecoder::SlotOf(uint32_t dynamic_index) const {
+    // 动态表索引 1 为最新条目
+    return (newest_slot_ + slots_.size() - (dynamic_index - 1)) % slots_.size();
 }
 
-std::optional<HpackHeader> HpackDecoder::GetTableEntry(uint32_t index) const {
+bool HpackDecoder::GetTableEntry(uint32_t index, std::string_view& name, std::string_view& value) const {
+    if (index == 0) {
+        return false;
+    }
     if (index <= STATIC_TABLE_SIZE) {
-        return GetStaticTableEntry(index);
-    } else {
-        uint32_t dynamic_index = index - STATIC_TABLE_SIZE;
-        return GetDynamicTableEntry(dynamic_index);
+        name = kHpackStaticTable[index].name;
+        value = kHpackStaticTable[index].value;
+        return true;
+    }
+
+    uint32_t dynamic_index = index - static_cast<uint32_t>(STATIC_TABLE_SIZE);
+    if (dynamic_index > entry_count_) {
+        return false;
     }
+    const RingSlot& slot = slots_[SlotOf(dynamic_index)];
+    name = std::string_view(ring_.data() + slot.offset, slot.name_len);
+    value = std::string_view(ring_.data() + slot.offset + slot.name_len, slot.value_len);
+    return true;
 }
 
 } // namespace http2
@@ -0,0 +1,261 @@
+#include "http2/hpack_encoder.h"
+#include "http2/hpack_huffman.h"
+#include "http2/hpack_static_table.h"
+#include "Logger.h"
+#include <array>
+
+namespace tinywebserver {
+namespace http2 {
+
+namespace {
+    // 静态表名称的完美哈希：FNV-1a（种子离线选出）取高 7 位，
+    // 52 个不同名称落在 128 个槽位中无冲突，由下方 static_assert 保证
+    constexpr uint32_t kStaticHashSeed = 73824;
+    constexpr uint32_t kStaticHashBits = 7;
+    constexpr size_t kStaticSlotCount = size_t{1} << kStaticHashBits;
+
+    constexpr uint32_t HashName(std::string_view name) {
+        uint32_t hash = 2166136261u ^ kStaticHashSeed;
+        for (char c : name) {
+            hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+        }
+        return hash >> (32 - kStaticHashBits);
+    }
+
+    /// 槽位：同名表项在静态表中连续，记录首个索引与个数（first 为 0 表示空槽）
+    struct StaticSlot {
+        uint8_t first;
+        uint8_t count;
+    };
+
+    constexpr std::array<StaticSlot, kStaticSlotCount> BuildStaticSlots() {
+        std::array<StaticSlot, kStaticSlotCount> slots{};
+        for (size_t i = 1; i <= kHpackStaticTableSize; ++i) {
+            StaticSlot& slot = slots[HashName(kHpackStaticTable[i].name)];
+            if (slot.first == 0) {
+                slot.first = static_cast<uint8_t>(i);
+                slot.count = 1;
+            } else if (kHpackStaticTable[slot.first].name == kHpackStaticTable[i].name) {
+                ++slot.count;
+            }
+        }
+        return slots;
+    }
+
+    constexpr auto kStaticSlots = BuildStaticSlots();
+
+    constexpr bool StaticHashIsPerfect() {
+        for (size_t i = 1; i <= kHpackStaticTableSize; ++i) {
+            const StaticSlot& slot = kStaticSlots[HashName(kHpackStaticTable[i].name)];
+            if (kHpackStaticTable[slot.first].name != kHpackStaticTable[i].name ||
+                i < slot.first || i >= static_cast<size_t>(slot.first + slot.count)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static_assert(StaticHashIsPerfect(), "HPACK static table hash has collisions, pick a new seed");
+
+    /// 取值随响应变化、复用率低的字段不写入动态表
+    /// （content-length 每个资源各不相同，写入会冲掉 content-type 等条目并让头部块缓存失效）
+    bool IsVolatileHeader(const std::string& name) {
+        static const std::array<std::string_view, 11> kVolatile = {
+            ":path", "age", "content-length", "content-range", "date", "etag", "if-modified-since",
+            "if-none-match", "last-modified", "location", "set-cookie"};
+        for (auto v : kVolatile) {
+            if (name == v) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// 动态表条目开销（RFC 7541 Section 4.1）
+    constexpr size_t kEntryOverhead = 32;
+} // namespace
+
+HpackEncoder::HpackEncoder(uint32_t max_dynamic_table_size)
+    : local_max_table_size_(max_dynamic_table_size),
+      max_table_size_(max_dynamic_table_size),
+      table_usage_(0),
+      size_update_pending_(false),
+      min_pending_size_(max_dynamic_table_size),
+      generation_(0),
+      cache_hits_(0) {
+}
+
+std::pair<uint32_t, bool> HpackEncoder::FindStatic(std::string_view name, std::string_view value) {
+    const StaticSlot& slot = kStaticSlots[HashName(name)];
+    if (slot.first == 0 || kHpackStaticTable[slot.first].name != name) {
+        return {0, false};
+    }
+    for (uint32_t i = slot.first; i < static_cast<uint32_t>(slot.first + slot.count); ++i) {
+        if (kHpackStaticTable[i].value == value) {
+            return {i, true};
+        }
+    }
+    return {slot.first, false};
+}
+
+void HpackEncoder::SetMaxDynamicTableSize(uint32_t size) {
+    uint32_t new_size = std::min(size, local_max_table_size_);
+    if (new_size == max_table_size_) {
+        return;
+    }
+    if (!size_update_pending_ || new_size < min_pending_size_) {
+        min_pending_size_ = new_size;
+    }
+    size_update_pending_ = true;
+    max_table_size_ = new_size;
+    EvictTo(max_table_size_);
+    ++generation_;
+    LOG_DEBUG("HPACK encoder dynamic table size set to %u", max_table_size_);
+}
+
+void HpackEncoder::Encode(const std::vector<HpackHeader>& headers, std::vector<uint8_t>& out) {
+    if (size_update_pending_) {
+        // 期间缩小过时须先通告最小值，保证对端按相同顺序驱逐（RFC 7541 Section 4.2）
+        if (min_pending_size_ < max_table_size_) {
+            EncodeInteger(out, 0x20, 5, min_pending_size_);
+        }
+        EncodeInteger(out, 0x20, 5, max_table_size_);
+        size_update_pending_ = false;
+    }
+
+    // 小头部列表走缓存：键为字段序列化结果
+    bool cacheable = headers.size() <= kMaxCachedFields;
+    if (cacheable) {
+        cache_key_.clear();
+        for (const auto& header : headers) {
+            if (header.sensitive) {
+                cacheable = false;
+                break;
+            }
+            cache_key_.append(header.name).push_back('\0');
+            cache_key_.append(header.value).push_back('\0');
+        }
+    }
+    if (cacheable) {
+        auto it = block_cache_.find(cache_key_);
+        if (it != block_cache_.end() && it->second.generation == generation_) {
+            out.insert(out.end(), it->second.bytes.begin(), it->second.bytes.end());
+            ++cache_hits_;
+            return;
+        }
+    }
+
+    size_t start = out.size();
+    uint64_t generation_before = generation_;
+    for (const auto& header : headers) {
+        EncodeField(header, out);
+    }
+
+    // 只缓存未改动动态表的编码：重放时不会再次插入，索引也保持有效
+    if (cacheable && generation_ == generation_before) {
+        if (block_cache_.size() >= kMaxCacheEntries && !block_cache_.count(cache_key_)) {
+            block_cache_.clear();
+        }
+        CachedBlock& cached = block_cache_[cache_key_];
+        cached.bytes.assign(out.begin() + static_cast<std::ptrdiff_t>(start), out.end());
+        cached.generation = generation_;
+    }
+}
+
+void HpackEncoder::EncodeField(const HpackHeader& header, std::vector<uint8_t>& out) {
+    auto [static_index, static_exact] = FindStatic(header.name, header.value);
+    if (static_exact) {
+        EncodeInteger(out, 0x80, 7, static_index);   // 6.1 索引字段
+        return;
+    }
+
+    uint32_t name_index = static_index;
+    for (size_t i = 0; i < dynamic_table_.size(); ++i) {
+        const DynamicEntry& entry = dynamic_table_[i];
+        if (entry.name != header.name) {
+            continue;
+        }
+        uint32_t index = static_cast<uint32_t>(kHpackStaticTableSize + 1 + i);
+        if (entry.value == header.value) {
+            EncodeInteger(out, 0x80, 7, index);
+            return;
+        }
+        if (name_index == 0) {
+            name_index = index;
+        }
+    }
+
+    size_t entry_size = header.name.size() + header.value.size() + kEntryOverhead;
+    bool index = !header.sensitive && ShouldIndex(header.name, entry_size);
+    if (index) {
+        EncodeInteger(out, 0x40, 6, name_index);      // 6.2.1 带增量索引
+    } else if (header.sensitive) {
+        EncodeInteger(out, 0x10, 4, name_index);      // 6.2.3 永不索引
+    } else {
+        EncodeInteger(out, 0x00, 4, name_index);      // 6.2.2 不索引
+    }
+    if (name_index == 0) {
+        EncodeString(out, header.name);
+    }
+    EncodeString(out, header.value);
+
+    if (index) {
+        AddToDynamicTable(header.name, header.value);
+    }
+}
+
+bool HpackEncoder::ShouldIndex(const std::string& name, size_t entry_size) const {
+    // 过大的条目会一次性冲掉大部分动态表
+    if (entry_size > max_table_size_ * 3 / 4) {
+        return false;
+    }
+    return !IsVolatileHeader(name);
+}
+
+void HpackEncoder::AddToDynamicTable(const std::string& name, const std::string& value) {
+    uint32_t entry_size = static_cast<uint32_t>(name.size() + value.size() + kEntryOverhead);
+    EvictTo(max_table_size_ - entry_size);
+    dynamic_table_.push_front({name, value});
+    table_usage_ += entry_size;
+    ++generation_;
+}
+
+void HpackEncoder::EvictTo(uint32_t size) {
+    while (!dynamic_table_.empty() && table_usage_ > size) {
+        const DynamicEntry& oldest = dynamic_table_.back();
+        table_usage_ -= static_cast<uint32_t>(oldest.name.size() + oldest.value.size() + kEntryOverhead);
+        dynamic_table_.pop_back();
+    }
+}
+
+void HpackEncoder::EncodeInteger(std::vector<uint8_t>& out, uint8_t first_byte_flags,
+                                 uint8_t prefix_bits, uint32_t value) {
+    // RFC 7541 Section 5.1
+    uint32_t max_prefix = (1u << prefix_bits) - 1;
+    if (value < max_prefix) {
+        out.push_back(static_cast<uint8_t>(first_byte_flags | value));
+        return;
+    }
+    out.push_back(static_cast<uint8_t>(first_byte_flags | max_prefix));
+    value -= max_prefix;
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+void HpackEncoder::EncodeString(std::vector<uint8_t>& out, std::string_view str) {
+    // RFC 7541 Section 5.2：哈夫曼编码更短时使用
+    size_t huffman_len = HpackHuffman::EncodedLength(str);
+    if (huffman_len < str.size()) {
+        EncodeInteger(out, 0x80, 7, static_cast<uint32_t>(huffman_len));
+        HpackHuffman::Encode(str, out);
+    } else {
+        EncodeInteger(out, 0x00, 7, static_cast<uint32_t>(str.size()));
+        out.insert(out.end(), str.begin(), str.end());
+    }
+}
+
+} // namespace http2
+} // namespace tinywebserver
@@ -0,0 +1,296 @@
+#include "http2/hpack_huffman.h"
+#include <algorithm>
+#include <array>
+
+namespace tinywebserver {
+namespace http2 {
+
+// 码表（RFC 7541 Appendix B），下标即符号，256 为 EOS
+constexpr HpackHuffman::Code HpackHuffman::kCodes[257] = {
+    {0x00001ff8, 13}, {0x007fffd8, 23}, {0x0fffffe2, 28}, {0x0fffffe3, 28},
+    {0x0fffffe4, 28}, {0x0fffffe5, 28}, {0x0fffffe6, 28}, {0x0fffffe7, 28},
+    {0x0fffffe8, 28}, {0x00ffffea, 24}, {0x3ffffffc, 30}, {0x0fffffe9, 28},
+    {0x0fffffea, 28}, {0x3ffffffd, 30}, {0x0fffffeb, 28}, {0x0fffffec, 28},
+    {0x0fffffed, 28}, {0x0fffffee, 28}, {0x0fffffef, 28}, {0x0ffffff0, 28},
+    {0x0ffffff1, 28}, {0x0ffffff2, 28}, {0x3ffffffe, 30}, {0x0ffffff3, 28},
+    {0x0ffffff4, 28}, {0x0ffffff5, 28}, {0x0ffffff6, 28}, {0x0ffffff7, 28},
+    {0x0ffffff8, 28}, {0x0ffffff9, 28}, {0x0ffffffa, 28}, {0x0ffffffb, 28},
+    {0x00000014, 6}, {0x000003f8, 10}, {0x000003f9, 10}, {0x00000ffa, 12},
+    {0x00001ff9, 13}, {0x00000015, 6}, {0x000000f8, 8}, {0x000007fa, 11},
+    {0x000003fa, 10}, {0x000003fb, 10}, {0x000000f9, 8}, {0x000007fb, 11},
+    {0x000000fa, 8}, {0x00000016, 6}, {0x00000017, 6}, {0x00000018, 6},
+    {0x00000000, 5}, {0x00000001, 5}, {0x00000002, 5}, {0x00000019, 6},
+    {0x0000001a, 6}, {0x0000001b, 6}, {0x0000001c, 6}, {0x0000001d, 6},
+    {0x0000001e, 6}, {0x0000001f, 6}, {0x0000005c, 7}, {0x000000fb, 8},
+    {0x00007ffc, 15}, {0x00000020, 6}, {0x00000ffb, 12}, {0x000003fc, 10},
+    {0x00001ffa, 13}, {0x00000021, 6}, {0x0000005d, 7}, {0x0000005e, 7},
+    {0x0000005f, 7}, {0x00000060, 7}, {0x00000061, 7}, {0x00000062, 7},
+    {0x00000063, 7}, {0x00000064, 7}, {0x00000065, 7}, {0x00000066, 7},
+    {0x00000067, 7}, {0x00000068, 7}, {0x00000069, 7}, {0x0000006a, 7},
+    {0x0000006b, 7}, {0x0000006c, 7}, {0x0000006d, 7}, {0x0000006e, 7},
+    {0x0000006f, 7}, {0x00000070, 7}, {0x00000071, 7}, {0x00000072, 7},
+    {0x000000fc, 8}, {0x00000073, 7}, {0x000000fd, 8}, {0x00001ffb, 13},
+    {0x0007fff0, 19}, {0x00001ffc, 13}, {0x00003ffc, 14}, {0x00000022, 6},
+    {0x00007ffd, 15}, {0x00000003, 5}, {0x00000023, 6}, {0x00000004, 5},
+    {0x00000024, 6}, {0x00000005, 5}, {0x00000025, 6}, {0x00000026, 6},
+    {0x00000027, 6}, {0x00000006, 5}, {0x00000074, 7}, {0x00000075, 7},
+    {0x00000028, 6}, {0x00000029, 6}, {0x0000002a, 6}, {0x00000007, 5},
+    {0x0000002b, 6}, {0x00000076, 7}, {0x0000002c, 6}, {0x00000008, 5},
+    {0x00000009, 5}, {0x0000002d, 6}, {0x00000077, 7}, {0x00000078, 7},
+    {0x00000079, 7}, {0x0000007a, 7}, {0x0000007b, 7}, {0x00007ffe, 15},
+    {0x000007fc, 11}, {0x00003ffd, 14}, {0x00001ffd, 13}, {0x0ffffffc, 28},
+    {0x000fffe6, 20}, {0x003fffd2, 22}, {0x000fffe7, 20}, {0x000fffe8, 20},
+    {0x003fffd3, 22}, {0x003fffd4, 22}, {0x003fffd5, 22}, {0x007fffd9, 23},
+    {0x003fffd6, 22}, {0x007fffda, 23}, {0x007fffdb, 23}, {0x007fffdc, 23},
+    {0x007fffdd, 23}, {0x007fffde, 23}, {0x00ffffeb, 24}, {0x007fffdf, 23},
+    {0x00ffffec, 24}, {0x00ffffed, 24}, {0x003fffd7, 22}, {0x007fffe0, 23},
+    {0x00ffffee, 24}, {0x007fffe1, 23}, {0x007fffe2, 23}, {0x007fffe3, 23},
+    {0x007fffe4, 23}, {0x001fffdc, 21}, {0x003fffd8, 22}, {0x007fffe5, 23},
+    {0x003fffd9, 22}, {0x007fffe6, 23}, {0x007fffe7, 23}, {0x00ffffef, 24},
+    {0x003fffda, 22}, {0x001fffdd, 21}, {0x000fffe9, 20}, {0x003fffdb, 22},
+    {0x003fffdc, 22}, {0x007fffe8, 23}, {0x007fffe9, 23}, {0x001fffde, 21},
+    {0x007fffea, 23}, {0x003fffdd, 22}, {0x003fffde, 22}, {0x00fffff0, 24},
+    {0x001fffdf, 21}, {0x003fffdf, 22}, {0x007fffeb, 23}, {0x007fffec, 23},
+    {0x001fffe0, 21}, {0x001fffe1, 21}, {0x003fffe0, 22}, {0x001fffe2, 21},
+    {0x007fffed, 23}, {0x003fffe1, 22}, {0x007fffee, 23}, {0x007fffef, 23},
+    {0x000fffea, 20}, {0x003fffe2, 22}, {0x003fffe3, 22}, {0x003fffe4, 22},
+    {0x007ffff0, 23}, {0x003fffe5, 22}, {0x003fffe6, 22}, {0x007ffff1, 23},
+    {0x03ffffe0, 26}, {0x03ffffe1, 26}, {0x000fffeb, 20}, {0x0007fff1, 19},
+    {0x003fffe7, 22}, {0x007ffff2, 23}, {0x003fffe8, 22}, {0x01ffffec, 25},
+    {0x03ffffe2, 26}, {0x03ffffe3, 26}, {0x03ffffe4, 26}, {0x07ffffde, 27},
+    {0x07ffffdf, 27}, {0x03ffffe5, 26}, {0x00fffff1, 24}, {0x01ffffed, 25},
+    {0x0007fff2, 19}, {0x001fffe3, 21}, {0x03ffffe6, 26}, {0x07ffffe0, 27},
+    {0x07ffffe1, 27}, {0x03ffffe7, 26}, {0x07ffffe2, 27}, {0x00fffff2, 24},
+    {0x001fffe4, 21}, {0x001fffe5, 21}, {0x03ffffe8, 26}, {0x03ffffe9, 26},
+    {0x0ffffffd, 28}, {0x07ffffe3, 27}, {0x07ffffe4, 27}, {0x07ffffe5, 27},
+    {0x000fffec, 20}, {0x00fffff3, 24}, {0x000fffed, 20}, {0x001fffe6, 21},
+    {0x003fffe9, 22}, {0x001fffe7, 21}, {0x001fffe8, 21}, {0x007ffff3, 23},
+    {0x003fffea, 22}, {0x003fffeb, 22}, {0x01ffffee, 25}, {0x01ffffef, 25},
+    {0x00fffff4, 24}, {0x00fffff5, 24}, {0x03ffffea, 26}, {0x007ffff4, 23},
+    {0x03ffffeb, 26}, {0x07ffffe6, 27}, {0x03ffffec, 26}, {0x03ffffed, 26},
+    {0x07ffffe7, 27}, {0x07ffffe8, 27}, {0x07ffffe9, 27}, {0x07ffffea, 27},
+    {0x07ffffeb, 27}, {0x0ffffffe, 28}, {0x07ffffec, 27}, {0x07ffffed, 27},
+    {0x07ffffee, 27}, {0x07ffffef, 27}, {0x07fffff0, 27}, {0x03ffffee, 26},
+    {0x3fffffff, 30},
+};
+
+namespace {
+
+constexpr int kMaxCodeBits = 30;
+
+/**
+ * @brief 规范哈夫曼解码表：同一码长的码值连续，按 (码长, 码值) 排序后
+ * 只需记录每个码长的首码、个数和在符号数组中的起始下标
+ */
+struct CanonicalTable {
+    std::array<uint32_t, kMaxCodeBits + 1> first_code{};
+    std::array<uint16_t, kMaxCodeBits + 1> count{};
+    std::array<uint16_t, kMaxCodeBits + 1> offset{};
+    std::array<uint16_t, 257> symbols{};
+
+    CanonicalTable() {
+        for (uint16_t sym = 0; sym < 257; ++sym) {
+            symbols[sym] = sym;
+        }
+        std::sort(symbols.begin(), symbols.end(), [](uint16_t a, uint16_t b) {
+            const auto& ca = HpackHuffman::kCodes[a];
+            const auto& cb = HpackHuffman::kCodes[b];
+            return ca.bits != cb.bits ? ca.bits < cb.bits : ca.code < cb.code;
+        });
+        for (uint16_t i = 0; i < 257; ++i) {
+            const auto& c = HpackHuffman::kCodes[symbols[i]];
+            if (count[c.bits] == 0) {
+                first_code[c.bits] = c.code;
+                offset[c.bits] = i;
+            }
+            ++count[c.bits];
+        }
+    }
+};
+
+const CanonicalTable& GetCanonicalTable() {
+    static const CanonicalTable table;
+    return table;
+}
+
+/**
+ * @brief 哈夫曼树：257 个叶子的满二叉树共 256 个内部节点，节点 0 为根
+ *
+ * children 取值：正数为内部节点编号，负数 -(sym + 1) 为叶子。
+ */
+struct HuffmanTree {
+    int16_t children[256][2];
+    bool padding_ok[256];   ///< 从根出发不超过 7 位的全 1 路径（EOS 前缀）上的节点
+    int node_count;
+};
+
+constexpr HuffmanTree BuildTree() {
+    HuffmanTree tree{};
+    tree.node_count = 1;
+    for (int sym = 0; sym < 257; ++sym) {
+        const auto& code = HpackHuffman::kCodes[sym];
+        int node = 0;
+        for (int i = code.bits - 1; i > 0; --i) {
+            int bit = (code.code >> i) & 0x1;
+            if (tree.children[node][bit] == 0) {
+                tree.children[node][bit] = static_cast<int16_t>(tree.node_count++);
+            }
+            node = tree.children[node][bit];
+        }
+        tree.children[node][code.code & 0x1] = static_cast<int16_t>(-(sym + 1));
+    }
+    int node = 0;
+    for (int depth = 0; depth < 8; ++depth) {
+        tree.padding_ok[node] = true;
+        node = tree.children[node][1];
+    }
+    return tree;
+}
+
+static_assert(BuildTree().node_count == 256, "HPACK Huffman code table is not a complete prefix code");
+
+enum DecodeFlags : uint8_t {
+    kFlagSymbol = 0x1,   ///< 本步完成一个符号
+    kFlagAccept = 0x2,   ///< 停在此处时剩余位是合法填充
+    kFlagFail = 0x4      ///< 解出 EOS
+};
+
+struct DecodeEntry {
+    uint8_t state;
+    uint8_t flags;
+    uint8_t symbol;
+};
+
+/// 4 位一步的状态转移表：entries[状态][半字节]
+struct DecodeTable {
+    DecodeEntry entries[256][16];
+};
+
+constexpr DecodeTable BuildDecodeTable() {
+    const HuffmanTree tree = BuildTree();
+    DecodeTable table{};
+    for (int state = 0; state < 256; ++state) {
+        for (int nibble = 0; nibble < 16; ++nibble) {
+            int node = state;
+            uint8_t flags = 0;
+            uint8_t symbol = 0;
+            for (int i = 3; i >= 0; --i) {
+                int child = tree.children[node][(nibble >> i) & 0x1];
+                if (child >= 0) {
+                    node = child;
+                    continue;
+                }
+                int sym = -child - 1;
+                if (sym == HpackHuffman::kEosSymbol) {
+                    flags = kFlagFail;
+                    break;
+                }
+                flags |= kFlagSymbol;
+                symbol = static_cast<uint8_t>(sym);
+                node = 0;
+            }
+            if (!(flags & kFlagFail) && tree.padding_ok[node]) {
+                flags |= kFlagAccept;
+            }
+            table.entries[state][nibble] = {static_cast<uint8_t>(node), flags, symbol};
+        }
+    }
+    return table;
+}
+
+constexpr DecodeTable kDecodeTable = BuildDecodeTable();
+
+} // namespace
+
+size_t HpackHuffman::EncodedLength(std::string_view input) {
+    size_t bits = 0;
+    for (unsigned char c : input) {
+        bits += kCodes[c].bits;
+    }
+    return (bits + 7) / 8;
+}
+
+void HpackHuffman::Encode(std::string_view input, std::vector<uint8_t>& out) {
+    // 64 位累加器：最长码 30 位，累积不足 8 位时才追加，不会溢出
+    uint64_t acc = 0;
+    int acc_bits = 0;
+    for (unsigned char c : input) {
+        const Code& code = kCodes[c];
+        acc = (acc << code.bits) | code.code;
+        acc_bits += code.bits;
+        while (acc_bits >= 8) {
+            acc_bits -= 8;
+            out.push_back(static_cast<uint8_t>(acc >> acc_bits));
+        }
+    }
+    if (acc_bits > 0) {
+        // 填充取 EOS 码的高位（全 1）
+        out.push_back(static_cast<uint8_t>((acc << (8 - acc_bits)) | (0xFFu >> acc_bits)));
+    }
+}
+
+Error HpackHuffman::Decode(const uint8_t* data, size_t len, std::string& out) {
+    // 最短码 5 位，输出不超过 len * 8 / 5 字节：先一次扩容，循环内直接写入
+    // （多留 1 字节供无分支写入）
+    size_t base = out.size();
+    out.resize(base + len * 8 / 5 + 1);
+    char* dst = &out[base];
+
+    uint8_t state = 0;
+    uint8_t flags = kFlagAccept;
+    for (size_t i = 0; i < len; ++i) {
+        for (int shift = 4; shift >= 0; shift -= 4) {
+            const DecodeEntry& entry = kDecodeTable.entries[state][(data[i] >> shift) & 0xF];
+            if (entry.flags & kFlagFail) {
+                out.resize(base);
+                return Error(WebError::kParseError, "HPACK Huffman string contains EOS");
+            }
+            // 无分支输出：总是写入，仅在完成符号时前移（是否出符号难以预测）
+            *dst = static_cast<char>(entry.symbol);
+            dst += entry.flags & kFlagSymbol;
+            state = entry.state;
+            flags = entry.flags;
+        }
+    }
+    out.resize(static_cast<size_t>(dst - out.data()));
+
+    if (!(flags & kFlagAccept)) {
+        out.resize(base);
+        return Error(WebError::kParseError, "Invalid HPACK Huffman padding");
+    }
+    return Error::Success();
+}
+
+Error HpackHuffman::DecodeReference(const uint8_t* data, size_t len, std::string& out) {
+    const CanonicalTable& table = GetCanonicalTable();
+    uint32_t code = 0;
+    int bits = 0;
+
+    for (size_t i = 0; i < len; ++i) {
+        for (int shift = 7; shift >= 0; --shift) {
+            code = (code << 1) | ((data[i] >> shift) & 0x1);
+            ++bits;
+            if (table.count[bits] != 0 && code >= table.first_code[bits] &&
+                code - table.first_code[bits] < table.count[bits]) {
+                uint16_t sym = table.symbols[table.offset[bits] + (code - table.first_code[bits])];
+                if (sym == kEosSymbol) {
+                    return Error(WebError::kParseError, "HPACK Huffman string contains EOS");
+                }
+                out.push_back(static_cast<char>(sym));
+                code = 0;
+                bits = 0;
+            } else if (bits >= kMaxCodeBits) {
+                return Error(WebError::kParseError, "Invalid HPACK Huffman code");
+            }
+        }
+    }
+
+    // 剩余位为填充：不超过 7 位且必须是 EOS 码的高位（全 1）
+    if (bits > 7 || code != (1u << bits) - 1) {
+        return Error(WebError::kParseError, "Invalid HPACK Huffman padding");
+    }
+    return Error::Success();
+}
+
+} // namespace http2
+} // namespace tinywebserver
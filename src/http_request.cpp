@@ -49,6 +49,21 @@ bool HttpRequest::Parse(std::string& buffer) {
     return true;
 }
 
+void HttpRequest::InitFromFields(const std::string& method, const std::string& path,
+                                 const std::string& version,
+                                 std::unordered_map<std::string, std::string> headers) {
+    method_ = method;
+    path_ = path;
+    version_ = version;
+    headers_ = std::move(headers);
+
+    // 与请求行解析保持一致的路径归一化
+    if (path_.empty() || path_ == "/") {
+        path_ = "/index.html";
+    }
+    is_finished_ = true;
+}
+
 bool HttpRequest::ParseRequestLine(const std::string& line) {
     std::istringstream iss(line);
     if (!(iss >> method_ >> path_ >> version_)) {
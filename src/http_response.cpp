@@ -31,9 +31,13 @@ const std::unordered_map<std::string, std::string> HttpResponse::SUFFIX_TYPE = {
 
 const std::unordered_map<int, std::string> HttpResponse::CODE_STATUS = {
     {200, "OK"},
+    {201, "Created"},
     {400, "Bad Request"},
     {403, "Forbidden"},
     {404, "Not Found"},
+    {405, "Method Not Allowed"},
+    {413, "Payload Too Large"},
+    {500, "Internal Server Error"},
 };
 
 const std::unordered_map<int, std::string> HttpResponse::CODE_PATH = {
@@ -61,8 +65,10 @@ void HttpResponse::Init(const std::string& src_dir, const std::string& path, boo
     is_keep_alive_ = is_keep_alive;
     path_ = path;
     src_dir_ = src_dir;
+    pending_ = false;
     file_body_ = nullptr;
     body_string_.clear();
+    content_type_.clear();
     status_line_.clear();
     headers_.clear();
 
@@ -115,7 +121,18 @@ void HttpResponse::MakeResponse()
     // 4. 加载资源 (mmap 零拷贝)
     if (code_ == 200)
     {
-        file_body_ = StaticResourceManager::GetInstance().GetResource(full_path);
+        if (resource_provider_)
+        {
+            file_body_ = resource_provider_(full_path, pending_);
+            if (pending_)
+            {
+                return; // 资源加载中，由调用方在完成后重建响应
+            }
+        }
+        else
+        {
+            file_body_ = StaticResourceManager::GetInstance().GetResource(full_path);
+        }
         if (!file_body_)
         {
             code_ = 404; // mmap 失败降级
@@ -134,9 +151,14 @@ void HttpResponse::MakeResponse()
     AddContent_();
 }
 
+std::string HttpResponse::GetStatusText(int code) {
+    auto it = CODE_STATUS.find(code);
+    return it != CODE_STATUS.end() ? it->second : "Unknown";
+}
+
 void HttpResponse::AddStateLine_()
 {
-    std::string status = CODE_STATUS.count(code_) ? CODE_STATUS.at(code_) : "Unknown";
+    std::string status = GetStatusText(code_);
     status_line_ = "HTTP/1.1 " + std::to_string(code_) + " " + status + "\r\n";
 }
 
@@ -166,7 +188,7 @@ void HttpResponse::AddHeader_() {
     }
 
     // 正常响应的头部
-    header_string_ += "Content-Type: " + GetFileType_() + "\r\n";
+    header_string_ += "Content-Type: " + GetContentType() + "\r\n";
 
     // 获取长度：如果是静态文件则取文件大小，否则取错误页面的 body_string_ 大小
     size_t body_len = GetBodyLen();
@@ -198,8 +220,15 @@ void HttpResponse::ErrorHtml_()
     }
 }
 
-std::string HttpResponse::GetFileType_()
+void HttpResponse::SetBody(std::string body, const std::string& content_type)
+{
+    body_string_ = std::move(body);
+    content_type_ = content_type;
+}
+
+std::string HttpResponse::GetContentType() const
 {
+    if (!content_type_.empty()) return content_type_;
     size_t idx = path_.find_last_of('.');
     if (idx == std::string::npos) return "text/plain";
     
@@ -0,0 +1,70 @@
+#include "latency_histogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace tinywebserver {
+
+uint64_t LatencyHistogram::Snapshot::Percentile(double quantile) const {
+    if (total_count == 0) {
+        return 0;
+    }
+    quantile = std::min(1.0, std::max(0.0, quantile));
+    uint64_t rank = static_cast<uint64_t>(std::ceil(quantile * static_cast<double>(total_count)));
+    if (rank == 0) {
+        rank = 1;
+    }
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        seen += counts[i];
+        if (seen >= rank) {
+            // 桶上界不超过实际观测到的最大值
+            return std::min(BucketUpperBound(i), max_value);
+        }
+    }
+    return max_value;
+}
+
+uint64_t LatencyHistogram::Snapshot::CountAtOrBelow(uint64_t value_ns) const {
+    uint64_t total = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        if (BucketUpperBound(i) > value_ns) {
+            break;
+        }
+        total += counts[i];
+    }
+    return total;
+}
+
+void LatencyHistogram::MergeInto(Snapshot& out) const {
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        out.counts[i] += counts_[i].load(std::memory_order_relaxed);
+    }
+    out.total_count += total_count_.load(std::memory_order_relaxed);
+    out.total_sum += total_sum_.load(std::memory_order_relaxed);
+    out.max_value = std::max(out.max_value, max_value_.load(std::memory_order_relaxed));
+}
+
+void LatencyHistogram::MergeFrom(const LatencyHistogram& other) {
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        Bump(counts_[i], other.counts_[i].load(std::memory_order_relaxed));
+    }
+    Bump(total_count_, other.total_count_.load(std::memory_order_relaxed));
+    Bump(total_sum_, other.total_sum_.load(std::memory_order_relaxed));
+    uint64_t other_max = other.max_value_.load(std::memory_order_relaxed);
+    if (other_max > max_value_.load(std::memory_order_relaxed)) {
+        max_value_.store(other_max, std::memory_order_relaxed);
+    }
+}
+
+void LatencyHistogram::Clear() {
+    for (auto& counter : counts_) {
+        counter.store(0, std::memory_order_relaxed);
+    }
+    total_count_.store(0, std::memory_order_relaxed);
+    total_sum_.store(0, std::memory_order_relaxed);
+    max_value_.store(0, std::memory_order_relaxed);
+}
+
+} // namespace tinywebserver
@@ -6,17 +6,338 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <fstream>
+#include <optional>
+#include <algorithm>
+#include <cctype>
 #include "server.h"
 #include "http_response.h"
 #include "http_request.h"
 #include "connection.h"
+#include "http2/h2_stream.h"
+#include "http/request_body.h"
+#include "http/response_writer.h"
 #include "Logger.h"
 #include "request_validator.h"
+#include "server_metrics.h"
+#include "perf_counters.h"
 #include "config/server_config.h"
 #include "logging/structured_logger.h"
 #include "plugin/plugin_manager.h"
 #include "plugin/example_plugin.h"
 
+namespace {
+
+/**
+ * @brief 校验请求并生成响应（HTTP/1.x 与 HTTP/2 共用），同时记录 validate/lookup 阶段耗时
+ */
+void BuildResponse(const std::string& static_root, const HttpRequest& request, HttpResponse& response) {
+    auto& metrics = tinywebserver::ServerMetrics::GetInstance();
+    // 请求安全验证
+    uint64_t validate_start = metrics.NowNs();
+    // respond 阶段硬件计数：校验 + 资源查找 + 响应生成
+    std::optional<tinywebserver::PerfPhaseScope> respond_perf;
+    respond_perf.emplace(tinywebserver::PerfPhase::kRespond);
+    tinywebserver::RequestValidator validator(static_root);
+    auto validation_result = validator.ValidateRequest(request);
+    uint64_t lookup_start = metrics.NowNs();
+    metrics.OnRequestPhase(tinywebserver::RequestPhase::kValidate, lookup_start - validate_start);
+
+    if (!validation_result.valid) {
+        // 验证失败，生成错误响应
+        // 根据错误类型选择状态码
+        int error_code = 400; // Bad Request
+        if (validation_result.error.GetCode() == tinywebserver::WebError::kInvalidPath) {
+            error_code = 403; // Forbidden 或 404 Not Found
+        } else if (validation_result.error.GetCode() == tinywebserver::WebError::kRequestTooLarge) {
+            error_code = 413; // Payload Too Large
+        } else if (validation_result.error.GetCode() == tinywebserver::WebError::kUnsupportedMethod) {
+            error_code = 405; // Method Not Allowed
+        }
+
+        // 生成错误响应，使用错误码
+        response.Init(static_root, "", request.IsKeepAlive(), error_code, &request);
+        response.MakeResponse();
+
+        LOG_WARN("Request validation failed: %s (code: %d)",
+                 validation_result.error.ToString().c_str(), error_code);
+    } else {
+        // 验证成功，使用规范化路径
+        // 确保路径以斜杠开头，以便正确拼接
+        std::string normalized_path = validation_result.normalized_path;
+        if (!normalized_path.empty() && normalized_path[0] != '/') {
+            normalized_path = "/" + normalized_path;
+        }
+        response.Init(static_root, normalized_path, request.IsKeepAlive(), -1, &request);
+        response.MakeResponse();
+    }
+
+    metrics.OnRequestPhase(tinywebserver::RequestPhase::kLookup, metrics.NowNs() - lookup_start);
+    respond_perf.reset();
+}
+
+/**
+ * @brief 经连接非阻塞获取静态资源：未命中时由后台线程加载，loop 不等待磁盘 I/O
+ * @param pending_path 非空时记录置 pending 的资源路径，供 Connection::ParkUntilLoaded 挂起请求
+ */
+HttpResponse::ResourceProvider MakeResourceProvider(Connection* conn, std::string* pending_path = nullptr) {
+    // 响应只在调用方的本次处理内构建，连接与 pending_path 必然存活
+    return [conn, pending_path](const std::string& full_path, bool& pending) {
+        auto resource = conn->AcquireStaticResource(full_path, pending);
+        if (pending && pending_path) {
+            *pending_path = full_path;
+        }
+        return resource;
+    };
+}
+
+/**
+ * @brief 流式响应结束（End 或中止）时记录状态码并结束 Keep-Alive 请求计数
+ */
+void OnStreamFinish(tinywebserver::ResponseWriter& writer, Connection* conn) {
+    // writer 持有连接，回调执行时连接必然存活
+    writer.SetFinishCallback([conn](int status_code, uint64_t body_bytes, const tinywebserver::Error& result) {
+        if (result.IsFailure()) {
+            LOG_WARN("Streaming response aborted after %llu bytes: %s",
+                     static_cast<unsigned long long>(body_bytes), result.ToString().c_str());
+        }
+        tinywebserver::ServerMetrics::GetInstance().OnRequestWithStatusCode(status_code);
+        conn->OnRequestComplete();
+    });
+}
+
+/**
+ * @brief 以静态资源响应 HTTP/2 流；资源在后台加载时流挂起，加载完成后重新执行
+ */
+void RespondH2Static(const std::string& static_root, Server* server, const std::shared_ptr<Connection>& conn,
+                     const std::shared_ptr<tinywebserver::http2::H2Stream>& stream, HttpRequest request) {
+    HttpResponse response;
+    std::string pending_path;
+    response.SetResourceProvider(MakeResourceProvider(conn.get(), &pending_path));
+    BuildResponse(static_root, request, response);
+    if (response.IsPending()) {
+        // retry 由连接持有，只在连接存活时执行
+        Connection* raw_conn = conn.get();
+        conn->ParkUntilLoaded(pending_path, [static_root, server, raw_conn, stream, request]() {
+            RespondH2Static(static_root, server, raw_conn->shared_from_this(), stream, request);
+        });
+        return;
+    }
+    server->GetPluginManager().NotifyRequestComplete(request, response);
+
+    int status_code = response.GetCode();
+    bool has_body = request.GetMethod() != "HEAD" && status_code != 304;
+    tinywebserver::http2::H2Stream::Headers response_headers;
+    response_headers[":status"] = std::to_string(status_code);
+    if (status_code != 304) {
+        response_headers["content-type"] = response.GetContentType();
+        response_headers["content-length"] = std::to_string(response.GetBodyLen());
+    }
+
+    auto err = stream->SendHeaders(response_headers, !has_body);
+    if (err.IsSuccess() && has_body) {
+        if (response.HasFileBody()) {
+            err = stream->SendFile(response.GetFileBody(), true);
+        } else {
+            const std::string& body = response.GetBodyString();
+            err = stream->SendData(reinterpret_cast<const uint8_t*>(body.data()), body.size(), true);
+        }
+    }
+    if (err.IsFailure()) {
+        LOG_WARN("HTTP/2 stream %u response failed: %s", stream->GetStreamId(), err.ToString().c_str());
+    }
+
+    tinywebserver::ServerMetrics::GetInstance().OnRequestWithStatusCode(status_code);
+    conn->OnRequestComplete();
+}
+
+/**
+ * @brief 处理一个 HTTP/2 流上的请求：伪头部映射为 HttpRequest，响应经流控分帧发送
+ */
+void HandleH2Request(const std::string& static_root, int keep_alive_timeout, Server* server,
+                     const std::shared_ptr<Connection>& conn,
+                     const std::shared_ptr<tinywebserver::http2::H2Stream>& stream) {
+    std::string method;
+    std::string path;
+    std::unordered_map<std::string, std::string> headers;
+    for (const auto& [name, value] : stream->GetRequestHeaders()) {
+        if (name == ":method") {
+            method = value;
+        } else if (name == ":path") {
+            path = value;
+        } else if (!name.empty() && name[0] != ':') {
+            headers[name] = value;
+        }
+    }
+
+    HttpRequest request;
+    request.InitFromFields(method, path, "HTTP/2.0", std::move(headers));
+
+    // 多路复用连接：每个流都按 keep-alive 请求计
+    conn->OnRequestStart(true, keep_alive_timeout);
+    server->GetPluginManager().NotifyRequestStart(request);
+
+    if (const auto* handler = server->FindStreamRoute(path)) {
+        auto writer = tinywebserver::Http2ResponseWriter::Create(conn, stream, method == "HEAD");
+        OnStreamFinish(*writer, conn.get());
+        (*handler)(request, writer);
+        return;
+    }
+    RespondH2Static(static_root, server, conn, stream, std::move(request));
+}
+
+/**
+ * @brief 请求体相关配置
+ */
+struct BodyOptions {
+    std::string upload_dir;         ///< 空表示不接受上传
+    uint64_t max_upload_size = 0;
+    uint64_t max_request_size = 0;  ///< 普通请求的请求体上限
+};
+
+void SendResponse(Connection& conn, const HttpResponse& response) {
+    conn.Send(response.GetHeaderString());
+    if (response.HasFileBody()) {
+        conn.Send(response.GetFileBody());
+    } else {
+        conn.Send(response.GetBodyString());
+    }
+}
+
+/// 带请求体的请求响应已发出：记录状态码，出错时关闭写端
+void CompleteBodyRequest(Connection& conn, int status_code) {
+    tinywebserver::ServerMetrics::GetInstance().OnRequestWithStatusCode(status_code);
+    conn.OnRequestComplete();
+    if (status_code >= 400) {
+        conn.Shutdown();
+    }
+}
+
+/**
+ * @brief 请求体已完整丢弃后按静态资源响应；资源在后台加载时挂起本请求，
+ *        期间连接不再分派后续请求，加载完成后重新执行
+ */
+void RespondAfterBody(const std::shared_ptr<Connection>& conn, HttpRequest request,
+                      const std::string& static_root, Server* server) {
+    HttpResponse response;
+    std::string pending_path;
+    response.SetResourceProvider(MakeResourceProvider(conn.get(), &pending_path));
+    BuildResponse(static_root, request, response);
+    if (response.IsPending()) {
+        Connection* raw_conn = conn.get();   // retry 由连接持有，只在连接存活时执行
+        conn->ParkUntilLoaded(pending_path, [raw_conn, request, static_root, server]() {
+            RespondAfterBody(raw_conn->shared_from_this(), request, static_root, server);
+        });
+        return;
+    }
+    server->GetPluginManager().NotifyRequestComplete(request, response);
+    SendResponse(*conn, response);
+    CompleteBodyRequest(*conn, response.GetCode());
+}
+
+int StatusForBodyError(const tinywebserver::Error& err) {
+    switch (err.GetCode()) {
+    case tinywebserver::WebError::kRequestTooLarge:
+        return 413;
+    case tinywebserver::WebError::kInvalidRequest:
+        return 400;
+    default:
+        return 500;
+    }
+}
+
+/// POST /upload/<name>：name 只允许字母、数字与 ._-，且不以 . 开头
+bool IsUploadRequest(const BodyOptions& options, const HttpRequest& request, std::string& name) {
+    static const std::string kPrefix = "/upload/";
+    const std::string path = request.GetPath();
+    if (options.upload_dir.empty() || request.GetMethod() != "POST" || path.compare(0, kPrefix.size(), kPrefix) != 0) {
+        return false;
+    }
+    name = path.substr(kPrefix.size());
+    bool valid = !name.empty() && name[0] != '.' && name.size() <= 255 &&
+                 std::all_of(name.begin(), name.end(), [](unsigned char c) {
+                     return std::isalnum(c) || c == '.' || c == '_' || c == '-';
+                 });
+    if (!valid) {
+        name.clear();
+    }
+    return true;
+}
+
+/**
+ * @brief 请求带消息体时接管后续输入：上传写入 upload_dir，其它请求的请求体读完即丢弃后按静态资源响应
+ * @param header_err 请求头中的请求体描述不合法时的错误，此时直接发送错误响应
+ * @return true 表示消息回调应停止处理输入（开始接收请求体，或出错已丢弃输入）；
+ *         false 表示请求已处理完（无请求体的上传），可继续解析下一个请求
+ */
+bool BeginRequestBody(const std::shared_ptr<Connection>& conn, HttpRequest request,
+                      std::unique_ptr<tinywebserver::BodyDecoder> decoder, bool is_upload,
+                      const std::string& upload_name, const BodyOptions& options,
+                      const std::string& static_root, Server* server,
+                      const tinywebserver::Error& header_err = tinywebserver::Error::Success()) {
+    std::unique_ptr<tinywebserver::BodySink> sink;
+    tinywebserver::FileUploadSink* upload = nullptr;
+    tinywebserver::Error open_err = header_err;
+    if (!is_upload) {
+        // 插件只观察静态资源请求，上传不通知
+        server->GetPluginManager().NotifyRequestStart(request);
+    }
+    if (open_err.IsFailure()) {
+        // 请求头中的请求体描述不合法：直接以错误响应结束
+    } else if (is_upload) {
+        auto file_sink = std::make_unique<tinywebserver::FileUploadSink>();
+        open_err = upload_name.empty()
+            ? tinywebserver::Error(tinywebserver::WebError::kInvalidRequest, "Invalid upload name")
+            : file_sink->Open(options.upload_dir + "/" + upload_name);
+        upload = file_sink.get();
+        sink = std::move(file_sink);
+    } else {
+        sink = std::make_unique<tinywebserver::DiscardSink>();
+    }
+
+    auto on_complete = [request, is_upload, upload, upload_name, static_root, server](
+            std::shared_ptr<Connection> c, const tinywebserver::Error& err) mutable {
+        int status_code;
+        if (err.IsFailure()) {
+            status_code = StatusForBodyError(err);
+            LOG_WARN("Request body rejected: %s (code: %d)", err.ToString().c_str(), status_code);
+            HttpResponse response;
+            response.Init(static_root, "", false, status_code, &request);
+            response.MakeResponse();
+            SendResponse(*c, response);
+            if (!is_upload) {
+                server->GetPluginManager().NotifyRequestComplete(request, response);
+            }
+        } else if (is_upload) {
+            status_code = 201;
+            HttpResponse response;
+            response.Init(static_root, "", request.IsKeepAlive(), status_code, &request);
+            response.SetBody("{\"path\": \"/upload/" + upload_name + "\", \"bytes\": " +
+                             std::to_string(upload->GetBytes()) + "}\n", "application/json");
+            response.MakeResponse();
+            SendResponse(*c, response);
+        } else {
+            // 请求体已完整丢弃，连接与下一个请求保持同步
+            RespondAfterBody(c, std::move(request), static_root, server);
+            return;
+        }
+        CompleteBodyRequest(*c, status_code);
+    };
+
+    if (open_err.IsFailure()) {
+        conn->GetInputBuffer().clear();
+        on_complete(conn, open_err);
+        return true;
+    }
+    if (!decoder->HasBody()) {
+        on_complete(conn, sink->Finish());
+        return false;
+    }
+    conn->StartRequestBody(std::move(decoder), std::move(sink), std::move(on_complete));
+    return true;
+}
+
+} // namespace
+
 int main(int argc, char* argv[]) {
     std::string config_file;
     // 简单命令行参数解析
@@ -85,9 +406,13 @@ int main(int argc, char* argv[]) {
     // 确定静态资源根目录和 Keep-Alive 超时
     std::string static_root = "./public"; // 默认值
     int keep_alive_timeout = 15; // 默认 15 秒
+    BodyOptions body_options;
     if (config) {
         static_root = config->GetStaticOptions().root;
         keep_alive_timeout = config->GetLimitsOptions().keep_alive_timeout;
+        body_options.upload_dir = config->GetStaticOptions().upload_dir;
+        body_options.max_upload_size = config->GetLimitsOptions().max_upload_size;
+        body_options.max_request_size = config->GetLimitsOptions().max_request_size;
     }
 
     // 注册并加载插件
@@ -96,9 +421,11 @@ int main(int argc, char* argv[]) {
     server->LoadPlugins();
 
     auto* server_ptr = server.get();
-    server->SetOnMessage([static_root, keep_alive_timeout, server_ptr](std::shared_ptr<Connection> conn, const std::string& /*data*/) {
+    server->SetOnMessage([static_root, keep_alive_timeout, body_options, server_ptr](
+            std::shared_ptr<Connection> conn, const std::string& /*data*/) {
         auto parser = conn->GetHttpParser();
         auto& buffer = conn->GetInputBuffer();
+        auto provider = MakeResourceProvider(conn.get());
 
         // 核心修复：循环处理，直到缓冲区数据不足以构成一个完整 Header
         while (true) {
@@ -107,46 +434,70 @@ int main(int argc, char* argv[]) {
                 break; // 数据不足，跳出等待下次 Read
             }
 
-            if (parser->Parse(buffer)) {
-                // Keep-Alive 管理：通知连接开始处理请求
-                conn->OnRequestStart(parser->IsKeepAlive(), keep_alive_timeout);
+            auto& metrics = tinywebserver::ServerMetrics::GetInstance();
+            uint64_t parse_start = metrics.NowNs();
+            bool parsed;
+            {
+                tinywebserver::PerfPhaseScope perf_scope(tinywebserver::PerfPhase::kParse);
+                parsed = parser->Parse(buffer);
+            }
+            metrics.OnRequestPhase(tinywebserver::RequestPhase::kParse, metrics.NowNs() - parse_start);
 
-                // 插件事件：请求开始
-                server_ptr->GetPluginManager().NotifyRequestStart(*parser);
+            if (parsed) {
+                // 请求体：Content-Length 或 chunked，按请求头判定，不合法时直接拒绝
+                std::string upload_name;
+                bool is_upload = IsUploadRequest(body_options, *parser, upload_name);
+                auto decoder = std::make_unique<tinywebserver::BodyDecoder>();
+                tinywebserver::Error body_err = decoder->Init(
+                    *parser, is_upload ? body_options.max_upload_size : body_options.max_request_size);
+                if (body_err.IsFailure() || is_upload || decoder->HasBody()) {
+                    buffer.erase(0, header_end + 4);
+                    conn->OnRequestStart(parser->IsKeepAlive(), keep_alive_timeout);
+                    HttpRequest request = *parser;
+                    parser->Reset();
+                    if (body_err.IsFailure()) {
+                        buffer.clear();
+                        BeginRequestBody(conn, request, nullptr, is_upload, upload_name, body_options, static_root,
+                                         server_ptr, body_err);
+                        break;
+                    }
+                    if (BeginRequestBody(conn, request, std::move(decoder), is_upload, upload_name, body_options,
+                                         static_root, server_ptr)) {
+                        break;
+                    }
+                    continue;
+                }
 
-                // 请求安全验证
-                tinywebserver::RequestValidator validator(static_root);
-                auto validation_result = validator.ValidateRequest(*parser);
+                if (const auto* handler = server_ptr->FindStreamRoute(parser->GetPath())) {
+                    // 动态内容边生成边发送；响应结束前后续请求留在缓冲区
+                    buffer.erase(0, header_end + 4);
+                    conn->OnRequestStart(parser->IsKeepAlive(), keep_alive_timeout);
+                    HttpRequest request = *parser;
+                    parser->Reset();
+                    server_ptr->GetPluginManager().NotifyRequestStart(request);
+                    auto writer = tinywebserver::Http1ResponseWriter::Create(conn, request);
+                    OnStreamFinish(*writer, conn.get());
+                    (*handler)(request, writer);
+                    if (conn->IsStreamingResponse() || !conn->IsConnected()) {
+                        break;
+                    }
+                    continue;
+                }
 
                 HttpResponse response;
-                if (!validation_result.valid) {
-                    // 验证失败，生成错误响应
-                    // 根据错误类型选择状态码
-                    int error_code = 400; // Bad Request
-                    if (validation_result.error.GetCode() == tinywebserver::WebError::kInvalidPath) {
-                        error_code = 403; // Forbidden 或 404 Not Found
-                    } else if (validation_result.error.GetCode() == tinywebserver::WebError::kRequestTooLarge) {
-                        error_code = 413; // Payload Too Large
-                    } else if (validation_result.error.GetCode() == tinywebserver::WebError::kUnsupportedMethod) {
-                        error_code = 405; // Method Not Allowed
-                    }
+                response.SetResourceProvider(provider);
+                BuildResponse(static_root, *parser, response);
+                if (response.IsPending()) {
+                    // 资源加载中：请求留在缓冲区，加载完成后连接重新调用本回调
+                    parser->Reset();
+                    break;
+                }
 
-                    // 生成错误响应，使用错误码
-                    response.Init(static_root, "", parser->IsKeepAlive(), error_code, parser.get());
-                    response.MakeResponse();
+                // Keep-Alive 管理：通知连接开始处理请求
+                conn->OnRequestStart(parser->IsKeepAlive(), keep_alive_timeout);
 
-                    LOG_WARN("Request validation failed: %s (code: %d)",
-                             validation_result.error.ToString().c_str(), error_code);
-                } else {
-                    // 验证成功，使用规范化路径
-                    // 确保路径以斜杠开头，以便正确拼接
-                    std::string normalized_path = validation_result.normalized_path;
-                    if (!normalized_path.empty() && normalized_path[0] != '/') {
-                        normalized_path = "/" + normalized_path;
-                    }
-                    response.Init(static_root, normalized_path, parser->IsKeepAlive(), -1, parser.get());
-                    response.MakeResponse();
-                }
+                // 插件事件：请求开始
+                server_ptr->GetPluginManager().NotifyRequestStart(*parser);
 
                 // 插件事件：请求完成
                 server_ptr->GetPluginManager().NotifyRequestComplete(*parser, response);
@@ -165,6 +516,7 @@ int main(int argc, char* argv[]) {
                 buffer.erase(0, header_end + 4);
 
                 int status_code = response.GetCode();
+                tinywebserver::ServerMetrics::GetInstance().OnRequestWithStatusCode(status_code);
                 parser->Reset(); // 为下一次解析重置状态
                 conn->OnRequestComplete(); // Keep-Alive 管理：请求处理完成
 
@@ -182,6 +534,11 @@ int main(int argc, char* argv[]) {
         }
     });
 
+    server->SetOnH2Request([static_root, keep_alive_timeout, server_ptr](
+            std::shared_ptr<Connection> conn, std::shared_ptr<tinywebserver::http2::H2Stream> stream) {
+        HandleH2Request(static_root, keep_alive_timeout, server_ptr, conn, stream);
+    });
+
     LOG_INFO("Server starting on port 8080...");
     server->Start();
     server->Run();
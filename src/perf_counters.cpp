@@ -0,0 +1,153 @@
+#include "perf_counters.h"
+#include "server_metrics.h"
+#include "Logger.h"
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+namespace tinywebserver {
+
+std::atomic<bool> PerfCounters::enabled_{false};
+
+namespace {
+
+constexpr int kCounterCount = 4;
+
+constexpr uint64_t kCounterConfigs[kCounterCount] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES,
+};
+
+/**
+ * @brief 当前线程的计数组，线程退出时关闭
+ */
+struct ThreadCounterGroup {
+    int fds[kCounterCount] = {-1, -1, -1, -1};
+    bool open = false;
+    bool failed = false;   ///< 打开失败过，不再重试
+
+    ~ThreadCounterGroup() { Close(); }
+
+    void Close() {
+        for (int& fd : fds) {
+            if (fd >= 0) {
+                ::close(fd);
+                fd = -1;
+            }
+        }
+        open = false;
+    }
+};
+
+thread_local ThreadCounterGroup t_group;
+
+/// 打开失败只告警一次（每个 EventLoop 线程都会尝试打开）
+std::atomic<bool> g_open_failure_logged{false};
+
+int PerfEventOpen(uint64_t config, int group_fd) {
+    struct perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.read_format = PERF_FORMAT_GROUP;
+    attr.disabled = (group_fd == -1) ? 1 : 0;   // 组长先禁用，整组打开后再统一启用
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    // pid = 0, cpu = -1：统计当前线程，跟随其在任意 CPU 上运行
+    return static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0));
+}
+
+std::atomic<PerfCounters::OpenFunction> g_open_function{&PerfEventOpen};
+
+} // namespace
+
+const char* PerfPhaseName(PerfPhase phase) {
+    switch (phase) {
+        case PerfPhase::kRead:    return "read";
+        case PerfPhase::kParse:   return "parse";
+        case PerfPhase::kRespond: return "respond";
+        case PerfPhase::kWrite:   return "write";
+        default:                  return "unknown";
+    }
+}
+
+bool PerfCounters::OpenForCurrentThread() {
+    if (!IsEnabled()) {
+        return false;
+    }
+    if (t_group.open) {
+        return true;
+    }
+    if (t_group.failed) {
+        return false;
+    }
+
+    OpenFunction open_counter = g_open_function.load(std::memory_order_relaxed);
+    for (int i = 0; i < kCounterCount; ++i) {
+        int fd = open_counter(kCounterConfigs[i], i == 0 ? -1 : t_group.fds[0]);
+        if (fd < 0) {
+            int saved_errno = errno;
+            if (!g_open_failure_logged.exchange(true, std::memory_order_relaxed)) {
+                LOG_WARN("PerfCounters: perf_event_open failed for counter %d: %s (errno=%d), "
+                         "hardware counters disabled, check /proc/sys/kernel/perf_event_paranoid",
+                         i, strerror(saved_errno), saved_errno);
+            }
+            t_group.Close();
+            t_group.failed = true;
+            return false;
+        }
+        t_group.fds[i] = fd;
+    }
+
+    ::ioctl(t_group.fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ::ioctl(t_group.fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    t_group.open = true;
+    LOG_INFO("PerfCounters: counter group opened for thread (leader fd=%d)", t_group.fds[0]);
+    return true;
+}
+
+void PerfCounters::CloseForCurrentThread() {
+    t_group.Close();
+    t_group.failed = false;
+}
+
+bool PerfCounters::Read(PerfSample& out) {
+    if (!t_group.open) {
+        out = PerfSample();
+        return false;
+    }
+
+    // PERF_FORMAT_GROUP 布局：nr, value[nr]
+    uint64_t buffer[1 + kCounterCount];
+    ssize_t n = ::read(t_group.fds[0], buffer, sizeof(buffer));
+    if (n != static_cast<ssize_t>(sizeof(buffer)) || buffer[0] != kCounterCount) {
+        out = PerfSample();
+        return false;
+    }
+    out.cycles = buffer[1];
+    out.instructions = buffer[2];
+    out.cache_misses = buffer[3];
+    out.branch_misses = buffer[4];
+    return true;
+}
+
+void PerfCounters::SetOpenFunction(OpenFunction fn) {
+    g_open_function.store(fn ? fn : &PerfEventOpen, std::memory_order_relaxed);
+}
+
+void PerfPhaseScope::Finish() {
+    PerfSample end;
+    if (PerfCounters::Read(end)) {
+        ServerMetrics::GetInstance().OnPerfSample(phase_, end - start_);
+    }
+}
+
+} // namespace tinywebserver
@@ -3,12 +3,71 @@
 #include "Logger.h"
 #include "http_request.h"
 #include "http_response.h"
+#include <algorithm>
+#include <cctype>
+#include <memory>
 #include <sstream>
 
+namespace {
+
+constexpr char kStreamPrefix[] = "/example/stream/";
+
+/**
+ * @brief 流式响应示例：逐行生成文本，积压超过高水位时暂停，可写后继续
+ */
+class LineGenerator : public std::enable_shared_from_this<LineGenerator> {
+public:
+    static constexpr size_t kPieceSize = 16 * 1024;
+
+    LineGenerator(std::shared_ptr<tinywebserver::ResponseWriter> writer, uint64_t bytes)
+        : writer_(std::move(writer)), remaining_(bytes) {}
+
+    void Run() {
+        while (remaining_ > 0 && writer_->IsWritable()) {
+            std::string piece;
+            piece.reserve(kPieceSize + 32);
+            while (piece.size() < kPieceSize && piece.size() < remaining_) {
+                piece += "line " + std::to_string(line_++) + "\n";
+            }
+            piece.resize(std::min<uint64_t>(piece.size(), remaining_));
+            remaining_ -= piece.size();
+            if (writer_->Write(std::move(piece)).IsFailure()) {
+                return;
+            }
+        }
+        if (remaining_ == 0) {
+            writer_->End();
+        } else if (writer_->IsOpen()) {
+            // 连接关闭时回调同样执行，届时 IsOpen 为 false，生成器随之释放
+            writer_->OnWritable([self = shared_from_this()]() { self->Run(); });
+        }
+    }
+
+private:
+    std::shared_ptr<tinywebserver::ResponseWriter> writer_;
+    uint64_t remaining_;
+    uint64_t line_ = 0;
+};
+
+} // namespace
+
 bool ExamplePlugin::OnLoad(Server& server) {
     LOG_INFO("[ExamplePlugin] Plugin loaded successfully");
     connection_count_ = 0;
     request_count_ = 0;
+
+    // 示例：/example/stream/<KB> 返回指定大小（默认 64KB，上限 1GB）的 chunked 文本
+    server.AddStreamRoute(kStreamPrefix, [](const HttpRequest& request,
+                                            std::shared_ptr<tinywebserver::ResponseWriter> writer) {
+        std::string size_str = request.GetPath().substr(sizeof(kStreamPrefix) - 1);
+        uint64_t kb = 64;
+        if (!size_str.empty() && size_str.size() <= 7 &&
+            std::all_of(size_str.begin(), size_str.end(), [](unsigned char c) { return std::isdigit(c); })) {
+            kb = std::min<uint64_t>(std::stoull(size_str), 1024 * 1024);
+        }
+        writer->WriteHead(200, {{"Content-Type", "text/plain; charset=utf-8"}});
+        std::make_shared<LineGenerator>(std::move(writer), kb * 1024)->Run();
+    });
     return true;
 }
 
@@ -6,14 +6,22 @@
 #include "connection.h"
 #include "Logger.h"
 #include "config/server_config.h"
+#include "server_metrics.h"
+#include "static_resource_manager.h"
+#include "access_trace.h"
+#include "alloc_tag.h"
 
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <cstring>
 #include <cerrno>
+#include <csignal>
 #include <functional>
+#include <sstream>
+#include <iomanip>
 
 // ... 原有代码保持不变 ...
 int CreateListenSocket(unsigned short port, int backlog) {
@@ -32,6 +40,9 @@ int CreateListenSocket(unsigned short port, int backlog) {
     // 设置 SO_REUSEADDR 方便调试
     int opt = 1;
     setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    // 与 MultiListenSocket 默认一致：accept 出的连接继承 TCP_NODELAY，
+    // 响应头与响应体分两次写出时不会被 Nagle + 延迟确认卡住约 40ms
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
 
     if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
         LOG_ERROR("CreateListenSocket: bind() failed on port %d: %s (errno=%d)",
@@ -89,6 +100,16 @@ Server::Server(const std::shared_ptr<tinywebserver::ServerConfig>& config,
     }
 
     auto server_opts = config->GetServerOptions();
+    // 须在任何 EventLoop 线程启动前设置
+    tinywebserver::PerfCounters::SetEnabled(config->GetMetricsOptions().enable_perf_counters);
+    // 切换策略会清空静态资源缓存，只在与当前策略不同时设置
+    CachePolicy cache_policy;
+    auto& static_cache = StaticResourceManager::GetInstance();
+    if (ParseCachePolicy(config->GetStaticOptions().cache_policy, cache_policy) &&
+        static_cache.GetCachePolicy() != cache_policy) {
+        static_cache.SetCachePolicy(cache_policy);
+    }
+    static_cache.SetLoaderThreads(config->GetStaticOptions().loader_threads);
     ip_ = server_opts.ip;
     port_ = server_opts.port;
     backlog_ = server_opts.backlog;
@@ -105,6 +126,9 @@ Server::Server(const std::shared_ptr<tinywebserver::ServerConfig>& config,
     // 设置线程池线程数从配置
     thread_pool_->SetThreadNum(server_opts.threads);
 
+    // 预热完成（或超时）后才创建监听 socket，之前到达的连接被拒绝而不是排队等冷缓存
+    WarmUpStaticCache();
+
     // 根据配置选择启动模式
     if (reuseport_opts_.enabled) {
         SetupSOReusePortMode();
@@ -128,17 +152,37 @@ Server::~Server() {
 
 
 void Server::Start() {
+    // 0. 对端已关闭时 writev 会触发 SIGPIPE（默认终止进程），改为返回 EPIPE 由连接自行关闭
+    std::signal(SIGPIPE, SIG_IGN);
+
     // 1. 启动线程池 (SubLoops)
     // 线程数已在构造函数中设置，此处只需启动
     thread_pool_->Start();
 
-    // 2. 启动主循环 (MainLoop)
+    // 2. 启动管理端口（独立线程，不占用数据面 Reactor）
+    StartAdminServer();
+    StartWatchdog();
+    StartAccessTrace();
+    StartHotListSaver();
+
+    // 3. 启动主循环 (MainLoop)
 
 }
 
 void Server::Stop() {
+    if (watchdog_) {
+        watchdog_->Stop();
+    }
+    if (admin_server_) {
+        admin_server_->Stop();
+    }
     main_loop_->Stop();
     thread_pool_->Stop(); // 需在 ThreadPool 中实现 Stop
+    StopHotListSaver();
+    if (owns_access_trace_) {
+        tinywebserver::AccessTrace::Stop();
+        owns_access_trace_ = false;
+    }
 }
 
 void Server::Run() {
@@ -154,6 +198,7 @@ void Server::Run() {
         LOG_INFO("Server::Run() SO_REUSEPORT 模式：监听事件已在各个 Sub Reactor 中注册");
     }
 
+    tinywebserver::PerfCounters::OpenForCurrentThread();
     main_loop_->Loop();
     LOG_INFO("Server::Run() 事件循环结束");
 }
@@ -183,8 +228,12 @@ void Server::HandleAccept(int listen_fd) {
         
         // 创建连接对象
         // 注意：连接归属于 io_loop，但目前我们在 MainLoop 线程中
+        tinywebserver::AllocTagScope alloc_tag(tinywebserver::AllocTag::kConnection);
         auto conn = std::make_shared<Connection>(conn_fd, io_loop, config_, keep_alive_manager_.get());
         conn->SetMessageCallback(on_message_);
+        if (on_h2_request_) {
+            conn->SetH2RequestCallback(on_h2_request_);
+        }
         conn->SetCloseCallback(std::bind(&Server::RemoveConnection, this, std::placeholders::_1));
 
         {
@@ -218,6 +267,14 @@ void Server::RemoveConnection(int fd) {
     }
 }
 
+void Server::SetOnH2Request(Connection::H2RequestCallback cb) {
+    if (config_ && !config_->GetServerOptions().enable_h2c) {
+        LOG_INFO("HTTP/2 (h2c) disabled by configuration");
+        return;
+    }
+    on_h2_request_ = std::move(cb);
+}
+
 void Server::SetupSOReusePortMode() {
     // 创建多监听socket
     size_t num_sockets = reuseport_opts_.num_listen_sockets;
@@ -311,8 +368,12 @@ void Server::HandleAcceptInSubReactor(int listen_fd, EventLoop* sub_loop) {
         }
 
         // 在当前 Sub Reactor 中创建连接（无需跨线程分配）
+        tinywebserver::AllocTagScope alloc_tag(tinywebserver::AllocTag::kConnection);
         auto conn = std::make_shared<Connection>(conn_fd, sub_loop, config_, keep_alive_manager_.get());
         conn->SetMessageCallback(on_message_);
+        if (on_h2_request_) {
+            conn->SetH2RequestCallback(on_h2_request_);
+        }
         conn->SetCloseCallback(std::bind(&Server::RemoveConnection, this, std::placeholders::_1));
 
         {
@@ -333,7 +394,174 @@ void Server::HandleAcceptInSubReactor(int listen_fd, EventLoop* sub_loop) {
     }
 }
 
+void Server::StartAdminServer() {
+    if (!config_ || admin_server_) {
+        return;
+    }
+    auto metrics_opts = config_->GetMetricsOptions();
+    if (!metrics_opts.enable_prometheus) {
+        return;
+    }
+
+    auto admin = std::make_unique<tinywebserver::AdminServer>(metrics_opts.prometheus_port);
+    admin->RegisterHandler("/metrics", "text/plain; version=0.0.4", []() {
+        return tinywebserver::ServerMetrics::GetInstance().ToPrometheusString();
+    });
+    admin->RegisterHandler("/debug/loops", "text/plain", [this]() {
+        return GetLoopStatsString();
+    });
+    admin->RegisterHandler("/debug/cache", "application/json", []() {
+        auto status = StaticResourceManager::GetInstance().GetStatus();
+        double hit_ratio = status.total_requests == 0 ? 0.0 :
+            static_cast<double>(status.cache_hits) / static_cast<double>(status.total_requests);
+        std::ostringstream oss;
+        oss << "{";
+        oss << "\"memory_usage_bytes\": " << status.current_memory_usage << ", ";
+        oss << "\"cached_files\": " << status.cached_files_count << ", ";
+        oss << "\"total_requests\": " << status.total_requests << ", ";
+        oss << "\"cache_hits\": " << status.cache_hits << ", ";
+        oss << "\"evictions\": " << status.evictions << ", ";
+        oss << "\"rejected_admissions\": " << status.rejected_admissions << ", ";
+        oss << "\"background_loads\": " << status.background_loads << ", ";
+        oss << "\"coalesced_loads\": " << status.coalesced_loads << ", ";
+        oss << "\"policy\": \"" << CachePolicyName(status.policy) << "\", ";
+        oss << "\"hit_ratio\": " << std::fixed << std::setprecision(4) << hit_ratio;
+        oss << "}\n";
+        return oss.str();
+    });
+
+    auto error = admin->Start();
+    if (error.IsFailure()) {
+        // 管理端口不可用不影响数据面服务
+        LOG_ERROR("Admin listener disabled: %s", error.ToString().c_str());
+        return;
+    }
+    admin_server_ = std::move(admin);
+}
+
+void Server::StartAccessTrace() {
+    if (!config_ || owns_access_trace_) {
+        return;
+    }
+    const std::string path = config_->GetMetricsOptions().access_trace_path;
+    if (path.empty()) {
+        return;
+    }
+    tinywebserver::Error err = tinywebserver::AccessTrace::Start(path);
+    if (err.IsFailure()) {
+        LOG_ERROR("Failed to start access trace: %s", err.GetMessage().c_str());
+        return;
+    }
+    owns_access_trace_ = true;
+}
+
+void Server::WarmUpStaticCache() {
+    if (!config_ || !config_->GetStaticOptions().warmup) {
+        return;
+    }
+    const auto& static_opts = config_->GetStaticOptions();
+    StaticResourceManager::WarmUpOptions options;
+    options.root = static_opts.root;
+    options.hot_list_path = static_opts.hot_list_path;
+    options.threads = static_opts.warmup_threads;
+    options.budget = std::chrono::milliseconds(static_opts.warmup_budget_ms);
+
+    auto result = StaticResourceManager::GetInstance().WarmUp(options);
+    LOG_INFO("Static cache warm-up: %zu/%zu files (%zu from hot list), %zu bytes in %llu ms%s",
+             result.files_loaded, result.candidates, result.hot_list_hits, result.bytes_loaded,
+             static_cast<unsigned long long>(result.elapsed_ms),
+             result.timed_out ? " (budget expired)" : "");
+}
+
+void Server::StartHotListSaver() {
+    if (!config_ || config_->GetStaticOptions().hot_list_path.empty() || hot_list_thread_.joinable()) {
+        return;
+    }
+    std::string path = config_->GetStaticOptions().hot_list_path;
+    auto interval = std::chrono::seconds(config_->GetStaticOptions().hot_list_save_interval);
+    hot_list_stop_ = false;
+    hot_list_thread_ = std::thread([this, path, interval]() {
+        std::unique_lock<std::mutex> lock(hot_list_mutex_);
+        while (!hot_list_cv_.wait_for(lock, interval, [this] { return hot_list_stop_; })) {
+            // 进程可能被直接杀掉，定期保存保证下次启动有较新的列表
+            StaticResourceManager::GetInstance().SaveHotList(path);
+        }
+    });
+}
+
+void Server::StopHotListSaver() {
+    if (!hot_list_thread_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(hot_list_mutex_);
+        hot_list_stop_ = true;
+    }
+    hot_list_cv_.notify_one();
+    hot_list_thread_.join();
+    StaticResourceManager::GetInstance().SaveHotList(config_->GetStaticOptions().hot_list_path);
+}
+
+void Server::StartWatchdog() {
+    if (watchdog_) {
+        return;
+    }
+    auto metrics_opts = config_ ? config_->GetMetricsOptions() : tinywebserver::ServerConfig::MetricsOptions{};
+    if (metrics_opts.stall_threshold_ms <= 0) {
+        return;
+    }
+
+    watchdog_ = std::make_unique<LoopWatchdog>(metrics_opts.stall_threshold_ms);
+    watchdog_->Watch(main_loop_.get(), "main");
+    for (size_t i = 0; i < thread_pool_->GetThreadCount(); ++i) {
+        watchdog_->Watch(thread_pool_->GetLoopByIndex(i), "sub-" + std::to_string(i));
+    }
+    watchdog_->Start();
+}
+
+std::string Server::GetLoopStatsString() const {
+    std::ostringstream oss;
+    auto dump = [&oss](const char* role, size_t index, EventLoop* loop) {
+        auto stats = loop->GetStats();
+        uint64_t busy_since = loop->GetBusySinceNs();
+        uint64_t now = tinywebserver::ServerMetrics::NowNs();
+        uint64_t busy_ms = (busy_since != 0 && now > busy_since) ? (now - busy_since) / 1000000ULL : 0;
+        oss << "loop[" << index << "] role=" << role
+            << " thread=" << loop->GetThreadIdString()
+            << " connections=" << stats.connections
+            << " registered_fds=" << stats.registered_fds
+            << " pending_functors=" << stats.pending_functors
+            << " iterations=" << stats.iterations
+            << " active_timers=" << stats.active_timers
+            << " busy_ms=" << busy_ms << "\n";
+        oss << loop->GetTimerStats() << "\n";
+    };
+
+    dump("main", 0, main_loop_.get());
+    for (size_t i = 0; i < thread_pool_->GetThreadCount(); ++i) {
+        EventLoop* loop = thread_pool_->GetLoopByIndex(i);
+        if (loop) {
+            dump("sub", i + 1, loop);
+        }
+    }
+    return oss.str();
+}
+
 size_t Server::LoadPlugins() {
     return plugin_manager_.LoadAllPlugins(*this);
 }
 
+void Server::AddStreamRoute(const std::string& path_prefix, tinywebserver::StreamHandler handler) {
+    LOG_INFO("Stream route registered: %s", path_prefix.c_str());
+    stream_routes_.emplace_back(path_prefix, std::move(handler));
+}
+
+const tinywebserver::StreamHandler* Server::FindStreamRoute(const std::string& path) const {
+    for (const auto& [prefix, handler] : stream_routes_) {
+        if (path.compare(0, prefix.size(), prefix) == 0) {
+            return &handler;
+        }
+    }
+    return nullptr;
+}
+
@@ -1,9 +1,243 @@
 #include "server_metrics.h"
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
 
 namespace tinywebserver {
 
+namespace {
+
+void FoldShard(MetricsShard& dst, const MetricsShard& src) {
+    MetricsShard::Add(dst.connections_opened, MetricsShard::Read(src.connections_opened));
+    MetricsShard::Add(dst.connections_closed, MetricsShard::Read(src.connections_closed));
+    MetricsShard::Add(dst.total_requests, MetricsShard::Read(src.total_requests));
+    for (size_t i = 0; i < 5; ++i) {
+        MetricsShard::Add(dst.requests_by_class[i], MetricsShard::Read(src.requests_by_class[i]));
+    }
+    MetricsShard::Add(dst.bytes_sent, MetricsShard::Read(src.bytes_sent));
+    MetricsShard::Add(dst.bytes_received, MetricsShard::Read(src.bytes_received));
+    MetricsShard::Add(dst.errors, MetricsShard::Read(src.errors));
+    MetricsShard::Add(dst.memory_allocated, MetricsShard::Read(src.memory_allocated));
+    MetricsShard::Add(dst.memory_freed, MetricsShard::Read(src.memory_freed));
+    MetricsShard::Add(dst.epoll_wait_time_us, MetricsShard::Read(src.epoll_wait_time_us));
+    MetricsShard::Add(dst.loop_stalls, MetricsShard::Read(src.loop_stalls));
+    for (int i = 0; i < static_cast<int>(PerfPhase::kCount); ++i) {
+        MetricsShard::Add(dst.perf[i].samples, MetricsShard::Read(src.perf[i].samples));
+        MetricsShard::Add(dst.perf[i].cycles, MetricsShard::Read(src.perf[i].cycles));
+        MetricsShard::Add(dst.perf[i].instructions, MetricsShard::Read(src.perf[i].instructions));
+        MetricsShard::Add(dst.perf[i].cache_misses, MetricsShard::Read(src.perf[i].cache_misses));
+        MetricsShard::Add(dst.perf[i].branch_misses, MetricsShard::Read(src.perf[i].branch_misses));
+    }
+}
+
+void FoldLatency(MetricsShard& dst, const MetricsShard& src) {
+    for (int i = 0; i < static_cast<int>(RequestPhase::kCount); ++i) {
+        dst.latency[i].MergeFrom(src.latency[i]);
+    }
+    dst.loop_iteration.MergeFrom(src.loop_iteration);
+    dst.functor_batch.MergeFrom(src.functor_batch);
+}
+
+void ClearShard(MetricsShard& shard) {
+    shard.connections_opened.store(0, std::memory_order_relaxed);
+    shard.connections_closed.store(0, std::memory_order_relaxed);
+    shard.total_requests.store(0, std::memory_order_relaxed);
+    for (auto& counter : shard.requests_by_class) {
+        counter.store(0, std::memory_order_relaxed);
+    }
+    shard.bytes_sent.store(0, std::memory_order_relaxed);
+    shard.bytes_received.store(0, std::memory_order_relaxed);
+    shard.errors.store(0, std::memory_order_relaxed);
+    shard.memory_allocated.store(0, std::memory_order_relaxed);
+    shard.memory_freed.store(0, std::memory_order_relaxed);
+    shard.epoll_wait_time_us.store(0, std::memory_order_relaxed);
+    shard.loop_stalls.store(0, std::memory_order_relaxed);
+    for (auto& totals : shard.perf) {
+        totals.samples.store(0, std::memory_order_relaxed);
+        totals.cycles.store(0, std::memory_order_relaxed);
+        totals.instructions.store(0, std::memory_order_relaxed);
+        totals.cache_misses.store(0, std::memory_order_relaxed);
+        totals.branch_misses.store(0, std::memory_order_relaxed);
+    }
+    for (auto& histogram : shard.latency) {
+        histogram.Clear();
+    }
+    shard.loop_iteration.Clear();
+    shard.functor_batch.Clear();
+}
+
+// Prometheus 直方图的 le 边界（秒）
+constexpr double kLatencyBucketsSeconds[] = {
+    0.00005, 0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005,
+    0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0
+};
+
+// DoPendingFunctors 批大小的 le 边界（个）
+constexpr double kBatchSizeBuckets[] = {1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024};
+
+constexpr double kLatencyQuantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+// 标签中的浮点数按最短形式输出（0.5 / 5e-05），与 Prometheus 客户端一致
+std::string FormatLabelValue(double value) {
+    std::ostringstream oss;
+    oss << value;
+    return oss.str();
+}
+
+/**
+ * @brief 按 Prometheus histogram 格式输出一组 _bucket/_sum/_count
+ * @param labels 额外标签（如 phase="total"），可为空
+ * @param scale 边界单位 -> 记录单位的倍率（秒 -> 纳秒为 1e9）
+ */
+template <size_t N>
+void AppendHistogram(std::ostringstream& oss, const std::string& name, const std::string& labels,
+                     const LatencyHistogram::Snapshot& hist, const double (&bounds)[N], double scale) {
+    std::string prefix = labels.empty() ? "" : labels + ",";
+    for (double le : bounds) {
+        oss << name << "_bucket{" << prefix << "le=\"" << FormatLabelValue(le) << "\"} "
+            << hist.CountAtOrBelow(static_cast<uint64_t>(le * scale)) << "\n";
+    }
+    oss << name << "_bucket{" << prefix << "le=\"+Inf\"} " << hist.total_count << "\n";
+    std::string suffix = labels.empty() ? "" : "{" + labels + "}";
+    oss << name << "_sum" << suffix << " " << static_cast<double>(hist.total_sum) / scale << "\n";
+    oss << name << "_count" << suffix << " " << hist.total_count << "\n";
+}
+
+} // namespace
+
+const char* RequestPhaseName(RequestPhase phase) {
+    switch (phase) {
+        case RequestPhase::kTotal:        return "total";
+        case RequestPhase::kParse:        return "parse";
+        case RequestPhase::kValidate:     return "validate";
+        case RequestPhase::kLookup:       return "lookup";
+        case RequestPhase::kQueueToFlush: return "queue_to_flush";
+        default:                          return "unknown";
+    }
+}
+
+/**
+ * @brief 线程退出时把分片并入 retired_ 并释放
+ */
+class MetricsShardOwner
+{
+public:
+    explicit MetricsShardOwner(MetricsShard* shard) : shard_(shard) {}
+    ~MetricsShardOwner() { ServerMetrics::GetInstance().RetireShard(shard_); }
+
+private:
+    MetricsShard* shard_;
+};
+
+MetricsShard* ServerMetrics::RegisterThreadShard() {
+    auto* shard = new MetricsShard();
+    {
+        std::lock_guard<std::mutex> lock(shards_mutex_);
+        shards_.push_back(shard);
+    }
+    static thread_local MetricsShardOwner owner(shard);
+    return shard;
+}
+
+void ServerMetrics::RetireShard(MetricsShard* shard) {
+    std::lock_guard<std::mutex> lock(shards_mutex_);
+    FoldShard(retired_, *shard);
+    FoldLatency(retired_, *shard);
+    shards_.erase(std::remove(shards_.begin(), shards_.end(), shard), shards_.end());
+    delete shard;
+}
+
+size_t ServerMetrics::GetShardCount() const {
+    std::lock_guard<std::mutex> lock(shards_mutex_);
+    return shards_.size();
+}
+
+LatencyHistogram::Snapshot ServerMetrics::MergeHistograms(
+    const std::function<const LatencyHistogram&(const MetricsShard&)>& select) const {
+    LatencyHistogram::Snapshot snapshot;
+    std::lock_guard<std::mutex> lock(shards_mutex_);
+    select(retired_).MergeInto(snapshot);
+    for (const MetricsShard* shard : shards_) {
+        select(*shard).MergeInto(snapshot);
+    }
+    return snapshot;
+}
+
+LatencyHistogram::Snapshot ServerMetrics::GetLatencySnapshot(RequestPhase phase) const {
+    int index = static_cast<int>(phase);
+    return MergeHistograms([index](const MetricsShard& shard) -> const LatencyHistogram& {
+        return shard.latency[index];
+    });
+}
+
+LatencyHistogram::Snapshot ServerMetrics::GetLoopIterationSnapshot() const {
+    return MergeHistograms([](const MetricsShard& shard) -> const LatencyHistogram& {
+        return shard.loop_iteration;
+    });
+}
+
+LatencyHistogram::Snapshot ServerMetrics::GetFunctorBatchSnapshot() const {
+    return MergeHistograms([](const MetricsShard& shard) -> const LatencyHistogram& {
+        return shard.functor_batch;
+    });
+}
+
+ServerMetrics::PerfSnapshot ServerMetrics::GetPerfSnapshot(PerfPhase phase) const {
+    int index = static_cast<int>(phase);
+    PerfSnapshot snapshot{0, PerfSample{}};
+    auto accumulate = [&snapshot, index](const MetricsShard& shard) {
+        const MetricsShard::PerfTotals& totals = shard.perf[index];
+        snapshot.samples += MetricsShard::Read(totals.samples);
+        snapshot.totals.cycles += MetricsShard::Read(totals.cycles);
+        snapshot.totals.instructions += MetricsShard::Read(totals.instructions);
+        snapshot.totals.cache_misses += MetricsShard::Read(totals.cache_misses);
+        snapshot.totals.branch_misses += MetricsShard::Read(totals.branch_misses);
+    };
+
+    std::lock_guard<std::mutex> lock(shards_mutex_);
+    accumulate(retired_);
+    for (const MetricsShard* shard : shards_) {
+        accumulate(*shard);
+    }
+    return snapshot;
+}
+
+ServerMetrics::Snapshot ServerMetrics::GetSnapshot() const {
+    MetricsShard total;
+    {
+        std::lock_guard<std::mutex> lock(shards_mutex_);
+        FoldShard(total, retired_);
+        for (const MetricsShard* shard : shards_) {
+            FoldShard(total, *shard);
+        }
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    std::chrono::duration<double> diff = now - start_time_;
+
+    uint64_t opened = MetricsShard::Read(total.connections_opened);
+    uint64_t closed = MetricsShard::Read(total.connections_closed);
+
+    return {
+        opened >= closed ? opened - closed : 0,
+        opened,
+        MetricsShard::Read(total.total_requests),
+        MetricsShard::Read(total.requests_by_class[0]),
+        MetricsShard::Read(total.requests_by_class[1]),
+        MetricsShard::Read(total.requests_by_class[2]),
+        MetricsShard::Read(total.requests_by_class[3]),
+        MetricsShard::Read(total.requests_by_class[4]),
+        MetricsShard::Read(total.bytes_sent),
+        MetricsShard::Read(total.bytes_received),
+        MetricsShard::Read(total.errors),
+        static_cast<int64_t>(MetricsShard::Read(total.memory_allocated) -
+                             MetricsShard::Read(total.memory_freed)),
+        MetricsShard::Read(total.epoll_wait_time_us),
+        MetricsShard::Read(total.loop_stalls),
+        diff.count()
+    };
+}
+
 std::string ServerMetrics::ToJsonString() const {
     auto snapshot = GetSnapshot();
     std::ostringstream oss;
@@ -29,7 +263,48 @@ std::string ServerMetrics::ToJsonString() const {
     oss << "\"memory_allocated\": " << snapshot.memory_allocated << ", ";
     oss << "\"epoll_wait_time_us\": " << snapshot.epoll_wait_time_us;
     oss << "}, ";
-    oss << "\"uptime_seconds\": " << std::fixed << std::setprecision(2) << snapshot.uptime_sec;
+    auto iteration = GetLoopIterationSnapshot();
+    oss << "\"event_loop\": {";
+    oss << "\"stalls\": " << snapshot.loop_stalls << ", ";
+    oss << "\"iterations\": " << iteration.total_count << ", ";
+    oss << "\"iteration_p99_us\": " << iteration.Percentile(0.99) / 1000 << ", ";
+    oss << "\"iteration_max_us\": " << iteration.max_value / 1000 << ", ";
+    oss << "\"functor_batch_p99\": " << GetFunctorBatchSnapshot().Percentile(0.99);
+    oss << "}, ";
+    if (PerfCounters::IsEnabled()) {
+        oss << "\"perf\": {";
+        for (int i = 0; i < static_cast<int>(PerfPhase::kCount); ++i) {
+            auto phase = static_cast<PerfPhase>(i);
+            auto perf = GetPerfSnapshot(phase);
+            double samples = perf.samples == 0 ? 1.0 : static_cast<double>(perf.samples);
+            if (i > 0) oss << ", ";
+            oss << "\"" << PerfPhaseName(phase) << "\": {";
+            oss << "\"samples\": " << perf.samples << ", ";
+            oss << "\"ipc\": " << perf.Ipc() << ", ";
+            oss << "\"cycles_per_sample\": " << perf.totals.cycles / samples << ", ";
+            oss << "\"cache_misses_per_sample\": " << perf.totals.cache_misses / samples << ", ";
+            oss << "\"branch_misses_per_sample\": " << perf.totals.branch_misses / samples;
+            oss << "}";
+        }
+        oss << "}, ";
+    }
+    oss << "\"uptime_seconds\": " << std::fixed << std::setprecision(2) << snapshot.uptime_sec << ", ";
+    oss << "\"latency_us\": {";
+    for (int i = 0; i < static_cast<int>(RequestPhase::kCount); ++i) {
+        auto phase = static_cast<RequestPhase>(i);
+        auto hist = GetLatencySnapshot(phase);
+        if (i > 0) oss << ", ";
+        oss << "\"" << RequestPhaseName(phase) << "\": {";
+        oss << "\"count\": " << hist.total_count << ", ";
+        oss << "\"mean\": " << hist.MeanNs() / 1000.0 << ", ";
+        oss << "\"p50\": " << hist.Percentile(0.5) / 1000.0 << ", ";
+        oss << "\"p90\": " << hist.Percentile(0.9) / 1000.0 << ", ";
+        oss << "\"p99\": " << hist.Percentile(0.99) / 1000.0 << ", ";
+        oss << "\"p999\": " << hist.Percentile(0.999) / 1000.0 << ", ";
+        oss << "\"max\": " << hist.max_value / 1000.0;
+        oss << "}";
+    }
+    oss << "}";
     oss << "}";
     return oss.str();
 }
@@ -82,26 +357,100 @@ std::string ServerMetrics::ToPrometheusString() const {
 
     oss << "# HELP webserver_uptime_seconds Server uptime in seconds\n";
     oss << "# TYPE webserver_uptime_seconds gauge\n";
-    oss << "webserver_uptime_seconds " << std::fixed << std::setprecision(2) << snapshot.uptime_sec << "\n";
+    oss << "webserver_uptime_seconds " << std::fixed << std::setprecision(2) << snapshot.uptime_sec << "\n\n";
+
+    // 延迟直方图：le 按桶上界累计，误差不超过一个对数-线性子桶
+    std::vector<LatencyHistogram::Snapshot> phases;
+    for (int i = 0; i < static_cast<int>(RequestPhase::kCount); ++i) {
+        phases.push_back(GetLatencySnapshot(static_cast<RequestPhase>(i)));
+    }
+    oss << std::setprecision(9);
+
+    oss << "# HELP webserver_request_duration_seconds Request latency by processing phase\n";
+    oss << "# TYPE webserver_request_duration_seconds histogram\n";
+    for (int i = 0; i < static_cast<int>(RequestPhase::kCount); ++i) {
+        std::string labels = std::string("phase=\"") + RequestPhaseName(static_cast<RequestPhase>(i)) + "\"";
+        AppendHistogram(oss, "webserver_request_duration_seconds", labels, phases[i], kLatencyBucketsSeconds, 1e9);
+    }
+    oss << "\n";
+
+    oss << "# HELP webserver_request_duration_quantile_seconds Request latency quantiles by processing phase\n";
+    oss << "# TYPE webserver_request_duration_quantile_seconds gauge\n";
+    for (int i = 0; i < static_cast<int>(RequestPhase::kCount); ++i) {
+        const char* name = RequestPhaseName(static_cast<RequestPhase>(i));
+        for (double q : kLatencyQuantiles) {
+            oss << "webserver_request_duration_quantile_seconds{phase=\"" << name << "\",quantile=\"" << FormatLabelValue(q) << "\"} "
+                << static_cast<double>(phases[i].Percentile(q)) / 1e9 << "\n";
+        }
+    }
+    oss << "\n";
+
+    oss << "# HELP webserver_event_loop_stalls_total Event loop iterations exceeding the stall threshold\n";
+    oss << "# TYPE webserver_event_loop_stalls_total counter\n";
+    oss << "webserver_event_loop_stalls_total " << snapshot.loop_stalls << "\n\n";
+
+    oss << "# HELP webserver_event_loop_iteration_seconds Busy time per event loop iteration\n";
+    oss << "# TYPE webserver_event_loop_iteration_seconds histogram\n";
+    AppendHistogram(oss, "webserver_event_loop_iteration_seconds", "", GetLoopIterationSnapshot(),
+                    kLatencyBucketsSeconds, 1e9);
+    oss << "\n";
+
+    oss << "# HELP webserver_event_loop_functor_batch_size Functors executed per DoPendingFunctors call\n";
+    oss << "# TYPE webserver_event_loop_functor_batch_size histogram\n";
+    AppendHistogram(oss, "webserver_event_loop_functor_batch_size", "", GetFunctorBatchSnapshot(),
+                    kBatchSizeBuckets, 1.0);
+
+    // 硬件计数：仅在诊断模式启用时导出
+    if (PerfCounters::IsEnabled()) {
+        std::vector<PerfSnapshot> perf;
+        for (int i = 0; i < static_cast<int>(PerfPhase::kCount); ++i) {
+            perf.push_back(GetPerfSnapshot(static_cast<PerfPhase>(i)));
+        }
+        struct PerfMetric {
+            const char* name;
+            const char* help;
+            uint64_t PerfSample::*field;
+        };
+        const PerfMetric metrics[] = {
+            {"webserver_perf_cycles_total", "CPU cycles (user space) by request phase", &PerfSample::cycles},
+            {"webserver_perf_instructions_total", "Instructions retired (user space) by request phase", &PerfSample::instructions},
+            {"webserver_perf_cache_misses_total", "Cache misses by request phase", &PerfSample::cache_misses},
+            {"webserver_perf_branch_misses_total", "Branch mispredictions by request phase", &PerfSample::branch_misses},
+        };
+
+        oss << "\n# HELP webserver_perf_samples_total Hardware counter samples by request phase\n";
+        oss << "# TYPE webserver_perf_samples_total counter\n";
+        for (int i = 0; i < static_cast<int>(PerfPhase::kCount); ++i) {
+            oss << "webserver_perf_samples_total{phase=\"" << PerfPhaseName(static_cast<PerfPhase>(i)) << "\"} "
+                << perf[i].samples << "\n";
+        }
+        for (const auto& metric : metrics) {
+            oss << "\n# HELP " << metric.name << " " << metric.help << "\n";
+            oss << "# TYPE " << metric.name << " counter\n";
+            for (int i = 0; i < static_cast<int>(PerfPhase::kCount); ++i) {
+                oss << metric.name << "{phase=\"" << PerfPhaseName(static_cast<PerfPhase>(i)) << "\"} "
+                    << perf[i].totals.*metric.field << "\n";
+            }
+        }
+        oss << "\n# HELP webserver_perf_ipc Instructions per cycle by request phase\n";
+        oss << "# TYPE webserver_perf_ipc gauge\n";
+        for (int i = 0; i < static_cast<int>(PerfPhase::kCount); ++i) {
+            oss << "webserver_perf_ipc{phase=\"" << PerfPhaseName(static_cast<PerfPhase>(i)) << "\"} "
+                << perf[i].Ipc() << "\n";
+        }
+    }
 
     return oss.str();
 }
 
 void ServerMetrics::Reset() {
-    // 重置所有指标
-    active_connections_ = 0;
-    total_connections_ = 0;
-    total_requests_ = 0;
-    requests_1xx_ = 0;
-    requests_2xx_ = 0;
-    requests_3xx_ = 0;
-    requests_4xx_ = 0;
-    requests_5xx_ = 0;
-    total_bytes_sent_ = 0;
-    total_bytes_received_ = 0;
-    error_count_ = 0;
-    memory_allocated_ = 0;
-    epoll_wait_time_us_ = 0;
+    // 重置所有指标：清零 retired_ 与各线程分片
+    // 与写者并发时可能丢失极少量增量，仅用于测试
+    std::lock_guard<std::mutex> lock(shards_mutex_);
+    ClearShard(retired_);
+    for (MetricsShard* shard : shards_) {
+        ClearShard(*shard);
+    }
     start_time_ = std::chrono::steady_clock::now();
 }
 
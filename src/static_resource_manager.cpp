@@ -7,49 +7,551 @@
 #include <sys/stat.h>
 #include <sys/mman.h>
 #include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
 #include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+// 准入窗口占总容量的比例，保护段占主区的比例（W-TinyLFU 论文的默认值）
+constexpr double kWindowRatio = 0.01;
+constexpr double kProtectedRatio = 0.80;
+// 频率草图按平均 8KB 的文件估计需要区分的键数
+constexpr size_t kSketchBytesPerEntry = 8 * 1024;
+
+} // namespace
+
+bool ParseCachePolicy(const std::string& name, CachePolicy& policy)
+{
+    if (name == "lru") {
+        policy = CachePolicy::kLru;
+    } else if (name == "wtinylfu") {
+        policy = CachePolicy::kWTinyLfu;
+    } else if (name == "wtinylfu_size") {
+        policy = CachePolicy::kWTinyLfuSize;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* CachePolicyName(CachePolicy policy)
+{
+    switch (policy) {
+        case CachePolicy::kWTinyLfu:
+            return "wtinylfu";
+        case CachePolicy::kWTinyLfuSize:
+            return "wtinylfu_size";
+        case CachePolicy::kLru:
+        default:
+            return "lru";
+    }
+}
+
+StaticResourceManager::StaticResourceManager() : max_cache_size_(1024 * 1024 * 512)
+{
+    UpdateLimits_();
+}
+
+void StaticResourceManager::SetCacheLimit(size_t max_mem_bytes)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    max_cache_size_ = max_mem_bytes;
+    UpdateLimits_();
+    Rebalance_();
+}
+
+void StaticResourceManager::SetCachePolicy(CachePolicy policy)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    policy_ = policy;
+    Clear_();
+    UpdateLimits_();
+}
+
+CachePolicy StaticResourceManager::GetCachePolicy() const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return policy_;
+}
+
+void StaticResourceManager::SetLoaderThreads(size_t threads)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    loader_threads_ = threads;
+}
 
 std::shared_ptr<StaticResource> StaticResourceManager::GetResource(const std::string& path)
 {
-    total_requests_++;
-    
+    std::shared_future<std::shared_ptr<StaticResource>> in_flight;
     {
-        // 1. 尝试读锁：查找并提升 LRU 位置
-        std::unique_lock<std::shared_mutex> lock(mutex_); // 注意：调整 list 需要写锁
-        auto it = cache_map_.find(path);
-        if (it != cache_map_.end())
-        {
-            // 命中：移动到链表头部 (MRU)
-            lru_list_.splice(lru_list_.begin(), lru_list_, it->second);
-            cache_hits_++;
-            return it->second->resource;
+        // 调整链表需要写锁
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        if (auto resource = Lookup_(path)) {
+            return resource;
+        }
+        auto it = pending_loads_.find(path);
+        if (it != pending_loads_.end()) {
+            coalesced_loads_++;
+            in_flight = it->second->future;
+        } else {
+            auto pending = std::make_shared<PendingLoad>();
+            pending->future = pending->promise.get_future().share();
+            pending_loads_.emplace(path, pending);
         }
     }
 
-    // 2. 缓存未命中：执行加载逻辑 (需持有写锁)
-    std::unique_lock<std::shared_mutex> lock(mutex_);
-    
-    // 双重检查
-    if (cache_map_.count(path)) return cache_map_[path]->resource;
+    // 其它线程正在加载同一路径：等待其结果；否则由本线程加载
+    if (in_flight.valid()) {
+        return in_flight.get();
+    }
+    return LoadAndComplete_(path);
+}
+
+std::shared_ptr<StaticResource> StaticResourceManager::GetResourceAsync(const std::string& path,
+                                                                        LoadCallback on_loaded, bool& pending)
+{
+    pending = false;
+    std::shared_future<std::shared_ptr<StaticResource>> in_flight;
+    ThreadPool* pool = nullptr;
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        if (auto resource = Lookup_(path)) {
+            return resource;
+        }
+        auto it = pending_loads_.find(path);
+        if (it != pending_loads_.end()) {
+            coalesced_loads_++;
+            if (loader_threads_ == 0) {
+                in_flight = it->second->future;
+            } else {
+                it->second->waiters.push_back(std::move(on_loaded));
+                pending = true;
+                return nullptr;
+            }
+        } else {
+            auto load = std::make_shared<PendingLoad>();
+            load->future = load->promise.get_future().share();
+            if (loader_threads_ > 0) {
+                load->waiters.push_back(std::move(on_loaded));
+                if (!loader_pool_) {
+                    loader_pool_ = std::make_unique<ThreadPool>(loader_threads_);
+                }
+                pool = loader_pool_.get();
+                pending = true;
+            }
+            pending_loads_.emplace(path, std::move(load));
+        }
+    }
+
+    // 未配置加载线程：与 GetResource 相同，在调用线程加载或等待
+    if (in_flight.valid()) {
+        return in_flight.get();
+    }
+    if (!pool) {
+        return LoadAndComplete_(path);
+    }
+    pool->AddTask([this, path]() {
+        background_loads_++;
+        LoadAndComplete_(path);
+    });
+    return nullptr;
+}
+
+std::shared_ptr<StaticResource> StaticResourceManager::Lookup_(const std::string& path)
+{
+    total_requests_++;
+    if (policy_ != CachePolicy::kLru) {
+        // 未命中的访问也要计数，候选者的频率才能与淘汰者比较
+        sketch_.Increment(std::hash<std::string>{}(path));
+    }
+
+    auto it = cache_map_.find(path);
+    if (it == cache_map_.end()) {
+        return nullptr;
+    }
+    OnHit_(it->second);
+    cache_hits_++;
+    return it->second->resource;
+}
 
-    auto resource = Load_(path);
-    if (!resource) return nullptr;
+std::shared_ptr<StaticResource> StaticResourceManager::LoadAndComplete_(const std::string& path, bool populate)
+{
+    // open/fstat/mmap 不持锁，其它线程的命中不受磁盘 I/O 影响
+    auto resource = Load_(path, populate);
 
-    // 3. 检查并执行淘汰策略
-    while (current_cache_size_ + resource->size > max_cache_size_ && !lru_list_.empty())
+    std::shared_ptr<PendingLoad> load;
     {
-        Evict_();
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        auto it = pending_loads_.find(path);
+        if (it != pending_loads_.end()) {
+            load = std::move(it->second);
+            pending_loads_.erase(it);
+        }
+        if (resource && !cache_map_.count(path)) {
+            Insert_(path, resource);
+        }
     }
 
-    // 4. 插入新资源
-    lru_list_.push_front({path, resource});
-    cache_map_[path] = lru_list_.begin();
+    if (load) {
+        load->promise.set_value(resource);
+        for (auto& waiter : load->waiters) {
+            waiter(resource);
+        }
+    }
+    return resource;
+}
+
+void StaticResourceManager::Insert_(const std::string& path, const std::shared_ptr<StaticResource>& resource)
+{
+    // 比整个缓存还大的文件不缓存，否则会清空全部热点
+    if (resource->size > max_cache_size_) {
+        rejected_admissions_++;
+        return;
+    }
+
+    // 放入窗口段头部
+    uint64_t hash = policy_ == CachePolicy::kLru ? 0 : std::hash<std::string>{}(path);
+    window_list_.push_front({path, resource, hash, Segment::kWindow});
+    cache_map_[path] = window_list_.begin();
+    window_bytes_ += resource->size;
     current_cache_size_ += resource->size;
+    Rebalance_();
+}
 
-    return resource;
+void StaticResourceManager::OnHit_(ItemList::iterator it)
+{
+    switch (it->segment) {
+        case Segment::kWindow:
+            window_list_.splice(window_list_.begin(), window_list_, it);
+            break;
+        case Segment::kProtected:
+            protected_list_.splice(protected_list_.begin(), protected_list_, it);
+            break;
+        case Segment::kProbation:
+            // 试用段再次命中：升入保护段，保护段超限时把其队尾降回试用段
+            MoveTo_(it, Segment::kProtected);
+            while (protected_bytes_ > protected_limit_ && protected_list_.size() > 1) {
+                MoveTo_(std::prev(protected_list_.end()), Segment::kProbation);
+            }
+            break;
+    }
+}
+
+void StaticResourceManager::Rebalance_()
+{
+    while (window_bytes_ > window_limit_ && !window_list_.empty()) {
+        auto candidate = std::prev(window_list_.end());
+        if (policy_ == CachePolicy::kLru) {
+            Evict_(candidate);
+        } else {
+            Admit_(candidate);
+        }
+    }
+
+    // 主区超限（如缩小了上限）：先淘汰试用段，再淘汰保护段
+    size_t main_limit = max_cache_size_ - window_limit_;
+    while (probation_bytes_ + protected_bytes_ > main_limit) {
+        if (!probation_list_.empty()) {
+            Evict_(std::prev(probation_list_.end()));
+        } else {
+            Evict_(std::prev(protected_list_.end()));
+        }
+    }
 }
 
-std::shared_ptr<StaticResource> StaticResourceManager::Load_(const std::string& path)
+void StaticResourceManager::Admit_(ItemList::iterator candidate)
+{
+    size_t size = candidate->resource->size;
+    size_t main_limit = max_cache_size_ - window_limit_;
+    if (size > main_limit) {
+        rejected_admissions_++;
+        Evict_(candidate);
+        return;
+    }
+    MoveTo_(candidate, Segment::kProbation);
+    if (probation_bytes_ + protected_bytes_ <= main_limit) {
+        return;
+    }
+
+    // 淘汰者依次取试用段队尾、保护段队尾（跳过候选者本身，它在试用段头部）
+    std::vector<ItemList::iterator> victims;
+    size_t excess = probation_bytes_ + protected_bytes_ - main_limit;
+    size_t freed = 0;
+    for (auto it = probation_list_.rbegin(); it != probation_list_.rend() && freed < excess; ++it) {
+        if (std::prev(it.base()) != candidate) {
+            victims.push_back(std::prev(it.base()));
+            freed += it->resource->size;
+        }
+    }
+    for (auto it = protected_list_.rbegin(); it != protected_list_.rend() && freed < excess; ++it) {
+        victims.push_back(std::prev(it.base()));
+        freed += it->resource->size;
+    }
+
+    // 先判定再淘汰：候选者落选时淘汰者原样保留
+    uint64_t victim_frequency = 0;
+    for (const auto& victim : victims) {
+        uint32_t frequency = sketch_.Estimate(victim->hash);
+        if (policy_ == CachePolicy::kWTinyLfuSize) {
+            // 按字节计价：候选者占用的空间原本属于这些淘汰者，
+            // 只有候选者的命中多于它们的合计时才值得替换
+            victim_frequency += frequency;
+        } else {
+            // 经典 TinyLFU：候选者须比每个淘汰者都更常用
+            victim_frequency = std::max<uint64_t>(victim_frequency, frequency);
+        }
+    }
+    if (freed < excess || sketch_.Estimate(candidate->hash) <= victim_frequency) {
+        LOG_DEBUG("StaticResource: Admission rejected: %s (size: %zu)", candidate->path.c_str(), size);
+        rejected_admissions_++;
+        Evict_(candidate);
+        return;
+    }
+    for (const auto& victim : victims) {
+        Evict_(victim);
+    }
+}
+
+void StaticResourceManager::MoveTo_(ItemList::iterator it, Segment segment)
+{
+    size_t size = it->resource->size;
+    BytesOf_(it->segment) -= size;
+    ListOf_(segment).splice(ListOf_(segment).begin(), ListOf_(it->segment), it);
+    it->segment = segment;
+    BytesOf_(segment) += size;
+}
+
+StaticResourceManager::ItemList& StaticResourceManager::ListOf_(Segment segment)
+{
+    switch (segment) {
+        case Segment::kProbation:
+            return probation_list_;
+        case Segment::kProtected:
+            return protected_list_;
+        case Segment::kWindow:
+        default:
+            return window_list_;
+    }
+}
+
+size_t& StaticResourceManager::BytesOf_(Segment segment)
+{
+    switch (segment) {
+        case Segment::kProbation:
+            return probation_bytes_;
+        case Segment::kProtected:
+            return protected_bytes_;
+        case Segment::kWindow:
+        default:
+            return window_bytes_;
+    }
+}
+
+void StaticResourceManager::UpdateLimits_()
+{
+    if (policy_ == CachePolicy::kLru) {
+        window_limit_ = max_cache_size_;
+        protected_limit_ = 0;
+        return;
+    }
+    window_limit_ = std::max<size_t>(1, static_cast<size_t>(max_cache_size_ * kWindowRatio));
+    protected_limit_ = static_cast<size_t>((max_cache_size_ - window_limit_) * kProtectedRatio);
+    sketch_.Resize(std::max<size_t>(256, max_cache_size_ / kSketchBytesPerEntry));
+}
+
+void StaticResourceManager::Clear_()
+{
+    cache_map_.clear();
+    window_list_.clear();
+    probation_list_.clear();
+    protected_list_.clear();
+    window_bytes_ = 0;
+    probation_bytes_ = 0;
+    protected_bytes_ = 0;
+    current_cache_size_ = 0;
+    sketch_.Clear();
+}
+
+std::shared_ptr<StaticResource> StaticResourceManager::Prefetch_(const std::string& path)
+{
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        if (cache_map_.count(path) || pending_loads_.count(path)) {
+            return nullptr;
+        }
+        auto load = std::make_shared<PendingLoad>();
+        load->future = load->promise.get_future().share();
+        pending_loads_.emplace(path, std::move(load));
+    }
+    return LoadAndComplete_(path, true);
+}
+
+StaticResourceManager::WarmUpResult StaticResourceManager::WarmUp(const WarmUpOptions& options)
+{
+    namespace fs = std::filesystem;
+    WarmUpResult result;
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + options.budget;
+
+    // 1. 收集候选：缓存键与请求路径的拼接方式一致（root + "/" + 相对路径）
+    struct Candidate
+    {
+        std::string path;
+        size_t size;
+    };
+    std::vector<Candidate> files;
+    std::unordered_map<std::string, size_t> index;
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(options.root, ec), end; !ec && it != end; it.increment(ec)) {
+        if (!it->is_regular_file(ec)) {
+            continue;
+        }
+        size_t size = static_cast<size_t>(it->file_size(ec));
+        if (ec || size == 0) {
+            ec.clear();
+            continue;
+        }
+        std::string key = options.root + "/" + it->path().lexically_relative(options.root).string();
+        index.emplace(key, files.size());
+        files.push_back({std::move(key), size});
+    }
+    if (ec) {
+        LOG_WARN("StaticResource: warm-up walk of %s stopped: %s", options.root.c_str(), ec.message().c_str());
+    }
+
+    // 2. 排序：热点列表中的文件按列表顺序在前，其余从小到大（同样字节数能覆盖更多对象）
+    std::vector<Candidate> ordered;
+    std::unordered_set<std::string> from_hot_list;
+    if (!options.hot_list_path.empty()) {
+        std::ifstream in(options.hot_list_path);
+        std::string line;
+        while (std::getline(in, line)) {
+            auto it = index.find(line);
+            if (line.empty() || line[0] == '#' || it == index.end() || !from_hot_list.insert(line).second) {
+                continue;
+            }
+            ordered.push_back(files[it->second]);
+        }
+    }
+    std::vector<Candidate> rest;
+    for (auto& file : files) {
+        if (!from_hot_list.count(file.path)) {
+            rest.push_back(std::move(file));
+        }
+    }
+    std::sort(rest.begin(), rest.end(), [](const Candidate& a, const Candidate& b) { return a.size < b.size; });
+
+    // 3. 按缓存剩余容量截断；热点文件计入一次频率，后续准入时优先于冷文件
+    std::vector<std::string> plan;
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        size_t budget = max_cache_size_ > current_cache_size_ ? max_cache_size_ - current_cache_size_ : 0;
+        auto take = [&](const Candidate& file) {
+            if (file.size > budget || cache_map_.count(file.path)) {
+                return false;
+            }
+            budget -= file.size;
+            plan.push_back(file.path);
+            return true;
+        };
+        for (const auto& file : ordered) {
+            if (take(file)) {
+                result.hot_list_hits++;
+                if (policy_ != CachePolicy::kLru) {
+                    sketch_.Increment(std::hash<std::string>{}(file.path));
+                }
+            }
+        }
+        for (const auto& file : rest) {
+            take(file);
+        }
+    }
+    result.candidates = plan.size();
+
+    // 4. 并行加载，到期后不再开始新的文件
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> files_loaded{0};
+    std::atomic<size_t> bytes_loaded{0};
+    std::atomic<bool> timed_out{false};
+    auto worker = [&]() {
+        while (true) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                timed_out = true;
+                return;
+            }
+            size_t i = next++;
+            if (i >= plan.size()) {
+                return;
+            }
+            if (auto resource = Prefetch_(plan[i])) {
+                files_loaded++;
+                bytes_loaded += resource->size;
+            }
+        }
+    };
+    size_t threads = std::max<size_t>(1, std::min(options.threads, plan.size()));
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < threads; ++i) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& t : workers) {
+        t.join();
+    }
+
+    result.files_loaded = files_loaded;
+    result.bytes_loaded = bytes_loaded;
+    result.timed_out = timed_out && next < plan.size();
+    result.elapsed_ms = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count());
+    return result;
+}
+
+bool StaticResourceManager::SaveHotList(const std::string& path) const
+{
+    std::vector<std::string> paths;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        paths.reserve(cache_map_.size());
+        for (const ItemList* list : {&protected_list_, &probation_list_, &window_list_}) {
+            for (const auto& item : *list) {
+                paths.push_back(item.path);
+            }
+        }
+    }
+
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        if (!out) {
+            LOG_WARN("StaticResource: cannot write hot list %s", tmp.c_str());
+            return false;
+        }
+        out << "# static cache hot list, hottest first\n";
+        for (const auto& p : paths) {
+            out << p << '\n';
+        }
+        if (!out.flush()) {
+            LOG_WARN("StaticResource: failed to write hot list %s", tmp.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        LOG_WARN("StaticResource: rename %s failed: %s", tmp.c_str(), strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<StaticResource> StaticResourceManager::Load_(const std::string& path, bool populate)
 {
     int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
     if (fd < 0)
@@ -65,7 +567,8 @@ std::shared_ptr<StaticResource> StaticResourceManager::Load_(const std::string&
         return nullptr;
     }
 
-    void* addr = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    int flags = MAP_PRIVATE | (populate ? MAP_POPULATE : 0);
+    void* addr = ::mmap(nullptr, st.st_size, PROT_READ, flags, fd, 0);
     ::close(fd);
 
     if (addr == MAP_FAILED)
@@ -73,6 +576,11 @@ std::shared_ptr<StaticResource> StaticResourceManager::Load_(const std::string&
         LOG_ERROR("StaticResource: Mmap failed %s", path.c_str());
         return nullptr;
     }
+    if (!populate)
+    {
+        // 提前发起预读，发送时的缺页多半已在页缓存中
+        ::madvise(addr, st.st_size, MADV_WILLNEED);
+    }
 
     // 使用自定义删除器确保 munmap
     size_t size = static_cast<size_t>(st.st_size);
@@ -90,18 +598,17 @@ std::shared_ptr<StaticResource> StaticResourceManager::Load_(const std::string&
     });
 }
 
-void StaticResourceManager::Evict_()
+void StaticResourceManager::Evict_(ItemList::iterator it)
 {
-    if (lru_list_.empty()) return;
+    size_t size = it->resource->size;
+    LOG_DEBUG("StaticResource: Evicting cache item: %s, size: %zu", it->path.c_str(), size);
 
-    // 淘汰末尾 (最久未访问)
-    auto last = lru_list_.back();
-    LOG_INFO("StaticResource: Evicting cache item: %s, size: %zu", last.path.c_str(), last.resource->size);
-    
-    current_cache_size_ -= last.resource->size;
-    cache_map_.erase(last.path);
-    lru_list_.pop_back();
-    // last.resource 离开作用域，引用计数减1。若无连接在使用，则触发 munmap。
+    BytesOf_(it->segment) -= size;
+    current_cache_size_ -= size;
+    cache_map_.erase(it->path);
+    // 资源引用计数减1。若无连接在使用，则触发 munmap。
+    ListOf_(it->segment).erase(it);
+    evictions_++;
 }
 
 StaticResourceManager::Status StaticResourceManager::GetStatus() const
@@ -111,6 +618,11 @@ StaticResourceManager::Status StaticResourceManager::GetStatus() const
         current_cache_size_.load(),
         cache_map_.size(),
         total_requests_.load(),
-        cache_hits_.load()
+        cache_hits_.load(),
+        evictions_.load(),
+        rejected_admissions_.load(),
+        background_loads_.load(),
+        coalesced_loads_.load(),
+        policy_
     };
 }
\ No newline at end of file
@@ -9,7 +9,8 @@ TimerWheel::TimerWheel(std::size_t wheel_size, int tick_interval_ms)
     : wheel_(wheel_size),
       current_slot_(0),
       wheel_size_(wheel_size > 0 ? wheel_size : 60),
-      tick_interval_ms_(tick_interval_ms > 0 ? tick_interval_ms : 1000) {
+      tick_interval_ms_(tick_interval_ms > 0 ? tick_interval_ms : 1000),
+      last_tick_time_(std::chrono::steady_clock::now()) {
 
     // 预分配哈希表空间以减少重哈希
     timers_.reserve(wheel_size_ * 2);
@@ -47,8 +48,7 @@ Error TimerWheel::AddTimeout(int fd, int timeout_seconds, std::function<void()>
     if (timers_.find(fd) != timers_.end()) {
         // 静默移除旧定时器，不返回错误
         auto it = timers_[fd];
-        std::size_t slot = (current_slot_.load() + it->remaining_ticks) % wheel_size_;
-        wheel_[slot].erase(it);
+        wheel_[it->slot].erase(it);
         timers_.erase(fd);
         total_tasks_cancelled_.fetch_add(1, std::memory_order_relaxed);
     }
@@ -86,8 +86,7 @@ Error TimerWheel::RemoveTimeout(int fd) {
 
     // 从时间轮中移除
     auto task_it = it->second;
-    std::size_t slot = (current_slot_.load() + task_it->remaining_ticks) % wheel_size_;
-    wheel_[slot].erase(task_it);
+    wheel_[task_it->slot].erase(task_it);
     timers_.erase(it);
 
     total_tasks_cancelled_.fetch_add(1, std::memory_order_relaxed);
@@ -95,16 +94,39 @@ Error TimerWheel::RemoveTimeout(int fd) {
 }
 
 std::size_t TimerWheel::Tick() {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::function<void()>> expired;
+    std::size_t triggered_count;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        triggered_count = ProcessSlot(current_slot_.load(), expired);
 
-    std::size_t triggered_count = ProcessSlot(current_slot_.load());
+        // 前进到下一个槽位
+        current_slot_.store((current_slot_.load() + 1) % wheel_size_);
+    }
 
-    // 前进到下一个槽位
-    current_slot_.store((current_slot_.load() + 1) % wheel_size_);
+    // 回调通常会关闭连接并取消其它定时器，须在锁外执行
+    for (auto& callback : expired) {
+        try {
+            callback();
+        } catch (const std::exception& e) {
+            // 回调异常不应影响时间轮运行
+        }
+    }
 
     return triggered_count;
 }
 
+std::size_t TimerWheel::Advance(std::chrono::steady_clock::time_point now) {
+    const auto interval = std::chrono::milliseconds(tick_interval_ms_);
+    std::size_t triggered_count = 0;
+    while (now - last_tick_time_ >= interval) {
+        last_tick_time_ += interval;
+        triggered_count += Tick();
+    }
+    return triggered_count;
+}
+
 int TimerWheel::GetNextTickTimeout() const {
     std::lock_guard<std::mutex> lock(mutex_);
 
@@ -180,23 +202,17 @@ Error TimerWheel::CalculateSlot(int timeout_seconds, std::size_t& slot, int& rem
     // 转换为滴答数（1滴答 = 1秒）
     int ticks = timeout_seconds;
 
-    // 计算目标槽位
-    if (ticks <= static_cast<int>(wheel_size_)) {
-        // 单圈内超时
-        slot = (current_slot_.load() + ticks) % wheel_size_;
-        remaining_ticks = 0;
-    } else {
-        // 多圈超时
-        int cycles = ticks / static_cast<int>(wheel_size_);
-        if (cycles > static_cast<int>(kMaxCycles)) {
-            return Error(WebError::kInvalidArgument, "Timeout exceeds maximum cycles");
-        }
-
-        int offset = ticks % static_cast<int>(wheel_size_);
-        slot = (current_slot_.load() + offset) % wheel_size_;
-        remaining_ticks = cycles;
+    // 目标槽位在 offset 个滴答后首次被处理，此后每转一圈减一，
+    // 减到 0 时触发；ticks 恰为轮子大小的整数倍时 offset 为 0，同样适用
+    int cycles = ticks / static_cast<int>(wheel_size_);
+    if (cycles > static_cast<int>(kMaxCycles)) {
+        return Error(WebError::kInvalidArgument, "Timeout exceeds maximum cycles");
     }
 
+    int offset = ticks % static_cast<int>(wheel_size_);
+    slot = (current_slot_.load() + offset) % wheel_size_;
+    remaining_ticks = cycles;
+
     return Error::Success();
 }
 
@@ -207,6 +223,7 @@ void TimerWheel::AddTaskToSlot(std::size_t slot, TimerTask&& task) {
     }
 
     // 添加到槽位列表
+    task.slot = slot;
     auto& slot_list = wheel_[slot];
     slot_list.push_front(std::move(task));
 
@@ -214,7 +231,7 @@ void TimerWheel::AddTaskToSlot(std::size_t slot, TimerTask&& task) {
     timers_[task.fd] = slot_list.begin();
 }
 
-std::size_t TimerWheel::ProcessSlot(std::size_t slot) {
+std::size_t TimerWheel::ProcessSlot(std::size_t slot, std::vector<std::function<void()>>& expired) {
     if (slot >= wheel_.size()) {
         return 0;
     }
@@ -226,30 +243,13 @@ std::size_t TimerWheel::ProcessSlot(std::size_t slot) {
     auto it = slot_list.begin();
     while (it != slot_list.end()) {
         if (it->remaining_ticks > 0) {
-            // 还有剩余圈数，减少圈数并移动到下一轮
+            // 还有剩余圈数：留在本槽位，转完一圈后再次检查
             --(it->remaining_ticks);
-
-            // 移动到下一个槽位（下一圈）
-            std::size_t next_slot = (slot + 1) % wheel_size_;
-
-            // 保存任务并移除当前迭代器
-            TimerTask task = std::move(*it);
-            it = slot_list.erase(it);
-
-            // 更新迭代器映射
-            timers_.erase(task.fd);
-
-            // 重新添加到下一个槽位
-            AddTaskToSlot(next_slot, std::move(task));
+            ++it;
         } else {
-            // 触发超时回调
+            // 到期：回调交给调用方在锁外执行
             if (it->callback) {
-                try {
-                    it->callback();
-                } catch (const std::exception& e) {
-                    // 回调异常不应影响时间轮运行
-                    // 在实际项目中，这里应该记录日志
-                }
+                expired.push_back(std::move(it->callback));
             }
 
             // 从映射中移除
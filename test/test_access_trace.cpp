@@ -0,0 +1,197 @@
+#include "access_trace.h"
+#include "test_check.h"
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace tinywebserver;
+
+namespace {
+
+std::string TempPath(const char* name) {
+    return "/tmp/tws_" + std::to_string(getpid()) + "_" + name;
+}
+
+AccessTraceRecord MakeRecord(uint64_t timestamp_ns, uint64_t connection_id, TraceMethod method,
+                             const std::string& path, uint64_t response_bytes, uint64_t latency_ns) {
+    AccessTraceRecord record;
+    record.timestamp_ns = timestamp_ns;
+    record.connection_id = connection_id;
+    record.method = method;
+    record.path = path;
+    record.response_bytes = response_bytes;
+    record.latency_ns = latency_ns;
+    return record;
+}
+
+/**
+ * @brief 写入后读回字段一致；记录按完成顺序写入，时间戳可以回退
+ */
+void TestRoundTrip() {
+    std::cout << "=== TestRoundTrip ===" << std::endl;
+
+    std::string path = TempPath("roundtrip.trace");
+    std::vector<AccessTraceRecord> written = {
+        MakeRecord(1000000, 1, TraceMethod::kGet, "/index.html", 512, 80000),
+        MakeRecord(500000, 2, TraceMethod::kHead, "/", 0, 1200000),   // 先到后完成
+        MakeRecord(5000000000ull, 1, TraceMethod::kPost, std::string(300, 'p'), 1ull << 40, 0),
+        MakeRecord(5000000000ull, 3, TraceMethod::kOther, "", 0, 7),
+    };
+    {
+        AccessTraceWriter writer;
+        CHECK(writer.Open(path).IsSuccess());
+        for (const auto& record : written) {
+            writer.Append(record);
+        }
+        CHECK(writer.RecordCount() == written.size());
+    }
+
+    std::vector<AccessTraceRecord> read;
+    CHECK(AccessTraceReader::ReadAll(path, read).IsSuccess());
+    CHECK(read.size() == written.size());
+    for (size_t i = 0; i < read.size(); ++i) {
+        CHECK(read[i].timestamp_ns == written[i].timestamp_ns);
+        CHECK(read[i].connection_id == written[i].connection_id);
+        CHECK(read[i].method == written[i].method);
+        CHECK(read[i].path == written[i].path);
+        CHECK(read[i].response_bytes == written[i].response_bytes);
+        CHECK(read[i].latency_ns == written[i].latency_ns);
+    }
+    CHECK(TraceMethodFromString("GET") == TraceMethod::kGet);
+    CHECK(TraceMethodFromString("BREW") == TraceMethod::kOther);
+    CHECK(std::string(TraceMethodName(TraceMethod::kDelete)) == "DELETE");
+    std::remove(path.c_str());
+
+    std::cout << "Round trip test passed!" << std::endl;
+}
+
+/**
+ * @brief 截断的记录与错误的文件头报错，之前的完整记录仍可读出
+ */
+void TestCorruptedFile() {
+    std::cout << "=== TestCorruptedFile ===" << std::endl;
+
+    std::string path = TempPath("truncated.trace");
+    {
+        AccessTraceWriter writer;
+        CHECK(writer.Open(path).IsSuccess());
+        writer.Append(MakeRecord(10, 1, TraceMethod::kGet, "/a", 1, 1));
+        writer.Append(MakeRecord(20, 1, TraceMethod::kGet, "/bbbbbbbb", 2, 2));
+    }
+    CHECK(truncate(path.c_str(), 16 + 7 + 5) == 0);   // 第二条记录只剩路径的一部分
+
+    std::vector<AccessTraceRecord> read;
+    CHECK(AccessTraceReader::ReadAll(path, read).IsFailure());
+    CHECK(read.size() == 1);
+    CHECK(read[0].path == "/a");
+
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    std::fputs("NOTATRACEFILE...", file);
+    std::fclose(file);
+    read.clear();
+    CHECK(AccessTraceReader::ReadAll(path, read).IsFailure());
+    CHECK(read.empty());
+    std::remove(path.c_str());
+
+    std::cout << "Corrupted file test passed!" << std::endl;
+}
+
+/**
+ * @brief 多线程并发追加：记录不丢失，同一线程（连接）的记录保持追加顺序；Flush 后打开状态下即可读到
+ */
+void TestConcurrentAppend() {
+    std::cout << "=== TestConcurrentAppend ===" << std::endl;
+
+    constexpr int kThreads = 4;
+    constexpr int kPerThread = 3000;   // 超过一批，后台线程会在运行中写盘
+    std::string path = TempPath("concurrent.trace");
+    AccessTraceWriter writer;
+    CHECK(writer.Open(path).IsSuccess());
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&writer, t]() {
+            for (int i = 0; i < kPerThread; ++i) {
+                writer.Append(MakeRecord(static_cast<uint64_t>(i) * 1000, static_cast<uint64_t>(t + 1),
+                                         TraceMethod::kGet, "/t" + std::to_string(t), 10, static_cast<uint64_t>(i)));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    CHECK(writer.RecordCount() == static_cast<uint64_t>(kThreads * kPerThread));
+
+    writer.Flush();
+    std::vector<AccessTraceRecord> read;
+    CHECK(AccessTraceReader::ReadAll(path, read).IsSuccess());
+    CHECK(read.size() == static_cast<size_t>(kThreads * kPerThread));
+    std::vector<uint64_t> next(kThreads + 1, 0);
+    for (const auto& record : read) {
+        CHECK(record.connection_id >= 1 && record.connection_id <= static_cast<uint64_t>(kThreads));
+        CHECK(record.latency_ns == next[record.connection_id]);
+        CHECK(record.timestamp_ns == record.latency_ns * 1000);
+        CHECK(record.path == "/t" + std::to_string(record.connection_id - 1));
+        ++next[record.connection_id];
+    }
+
+    writer.Close();
+    CHECK(!writer.IsOpen());
+    writer.Append(MakeRecord(0, 9, TraceMethod::kGet, "/late", 0, 0));   // 关闭后忽略
+    read.clear();
+    CHECK(AccessTraceReader::ReadAll(path, read).IsSuccess());
+    CHECK(read.size() == static_cast<size_t>(kThreads * kPerThread));
+    std::remove(path.c_str());
+
+    std::cout << "Concurrent append test passed!" << std::endl;
+}
+
+/**
+ * @brief 全局开关：启用期间的记录写入文件，停止后忽略
+ */
+void TestGlobalTrace() {
+    std::cout << "=== TestGlobalTrace ===" << std::endl;
+
+    std::string path = TempPath("global.trace");
+    CHECK(!AccessTrace::IsEnabled());
+    CHECK(AccessTrace::Start(path).IsSuccess());
+    CHECK(AccessTrace::IsEnabled());
+    uint64_t id = AccessTrace::NextConnectionId();
+    CHECK(AccessTrace::NextConnectionId() == id + 1);
+    AccessTrace::Record(0, id, TraceMethod::kGet, "/x", 100, 2000);
+    AccessTrace::Stop();
+    CHECK(!AccessTrace::IsEnabled());
+
+    std::vector<AccessTraceRecord> read;
+    CHECK(AccessTraceReader::ReadAll(path, read).IsSuccess());
+    CHECK(read.size() == 1);
+    CHECK(read[0].connection_id == id);
+    CHECK(read[0].timestamp_ns == 0);   // 早于开始时刻的请求记为 0
+    CHECK(read[0].latency_ns == 2000);
+    std::remove(path.c_str());
+
+    std::cout << "Global trace test passed!" << std::endl;
+}
+
+} // namespace
+
+int main() {
+    std::cout << "Starting access trace tests..." << std::endl;
+
+    try {
+        TestRoundTrip();
+        TestCorruptedFile();
+        TestConcurrentAppend();
+        TestGlobalTrace();
+
+        std::cout << "\nAll access trace tests passed!" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    }
+}
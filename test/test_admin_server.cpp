@@ -0,0 +1,139 @@
+#include "admin/admin_server.h"
+#include "server_metrics.h"
+#include "test_check.h"
+#include <arpa/inet.h>
+#include <iostream>
+#include <netinet/in.h>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace tinywebserver;
+
+namespace {
+
+/// 向内核要一个空闲端口（关闭后交给 AdminServer 监听）
+int PickFreePort() {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    CHECK(fd >= 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    CHECK(::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+    socklen_t len = sizeof(addr);
+    CHECK(::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) == 0);
+    ::close(fd);
+    return ntohs(addr.sin_port);
+}
+
+/// 发送一个请求并读到对端关闭（管理连接每个请求后关闭）
+std::string Fetch(int port, const std::string& request) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    CHECK(fd >= 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    CHECK(::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+    CHECK(::write(fd, request.data(), request.size()) == static_cast<ssize_t>(request.size()));
+    std::string response;
+    char buf[4096];
+    ssize_t n;
+    while ((n = ::read(fd, buf, sizeof(buf))) > 0) {
+        response.append(buf, static_cast<size_t>(n));
+    }
+    ::close(fd);
+    return response;
+}
+
+std::string Get(int port, const std::string& target, const std::string& method = "GET") {
+    return Fetch(port, method + " " + target + " HTTP/1.1\r\nHost: localhost\r\n\r\n");
+}
+
+std::string Body(const std::string& response) {
+    size_t pos = response.find("\r\n\r\n");
+    CHECK(pos != std::string::npos);
+    return response.substr(pos + 4);
+}
+
+/**
+ * @brief /metrics 与 /debug/loops 按精确路径路由，查询串被忽略，HEAD 只返回头部
+ */
+void TestRouting(int port) {
+    std::cout << "=== TestRouting ===" << std::endl;
+
+    ServerMetrics::GetInstance().OnRequestWithStatusCode(200);
+    std::string metrics = Get(port, "/metrics");
+    CHECK(metrics.compare(0, 17, "HTTP/1.1 200 OK\r\n") == 0);
+    CHECK(metrics.find("Content-Type: text/plain; version=0.0.4\r\n") != std::string::npos);
+    CHECK(metrics.find("Connection: close\r\n") != std::string::npos);
+    CHECK(Body(metrics).find("# TYPE webserver_requests_total counter") != std::string::npos);
+    CHECK(Body(metrics).find("webserver_requests_by_status_total{") != std::string::npos);
+
+    std::string loops = Get(port, "/debug/loops?verbose=1");
+    CHECK(loops.compare(0, 17, "HTTP/1.1 200 OK\r\n") == 0);
+    CHECK(loops.find("Content-Length: 16\r\n") != std::string::npos);
+    CHECK(Body(loops) == "loop 0: idle ok\n");
+
+    std::string head = Get(port, "/debug/loops", "HEAD");
+    CHECK(head.find("Content-Length: 16\r\n") != std::string::npos);
+    CHECK(Body(head).empty());
+
+    std::cout << "Routing test passed!" << std::endl;
+}
+
+/**
+ * @brief 未知路径 404 并列出可用路由；非 GET/HEAD 405；请求行不合法 400；处理函数异常 500
+ */
+void TestErrors(int port) {
+    std::cout << "=== TestErrors ===" << std::endl;
+
+    std::string missing = Get(port, "/debug/nothing");
+    CHECK(missing.compare(0, 24, "HTTP/1.1 404 Not Found\r\n") == 0);
+    CHECK(Body(missing).find("  /metrics\n") != std::string::npos);
+    CHECK(Body(missing).find("  /debug/loops\n") != std::string::npos);
+    // 只做精确匹配，前缀不算命中
+    CHECK(Get(port, "/metrics/extra").compare(0, 24, "HTTP/1.1 404 Not Found\r\n") == 0);
+
+    std::string post = Fetch(port, "POST /metrics HTTP/1.1\r\nHost: localhost\r\nContent-Length: 0\r\n\r\n");
+    CHECK(post.compare(0, 33, "HTTP/1.1 405 Method Not Allowed\r\n") == 0);
+    CHECK(Body(post) == "method not allowed\n");
+
+    CHECK(Fetch(port, "GARBAGE\r\n\r\n").compare(0, 26, "HTTP/1.1 400 Bad Request\r\n") == 0);
+    CHECK(Get(port, "/debug/throw").compare(0, 36, "HTTP/1.1 500 Internal Server Error\r\n") == 0);
+
+    std::cout << "Errors test passed!" << std::endl;
+}
+
+} // namespace
+
+int main() {
+    std::cout << "Starting admin server tests..." << std::endl;
+
+    try {
+        int port = PickFreePort();
+        AdminServer admin(port);
+        admin.RegisterHandler("/metrics", "text/plain; version=0.0.4", []() {
+            return ServerMetrics::GetInstance().ToPrometheusString();
+        });
+        admin.RegisterHandler("/debug/loops", "text/plain", []() { return std::string("loop 0: idle ok\n"); });
+        admin.RegisterHandler("/debug/throw", "text/plain", []() -> std::string {
+            throw std::runtime_error("handler failure");
+        });
+        CHECK(admin.Start().IsSuccess());
+        CHECK(admin.IsRunning());
+
+        TestRouting(port);
+        TestErrors(port);
+
+        admin.Stop();
+        CHECK(!admin.IsRunning());
+
+        std::cout << "\nAll admin server tests passed!" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    }
+}
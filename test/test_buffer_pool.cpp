@@ -0,0 +1,127 @@
+#include "connection_buffer_pool.h"
+#include "test_check.h"
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace tinywebserver;
+
+namespace {
+
+/**
+ * @brief BufferChain 在首次写入前不分配存储，交出存储后仍可继续使用
+ */
+void TestLazyStorage() {
+    std::cout << "=== TestLazyStorage ===" << std::endl;
+
+    BufferChain chain;
+    CHECK(!chain.HasStorage());
+    CHECK(chain.IsEmpty());
+
+    BufferChain empty;
+    chain.Splice(empty);
+    CHECK(!chain.HasStorage());
+
+    chain.Append(std::string("hello"));
+    CHECK(chain.HasStorage());
+    CHECK(chain.ReleaseStorage() == nullptr);   // 有未发送数据时不交出
+    chain.Advance(5);
+    CHECK(chain.IsEmpty());
+
+    auto storage = chain.ReleaseStorage();
+    CHECK(storage != nullptr);
+    CHECK(!chain.HasStorage());
+
+    chain.AdoptStorage(std::move(storage));
+    CHECK(chain.HasStorage());
+    chain.Append(std::string("abc"));
+    CHECK(chain.TotalBytes() == 3);
+
+    std::cout << "Lazy storage test passed!" << std::endl;
+}
+
+/**
+ * @brief 归还的缓冲区被下一次借用复用，超限的不进池
+ */
+void TestReuse() {
+    std::cout << "=== TestReuse ===" << std::endl;
+
+    ConnectionBufferPool pool;
+
+    std::string input;
+    pool.AcquireString(input);   // 池空：保持原样
+    input.assign(1000, 'x');
+    const char* data = input.data();
+    pool.ReleaseString(input);
+    CHECK(input.empty());
+    CHECK(pool.GetStats().cached_strings == 1);
+
+    std::string next("GET");
+    pool.AcquireString(next);    // 换入缓存的字符串，已有内容保留
+    CHECK(next == "GET");
+    CHECK(next.data() == data);
+    CHECK(pool.GetStats().cached_strings == 0);
+
+    std::string huge(ConnectionBufferPool::kMaxCachedStringCapacity + 1, 'y');
+    pool.ReleaseString(huge);
+    CHECK(huge.empty());
+    CHECK(pool.GetStats().cached_strings == 0);
+
+    CHECK(pool.AcquireStorage() == nullptr);
+    BufferChain chain;
+    chain.Append(std::string("data"));
+    chain.Advance(4);
+    pool.ReleaseStorage(chain.ReleaseStorage());
+    CHECK(pool.GetStats().cached_storages == 1);
+    CHECK(pool.AcquireStorage() != nullptr);
+
+    auto request = pool.AcquireRequest();
+    HttpRequest* raw = request.get();
+    auto holder = request;       // 仍被其它持有者引用：不回收
+    pool.ReleaseRequest(request);
+    CHECK(request == nullptr);
+    CHECK(pool.GetStats().cached_requests == 0);
+    pool.ReleaseRequest(holder);
+    CHECK(pool.GetStats().cached_requests == 1);
+    CHECK(pool.AcquireRequest().get() == raw);
+
+    auto stats = pool.GetStats();
+    CHECK(stats.hits == 3);
+    CHECK(stats.misses == 3);
+
+    std::cout << "Reuse test passed!" << std::endl;
+}
+
+/**
+ * @brief 池的缓存数量有上限
+ */
+void TestCapacityLimit() {
+    std::cout << "=== TestCapacityLimit ===" << std::endl;
+
+    ConnectionBufferPool pool;
+    for (size_t i = 0; i < ConnectionBufferPool::kMaxCachedPerKind + 10; ++i) {
+        std::string s(100, 'z');
+        pool.ReleaseString(s);
+    }
+    CHECK(pool.GetStats().cached_strings == ConnectionBufferPool::kMaxCachedPerKind);
+
+    std::cout << "Capacity limit test passed!" << std::endl;
+}
+
+} // namespace
+
+int main() {
+    std::cout << "Starting connection buffer pool tests..." << std::endl;
+
+    try {
+        TestLazyStorage();
+        TestReuse();
+        TestCapacityLimit();
+
+        std::cout << "\nAll connection buffer pool tests passed!" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+
+/**
+ * @file test_check.h
+ * @brief 测试用断言：条件不成立时抛出带表达式文本的异常，由各测试 main 捕获并返回失败
+ */
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) throw std::runtime_error(std::string("CHECK failed: ") + #cond); \
+    } while (0)
@@ -0,0 +1,84 @@
+#include "http2/hpack_huffman.h"
+#include "test_check.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace tinywebserver::http2;
+
+namespace {
+
+// 典型浏览器请求头的取值，HPACK 中通常以哈夫曼编码出现
+const std::vector<std::string> kSampleValues = {
+    "www.example.com",
+    "/static/js/app.3f9a1c2e.bundle.js?v=20240101",
+    "Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0.0.0 Safari/537.36",
+    "text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8",
+    "gzip, deflate, br",
+    "en-US,en;q=0.9,zh-CN;q=0.8,zh;q=0.7",
+    "session_id=8f14e45fceea167a5a36dedd4bea2543; theme=dark; _ga=GA1.2.1234567890.1700000000",
+    "max-age=0",
+    "https://www.example.com/articles/2024/http2-header-compression",
+    "\"5d8c72a5edda8d6a\"",
+};
+
+using DecodeFn = tinywebserver::Error (*)(const uint8_t*, size_t, std::string&);
+
+/**
+ * @brief 重复解码，返回吞吐（MB/s，按解码输出计）
+ *
+ * 输入为样本拼接后的长串：摊薄每次调用构造 Error 的固定开销，只比较解码循环本身。
+ */
+double Measure(DecodeFn decode, const std::vector<uint8_t>& encoded, size_t decoded_bytes,
+               int iterations) {
+    std::string out;
+    out.reserve(decoded_bytes * 2);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        out.clear();
+        decode(encoded.data(), encoded.size(), out);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return static_cast<double>(decoded_bytes) * iterations / seconds / (1024.0 * 1024.0);
+}
+
+} // namespace
+
+int main() {
+    std::cout << "Starting HPACK Huffman decode benchmark..." << std::endl;
+
+    try {
+        // 样本重复拼接到约 16KB
+        std::string corpus;
+        while (corpus.size() < 16 * 1024) {
+            for (const auto& value : kSampleValues) {
+                corpus += value;
+            }
+        }
+        std::vector<uint8_t> encoded;
+        HpackHuffman::Encode(corpus, encoded);
+
+        std::string table_out;
+        std::string reference_out;
+        CHECK(HpackHuffman::Decode(encoded.data(), encoded.size(), table_out).IsSuccess());
+        CHECK(HpackHuffman::DecodeReference(encoded.data(), encoded.size(), reference_out).IsSuccess());
+        CHECK(table_out == corpus && reference_out == corpus);
+
+        const size_t decoded_bytes = corpus.size();
+        const int kIterations = 2000;
+        double reference = Measure(&HpackHuffman::DecodeReference, encoded, decoded_bytes, kIterations);
+        double table = Measure(&HpackHuffman::Decode, encoded, decoded_bytes, kIterations);
+
+        std::cout << std::fixed << std::setprecision(1)
+                  << "bit-by-bit reference: " << reference << " MB/s\n"
+                  << "4-bit table:          " << table << " MB/s\n"
+                  << "speedup:              " << table / reference << "x" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Benchmark failed with exception: " << e.what() << std::endl;
+        return 1;
+    }
+}
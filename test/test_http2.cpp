@@ -0,0 +1,736 @@
+#include "http2/h2_connection.h"
+#include "http2/h2_stream.h"
+#include "http2/h2_stream_table.h"
+#include "http2/hpack_encoder.h"
+#include "http2/hpack_huffman.h"
+#include "http2/hpack_static_table.h"
+#include "test_check.h"
+#include <algorithm>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace tinywebserver;
+using namespace tinywebserver::http2;
+
+namespace {
+
+struct CapturedFrame {
+    uint8_t type;
+    uint8_t flags;
+    uint32_t stream_id;
+    std::vector<uint8_t> payload;
+};
+
+std::vector<uint8_t> MakeFrame(uint8_t type, uint8_t flags, uint32_t stream_id,
+                               const std::vector<uint8_t>& payload) {
+    std::vector<uint8_t> frame;
+    frame.reserve(9 + payload.size());
+    for (int shift = 16; shift >= 0; shift -= 8) {
+        frame.push_back(static_cast<uint8_t>(payload.size() >> shift));
+    }
+    frame.push_back(type);
+    frame.push_back(flags);
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        frame.push_back(static_cast<uint8_t>(stream_id >> shift));
+    }
+    for (uint8_t byte : payload) {
+        frame.push_back(byte);
+    }
+    return frame;
+}
+
+std::vector<uint8_t> WindowUpdate(uint32_t stream_id, uint32_t increment) {
+    return MakeFrame(0x8, 0, stream_id, {static_cast<uint8_t>(increment >> 24),
+                                         static_cast<uint8_t>(increment >> 16),
+                                         static_cast<uint8_t>(increment >> 8),
+                                         static_cast<uint8_t>(increment)});
+}
+
+/// 模拟 Connection 的输入缓冲区：未消费的字节（不完整的帧）留到下次喂入
+struct InputFeeder {
+    std::vector<uint8_t> pending;
+
+    Error Feed(H2Connection& conn, const std::vector<uint8_t>& bytes) {
+        pending.insert(pending.end(), bytes.begin(), bytes.end());
+        size_t consumed = 0;
+        auto err = conn.ProcessData(pending.data(), pending.size(), consumed);
+        pending.erase(pending.begin(), pending.begin() + static_cast<std::ptrdiff_t>(consumed));
+        return err;
+    }
+};
+
+/// 取走输出链中的字节并按帧切分；给定 mapped 时统计直接引用其映射区的字节数
+void CaptureFrames(BufferChain& chain, std::vector<CapturedFrame>& frames,
+                   const StaticResource* mapped = nullptr, size_t* mapped_bytes = nullptr) {
+    std::vector<uint8_t> bytes;
+    struct iovec iov[16];
+    while (!chain.IsEmpty()) {
+        int count = chain.GetIov(iov, 16);
+        size_t total = 0;
+        for (int i = 0; i < count; ++i) {
+            auto* base = static_cast<const uint8_t*>(iov[i].iov_base);
+            bytes.insert(bytes.end(), base, base + iov[i].iov_len);
+            total += iov[i].iov_len;
+            if (mapped && base >= static_cast<const uint8_t*>(mapped->addr) &&
+                base < static_cast<const uint8_t*>(mapped->addr) + mapped->size) {
+                *mapped_bytes += iov[i].iov_len;
+            }
+        }
+        chain.Advance(total);
+    }
+
+    size_t offset = 0;
+    while (offset < bytes.size()) {
+        CHECK(bytes.size() - offset >= 9);
+        auto header = H2FrameParser::ParseHeader(bytes.data() + offset, 9);
+        CHECK(header && bytes.size() - offset - 9 >= header->length);
+        const uint8_t* payload = bytes.data() + offset + 9;
+        frames.push_back({header->type, header->flags, header->stream_id,
+                          std::vector<uint8_t>(payload, payload + header->length)});
+        offset += 9 + header->length;
+    }
+}
+
+} // namespace
+
+void TestHuffmanDecode() {
+    std::cout << "=== TestHuffmanDecode ===" << std::endl;
+
+    // RFC 7541 C.4.1
+    const uint8_t encoded[] = {0xf1, 0xe3, 0xc2, 0xe5, 0xf2, 0x3a, 0x6b, 0xa0, 0xab, 0x90, 0xf4, 0xff};
+    std::string out;
+    CHECK(HpackHuffman::Decode(encoded, sizeof(encoded), out).IsSuccess());
+    CHECK(out == "www.example.com");
+
+    // 填充超过 7 位（整字节全 1）必须拒绝
+    const uint8_t long_padding[] = {0xf1, 0xe3, 0xc2, 0xe5, 0xf2, 0x3a, 0x6b, 0xa0, 0xab, 0x90, 0xf4, 0xff, 0xff};
+    out.clear();
+    CHECK(HpackHuffman::Decode(long_padding, sizeof(long_padding), out).IsFailure());
+
+    // 填充不是全 1 必须拒绝（'w' = 1111000，末位填 0）
+    const uint8_t bad_padding[] = {0xf0};
+    out.clear();
+    CHECK(HpackHuffman::Decode(bad_padding, sizeof(bad_padding), out).IsFailure());
+
+    // 查表解码与按位解码逐一对照：合法编码的随机串，以及任意随机字节
+    std::mt19937 rng(42);
+    for (int round = 0; round < 2000; ++round) {
+        std::string text(rng() % 64, '\0');
+        for (auto& c : text) {
+            c = static_cast<char>(rng() % 256);
+        }
+        std::vector<uint8_t> bytes;
+        if (round % 2 == 0) {
+            HpackHuffman::Encode(text, bytes);
+        } else {
+            bytes.resize(rng() % 16);
+            for (auto& b : bytes) {
+                b = static_cast<uint8_t>(rng() % 4 == 0 ? 0xFF : rng() % 256);
+            }
+        }
+        std::string fast;
+        std::string reference;
+        bool fast_ok = HpackHuffman::Decode(bytes.data(), bytes.size(), fast).IsSuccess();
+        bool reference_ok = HpackHuffman::DecodeReference(bytes.data(), bytes.size(), reference).IsSuccess();
+        CHECK(fast_ok == reference_ok);
+        if (fast_ok) {
+            CHECK(fast == reference);
+        }
+        if (round % 2 == 0) {
+            CHECK(fast_ok && fast == text);
+        }
+    }
+
+    std::cout << "Huffman decode test passed!" << std::endl;
+}
+
+void TestHpackEncoder() {
+    std::cout << "=== TestHpackEncoder ===" << std::endl;
+
+    // 哈夫曼编码与 RFC 7541 C.4.1 一致
+    std::vector<uint8_t> huffman;
+    HpackHuffman::Encode("www.example.com", huffman);
+    CHECK(huffman == std::vector<uint8_t>({0xf1, 0xe3, 0xc2, 0xe5, 0xf2, 0x3a, 0x6b, 0xa0,
+                                           0xab, 0x90, 0xf4, 0xff}));
+
+    // 完美哈希覆盖全部静态表项
+    for (uint32_t i = 1; i <= kHpackStaticTableSize; ++i) {
+        auto [index, exact] = HpackEncoder::FindStatic(kHpackStaticTable[i].name, kHpackStaticTable[i].value);
+        CHECK(exact && index == i);
+    }
+    CHECK(HpackEncoder::FindStatic("x-unknown", "").first == 0);
+    CHECK(HpackEncoder::FindStatic(":status", "418") == std::make_pair(8u, false));
+
+    HpackEncoder encoder;
+    HpackDecoder decoder;
+    std::vector<HpackHeader> headers = {
+        {":status", "200"}, {"content-type", "text/html"}, {"content-length", "1234"}};
+
+    // 首次：content-type 写入动态表，content-length 以不索引字面值发送；
+    // 二次：:status 与 content-type 为索引，动态表不变；三次：命中缓存
+    std::vector<uint8_t> first;
+    encoder.Encode(headers, first);
+    CHECK(encoder.GetDynamicTableEntryCount() == 1);
+    std::vector<uint8_t> second;
+    encoder.Encode(headers, second);
+    CHECK(second[0] == 0x88 && second[1] == 0xbe);
+    CHECK(second[2] == 0x0f && second[3] == 0x0d);   // 不索引，名称取静态表 28
+    std::vector<uint8_t> third;
+    encoder.Encode(headers, third);
+    CHECK(third == second);
+    CHECK(encoder.GetCacheHits() == 1);
+
+    for (const auto* block : {&first, &second, &third}) {
+        auto decoded = decoder.Decode(block->data(), block->size());
+        CHECK(decoded && decoded->size() == headers.size());
+        for (size_t i = 0; i < headers.size(); ++i) {
+            CHECK((*decoded)[i].name == headers[i].name);
+            CHECK((*decoded)[i].value == headers[i].value);
+        }
+    }
+
+    // 敏感字段使用永不索引表示，不进入动态表
+    std::vector<uint8_t> sensitive;
+    HpackHeader secret{"authorization", "secret-token"};
+    secret.sensitive = true;
+    encoder.Encode({secret}, sensitive);
+    CHECK((sensitive[0] & 0xF0) == 0x10);
+    CHECK(encoder.GetDynamicTableEntryCount() == 1);
+    auto decoded_secret = decoder.Decode(sensitive.data(), sensitive.size());
+    CHECK(decoded_secret && (*decoded_secret)[0].sensitive && (*decoded_secret)[0].value == "secret-token");
+
+    // 对端缩小动态表：下一个头部块以大小更新开头，且缓存失效
+    encoder.SetMaxDynamicTableSize(0);
+    CHECK(encoder.GetDynamicTableEntryCount() == 0);
+    std::vector<uint8_t> after_resize;
+    encoder.Encode(headers, after_resize);
+    CHECK(after_resize[0] == 0x20);
+    CHECK(encoder.GetCacheHits() == 1);
+    auto decoded_resize = decoder.Decode(after_resize.data(), after_resize.size());
+    CHECK(decoded_resize && decoded_resize->size() == headers.size());
+    CHECK((*decoded_resize)[2].value == "1234");
+
+    std::cout << "HPACK encoder test passed!" << std::endl;
+}
+
+void TestHpackBlockCacheAcrossLengths() {
+    std::cout << "=== TestHpackBlockCacheAcrossLengths ===" << std::endl;
+
+    // 同类资源长度各异：content-length 不进动态表，两种响应交替出现时都能命中缓存
+    HpackEncoder encoder;
+    HpackDecoder decoder;
+    const std::vector<HpackHeader> responses[2] = {
+        {{":status", "200"}, {"content-type", "text/css"}, {"content-length", "1000"}},
+        {{":status", "200"}, {"content-type", "text/css"}, {"content-length", "2345"}},
+    };
+    for (int round = 0; round < 3; ++round) {
+        for (const auto& headers : responses) {
+            std::vector<uint8_t> block;
+            encoder.Encode(headers, block);
+            auto decoded = decoder.Decode(block.data(), block.size());
+            CHECK(decoded && decoded->size() == 3);
+            CHECK((*decoded)[2].value == headers[2].value);
+        }
+    }
+    // 首轮第一个块插入 content-type，之后两种块各缓存一次，其余全部命中
+    CHECK(encoder.GetCacheHits() == 3);
+    CHECK(encoder.GetDynamicTableEntryCount() == 1);
+
+    std::cout << "HPACK block cache across lengths test passed!" << std::endl;
+}
+
+void TestHpackDynamicTableRing() {
+    std::cout << "=== TestHpackDynamicTableRing ===" << std::endl;
+
+    // 小表 + 随机长度的值：反复驱逐、回绕与整理后，解码结果仍与编码端一致
+    HpackEncoder encoder(256);
+    HpackDecoder ring_decoder(256);
+    std::mt19937 rng(7541);
+    const char* names[] = {"x-a", "x-bb", "x-ccc", "content-type", "accept-language"};
+    for (int round = 0; round < 2000; ++round) {
+        std::vector<HpackHeader> headers;
+        int count = 1 + static_cast<int>(rng() % 4);
+        for (int i = 0; i < count; ++i) {
+            std::string value(rng() % 120, static_cast<char>('a' + rng() % 26));
+            headers.push_back({names[rng() % 5], value + std::to_string(rng() % 8)});
+        }
+        std::vector<uint8_t> block;
+        encoder.Encode(headers, block);
+        auto decoded = ring_decoder.Decode(block.data(), block.size());
+        CHECK(decoded && decoded->size() == headers.size());
+        for (size_t i = 0; i < headers.size(); ++i) {
+            CHECK((*decoded)[i].name == headers[i].name && (*decoded)[i].value == headers[i].value);
+        }
+        CHECK(ring_decoder.GetDynamicTableSize() == encoder.GetDynamicTableEntryCount());
+        CHECK(ring_decoder.GetDynamicTableUsage() == encoder.GetDynamicTableUsage());
+    }
+
+    // 直接构造接近整表大小的条目（编码器不会索引），覆盖尾部放不下而回绕的路径；
+    // 每次插入后按随机动态索引回读，与 deque 参照模型比较
+    HpackDecoder big_decoder(256);
+    std::deque<std::pair<std::string, std::string>> model;
+    uint32_t model_usage = 0;
+    for (int round = 0; round < 5000; ++round) {
+        std::string name = "n" + std::to_string(rng() % 10);
+        std::string value(rng() % 200, static_cast<char>('a' + round % 26));
+        std::vector<uint8_t> literal = {0x40, static_cast<uint8_t>(name.size())};
+        literal.insert(literal.end(), name.begin(), name.end());
+        literal.push_back(0x7F);   // 值长度 >= 127 时使用多字节整数
+        uint32_t rest = static_cast<uint32_t>(value.size());
+        if (rest < 127) {
+            literal.back() = static_cast<uint8_t>(rest);
+        } else {
+            literal.push_back(static_cast<uint8_t>(rest - 127));
+        }
+        literal.insert(literal.end(), value.begin(), value.end());
+        CHECK(big_decoder.DecodeBlock(literal.data(), literal.size(), [](const HpackHeaderView&) {}).IsSuccess());
+
+        model.emplace_front(name, value);
+        model_usage += static_cast<uint32_t>(name.size() + value.size() + 32);
+        while (model_usage > 256) {
+            model_usage -= static_cast<uint32_t>(model.back().first.size() + model.back().second.size() + 32);
+            model.pop_back();
+        }
+        CHECK(big_decoder.GetDynamicTableSize() == model.size());
+
+        size_t pick = rng() % model.size();
+        uint8_t indexed = static_cast<uint8_t>(0x80 | (kHpackStaticTableSize + 1 + pick));
+        std::string got;
+        CHECK(big_decoder.DecodeBlock(&indexed, 1, [&got](const HpackHeaderView& field) {
+            got = std::string(field.name) + ":" + std::string(field.value);
+        }).IsSuccess());
+        CHECK(got == model[pick].first + ":" + model[pick].second);
+    }
+
+    // 名称引用的条目在插入时被驱逐；随后一个超出整表的条目清空动态表
+    HpackDecoder decoder(64);
+    std::vector<uint8_t> block = {0x40, 0x04, 'a', 'a', 'a', 'a', 0x04, 'b', 'b', 'b', 'b',
+                                  0x7E, 0x08, 'c', 'c', 'c', 'c', 'c', 'c', 'c', 'c'};
+    std::vector<std::string> fields;
+    auto collect = [&fields](const HpackHeaderView& field) {
+        fields.push_back(std::string(field.name) + ":" + std::string(field.value));
+    };
+    CHECK(decoder.DecodeBlock(block.data(), block.size(), collect).IsSuccess());
+    CHECK(fields == std::vector<std::string>({"aaaa:bbbb", "aaaa:cccccccc"}));
+    CHECK(decoder.GetDynamicTableSize() == 1 && decoder.GetDynamicTableUsage() == 44);
+
+    std::vector<uint8_t> oversized = {0x40, 0x01, 'x', 0x28};
+    oversized.insert(oversized.end(), 40, 'y');
+    CHECK(decoder.DecodeBlock(oversized.data(), oversized.size(), collect).IsSuccess());
+    CHECK(fields.back() == "x:" + std::string(40, 'y'));
+    CHECK(decoder.GetDynamicTableSize() == 0 && decoder.GetDynamicTableUsage() == 0);
+
+    // 大小更新只能出现在块开头，且不能超过本端上限
+    std::vector<uint8_t> late_update = {0x82, 0x20};
+    CHECK(decoder.DecodeBlock(late_update.data(), late_update.size(), collect).IsFailure());
+    std::vector<uint8_t> too_large = {0x3F, 0x22};
+    CHECK(decoder.DecodeBlock(too_large.data(), too_large.size(), collect).IsFailure());
+
+    std::cout << "HPACK dynamic table ring test passed!" << std::endl;
+}
+
+void TestRequestAndFlowControl() {
+    std::cout << "=== TestRequestAndFlowControl ===" << std::endl;
+
+    H2Connection conn(-1, true);
+    InputFeeder feeder;
+    std::vector<CapturedFrame> frames;
+    size_t flushes = 0;
+    conn.SetFrameCallback([&frames, &flushes](BufferChain& chain) {
+        ++flushes;
+        CaptureFrames(chain, frames);
+    });
+
+    const size_t kBodySize = 100000;
+    std::vector<uint8_t> body(kBodySize, 'x');
+    std::shared_ptr<H2Stream> request_stream;
+    conn.SetStreamRequestCallback([&](std::shared_ptr<H2Stream> stream) {
+        request_stream = stream;
+        CHECK(stream->SendHeaders({{":status", "200"}, {"content-type", "text/plain"}}, false).IsSuccess());
+        CHECK(stream->SendData(body.data(), body.size(), true).IsSuccess());
+    });
+
+    // 前言 + 空 SETTINGS + HEADERS(END_STREAM | END_HEADERS)，头部块取自 RFC 7541 C.4.1
+    const std::string preface = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+    std::vector<uint8_t> input(preface.begin(), preface.end());
+    auto settings = MakeFrame(0x4, 0, 0, {});
+    auto headers = MakeFrame(0x1, 0x5, 1, {0x82, 0x86, 0x84, 0x41, 0x8c, 0xf1, 0xe3, 0xc2, 0xe5,
+                                           0xf2, 0x3a, 0x6b, 0xa0, 0xab, 0x90, 0xf4, 0xff});
+    input.insert(input.end(), settings.begin(), settings.end());
+    input.insert(input.end(), headers.begin(), headers.end());
+
+    // 分段喂入，覆盖前言与帧跨读边界的情况（剩余的不完整帧留在输入缓冲区）
+    std::vector<uint8_t> first(input.begin(), input.begin() + 10);
+    std::vector<uint8_t> second(input.begin() + 10, input.end() - 5);
+    std::vector<uint8_t> rest(input.end() - 5, input.end());
+    CHECK(feeder.Feed(conn, first).IsSuccess());
+    CHECK(feeder.Feed(conn, second).IsSuccess());
+    CHECK(feeder.pending.size() == headers.size() - 5);
+    CHECK(request_stream == nullptr);
+    flushes = 0;
+    CHECK(feeder.Feed(conn, rest).IsSuccess());
+    CHECK(feeder.pending.empty());
+    // 一批输入产生的响应帧一次交给上层
+    CHECK(flushes == 1);
+
+    CHECK(request_stream != nullptr);
+    const auto& request_headers = request_stream->GetRequestHeaders();
+    CHECK(request_headers.at(":method") == "GET");
+    CHECK(request_headers.at(":path") == "/");
+    CHECK(request_headers.at(":authority") == "www.example.com");
+
+    // 默认初始窗口 65535：DATA 先发满窗口，剩余部分挂起
+    size_t data_bytes = 0;
+    bool saw_headers = false;
+    bool saw_end_stream = false;
+    for (const auto& frame : frames) {
+        if (frame.type == 0x1 && frame.stream_id == 1) {
+            saw_headers = true;
+        } else if (frame.type == 0x0 && frame.stream_id == 1) {
+            CHECK(frame.payload.size() <= 16384);
+            data_bytes += frame.payload.size();
+            saw_end_stream = saw_end_stream || (frame.flags & 0x1);
+        }
+    }
+    CHECK(saw_headers);
+    CHECK(data_bytes == 65535);
+    CHECK(!saw_end_stream);
+    CHECK(request_stream->HasPendingData());
+
+    // 连接级与流级 WINDOW_UPDATE 之后发送剩余数据并结束流
+    frames.clear();
+    CHECK(feeder.Feed(conn, WindowUpdate(0, 1 << 20)).IsSuccess());
+    CHECK(frames.empty());
+    CHECK(feeder.Feed(conn, WindowUpdate(1, 1 << 20)).IsSuccess());
+
+    data_bytes = 0;
+    for (const auto& frame : frames) {
+        if (frame.type == 0x0 && frame.stream_id == 1) {
+            data_bytes += frame.payload.size();
+            saw_end_stream = saw_end_stream || (frame.flags & 0x1);
+        }
+    }
+    CHECK(data_bytes == kBodySize - 65535);
+    CHECK(saw_end_stream);
+    for (const auto& frame : frames) {
+        if (frame.type == 0x0) {
+            CHECK(std::all_of(frame.payload.begin(), frame.payload.end(), [](uint8_t b) { return b == 'x'; }));
+        }
+    }
+    CHECK(request_stream->IsClosed());
+    CHECK(conn.FindStream(1) == nullptr);
+
+    std::cout << "Request and flow control test passed!" << std::endl;
+}
+
+void TestDataScheduling() {
+    std::cout << "=== TestDataScheduling ===" << std::endl;
+
+    H2Connection conn(-1, true);
+    InputFeeder feeder;
+
+    // 模拟 mmap 的静态资源：DATA 负载应直接引用这块内存
+    const size_t kFileSize = 600 * 1024;
+    std::vector<uint8_t> file_bytes(kFileSize);
+    for (size_t i = 0; i < kFileSize; ++i) {
+        file_bytes[i] = static_cast<uint8_t>(i * 131 + 7);
+    }
+    auto file = std::make_shared<StaticResource>();
+    file->addr = file_bytes.data();
+    file->size = kFileSize;
+
+    std::vector<CapturedFrame> frames;
+    size_t mapped_bytes = 0;
+    size_t batch_bytes = 0;
+    conn.SetFrameCallback([&](BufferChain& chain) {
+        batch_bytes = chain.TotalBytes();
+        CaptureFrames(chain, frames, file.get(), &mapped_bytes);
+    });
+
+    // 流 1：大文件（权重 256）；流 3：64KB 动态内容（默认权重 16）；流 5：4KB 小资源
+    const size_t kMediumSize = 64 * 1024;
+    const size_t kSmallSize = 4096;
+    conn.SetStreamRequestCallback([&](std::shared_ptr<H2Stream> stream) {
+        CHECK(stream->SendHeaders({{":status", "200"}}, false).IsSuccess());
+        if (stream->GetStreamId() == 1) {
+            CHECK(stream->GetPriority().weight == 256);
+            CHECK(stream->SendFile(file, true).IsSuccess());
+        } else {
+            std::vector<uint8_t> body(stream->GetStreamId() == 3 ? kMediumSize : kSmallSize, 'y');
+            CHECK(stream->SendData(body.data(), body.size(), true).IsSuccess());
+        }
+    });
+
+    // 放大连接级与流级窗口，只让调度器与输出水位决定发送顺序
+    const std::string preface = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+    std::vector<uint8_t> input(preface.begin(), preface.end());
+    auto append = [&input](const std::vector<uint8_t>& frame) {
+        input.insert(input.end(), frame.begin(), frame.end());
+    };
+    append(MakeFrame(0x4, 0, 0, {0x00, 0x04, 0x01, 0x00, 0x00, 0x00}));   // INITIAL_WINDOW_SIZE = 16MB
+    append(WindowUpdate(0, 16 << 20));
+    const std::vector<uint8_t> block = {0x82, 0x86, 0x84, 0x41, 0x8c, 0xf1, 0xe3, 0xc2, 0xe5,
+                                        0xf2, 0x3a, 0x6b, 0xa0, 0xab, 0x90, 0xf4, 0xff};
+    std::vector<uint8_t> prioritized = {0x00, 0x00, 0x00, 0x00, 0xFF};   // 无依赖，权重 256
+    prioritized.insert(prioritized.end(), block.begin(), block.end());
+    append(MakeFrame(0x1, 0x25, 1, prioritized));   // END_STREAM | END_HEADERS | PRIORITY
+    append(MakeFrame(0x1, 0x5, 3, block));
+    append(MakeFrame(0x1, 0x5, 5, block));
+    CHECK(feeder.Feed(conn, input).IsSuccess());
+
+    std::map<uint32_t, size_t> data_bytes;
+    std::map<uint32_t, size_t> end_order;
+    size_t consumed_frames = 0;
+    size_t ended = 0;
+    std::vector<uint8_t> file_received;
+    auto collect = [&]() {
+        for (; consumed_frames < frames.size(); ++consumed_frames) {
+            const auto& frame = frames[consumed_frames];
+            if (frame.type != 0x0) {
+                continue;
+            }
+            CHECK(frame.payload.size() <= H2Connection::kDataFrameQuantum);
+            data_bytes[frame.stream_id] += frame.payload.size();
+            if (frame.stream_id == 1) {
+                file_received.insert(file_received.end(), frame.payload.begin(), frame.payload.end());
+            }
+            if (frame.flags & 0x1) {
+                end_order[frame.stream_id] = ++ended;
+            }
+        }
+    };
+
+    // 第一批受输出高水位限制；小资源不被大文件挡住，大文件按权重领先
+    collect();
+    CHECK(batch_bytes <= H2Connection::kOutputHighWatermark + 9 + H2Connection::kDataFrameQuantum);
+    CHECK(end_order.count(5) == 1);
+    CHECK(data_bytes[1] < kFileSize);
+    CHECK(data_bytes[1] >= 8 * data_bytes[3]);
+    CHECK(conn.HasPendingOutput());
+
+    // 上层写出后继续调度，每批同样受水位限制
+    size_t rounds = 0;
+    while (conn.HasPendingOutput()) {
+        CHECK(++rounds < 100);
+        conn.OnOutputDrained();
+        CHECK(batch_bytes <= H2Connection::kOutputHighWatermark + 9 + H2Connection::kDataFrameQuantum);
+        collect();
+    }
+
+    CHECK(data_bytes[1] == kFileSize);
+    CHECK(data_bytes[3] == kMediumSize);
+    CHECK(data_bytes[5] == kSmallSize);
+    CHECK(end_order[5] < end_order[1] && end_order[1] < end_order[3]);
+    CHECK(file_received == file_bytes);
+    // 文件负载全部来自映射区，没有拷贝
+    CHECK(mapped_bytes == kFileSize);
+    CHECK(conn.GetActiveStreamCount() == 0);
+
+    std::cout << "DATA scheduling test passed!" << std::endl;
+}
+
+void TestStreamTableAndPool() {
+    std::cout << "=== TestStreamTableAndPool ===" << std::endl;
+
+    // 流表与 std::map 对拍：递增的奇数 ID 随机开关，覆盖扩容、回绕冲突与后移删除
+    H2StreamTable table;
+    std::map<uint32_t, std::shared_ptr<H2Stream>> model;
+    std::mt19937 rng(2024);
+    uint32_t next_id = 1;
+    for (int round = 0; round < 20000; ++round) {
+        bool open = model.empty() || (model.size() < 300 && rng() % 2 == 0);
+        if (open) {
+            // 偶尔跳过一段 ID，模拟被拒绝或从未使用的流
+            next_id += 2 * (rng() % 8 == 0 ? rng() % 64 : 0);
+            auto stream = std::make_shared<H2Stream>(next_id, nullptr);
+            table.Insert(next_id, stream);
+            model[next_id] = stream;
+            next_id += 2;
+        } else {
+            auto it = model.begin();
+            std::advance(it, rng() % model.size());
+            CHECK(table.Erase(it->first) == it->second);
+            model.erase(it);
+        }
+        CHECK(table.Size() == model.size());
+        if (round % 97 == 0) {
+            for (const auto& [id, stream] : model) {
+                CHECK(table.Find(id) == stream);
+            }
+            CHECK(table.Find(next_id) == nullptr);
+            CHECK(table.Snapshot().size() == model.size());
+        }
+    }
+    CHECK(table.Erase(next_id) == nullptr);
+
+    // 顺序请求复用同一个流对象：请求处理完、外部引用释放后回到对象池
+    H2Connection conn(-1, true);
+    InputFeeder feeder;
+    std::vector<CapturedFrame> frames;
+    conn.SetFrameCallback([&frames](BufferChain& chain) { CaptureFrames(chain, frames); });
+    std::vector<const H2Stream*> seen;
+    conn.SetStreamRequestCallback([&seen](std::shared_ptr<H2Stream> stream) {
+        seen.push_back(stream.get());
+        CHECK(stream->GetRequestHeaders().at(":path") == "/");
+        CHECK(stream->GetSendWindow() == 65535);
+        CHECK(stream->SendHeaders({{":status", "204"}}, true).IsSuccess());
+    });
+
+    const std::string preface = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+    std::vector<uint8_t> input(preface.begin(), preface.end());
+    auto settings = MakeFrame(0x4, 0, 0, {});
+    input.insert(input.end(), settings.begin(), settings.end());
+    CHECK(feeder.Feed(conn, input).IsSuccess());
+    const std::vector<uint8_t> block = {0x82, 0x86, 0x84, 0x41, 0x8c, 0xf1, 0xe3, 0xc2, 0xe5,
+                                        0xf2, 0x3a, 0x6b, 0xa0, 0xab, 0x90, 0xf4, 0xff};
+    for (uint32_t id = 1; id <= 9; id += 2) {
+        CHECK(feeder.Feed(conn, MakeFrame(0x1, 0x5, id, block)).IsSuccess());
+        CHECK(conn.GetActiveStreamCount() == 0);
+    }
+    CHECK(seen.size() == 5);
+    CHECK(std::all_of(seen.begin(), seen.end(), [&seen](const H2Stream* s) { return s == seen[0]; }));
+
+    size_t responses = 0;
+    for (const auto& frame : frames) {
+        if (frame.type == 0x1) {
+            CHECK(frame.flags & 0x1);
+            ++responses;
+        }
+    }
+    CHECK(responses == 5);
+
+    std::cout << "Stream table and pool test passed!" << std::endl;
+}
+
+void TestRequestBodyLimit() {
+    std::cout << "=== TestRequestBodyLimit ===" << std::endl;
+
+    H2Connection conn(-1, true);
+    conn.SetMaxRequestBodySize(100000);
+    InputFeeder feeder;
+    std::vector<CapturedFrame> frames;
+    conn.SetFrameCallback([&frames](BufferChain& chain) { CaptureFrames(chain, frames); });
+    std::vector<uint32_t> dispatched;
+    uint64_t dispatched_body = 0;
+    conn.SetStreamRequestCallback([&](std::shared_ptr<H2Stream> stream) {
+        dispatched.push_back(stream->GetStreamId());
+        dispatched_body = stream->GetRequestBodyBytes();
+        CHECK(stream->SendHeaders({{":status", "204"}}, true).IsSuccess());
+    });
+
+    // 只带 END_HEADERS 的 HEADERS：请求体随后到达
+    const std::vector<uint8_t> block = {0x82, 0x86, 0x84, 0x41, 0x8c, 0xf1, 0xe3, 0xc2, 0xe5,
+                                        0xf2, 0x3a, 0x6b, 0xa0, 0xab, 0x90, 0xf4, 0xff};
+    const std::string preface = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+    std::vector<uint8_t> input(preface.begin(), preface.end());
+    auto settings = MakeFrame(0x4, 0, 0, {});
+    input.insert(input.end(), settings.begin(), settings.end());
+    CHECK(feeder.Feed(conn, input).IsSuccess());
+
+    auto stream_window_updates = [&frames](uint32_t stream_id) {
+        uint64_t total = 0;
+        for (const auto& frame : frames) {
+            if (frame.type == 0x8 && frame.stream_id == stream_id) {
+                total += (uint32_t(frame.payload[0] & 0x7f) << 24) | (uint32_t(frame.payload[1]) << 16) |
+                         (uint32_t(frame.payload[2]) << 8) | frame.payload[3];
+            }
+        }
+        return total;
+    };
+
+    // 限额内：窗口过半后按已消费的字节归还，结束后照常分派
+    CHECK(feeder.Feed(conn, MakeFrame(0x1, 0x4, 1, block)).IsSuccess());
+    const std::vector<uint8_t> chunk(16384, 'b');
+    for (int i = 0; i < 3; ++i) {
+        CHECK(feeder.Feed(conn, MakeFrame(0x0, 0, 1, chunk)).IsSuccess());
+    }
+    CHECK(stream_window_updates(1) == 3 * 16384);
+    CHECK(conn.FindStream(1)->GetRecvConsumed() == 0);
+    CHECK(feeder.Feed(conn, MakeFrame(0x0, 0x1, 1, std::vector<uint8_t>(1000, 'b'))).IsSuccess());
+    CHECK(dispatched.size() == 1 && dispatched[0] == 1);
+    CHECK(dispatched_body == 3 * 16384 + 1000);
+
+    // 超出限额：回 413 并以 NO_ERROR 重置流，请求不分派
+    frames.clear();
+    CHECK(feeder.Feed(conn, MakeFrame(0x1, 0x4, 3, block)).IsSuccess());
+    for (int i = 0; i < 7; ++i) {
+        CHECK(feeder.Feed(conn, MakeFrame(0x0, 0, 3, chunk)).IsSuccess());
+    }
+    bool saw_413 = false;
+    bool saw_reset = false;
+    for (const auto& frame : frames) {
+        if (frame.type == 0x1 && frame.stream_id == 3) {
+            saw_413 = (frame.flags & 0x1) && !frame.payload.empty();
+        } else if (frame.type == 0x3 && frame.stream_id == 3) {
+            saw_reset = frame.payload == std::vector<uint8_t>{0, 0, 0, 0};
+        }
+    }
+    CHECK(saw_413);
+    CHECK(saw_reset);
+    CHECK(conn.FindStream(3) == nullptr);
+    CHECK(dispatched.size() == 1);
+
+    // 重置后仍在途的 DATA 只扣连接窗口
+    CHECK(feeder.Feed(conn, MakeFrame(0x0, 0x1, 3, chunk)).IsSuccess());
+    CHECK(dispatched.size() == 1);
+
+    std::cout << "Request body limit test passed!" << std::endl;
+}
+
+void TestOversizedFrameRejected() {
+    std::cout << "=== TestOversizedFrameRejected ===" << std::endl;
+
+    H2Connection conn(-1, true);
+    InputFeeder feeder;
+    std::vector<CapturedFrame> frames;
+    conn.SetFrameCallback([&frames](BufferChain& chain) { CaptureFrames(chain, frames); });
+
+    const std::string preface = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+    std::vector<uint8_t> input(preface.begin(), preface.end());
+    auto oversized = MakeFrame(0x0, 0, 1, std::vector<uint8_t>(16385, 0));
+    input.insert(input.end(), oversized.begin(), oversized.end());
+
+    auto err = feeder.Feed(conn, input);
+    CHECK(err.IsFailure());
+
+    // 上层关闭连接时以 GOAWAY(FRAME_SIZE_ERROR) 告知对端
+    conn.Close(err);
+    bool saw_goaway = false;
+    for (const auto& frame : frames) {
+        if (frame.type == 0x7) {
+            saw_goaway = true;
+            CHECK(frame.payload.size() >= 8);
+            CHECK(frame.payload[7] == 0x6);
+        }
+    }
+    CHECK(saw_goaway);
+
+    std::cout << "Oversized frame test passed!" << std::endl;
+}
+
+int main() {
+    std::cout << "Starting HTTP/2 tests..." << std::endl;
+
+    try {
+        TestHuffmanDecode();
+        TestHpackEncoder();
+        TestHpackBlockCacheAcrossLengths();
+        TestHpackDynamicTableRing();
+        TestRequestAndFlowControl();
+        TestDataScheduling();
+        TestStreamTableAndPool();
+        TestRequestBodyLimit();
+        TestOversizedFrameRejected();
+
+        std::cout << "\nAll HTTP/2 tests passed!" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,306 @@
+#include "load_generator.h"
+#include "test_check.h"
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace tinywebserver::benchmark;
+
+namespace {
+
+/**
+ * @brief 阻塞式测试服务器：每条连接一个线程，按路径返回不同格式的响应
+ *
+ * - /chunked：chunked 编码响应体
+ * - /close：无 Content-Length，写完后关闭连接
+ * - /missing：404
+ * - 其他：Content-Length 响应；stall_ms 非 0 时下一个请求先停顿该时长
+ */
+class TestServer {
+public:
+    TestServer() {
+        listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        struct sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        CHECK(bind(listen_fd_, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == 0);
+        CHECK(listen(listen_fd_, 128) == 0);
+        socklen_t len = sizeof(addr);
+        getsockname(listen_fd_, reinterpret_cast<struct sockaddr*>(&addr), &len);
+        port_ = ntohs(addr.sin_port);
+        acceptor_ = std::thread([this]() { AcceptLoop(); });
+    }
+
+    ~TestServer() {
+        stop_ = true;
+        shutdown(listen_fd_, SHUT_RDWR);
+        close(listen_fd_);
+        acceptor_.join();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    int Port() const { return port_; }
+    void StallNext(int ms) { stall_ms_ = ms; }
+
+private:
+    void AcceptLoop() {
+        while (!stop_) {
+            int fd = accept(listen_fd_, nullptr, nullptr);
+            if (fd < 0) {
+                return;
+            }
+            struct timeval tv = {0, 200 * 1000};
+            setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+            // 流水线时连续写多个小响应，关闭 Nagle 以免与对端延迟确认叠加
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            workers_.emplace_back([this, fd]() { Serve(fd); });
+        }
+    }
+
+    void Serve(int fd) {
+        std::string in;
+        char buffer[4096];
+        while (!stop_) {
+            size_t end = in.find("\r\n\r\n");
+            if (end == std::string::npos) {
+                ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+                if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+                    break;
+                }
+                if (n > 0) {
+                    in.append(buffer, static_cast<size_t>(n));
+                }
+                continue;
+            }
+            std::string path = in.substr(4, in.find(' ', 4) - 4);
+            in.erase(0, end + 4);
+
+            int stall = stall_ms_.exchange(0);
+            if (stall > 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(stall));
+            }
+            std::string response;
+            bool close_after = false;
+            if (path == "/chunked") {
+                response = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+                           "5\r\nhello\r\n6;ext=1\r\n world\r\n0\r\nX-Trailer: 1\r\n\r\n";
+            } else if (path == "/close") {
+                response = "HTTP/1.1 200 OK\r\nConnection: close\r\n\r\nbody until close";
+                close_after = true;
+            } else if (path == "/missing") {
+                response = "HTTP/1.1 404 Not Found\r\nContent-Length: 9\r\n\r\nnot found";
+            } else {
+                response = "HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\nhello";
+            }
+            send(fd, response.data(), response.size(), MSG_NOSIGNAL);
+            if (close_after) {
+                break;
+            }
+        }
+        close(fd);
+    }
+
+    int listen_fd_ = -1;
+    int port_ = 0;
+    std::atomic<bool> stop_{false};
+    std::atomic<int> stall_ms_{0};
+    std::thread acceptor_;
+    std::vector<std::thread> workers_;
+};
+
+LoadGeneratorOptions BaseOptions(const TestServer& server) {
+    LoadGeneratorOptions options;
+    options.port = server.Port();
+    options.threads = 1;
+    options.requests.push_back(LoadGenerator::BuildRequest("GET", "/", "127.0.0.1", "", true));
+    return options;
+}
+
+/**
+ * @brief 服务器停顿期间计划发出的请求在客户端排队：修正后的尾延迟必须体现停顿，
+ * 只从实际发出时刻计时的服务延迟则几乎看不到（协调遗漏）
+ */
+void TestCoordinatedOmissionCorrection() {
+    std::cout << "Testing coordinated omission correction..." << std::endl;
+
+    TestServer server;
+    LoadGeneratorOptions options = BaseOptions(server);
+    options.connections = 1;
+    options.target_rate = 200;
+    options.duration_seconds = 2.0;
+
+    std::thread staller([&server]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(800));
+        server.StallNext(400);
+    });
+    LoadGeneratorStats stats = LoadGenerator(options).Run();
+    staller.join();
+
+    double corrected_p95_ms = stats.corrected.Percentile(0.95) / 1e6;
+    double service_p95_ms = stats.service.Percentile(0.95) / 1e6;
+    std::cout << "  completed=" << stats.completed << " corrected p95=" << corrected_p95_ms
+              << "ms service p95=" << service_p95_ms << "ms" << std::endl;
+
+    // 开环：停顿不会减少计划请求数，停顿过后积压的请求被补发
+    CHECK(stats.completed >= 300);
+    CHECK(stats.Failed() == 0);
+    // 停顿 400ms 期间约 80 个请求排队（占 2 秒内 400 个请求的 20%）
+    CHECK(corrected_p95_ms > 100.0);
+    CHECK(service_p95_ms < 50.0);
+    CHECK(stats.corrected.max_value >= stats.service.max_value);
+
+    std::cout << "  Coordinated omission correction test passed" << std::endl;
+}
+
+/**
+ * @brief 闭环满载 + 不同响应格式：chunked、读到关闭、非 2xx 均被正确计数
+ */
+void TestResponseFraming() {
+    std::cout << "Testing response framing..." << std::endl;
+
+    TestServer server;
+    LoadGeneratorOptions options = BaseOptions(server);
+    options.connections = 4;
+    options.duration_seconds = 0.5;
+    options.requests = {
+        LoadGenerator::BuildRequest("GET", "/", "127.0.0.1", "", true),
+        LoadGenerator::BuildRequest("GET", "/chunked", "127.0.0.1", "", true),
+        LoadGenerator::BuildRequest("GET", "/close", "127.0.0.1", "", true),
+        LoadGenerator::BuildRequest("GET", "/missing", "127.0.0.1", "", true),
+    };
+    LoadGeneratorStats stats = LoadGenerator(options).Run();
+
+    std::cout << "  completed=" << stats.completed << " non_2xx=" << stats.non_2xx
+              << " io_errors=" << stats.io_errors << std::endl;
+    CHECK(stats.completed >= 40);
+    CHECK(stats.io_errors == 0);
+    CHECK(stats.timeouts == 0);
+    // 四种请求轮转，恰好四分之一是 404
+    CHECK(stats.non_2xx >= stats.completed / 4 - 4 && stats.non_2xx <= stats.completed / 4 + 4);
+
+    std::cout << "  Response framing test passed" << std::endl;
+}
+
+/**
+ * @brief 流水线：每批的多个响应可能在一次读取中到达，须逐个按序计数
+ */
+void TestPipelining() {
+    std::cout << "Testing pipelining..." << std::endl;
+
+    TestServer server;
+    LoadGeneratorOptions options = BaseOptions(server);
+    options.connections = 2;
+    options.duration_seconds = 0.5;
+    options.pipeline_depth = 8;
+    options.requests = {
+        LoadGenerator::BuildRequest("GET", "/", "127.0.0.1", "", true),
+        LoadGenerator::BuildRequest("GET", "/chunked", "127.0.0.1", "", true),
+    };
+    LoadGeneratorStats stats = LoadGenerator(options).Run();
+
+    std::cout << "  completed=" << stats.completed << " io_errors=" << stats.io_errors << std::endl;
+    CHECK(stats.completed >= 400);
+    CHECK(stats.Failed() == 0);
+
+    // 开环：队列中积压的请求一次最多取一个流水线深度
+    options.target_rate = 400;
+    stats = LoadGenerator(options).Run();
+    CHECK(stats.completed >= 150);
+    CHECK(stats.Failed() == 0);
+
+    std::cout << "  Pipelining test passed" << std::endl;
+}
+
+/**
+ * @brief 按脚本回放：请求不早于计划时刻发出，同一连接上逐个发送，全部完成后提前结束
+ */
+void TestSchedule() {
+    std::cout << "Testing scripted replay..." << std::endl;
+
+    TestServer server;
+    LoadGeneratorOptions options = BaseOptions(server);
+    options.duration_seconds = 5.0;
+    options.requests.push_back(LoadGenerator::BuildRequest("GET", "/chunked", "127.0.0.1", "", true));
+    // 连接 0：每 50ms 一个请求；连接 1：同一时刻的三个请求须排队逐个发送
+    for (int i = 0; i < 6; ++i) {
+        options.schedule.push_back({0.05 * i, 0, static_cast<size_t>(i % 2)});
+    }
+    for (int i = 0; i < 3; ++i) {
+        options.schedule.push_back({0.1, 1, 0});
+    }
+    server.StallNext(150);
+    LoadGeneratorStats stats = LoadGenerator(options).Run();
+
+    std::cout << "  completed=" << stats.completed << " elapsed=" << stats.elapsed_seconds
+              << "s max=" << stats.corrected.max_value / 1e6 << "ms" << std::endl;
+    CHECK(stats.completed == 9);
+    CHECK(stats.Failed() == 0);
+    CHECK(stats.unsent == 0);
+    CHECK(stats.elapsed_seconds >= 0.25);
+    CHECK(stats.elapsed_seconds < 2.0);
+    // 第一个请求停顿 150ms，同一连接上排在其后的请求从计划时刻计时也至少等待这么久
+    CHECK(stats.corrected.max_value >= 150ull * 1000 * 1000);
+
+    std::cout << "  Scripted replay test passed" << std::endl;
+}
+
+/**
+ * @brief 连接不上时计入连接错误，不应卡住或崩溃
+ */
+void TestConnectFailure() {
+    std::cout << "Testing connect failure..." << std::endl;
+
+    int port;
+    {
+        TestServer server;
+        port = server.Port();
+    }
+    LoadGeneratorOptions options;
+    options.port = port;
+    options.connections = 2;
+    options.threads = 1;
+    options.duration_seconds = 0.3;
+    LoadGeneratorStats stats = LoadGenerator(options).Run();
+
+    CHECK(stats.completed == 0);
+    CHECK(stats.connect_errors > 0);
+
+    std::cout << "  Connect failure test passed" << std::endl;
+}
+
+} // namespace
+
+int main() {
+    std::cout << "Starting load generator tests..." << std::endl;
+
+    try {
+        TestCoordinatedOmissionCorrection();
+        TestResponseFraming();
+        TestPipelining();
+        TestSchedule();
+        TestConnectFailure();
+
+        std::cout << "\nAll load generator tests passed!" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,136 @@
+#include "reactor/event_loop.h"
+#include "reactor/event_loop_thread.h"
+#include "reactor/loop_watchdog.h"
+#include "server_metrics.h"
+#include "test_check.h"
+#include <chrono>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace tinywebserver;
+
+namespace {
+
+constexpr int kThresholdMs = 50;
+constexpr uint64_t kThresholdNs = kThresholdMs * 1000000ULL;
+
+/// 等待循环线程到达某个状态；超时只用于防止测试挂死，不参与判定
+void WaitUntil(const std::function<bool()>& condition) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!condition()) {
+        CHECK(std::chrono::steady_clock::now() < deadline);
+        std::this_thread::yield();
+    }
+}
+
+/**
+ * @brief 在循环线程上执行一个阻塞回调，直到 Release() 才返回
+ */
+class BlockingTask {
+public:
+    explicit BlockingTask(EventLoop* loop) {
+        auto released = released_.get_future().share();
+        loop->QueueInLoop([this, released]() {
+            started_.set_value();
+            released.wait();
+        });
+        started_.get_future().wait();
+    }
+
+    void Release() { released_.set_value(); }
+
+private:
+    std::promise<void> started_;
+    std::promise<void> released_;
+};
+
+} // namespace
+
+void TestIdleLoopIsNotStall() {
+    std::cout << "=== TestIdleLoopIsNotStall ===" << std::endl;
+
+    EventLoopThread loop_thread;
+    EventLoop* loop = loop_thread.StartLoop();
+
+    LoopWatchdog watchdog(kThresholdMs);
+    watchdog.Watch(loop, "idle");
+
+    // 阻塞在 epoll_wait 的空闲循环不应被判定为停顿，无论过去多久
+    WaitUntil([loop]() { return loop->GetBusySinceNs() == 0; });
+    uint64_t now = ServerMetrics::NowNs();
+    CHECK(watchdog.CheckOnce(now) == 0);
+    CHECK(watchdog.CheckOnce(now + 100 * kThresholdNs) == 0);
+    CHECK(watchdog.GetStallCount() == 0);
+
+    // 巡检线程可以正常启停
+    watchdog.Start();
+    watchdog.Stop();
+
+    loop_thread.Stop();
+    loop_thread.Join();
+
+    std::cout << "Idle loop test passed!" << std::endl;
+}
+
+void TestBlockedLoopIsStall() {
+    std::cout << "=== TestBlockedLoopIsStall ===" << std::endl;
+
+    ServerMetrics::GetInstance().Reset();
+
+    EventLoopThread loop_thread;
+    EventLoop* loop = loop_thread.StartLoop();
+
+    LoopWatchdog watchdog(kThresholdMs);
+    watchdog.Watch(loop, "blocked");
+
+    // 模拟阻塞的回调：阈值之前不报告，超过阈值报告一次，同一次停顿不重复计数
+    BlockingTask first(loop);
+    uint64_t busy_since = loop->GetBusySinceNs();
+    CHECK(busy_since != 0);
+    CHECK(watchdog.CheckOnce(busy_since + kThresholdNs - 1) == 0);
+    CHECK(watchdog.CheckOnce(busy_since + kThresholdNs) == 1);
+    CHECK(watchdog.CheckOnce(busy_since + 10 * kThresholdNs) == 0);
+    CHECK(watchdog.GetStallCount() == 1);
+    CHECK(ServerMetrics::GetInstance().GetSnapshot().loop_stalls == 1);
+    first.Release();
+
+    // 回到 epoll_wait 后不再是停顿；下一次阻塞是新的停顿
+    WaitUntil([loop]() { return loop->GetBusySinceNs() == 0; });
+    CHECK(watchdog.CheckOnce(busy_since + 100 * kThresholdNs) == 0);
+
+    BlockingTask second(loop);
+    uint64_t second_since = loop->GetBusySinceNs();
+    CHECK(second_since != 0 && second_since != busy_since);
+    CHECK(watchdog.CheckOnce(second_since + kThresholdNs) == 1);
+    CHECK(watchdog.GetStallCount() == 2);
+    second.Release();
+    WaitUntil([loop]() { return loop->GetBusySinceNs() == 0; });
+
+    CHECK(ServerMetrics::GetInstance().GetSnapshot().loop_stalls == 2);
+    CHECK(ServerMetrics::GetInstance().GetFunctorBatchSnapshot().total_count >= 2);
+    CHECK(ServerMetrics::GetInstance().GetLoopIterationSnapshot().total_count >= 2);
+
+    loop_thread.Stop();
+    loop_thread.Join();
+
+    std::cout << "Blocked loop test passed!" << std::endl;
+}
+
+int main() {
+    std::cout << "Starting LoopWatchdog tests..." << std::endl;
+
+    try {
+        TestIdleLoopIsNotStall();
+        TestBlockedLoopIsStall();
+
+        std::cout << "\nAll LoopWatchdog tests passed!" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,166 @@
+#include "perf_counters.h"
+#include "server_metrics.h"
+#include "test_check.h"
+#include <atomic>
+#include <cerrno>
+#include <fcntl.h>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+using namespace tinywebserver;
+
+namespace {
+
+std::atomic<int> g_open_calls{0};
+std::atomic<int> g_fail_at{0};      // 第几个计数器开始失败（0 表示组长就失败）
+std::atomic<int> g_opened_fd{-1};   // 失败前成功打开的最后一个 fd
+
+/// 模拟 perf_event_paranoid 禁止：前 g_fail_at 个计数器用 /dev/null 占位，之后返回 EACCES
+int FakeOpen(uint64_t /*config*/, int group_fd) {
+    g_open_calls.fetch_add(1);
+    static thread_local int opened_in_group = 0;
+    if (group_fd < 0) {
+        opened_in_group = 0;   // 组长：新的一组
+    }
+    if (opened_in_group >= g_fail_at.load()) {
+        errno = EACCES;
+        return -1;
+    }
+    ++opened_in_group;
+    int fd = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+    g_opened_fd.store(fd);
+    return fd;
+}
+
+PerfSample Garbage() {
+    return {1, 2, 3, 4};
+}
+
+bool IsZero(const PerfSample& sample) {
+    return sample.cycles == 0 && sample.instructions == 0 && sample.cache_misses == 0 && sample.branch_misses == 0;
+}
+
+uint64_t TotalSamples() {
+    uint64_t total = 0;
+    for (int i = 0; i < static_cast<int>(PerfPhase::kCount); ++i) {
+        total += ServerMetrics::GetInstance().GetPerfSnapshot(static_cast<PerfPhase>(i)).samples;
+    }
+    return total;
+}
+
+/**
+ * @brief 未启用：不尝试打开，Read 返回零值，阶段采样不计数
+ */
+void TestDisabled() {
+    std::cout << "=== TestDisabled ===" << std::endl;
+
+    PerfCounters::SetEnabled(false);
+    g_open_calls = 0;
+    CHECK(!PerfCounters::OpenForCurrentThread());
+    CHECK(g_open_calls == 0);
+
+    PerfSample sample = Garbage();
+    CHECK(!PerfCounters::Read(sample));
+    CHECK(IsZero(sample));
+
+    for (int i = 0; i < 100; ++i) {
+        PerfPhaseScope scope(PerfPhase::kRespond);
+    }
+    CHECK(TotalSamples() == 0);
+
+    std::cout << "Disabled test passed!" << std::endl;
+}
+
+/**
+ * @brief perf_event_open 失败：每线程只尝试一次，之后的请求级采样不再触碰内核
+ */
+void TestOpenFailure() {
+    std::cout << "=== TestOpenFailure ===" << std::endl;
+
+    PerfCounters::SetEnabled(true);
+    g_fail_at = 0;
+    g_open_calls = 0;
+    CHECK(!PerfCounters::OpenForCurrentThread());
+    CHECK(g_open_calls == 1);
+
+    // 不重试：EventLoop 线程重复调用、每个请求的 PerfPhaseScope 都不会再打开或告警
+    CHECK(!PerfCounters::OpenForCurrentThread());
+    for (int i = 0; i < 1000; ++i) {
+        PerfPhaseScope scope(PerfPhase::kParse);
+    }
+    CHECK(g_open_calls == 1);
+    CHECK(TotalSamples() == 0);
+
+    PerfSample sample = Garbage();
+    CHECK(!PerfCounters::Read(sample));
+    CHECK(IsZero(sample));
+
+    // 其它线程各自尝试一次
+    std::thread other([]() {
+        CHECK(!PerfCounters::OpenForCurrentThread());
+        CHECK(!PerfCounters::OpenForCurrentThread());
+    });
+    other.join();
+    CHECK(g_open_calls == 2);
+
+    // 显式关闭后允许重新尝试
+    PerfCounters::CloseForCurrentThread();
+    CHECK(!PerfCounters::OpenForCurrentThread());
+    CHECK(g_open_calls == 3);
+    PerfCounters::CloseForCurrentThread();
+
+    std::cout << "Open failure test passed!" << std::endl;
+}
+
+/**
+ * @brief 组内后续计数器打开失败：已打开的 fd 被关闭，计数组保持未打开
+ */
+void TestPartialOpenFailure() {
+    std::cout << "=== TestPartialOpenFailure ===" << std::endl;
+
+    PerfCounters::SetEnabled(true);
+    g_fail_at = 2;
+    g_open_calls = 0;
+    g_opened_fd = -1;
+    CHECK(!PerfCounters::OpenForCurrentThread());
+    CHECK(g_open_calls == 3);
+
+    int leaked = g_opened_fd.load();
+    CHECK(leaked >= 0);
+    errno = 0;
+    CHECK(::fcntl(leaked, F_GETFD) == -1 && errno == EBADF);
+
+    PerfSample sample = Garbage();
+    CHECK(!PerfCounters::Read(sample));
+    CHECK(IsZero(sample));
+    PerfCounters::CloseForCurrentThread();
+
+    std::cout << "Partial open failure test passed!" << std::endl;
+}
+
+} // namespace
+
+int main() {
+    std::cout << "Starting perf counters tests..." << std::endl;
+
+    try {
+        ServerMetrics::GetInstance().Reset();
+        PerfCounters::SetOpenFunction(&FakeOpen);
+
+        TestDisabled();
+        TestOpenFailure();
+        TestPartialOpenFailure();
+
+        PerfCounters::SetOpenFunction(nullptr);
+        PerfCounters::SetEnabled(false);
+
+        std::cout << "\nAll perf counters tests passed!" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,247 @@
+#include "http/request_body.h"
+#include "test_check.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <netinet/in.h>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace tinywebserver;
+
+namespace {
+
+HttpRequest MakeRequest(const std::string& headers) {
+    HttpRequest request;
+    std::string raw = "POST /submit HTTP/1.1\r\nHost: localhost\r\n" + headers + "\r\n";
+    CHECK(request.Parse(raw));
+    return request;
+}
+
+/// 每次只输入 step 个字节，返回解出的载荷与消费的总字节数
+std::string FeedInSteps(BodyDecoder& decoder, const std::string& input, size_t step, size_t& consumed_total) {
+    std::string body;
+    auto on_data = [&body](const char* data, size_t len) {
+        body.append(data, len);
+        return Error::Success();
+    };
+    consumed_total = 0;
+    while (consumed_total < input.size() && !decoder.IsDone()) {
+        size_t len = std::min(step, input.size() - consumed_total);
+        size_t consumed = 0;
+        Error err = decoder.Feed(input.data() + consumed_total, len, on_data, consumed);
+        if (err.IsFailure()) {
+            throw std::runtime_error(err.ToString());
+        }
+        consumed_total += consumed;
+        if (consumed < len) {
+            break;   // 请求体已结束，其余属于下一个请求
+        }
+    }
+    return body;
+}
+
+/**
+ * @brief Content-Length：只消费声明的长度，后续字节留给下一个请求
+ */
+void TestContentLength() {
+    std::cout << "=== TestContentLength ===" << std::endl;
+
+    for (size_t step : {1, 3, 1024}) {
+        BodyDecoder decoder;
+        CHECK(decoder.Init(MakeRequest("Content-Length: 11\r\n"), 1024).IsSuccess());
+        CHECK(decoder.GetMode() == BodyDecoder::Mode::kContentLength);
+        CHECK(decoder.RawRemaining() == 11);
+        size_t consumed = 0;
+        std::string body = FeedInSteps(decoder, "hello worldGET / HTTP/1.1\r\n", step, consumed);
+        CHECK(body == "hello world");
+        CHECK(consumed == 11);
+        CHECK(decoder.IsDone());
+    }
+
+    BodyDecoder none;
+    CHECK(none.Init(MakeRequest(""), 1024).IsSuccess());
+    CHECK(!none.HasBody());
+    CHECK(none.Init(MakeRequest("Content-Length: 0\r\n"), 1024).IsSuccess());
+    CHECK(!none.HasBody());
+
+    BodyDecoder decoder;
+    CHECK(decoder.Init(MakeRequest("Content-Length: 2048\r\n"), 1024).GetCode() == WebError::kRequestTooLarge);
+    CHECK(decoder.Init(MakeRequest("Content-Length: -1\r\n"), 1024).GetCode() == WebError::kInvalidRequest);
+    CHECK(decoder.Init(MakeRequest("Content-Length: 1x\r\n"), 1024).GetCode() == WebError::kInvalidRequest);
+
+    std::cout << "Content-Length test passed!" << std::endl;
+}
+
+/**
+ * @brief chunked：任意切分输入都得到相同结果；扩展与尾部字段被忽略
+ */
+void TestChunked() {
+    std::cout << "=== TestChunked ===" << std::endl;
+
+    const std::string input =
+        "5\r\nhello\r\n"
+        "1;name=value\r\n \r\n"
+        "A\r\n0123456789\r\n"
+        "0\r\nX-Checksum: abc\r\n\r\n"
+        "GET /next HTTP/1.1\r\n";
+    const size_t body_end = input.find("GET");
+
+    for (size_t step = 1; step <= input.size(); ++step) {
+        BodyDecoder decoder;
+        CHECK(decoder.Init(MakeRequest("Transfer-Encoding: chunked\r\n"), 1024).IsSuccess());
+        size_t consumed = 0;
+        std::string body = FeedInSteps(decoder, input, step, consumed);
+        CHECK(body == "hello 0123456789");
+        CHECK(consumed == body_end);
+        CHECK(decoder.IsDone());
+        CHECK(decoder.GetBodyBytes() == 16);
+    }
+
+    // 分块载荷可以不经 Feed 直接搬运
+    BodyDecoder decoder;
+    CHECK(decoder.Init(MakeRequest("Transfer-Encoding: Chunked\r\n"), 1024).IsSuccess());
+    size_t consumed = 0;
+    auto ignore = [](const char*, size_t) { return Error::Success(); };
+    CHECK(decoder.Feed("8\r\n", 3, ignore, consumed).IsSuccess());
+    CHECK(decoder.RawRemaining() == 8);
+    decoder.ConsumeRaw(8);
+    CHECK(decoder.RawRemaining() == 0);
+    CHECK(decoder.Feed("\r\n0\r\n\r\n", 7, ignore, consumed).IsSuccess());
+    CHECK(consumed == 7);
+    CHECK(decoder.IsDone());
+
+    std::cout << "Chunked test passed!" << std::endl;
+}
+
+/**
+ * @brief 非法帧、走私风险的头部组合与超限
+ */
+void TestRejects() {
+    std::cout << "=== TestRejects ===" << std::endl;
+
+    BodyDecoder decoder;
+    CHECK(decoder.Init(MakeRequest("Transfer-Encoding: chunked\r\nContent-Length: 5\r\n"), 1024).GetCode() ==
+          WebError::kInvalidRequest);
+    CHECK(decoder.Init(MakeRequest("Transfer-Encoding: gzip\r\n"), 1024).GetCode() == WebError::kInvalidRequest);
+
+    auto feed_all = [](BodyDecoder& d, const std::string& s) {
+        size_t consumed = 0;
+        return d.Feed(s.data(), s.size(), [](const char*, size_t) { return Error::Success(); }, consumed);
+    };
+    const std::string bad_inputs[] = {
+        "zz\r\n",                    // 非十六进制
+        "\r\n",                      // 缺少长度
+        "3\r\nabcX\r\n",             // 数据后缺少 CRLF
+        "3\nabc\r\n",                // 裸 LF
+        "1000000000000000\r\n",      // 长度溢出
+    };
+    for (const auto& input : bad_inputs) {
+        CHECK(decoder.Init(MakeRequest("Transfer-Encoding: chunked\r\n"), 1024).IsSuccess());
+        CHECK(feed_all(decoder, input).GetCode() == WebError::kInvalidRequest);
+    }
+
+    CHECK(decoder.Init(MakeRequest("Transfer-Encoding: chunked\r\n"), 8).IsSuccess());
+    CHECK(feed_all(decoder, "5\r\nhello\r\n").IsSuccess());
+    CHECK(feed_all(decoder, "4\r\n").GetCode() == WebError::kRequestTooLarge);
+
+    std::cout << "Rejects test passed!" << std::endl;
+}
+
+/**
+ * @brief 上传：缓冲区部分用 write，其余从 TCP socket 经管道 splice 进文件
+ */
+void TestFileUploadSplice() {
+    std::cout << "=== TestFileUploadSplice ===" << std::endl;
+
+    int listener = ::socket(AF_INET, SOCK_STREAM, 0);
+    CHECK(listener >= 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    CHECK(::bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+    CHECK(::listen(listener, 1) == 0);
+    socklen_t len = sizeof(addr);
+    CHECK(::getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &len) == 0);
+    int client = ::socket(AF_INET, SOCK_STREAM, 0);
+    CHECK(::connect(client, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+    int server = ::accept(listener, nullptr, nullptr);
+    CHECK(server >= 0);
+
+    std::string payload;
+    for (int i = 0; i < 20000; ++i) {
+        payload += static_cast<char>('a' + i % 26);
+    }
+    CHECK(::write(client, payload.data() + 100, payload.size() - 100) == static_cast<ssize_t>(payload.size() - 100));
+    ::shutdown(client, SHUT_WR);
+
+    char dir_template[] = "/tmp/test_request_body_XXXXXX";
+    std::string dir = mkdtemp(dir_template);
+    std::string target = dir + "/upload.bin";
+    {
+        FileUploadSink sink;
+        CHECK(sink.Open(target).IsSuccess());
+        CHECK(sink.Write(payload.data(), 100).IsSuccess());   // 随请求头一起读入缓冲区的部分
+        size_t total = 100;
+        while (total < payload.size()) {
+            size_t moved = 0;
+            bool eof = false;
+            CHECK(sink.SpliceFrom(server, payload.size() - total, moved, eof).IsSuccess());
+            CHECK(!eof);
+            if (moved == 0 && !sink.SupportsSplice()) {
+                char buf[4096];
+                ssize_t n = ::read(server, buf, sizeof(buf));
+                CHECK(n > 0);
+                CHECK(sink.Write(buf, static_cast<size_t>(n)).IsSuccess());
+                moved = static_cast<size_t>(n);
+            }
+            total += moved;
+        }
+        CHECK(sink.GetBytes() == payload.size());
+        CHECK(::access(target.c_str(), F_OK) != 0);   // 完成前只有临时文件
+        CHECK(sink.Finish().IsSuccess());
+        std::cout << "  spliced " << sink.GetSplicedBytes() << " of " << payload.size() << " bytes" << std::endl;
+    }
+    std::ifstream in(target, std::ios::binary);
+    std::stringstream content;
+    content << in.rdbuf();
+    CHECK(content.str() == payload);
+
+    // 未完成的上传不留下文件
+    {
+        FileUploadSink sink;
+        CHECK(sink.Open(dir + "/partial.bin").IsSuccess());
+        CHECK(sink.Write("x", 1).IsSuccess());
+    }
+    CHECK(::access((dir + "/partial.bin").c_str(), F_OK) != 0);
+
+    ::close(client);
+    ::close(server);
+    ::close(listener);
+    std::system(("rm -rf " + dir).c_str());
+    std::cout << "File upload splice test passed!" << std::endl;
+}
+
+} // namespace
+
+int main() {
+    std::cout << "Starting request body tests..." << std::endl;
+
+    try {
+        TestContentLength();
+        TestChunked();
+        TestRejects();
+        TestFileUploadSplice();
+
+        std::cout << "\nAll request body tests passed!" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,349 @@
+#include "connection.h"
+#include "http/response_writer.h"
+#include "reactor/event_loop.h"
+#include "reactor/event_loop_thread.h"
+#include "test_check.h"
+#include <atomic>
+#include <chrono>
+#include <fcntl.h>
+#include <future>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace tinywebserver;
+
+namespace {
+
+/// 在 loop 线程执行 f 并等待完成
+template <typename F>
+void RunOnLoop(EventLoop* loop, F f) {
+    std::promise<void> done;
+    loop->RunInLoop([&]() {
+        f();
+        done.set_value();
+    });
+    done.get_future().wait();
+}
+
+template <typename Pred>
+bool WaitFor(Pred pred) {
+    for (int i = 0; i < 500; ++i) {
+        if (pred()) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+HttpRequest MakeRequest(const std::string& request_line, const std::string& headers = "") {
+    HttpRequest request;
+    std::string raw = request_line + "\r\nHost: localhost\r\n" + headers + "\r\n";
+    CHECK(request.Parse(raw));
+    return request;
+}
+
+/**
+ * @brief 服务端为 Connection，测试线程持有对端 socket
+ */
+struct ConnectionPair {
+    EventLoopThread loop_thread;
+    EventLoop* loop = nullptr;
+    std::shared_ptr<Connection> conn;
+    int peer = -1;
+
+    ConnectionPair() {
+        int fds[2];
+        CHECK(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+        ::fcntl(fds[0], F_SETFL, ::fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+        peer = fds[1];
+        loop = loop_thread.StartLoop();
+        conn = std::make_shared<Connection>(fds[0], loop);
+        RunOnLoop(loop, [this]() { conn->ConnectEstablished(); });
+    }
+
+    ~ConnectionPair() {
+        RunOnLoop(loop, [this]() {
+            conn->Close(Error(WebError::kTimeout, "test done"));
+            conn.reset();
+        });
+        ::close(peer);
+        loop_thread.Stop();
+        loop_thread.Join();
+    }
+
+    /// 读到 until 出现或对端关闭为止
+    std::string ReadUntil(const std::string& until) {
+        std::string data;
+        char buf[65536];
+        while (data.find(until) == std::string::npos) {
+            ssize_t n = ::read(peer, buf, sizeof(buf));
+            if (n <= 0) {
+                break;
+            }
+            data.append(buf, static_cast<size_t>(n));
+        }
+        return data;
+    }
+};
+
+/// 解出 chunked 响应体，格式错误时抛出
+std::string DecodeChunked(const std::string& body) {
+    std::string out;
+    size_t pos = 0;
+    while (true) {
+        size_t line_end = body.find("\r\n", pos);
+        CHECK(line_end != std::string::npos);
+        size_t size = std::stoul(body.substr(pos, line_end - pos), nullptr, 16);
+        pos = line_end + 2;
+        if (size == 0) {
+            CHECK(body.compare(pos, 2, "\r\n") == 0);
+            return out;
+        }
+        out.append(body, pos, size);
+        pos += size;
+        CHECK(body.compare(pos, 2, "\r\n") == 0);
+        pos += 2;
+    }
+}
+
+/**
+ * @brief 未声明长度时使用 chunked：小片段合并为一个节点，大片段不拷贝，处理器给出的分帧头部被忽略
+ */
+void TestChunkedResponse() {
+    std::cout << "=== TestChunkedResponse ===" << std::endl;
+
+    ConnectionPair pair;
+    std::string big(40000, 'x');
+    int finished_status = 0;
+    uint64_t finished_bytes = 0;
+    RunOnLoop(pair.loop, [&]() {
+        auto writer = Http1ResponseWriter::Create(pair.conn, MakeRequest("GET /gen HTTP/1.1"));
+        CHECK(pair.conn->IsStreamingResponse());
+        writer->SetFinishCallback([&](int status, uint64_t bytes, const Error& result) {
+            CHECK(result.IsSuccess());
+            finished_status = status;
+            finished_bytes = bytes;
+        });
+        CHECK(writer->WriteHead(200, {{"Content-Type", "text/plain"}, {"Transfer-Encoding", "gzip"}}).IsSuccess());
+        CHECK(writer->Write("hello").IsSuccess());
+        CHECK(writer->Write(std::string(big)).IsSuccess());
+        CHECK(writer->End().IsSuccess());
+        CHECK(writer->Write("late").IsFailure());
+        CHECK(!pair.conn->IsStreamingResponse());
+    });
+
+    std::string response = pair.ReadUntil("\r\n0\r\n\r\n");
+    size_t head_end = response.find("\r\n\r\n");
+    std::string head = response.substr(0, head_end + 4);
+    CHECK(head == "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\n"
+                  "Transfer-Encoding: chunked\r\nConnection: keep-alive\r\n\r\n");
+    CHECK(response.compare(head_end + 4, 10, "5\r\nhello\r\n") == 0);
+    CHECK(DecodeChunked(response.substr(head_end + 4)) == "hello" + big);
+    CHECK(finished_status == 200);
+    CHECK(finished_bytes == 5 + big.size());
+
+    std::cout << "Chunked response test passed!" << std::endl;
+}
+
+/**
+ * @brief 声明 Content-Length 时原样发送并校验长度；HTTP/1.0 以关闭连接结束响应体；无响应体时不用 chunked
+ */
+void TestFramingVariants() {
+    std::cout << "=== TestFramingVariants ===" << std::endl;
+
+    {
+        ConnectionPair pair;
+        RunOnLoop(pair.loop, [&]() {
+            auto writer = Http1ResponseWriter::Create(pair.conn, MakeRequest("GET /gen HTTP/1.1"));
+            CHECK(writer->WriteHead(201, {{"Content-Length", "6"}}).IsSuccess());
+            CHECK(writer->Write("abc").IsSuccess());
+            CHECK(writer->Write("defg").IsFailure());   // 超出声明的长度
+            CHECK(writer->Write("def").IsSuccess());
+            CHECK(writer->End().IsSuccess());
+        });
+        std::string response = pair.ReadUntil("abcdef");
+        CHECK(response == "HTTP/1.1 201 Created\r\nContent-Length: 6\r\nConnection: keep-alive\r\n\r\nabcdef");
+    }
+    {
+        // 实际长度不足：中止并关闭连接
+        ConnectionPair pair;
+        Error finish_result;
+        RunOnLoop(pair.loop, [&]() {
+            auto writer = Http1ResponseWriter::Create(pair.conn, MakeRequest("GET /gen HTTP/1.1"));
+            writer->SetFinishCallback([&](int, uint64_t, const Error& result) { finish_result = result; });
+            CHECK(writer->WriteHead(200, {{"Content-Length", "10"}}).IsSuccess());
+            CHECK(writer->Write("abc").IsSuccess());
+            CHECK(writer->End().IsFailure());
+            CHECK(!pair.conn->IsConnected());
+        });
+        CHECK(finish_result.IsFailure());
+        std::string response = pair.ReadUntil("<eof>");
+        CHECK(response.find("abc") != std::string::npos);
+    }
+    {
+        ConnectionPair pair;
+        RunOnLoop(pair.loop, [&]() {
+            auto writer = Http1ResponseWriter::Create(pair.conn, MakeRequest("GET /gen HTTP/1.0"));
+            CHECK(writer->Write("one,").IsSuccess());
+            CHECK(writer->Write("two").IsSuccess());
+            CHECK(writer->End().IsSuccess());
+        });
+        std::string response = pair.ReadUntil("<eof>");
+        CHECK(response == "HTTP/1.1 200 OK\r\nConnection: close\r\n\r\none,two");
+    }
+    {
+        // 处理器没写响应体就结束；HEAD 不发送响应体
+        ConnectionPair pair;
+        RunOnLoop(pair.loop, [&]() {
+            auto writer = Http1ResponseWriter::Create(pair.conn, MakeRequest("GET /gen HTTP/1.1"));
+            CHECK(writer->End().IsSuccess());
+            writer = Http1ResponseWriter::Create(pair.conn, MakeRequest("HEAD /gen HTTP/1.1"));
+            CHECK(writer->Write("ignored").IsSuccess());
+            CHECK(writer->End().IsSuccess());
+            CHECK(writer->GetBodyBytes() == 0);
+        });
+        std::string response = pair.ReadUntil("chunked\r\nConnection: keep-alive\r\n\r\n");
+        CHECK(response ==
+              "HTTP/1.1 200 OK\r\nContent-Length: 0\r\nConnection: keep-alive\r\n\r\n"
+              "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\nConnection: keep-alive\r\n\r\n");
+    }
+
+    std::cout << "Framing variants test passed!" << std::endl;
+}
+
+/**
+ * @brief 积压超过高水位后 IsWritable 为 false，对端读取后在低水位以下回调 OnWritable
+ */
+void TestBackpressure() {
+    std::cout << "=== TestBackpressure ===" << std::endl;
+
+    ConnectionPair pair;
+    int sndbuf = 16 * 1024;
+    ::setsockopt(pair.conn->GetFd(), SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+    const size_t kPiece = 32 * 1024;
+    const size_t high = pair.conn->GetOutputHighWatermark();
+
+    std::shared_ptr<ResponseWriter> writer;
+    std::atomic<bool> resumed{false};
+    std::atomic<size_t> backlog_at_resume{0};
+    size_t written = 0;
+    RunOnLoop(pair.loop, [&]() {
+        writer = Http1ResponseWriter::Create(pair.conn, MakeRequest("GET /gen HTTP/1.1"));
+        while (writer->IsWritable()) {
+            CHECK(writer->Write(std::string(kPiece, 'a' + written / kPiece % 26)).IsSuccess());
+            written += kPiece;
+        }
+        // 生产者最多比高水位多写一个片段
+        CHECK(writer->GetBacklog() >= high);
+        CHECK(writer->GetBacklog() < high + kPiece + 64);
+        writer->OnWritable([&]() {
+            backlog_at_resume = writer->GetBacklog();
+            resumed = true;
+        });
+    });
+    CHECK(!resumed);
+
+    // 对端开始读取：积压降到低水位后回调
+    std::string received;
+    char buf[65536];
+    while (!resumed) {
+        ssize_t n = ::read(pair.peer, buf, sizeof(buf));
+        CHECK(n > 0);
+        received.append(buf, static_cast<size_t>(n));
+    }
+    CHECK(backlog_at_resume <= high / 2);
+
+    RunOnLoop(pair.loop, [&]() {
+        CHECK(writer->IsWritable());
+        CHECK(writer->End().IsSuccess());
+        writer.reset();
+    });
+    std::string rest = pair.ReadUntil("\r\n0\r\n\r\n");
+    received += rest;
+    while (received.compare(received.size() - 5, 5, "0\r\n\r\n") != 0) {
+        received += pair.ReadUntil("0\r\n\r\n");
+    }
+    std::string body = DecodeChunked(received.substr(received.find("\r\n\r\n") + 4));
+    CHECK(body.size() == written);
+    CHECK(body[0] == 'a' && body[kPiece] == 'b');
+
+    std::cout << "Backpressure test passed!" << std::endl;
+}
+
+/**
+ * @brief 流式响应期间后续请求留在缓冲区，结束后才交给消息回调；连接关闭时唤醒等待的生产者
+ */
+void TestStreamingPausesDispatch() {
+    std::cout << "=== TestStreamingPausesDispatch ===" << std::endl;
+
+    ConnectionPair pair;
+    std::atomic<int> dispatched{0};
+    std::shared_ptr<ResponseWriter> writer;
+    RunOnLoop(pair.loop, [&]() {
+        pair.conn->SetMessageCallback([&](std::shared_ptr<Connection> conn, const std::string&) {
+            dispatched++;
+            conn->GetInputBuffer().clear();
+        });
+        writer = Http1ResponseWriter::Create(pair.conn, MakeRequest("GET /gen HTTP/1.1"));
+        CHECK(writer->Write("partial").IsSuccess());
+    });
+
+    const std::string next = "GET /next HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    CHECK(::write(pair.peer, next.data(), next.size()) == static_cast<ssize_t>(next.size()));
+    CHECK(WaitFor([&] {
+        bool buffered = false;
+        RunOnLoop(pair.loop, [&]() { buffered = !pair.conn->GetInputBuffer().empty(); });
+        return buffered;
+    }));
+    CHECK(dispatched == 0);
+
+    RunOnLoop(pair.loop, [&]() { CHECK(writer->End().IsSuccess()); });
+    CHECK(WaitFor([&] { return dispatched == 1; }));
+
+    // 等待可写时连接关闭：回调照常执行，此时已不可写
+    std::atomic<bool> woken{false};
+    std::atomic<bool> open_when_woken{true};
+    RunOnLoop(pair.loop, [&]() {
+        writer = Http1ResponseWriter::Create(pair.conn, MakeRequest("GET /gen HTTP/1.1"));
+        while (writer->IsWritable()) {
+            CHECK(writer->Write(std::string(64 * 1024, 'z')).IsSuccess());
+        }
+        writer->OnWritable([&]() {
+            open_when_woken = writer->IsOpen();
+            woken = true;
+        });
+        pair.conn->Close(Error(WebError::kTimeout, "peer gone"));
+    });
+    CHECK(WaitFor([&] { return woken.load(); }));
+    CHECK(!open_when_woken);
+    RunOnLoop(pair.loop, [&]() {
+        CHECK(writer->Write("more").IsFailure());
+        writer.reset();
+    });
+
+    std::cout << "Streaming dispatch test passed!" << std::endl;
+}
+
+} // namespace
+
+int main() {
+    std::cout << "Starting response writer tests..." << std::endl;
+
+    try {
+        TestChunkedResponse();
+        TestFramingVariants();
+        TestBackpressure();
+        TestStreamingPausesDispatch();
+
+        std::cout << "\nAll response writer tests passed!" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,146 @@
+#include "server_metrics.h"
+#include "test_check.h"
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace tinywebserver;
+
+// Release 构建下 assert 会被裁掉，这里用抛异常的检查保证断言始终生效
+void TestSingleThread() {
+    std::cout << "=== TestSingleThread ===" << std::endl;
+
+    auto& metrics = ServerMetrics::GetInstance();
+    metrics.Reset();
+
+    metrics.OnNewConnection();
+    metrics.OnNewConnection();
+    metrics.OnCloseConnection();
+    metrics.OnRequestWithStatusCode(200);
+    metrics.OnRequestWithStatusCode(404);
+    metrics.OnRequestWithStatusCode(503);
+    metrics.OnBytesSent(100);
+    metrics.OnBytesReceived(40);
+    metrics.OnMemoryAllocated(64);
+    metrics.OnMemoryFreed(16);
+
+    auto snap = metrics.GetSnapshot();
+    CHECK(snap.active_connections == 1);
+    CHECK(snap.total_connections == 2);
+    CHECK(snap.total_requests == 3);
+    CHECK(snap.requests_2xx == 1);
+    CHECK(snap.requests_4xx == 1);
+    CHECK(snap.requests_5xx == 1);
+    CHECK(snap.bytes_sent == 100);
+    CHECK(snap.bytes_received == 40);
+    CHECK(snap.memory_allocated == 48);
+
+    std::cout << "Single thread test passed!" << std::endl;
+}
+
+void TestShardAggregation() {
+    std::cout << "=== TestShardAggregation ===" << std::endl;
+
+    auto& metrics = ServerMetrics::GetInstance();
+    metrics.Reset();
+
+    const int kThreads = 8;
+    const int kIterations = 100000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&metrics]() {
+            for (int i = 0; i < kIterations; ++i) {
+                metrics.OnBytesSent(2);
+                metrics.OnRequestWithStatusCode(200);
+            }
+            // 连接在本线程建立、在主线程关闭，模拟跨线程 gauge
+            metrics.OnNewConnection();
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+    metrics.OnCloseConnection();
+
+    // 线程已退出，其分片应已并入 retired 计数
+    auto snap = metrics.GetSnapshot();
+    CHECK(snap.bytes_sent == static_cast<uint64_t>(kThreads) * kIterations * 2);
+    CHECK(snap.requests_2xx == static_cast<uint64_t>(kThreads) * kIterations);
+    CHECK(snap.total_connections == static_cast<uint64_t>(kThreads));
+    CHECK(snap.active_connections == static_cast<uint64_t>(kThreads - 1));
+    CHECK(metrics.GetShardCount() == 1);  // 只剩主线程分片
+
+    std::cout << "Shard aggregation test passed!" << std::endl;
+}
+
+void TestExportFormat() {
+    std::cout << "=== TestExportFormat ===" << std::endl;
+
+    auto& metrics = ServerMetrics::GetInstance();
+    metrics.Reset();
+    metrics.OnBytesSent(7);
+
+    std::string prom = metrics.ToPrometheusString();
+    CHECK(prom.find("webserver_traffic_bytes_sent_total 7\n") != std::string::npos);
+    CHECK(prom.find("webserver_requests_by_status_total{status=\"2xx\"} 0\n") != std::string::npos);
+
+    std::string json = metrics.ToJsonString();
+    CHECK(json.find("\"bytes_sent\": 7") != std::string::npos);
+
+    std::cout << "Export format test passed!" << std::endl;
+}
+
+void TestLatencyHistogram() {
+    std::cout << "=== TestLatencyHistogram ===" << std::endl;
+
+    // 桶上界单调递增，且每个值都落在不小于自身的桶里
+    for (size_t i = 1; i < LatencyHistogram::kBucketCount; ++i) {
+        CHECK(LatencyHistogram::BucketUpperBound(i) > LatencyHistogram::BucketUpperBound(i - 1));
+    }
+    for (uint64_t v : std::vector<uint64_t>{0, 1, 31, 32, 33, 1000, 123456789, LatencyHistogram::kMaxValue}) {
+        size_t index = LatencyHistogram::BucketIndex(v);
+        CHECK(index < LatencyHistogram::kBucketCount);
+        CHECK(LatencyHistogram::BucketUpperBound(index) >= v);
+        CHECK(index == 0 || LatencyHistogram::BucketUpperBound(index - 1) < v);
+    }
+
+    auto& metrics = ServerMetrics::GetInstance();
+    metrics.Reset();
+    // 1..10000 微秒均匀分布
+    for (uint64_t us = 1; us <= 10000; ++us) {
+        metrics.OnRequestPhase(RequestPhase::kTotal, us * 1000);
+    }
+    auto hist = metrics.GetLatencySnapshot(RequestPhase::kTotal);
+    CHECK(hist.total_count == 10000);
+    double p50 = static_cast<double>(hist.Percentile(0.5)) / 1000.0;
+    double p99 = static_cast<double>(hist.Percentile(0.99)) / 1000.0;
+    CHECK(p50 >= 5000.0 && p50 <= 5000.0 * 1.07);
+    CHECK(p99 >= 9900.0 && p99 <= 10000.0);
+    CHECK(hist.CountAtOrBelow(LatencyHistogram::kMaxValue) == 10000);
+
+    std::string prom = metrics.ToPrometheusString();
+    CHECK(prom.find("webserver_request_duration_seconds_count{phase=\"total\"} 10000\n") != std::string::npos);
+    CHECK(prom.find("webserver_request_duration_seconds_bucket{phase=\"total\",le=\"+Inf\"} 10000\n") != std::string::npos);
+    CHECK(prom.find("quantile=\"0.999\"") != std::string::npos);
+
+    std::cout << "Latency histogram test passed!" << std::endl;
+}
+
+int main() {
+    std::cout << "Starting ServerMetrics tests..." << std::endl;
+
+    try {
+        TestSingleThread();
+        TestShardAggregation();
+        TestExportFormat();
+        TestLatencyHistogram();
+
+        std::cout << "\nAll ServerMetrics tests passed!" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    }
+}
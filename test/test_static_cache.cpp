@@ -0,0 +1,448 @@
+#include "connection.h"
+#include "frequency_sketch.h"
+#include "reactor/event_loop.h"
+#include "reactor/event_loop_thread.h"
+#include "static_resource_manager.h"
+#include "test_check.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace tinywebserver;
+
+namespace {
+
+std::string MakeFile(const std::string& dir, const std::string& name, size_t size) {
+    std::string path = dir + "/" + name;
+    std::ofstream out(path, std::ios::binary);
+    out << std::string(size, 'x');
+    return path;
+}
+
+/**
+ * @brief 计数、饱和与老化
+ */
+void TestSketch() {
+    std::cout << "=== TestSketch ===" << std::endl;
+
+    FrequencySketch sketch(64);
+    for (int i = 0; i < 5; ++i) {
+        sketch.Increment(42);
+    }
+    CHECK(sketch.Estimate(42) == 5);
+    CHECK(sketch.Estimate(7) == 0);
+
+    for (int i = 0; i < 100; ++i) {
+        sketch.Increment(43);
+    }
+    CHECK(sketch.Estimate(43) == FrequencySketch::kMaxFrequency);
+
+    // 其它键的访问累计到采样上限后计数减半
+    uint64_t key = 1000;
+    while (sketch.GetResetCount() == 0) {
+        sketch.Increment(key++);
+    }
+    CHECK(sketch.Estimate(42) <= 3);
+    CHECK(sketch.Estimate(43) <= 8);
+
+    std::cout << "Sketch test passed!" << std::endl;
+}
+
+/**
+ * @brief 一次扫描冲掉 LRU 的热点，W-TinyLFU 保留热点
+ */
+void TestScanResistance(const std::string& dir) {
+    std::cout << "=== TestScanResistance ===" << std::endl;
+
+    std::vector<std::string> hot;
+    for (int i = 0; i < 8; ++i) {
+        hot.push_back(MakeFile(dir, "hot_" + std::to_string(i), 4096));
+    }
+    std::vector<std::string> scan;
+    for (int i = 0; i < 64; ++i) {
+        scan.push_back(MakeFile(dir, "scan_" + std::to_string(i), 4096));
+    }
+
+    auto& manager = StaticResourceManager::GetInstance();
+    manager.SetCacheLimit(16 * 4096);
+    for (CachePolicy policy : {CachePolicy::kLru, CachePolicy::kWTinyLfu, CachePolicy::kWTinyLfuSize}) {
+        manager.SetCachePolicy(policy);
+        for (int round = 0; round < 4; ++round) {
+            for (const auto& path : hot) {
+                CHECK(manager.GetResource(path) != nullptr);
+            }
+        }
+        for (const auto& path : scan) {
+            CHECK(manager.GetResource(path) != nullptr);
+        }
+        auto before = manager.GetStatus();
+        for (const auto& path : hot) {
+            manager.GetResource(path);
+        }
+        uint64_t hits = manager.GetStatus().cache_hits - before.cache_hits;
+        CHECK(manager.GetStatus().current_memory_usage <= 16 * 4096);
+        if (policy == CachePolicy::kLru) {
+            CHECK(hits == 0);
+        } else {
+            CHECK(hits == hot.size());
+            CHECK(manager.GetStatus().rejected_admissions > 0);
+        }
+    }
+
+    std::cout << "Scan resistance test passed!" << std::endl;
+}
+
+/**
+ * @brief 按字节计价：一个大文件挤不掉多个同样热的小文件，经典 TinyLFU 则会
+ */
+void TestSizeAwareAdmission(const std::string& dir) {
+    std::cout << "=== TestSizeAwareAdmission ===" << std::endl;
+
+    std::vector<std::string> small;
+    for (int i = 0; i < 12; ++i) {
+        small.push_back(MakeFile(dir, "small_" + std::to_string(i), 4096));
+    }
+    std::string big = MakeFile(dir, "big", 10 * 4096);
+
+    auto& manager = StaticResourceManager::GetInstance();
+    manager.SetCacheLimit(16 * 4096);
+    for (CachePolicy policy : {CachePolicy::kWTinyLfu, CachePolicy::kWTinyLfuSize}) {
+        manager.SetCachePolicy(policy);
+        for (int round = 0; round < 3; ++round) {
+            for (const auto& path : small) {
+                manager.GetResource(path);
+            }
+        }
+        for (int round = 0; round < 5; ++round) {
+            manager.GetResource(big);
+        }
+        auto before = manager.GetStatus();
+        for (const auto& path : small) {
+            manager.GetResource(path);
+        }
+        uint64_t hits = manager.GetStatus().cache_hits - before.cache_hits;
+        if (policy == CachePolicy::kWTinyLfuSize) {
+            CHECK(hits == small.size());
+        } else {
+            CHECK(hits < small.size());
+        }
+    }
+
+    manager.SetCachePolicy(CachePolicy::kLru);
+    std::cout << "Size-aware admission test passed!" << std::endl;
+}
+
+/**
+ * @brief 候选者先胜过冷的淘汰者、再输给热的淘汰者时整体落选，所有淘汰者都保留
+ */
+void TestRejectedAdmissionKeepsVictims(const std::string& dir) {
+    std::cout << "=== TestRejectedAdmissionKeepsVictims ===" << std::endl;
+
+    std::vector<std::string> cold;
+    for (int i = 0; i < 4; ++i) {
+        cold.push_back(MakeFile(dir, "victim_cold_" + std::to_string(i), 4096));
+    }
+    std::vector<std::string> hot;
+    for (int i = 0; i < 10; ++i) {
+        hot.push_back(MakeFile(dir, "victim_hot_" + std::to_string(i), 4096));
+    }
+    std::string candidate = MakeFile(dir, "victim_candidate", 8 * 4096);
+
+    auto& manager = StaticResourceManager::GetInstance();
+    manager.SetCacheLimit(16 * 4096);
+    for (CachePolicy policy : {CachePolicy::kWTinyLfu, CachePolicy::kWTinyLfuSize}) {
+        manager.SetCachePolicy(policy);
+        // 试用段队尾是只访问过一次的冷文件，热文件多次命中后进入保护段
+        for (const auto& path : cold) {
+            CHECK(manager.GetResource(path) != nullptr);
+        }
+        for (int round = 0; round < 4; ++round) {
+            for (const auto& path : hot) {
+                CHECK(manager.GetResource(path) != nullptr);
+            }
+        }
+
+        // 候选者频率高于冷文件、低于热文件：腾出空间需要冷热两类淘汰者
+        auto before = manager.GetStatus();
+        manager.GetResource(candidate);
+        manager.GetResource(candidate);
+        auto after = manager.GetStatus();
+        CHECK(after.rejected_admissions == before.rejected_admissions + 2);
+        CHECK(after.evictions == before.evictions + 2);   // 只淘汰了候选者自己
+        CHECK(after.cached_files_count == cold.size() + hot.size());
+
+        for (const auto& path : cold) {
+            manager.GetResource(path);
+        }
+        for (const auto& path : hot) {
+            manager.GetResource(path);
+        }
+        CHECK(manager.GetStatus().cache_hits - after.cache_hits == cold.size() + hot.size());
+    }
+
+    manager.SetCachePolicy(CachePolicy::kLru);
+    std::cout << "Rejected admission test passed!" << std::endl;
+}
+
+template <typename Pred>
+bool WaitFor(Pred pred) {
+    for (int i = 0; i < 500; ++i) {
+        if (pred()) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+/**
+ * @brief 未命中交给后台线程：同一路径只加载一次，加载期间其它路径的命中不被阻塞
+ */
+void TestSingleFlightLoad(const std::string& dir) {
+    std::cout << "=== TestSingleFlightLoad ===" << std::endl;
+
+    auto& manager = StaticResourceManager::GetInstance();
+    manager.SetCacheLimit(16 * 4096);
+    manager.SetCachePolicy(CachePolicy::kLru);
+    manager.SetLoaderThreads(1);
+
+    std::string hot = MakeFile(dir, "loader_hot", 4096);
+    CHECK(manager.GetResource(hot) != nullptr);
+
+    // FIFO 的 open 会阻塞到有写端为止，借此让加载停在磁盘 I/O 上
+    std::string slow = dir + "/loader_fifo";
+    CHECK(mkfifo(slow.c_str(), 0600) == 0);
+    auto before = manager.GetStatus();
+
+    std::atomic<int> callbacks{0};
+    auto on_loaded = [&callbacks](std::shared_ptr<StaticResource> resource) {
+        CHECK(resource == nullptr);   // FIFO 大小为 0，不可缓存
+        callbacks++;
+    };
+    bool pending = false;
+    CHECK(manager.GetResourceAsync(slow, on_loaded, pending) == nullptr);
+    CHECK(pending);
+    CHECK(manager.GetResourceAsync(slow, on_loaded, pending) == nullptr);
+    CHECK(pending);
+
+    // 同步调用者等待同一次加载
+    std::thread waiter([&manager, &slow]() { manager.GetResource(slow); });
+    CHECK(WaitFor([&] { return manager.GetStatus().coalesced_loads == before.coalesced_loads + 2; }));
+
+    CHECK(manager.GetResourceAsync(hot, on_loaded, pending) != nullptr);
+    CHECK(!pending);
+    CHECK(callbacks == 0);
+
+    int fd = ::open(slow.c_str(), O_WRONLY);
+    CHECK(fd >= 0);
+    ::close(fd);
+    waiter.join();
+    CHECK(WaitFor([&] { return callbacks == 2; }));
+    CHECK(manager.GetStatus().background_loads == before.background_loads + 1);
+
+    // 正常文件：回调拿到资源后即已入缓存
+    std::string cold = MakeFile(dir, "loader_cold", 4096);
+    std::atomic<bool> loaded{false};
+    CHECK(manager.GetResourceAsync(cold, [&loaded](std::shared_ptr<StaticResource> resource) {
+        CHECK(resource != nullptr && resource->size == 4096);
+        loaded = true;
+    }, pending) == nullptr);
+    CHECK(pending);
+    CHECK(WaitFor([&] { return loaded.load(); }));
+    CHECK(manager.GetResourceAsync(cold, on_loaded, pending) != nullptr);
+    CHECK(!pending);
+
+    // 加载线程数为 0：在调用线程同步加载
+    manager.SetLoaderThreads(0);
+    std::string inline_file = MakeFile(dir, "loader_inline", 4096);
+    CHECK(manager.GetResourceAsync(inline_file, on_loaded, pending) != nullptr);
+    CHECK(!pending);
+
+    std::cout << "Single-flight load test passed!" << std::endl;
+}
+
+/**
+ * @brief 挂起的请求（HTTP/2 流、已读完请求体的请求）在加载完成后先于缓冲区中的后续请求执行
+ */
+void TestParkedRequests(const std::string& dir) {
+    std::cout << "=== TestParkedRequests ===" << std::endl;
+
+    auto& manager = StaticResourceManager::GetInstance();
+    manager.SetLoaderThreads(1);
+    std::string slow = dir + "/parked_fifo";
+    CHECK(mkfifo(slow.c_str(), 0600) == 0);
+
+    int fds[2];
+    CHECK(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    ::fcntl(fds[0], F_SETFL, ::fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+    EventLoopThread loop_thread;
+    EventLoop* loop = loop_thread.StartLoop();
+    auto conn = std::make_shared<Connection>(fds[0], loop);
+    auto run_on_loop = [loop](const std::function<void()>& f) {
+        std::promise<void> done;
+        loop->RunInLoop([&]() {
+            f();
+            done.set_value();
+        });
+        done.get_future().wait();
+    };
+
+    std::mutex mutex;
+    std::vector<std::string> order;
+    auto record = [&](const std::string& what) {
+        std::lock_guard<std::mutex> lock(mutex);
+        order.push_back(what);
+    };
+    run_on_loop([&]() {
+        conn->SetMessageCallback([&](std::shared_ptr<Connection> c, const std::string&) {
+            record("input");
+            c->GetInputBuffer().clear();
+        });
+        conn->ConnectEstablished();
+        bool pending = false;
+        CHECK(conn->AcquireStaticResource(slow, pending) == nullptr);
+        CHECK(pending);
+        for (const char* name : {"stream1", "stream3"}) {
+            conn->ParkUntilLoaded(slow, [&, name]() {
+                bool again = true;
+                conn->AcquireStaticResource(slow, again);
+                CHECK(!again);   // 取到刚加载完成的结果，不再发起加载
+                record(name);
+            });
+        }
+    });
+
+    // 等待期间到达的请求只进入缓冲区
+    CHECK(::write(fds[1], "GET", 3) == 3);
+    CHECK(WaitFor([&] {
+        bool buffered = false;
+        run_on_loop([&]() { buffered = !conn->GetInputBuffer().empty(); });
+        return buffered;
+    }));
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        CHECK(order.empty());
+    }
+
+    int fd = ::open(slow.c_str(), O_WRONLY);
+    CHECK(fd >= 0);
+    ::close(fd);
+    CHECK(WaitFor([&] {
+        std::lock_guard<std::mutex> lock(mutex);
+        return order.size() == 3;
+    }));
+    CHECK((order == std::vector<std::string>{"stream1", "stream3", "input"}));
+
+    run_on_loop([&]() {
+        conn->Close(Error(WebError::kTimeout, "test done"));
+        conn.reset();
+    });
+    ::close(fds[1]);
+    loop_thread.Stop();
+    loop_thread.Join();
+
+    std::cout << "Parked requests test passed!" << std::endl;
+}
+
+/**
+ * @brief 预热按缓存上限截断，热点列表中的文件优先于更小的冷文件
+ */
+void TestWarmUp(const std::string& dir) {
+    std::cout << "=== TestWarmUp ===" << std::endl;
+
+    std::string root = dir + "/warm";
+    CHECK(mkdir(root.c_str(), 0700) == 0);
+    CHECK(mkdir((root + "/css").c_str(), 0700) == 0);
+    std::string big = MakeFile(root, "big.bin", 8 * 4096);
+    std::vector<std::string> small;
+    for (int i = 0; i < 8; ++i) {
+        small.push_back(MakeFile(root + "/css", "s" + std::to_string(i) + ".css", 4096));
+    }
+
+    auto& manager = StaticResourceManager::GetInstance();
+    manager.SetCacheLimit(12 * 4096);
+    manager.SetCachePolicy(CachePolicy::kLru);
+
+    // 无热点列表：小文件优先
+    StaticResourceManager::WarmUpOptions options;
+    options.root = root;
+    options.threads = 3;
+    auto result = manager.WarmUp(options);
+    CHECK(!result.timed_out);
+    CHECK(result.files_loaded == small.size());
+    CHECK(result.bytes_loaded == small.size() * 4096);
+
+    // 缓存键与请求拼接的路径一致：命中
+    auto before = manager.GetStatus();
+    CHECK(manager.GetResource(small[0]) != nullptr);
+    CHECK(manager.GetStatus().cache_hits == before.cache_hits + 1);
+
+    // 保存的热点列表让大文件排在最前
+    manager.GetResource(big);
+    std::string hot_list = dir + "/hot_list.txt";
+    CHECK(manager.SaveHotList(hot_list));
+    {
+        std::ofstream out(hot_list, std::ios::trunc);
+        out << "# hottest first\n" << big << "\n" << dir << "/outside_root\n";
+    }
+    manager.SetCachePolicy(CachePolicy::kWTinyLfuSize);
+    options.hot_list_path = hot_list;
+    result = manager.WarmUp(options);
+    CHECK(result.hot_list_hits == 1);
+    CHECK(result.files_loaded == 1 + 4);
+    before = manager.GetStatus();
+    CHECK(manager.GetResource(big) != nullptr);
+    CHECK(manager.GetStatus().cache_hits == before.cache_hits + 1);
+
+    // 预算为 0：不开始任何加载
+    manager.SetCachePolicy(CachePolicy::kLru);
+    options.budget = std::chrono::milliseconds(0);
+    result = manager.WarmUp(options);
+    CHECK(result.timed_out);
+    CHECK(result.files_loaded == 0);
+
+    std::cout << "Warm-up test passed!" << std::endl;
+}
+
+} // namespace
+
+int main() {
+    std::cout << "Starting static cache tests..." << std::endl;
+
+    char dir_template[] = "/tmp/test_static_cache_XXXXXX";
+    const char* dir = mkdtemp(dir_template);
+    if (!dir) {
+        std::cerr << "mkdtemp failed" << std::endl;
+        return 1;
+    }
+
+    int status = 0;
+    try {
+        TestSketch();
+        TestScanResistance(dir);
+        TestSizeAwareAdmission(dir);
+        TestRejectedAdmissionKeepsVictims(dir);
+        TestSingleFlightLoad(dir);
+        TestParkedRequests(dir);
+        TestWarmUp(dir);
+        std::cout << "\nAll static cache tests passed!" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        status = 1;
+    }
+    std::system((std::string("rm -rf ") + dir).c_str());
+    return status;
+}
@@ -0,0 +1,134 @@
+#include "timer/timer_wheel.h"
+#include "test_check.h"
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace tinywebserver;
+
+namespace {
+
+/// 连续 Tick，返回第几次 Tick 时 fired 变为 true（未触发返回 0）
+int TicksUntilFired(TimerWheel& wheel, const bool& fired, int max_ticks) {
+    for (int i = 1; i <= max_ticks; ++i) {
+        wheel.Tick();
+        if (fired) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 单圈、恰好一圈与多圈的超时都在第 timeout + 1 次 Tick 时触发
+ */
+void TestTimeoutLength() {
+    std::cout << "=== TestTimeoutLength ===" << std::endl;
+
+    for (int timeout : {3, 8, 20}) {
+        TimerWheel wheel(8, 1000);
+        wheel.Tick();   // 从非零槽位开始
+        bool fired = false;
+        CHECK(wheel.AddTimeout(5, timeout, [&fired]() { fired = true; }).IsSuccess());
+        CHECK(TicksUntilFired(wheel, fired, 100) == timeout + 1);
+        CHECK(wheel.GetActiveTimerCount() == 0);
+    }
+
+    std::cout << "Timeout length test passed!" << std::endl;
+}
+
+/**
+ * @brief 经过若干滴答后仍能删除与替换定时器
+ */
+void TestRemoveAfterTicks() {
+    std::cout << "=== TestRemoveAfterTicks ===" << std::endl;
+
+    TimerWheel wheel(8, 1000);
+    bool fired = false;
+    CHECK(wheel.AddTimeout(1, 20, [&fired]() { fired = true; }).IsSuccess());
+    for (int i = 0; i < 10; ++i) {
+        wheel.Tick();   // 多圈任务在本槽位内递减圈数
+    }
+    CHECK(wheel.HasTimer(1));
+    CHECK(wheel.RemoveTimeout(1).IsSuccess());
+    CHECK(!wheel.HasTimer(1));
+    CHECK(TicksUntilFired(wheel, fired, 30) == 0);
+
+    // 同一 fd 续期：旧任务被替换，只有新任务触发
+    int calls = 0;
+    CHECK(wheel.AddTimeout(2, 2, [&calls]() { calls += 1; }).IsSuccess());
+    wheel.Tick();
+    CHECK(wheel.AddTimeout(2, 5, [&calls]() { calls += 10; }).IsSuccess());
+    for (int i = 0; i < 10; ++i) {
+        wheel.Tick();
+    }
+    CHECK(calls == 10);
+
+    std::cout << "Remove after ticks test passed!" << std::endl;
+}
+
+/**
+ * @brief 回调中增删定时器（连接超时关闭时会取消其它定时器）不会死锁
+ */
+void TestReentrantCallback() {
+    std::cout << "=== TestReentrantCallback ===" << std::endl;
+
+    TimerWheel wheel(8, 1000);
+    bool rearmed_fired = false;
+    bool other_fired = false;
+    CHECK(wheel.AddTimeout(2, 4, [&other_fired]() { other_fired = true; }).IsSuccess());
+    CHECK(wheel.AddTimeout(1, 1, [&]() {
+        CHECK(wheel.RemoveTimeout(2).IsSuccess());
+        CHECK(wheel.AddTimeout(1, 1, [&rearmed_fired]() { rearmed_fired = true; }).IsSuccess());
+    }).IsSuccess());
+    for (int i = 0; i < 10; ++i) {
+        wheel.Tick();
+    }
+    CHECK(rearmed_fired);
+    CHECK(!other_fired);
+    CHECK(wheel.GetActiveTimerCount() == 0);
+
+    std::cout << "Reentrant callback test passed!" << std::endl;
+}
+
+/**
+ * @brief Advance 按经过的时间前进，调用次数不影响超时时长
+ */
+void TestAdvance() {
+    std::cout << "=== TestAdvance ===" << std::endl;
+
+    TimerWheel wheel(8, 1000);
+    auto start = std::chrono::steady_clock::now();
+    bool fired = false;
+    CHECK(wheel.AddTimeout(1, 2, [&fired]() { fired = true; }).IsSuccess());
+    for (int i = 0; i < 1000; ++i) {
+        wheel.Advance(start);   // 同一时刻反复调用不前进
+    }
+    CHECK(wheel.GetCurrentSlot() == 0);
+    CHECK(wheel.Advance(start + std::chrono::milliseconds(2500)) == 0);
+    CHECK(!fired);
+    CHECK(wheel.Advance(start + std::chrono::milliseconds(3500)) == 1);
+    CHECK(fired);
+
+    std::cout << "Advance test passed!" << std::endl;
+}
+
+} // namespace
+
+int main() {
+    std::cout << "Starting timer wheel tests..." << std::endl;
+
+    try {
+        TestTimeoutLength();
+        TestRemoveAfterTicks();
+        TestReentrantCallback();
+        TestAdvance();
+
+        std::cout << "\nAll timer wheel tests passed!" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    }
+}
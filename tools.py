@@ -586,7 +586,9 @@ def main():
 
     # benchmark run
     run_p = benchmark_subparsers.add_parser("run", help="运行基准测试")
-    run_p.add_argument("--type", required=True, choices=["qps", "latency", "memory", "concurrent"],
+    run_p.add_argument("--type", required=True, choices=["qps", "latency", "memory", "concurrent", "step_stress", "http2",
+                                                           "pipeline", "static_mix", "large_file", "replay",
+                                                           "connection_memory"],
                       help="基准测试类型")
     run_p.add_argument("--config", help="配置文件路径")
     run_p.add_argument("--output", help="输出目录")